@@ -0,0 +1,637 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#include <sched.h>
+#include <unistd.h>
+
+#include <getopt.h>
+
+#include <rxc/rxc.h>
+#include <rxc/blueprint.h>
+#include <rxc/generator.h>
+#include <rxc/logic.h>
+#include <rxc/ops/core.h>
+#include <rxc/schedulers/eventloop.h>
+#include <rxc/schedulers/serial.h>
+#include <rxc/schedulers/thread_pool.h>
+
+/* Allocation counting, where the allocations of the worker threads are counted
+ * as well */
+static atomic_size_t allocations;
+
+static void allocation_count(void)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+}
+
+static size_t allocation_total(void)
+{
+    return atomic_load_explicit(&allocations, memory_order_relaxed);
+}
+
+#ifdef __GLIBC__
+/* Interpose the allocator so allocations made by rxc are counted as well */
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t count, size_t size);
+extern void * __libc_realloc(void *ptr, size_t size);
+extern void * __libc_memalign(size_t alignment, size_t size);
+
+void * malloc(size_t size)
+{
+    allocation_count();
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t count, size_t size)
+{
+    allocation_count();
+    return __libc_calloc(count, size);
+}
+
+void * realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL) {
+        allocation_count();
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void * aligned_alloc(size_t alignment, size_t size)
+{
+    allocation_count();
+    return __libc_memalign(alignment, size);
+}
+#define ALLOCATIONS_COUNTED 1
+#else
+#define ALLOCATIONS_COUNTED 0
+#endif
+
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Print a single result as a JSON object on its own line.
+ */
+static void report(const char *bench, const char *param, long value,
+                   long elements, uint64_t elapsed, size_t allocs)
+{
+    double ns = (double) elapsed / (double) elements;
+
+    printf("{\"bench\": \"%s\", \"%s\": %ld, \"elements\": %ld, "
+           "\"ns_per_element\": %.2f, \"elements_per_sec\": %.0f",
+           bench, param, value, elements, ns, 1e9 / ns);
+
+    if (ALLOCATIONS_COUNTED) {
+        printf(", \"allocs_per_element\": %.3f", (double) allocs / (double) elements);
+    }
+
+    printf("}\n");
+    fflush(stdout);
+}
+
+/* Schedulers under test */
+struct bench_scheduler {
+    const char *name;
+    struct rxc_scheduler * (*create)(void);
+
+    /**
+     * Run the tasks scheduled on the scheduler until the counter drops to
+     * zero.
+     */
+    void (*drain)(struct rxc_scheduler *scheduler, atomic_long *remaining);
+};
+
+static struct rxc_scheduler * trampoline_create(void)
+{
+    return rxc_scheduler_trampoline();
+}
+
+static void trampoline_drain(struct rxc_scheduler *scheduler, atomic_long *remaining)
+{
+    /* Tasks run while they are being scheduled */
+}
+
+static void eventloop_drain(struct rxc_scheduler *scheduler, atomic_long *remaining)
+{
+    rxc_scheduler_eventloop_run(scheduler);
+}
+
+static struct rxc_scheduler * thread_pool_create(void)
+{
+    return rxc_scheduler_thread_pool(1);
+}
+
+static void thread_pool_drain(struct rxc_scheduler *scheduler, atomic_long *remaining)
+{
+    while (atomic_load(remaining) > 0) {
+        sched_yield();
+    }
+}
+
+static struct bench_scheduler schedulers[] = {
+    {"trampoline", trampoline_create, trampoline_drain},
+    {"eventloop", rxc_scheduler_eventloop, eventloop_drain},
+    {"serial", rxc_scheduler_serial, trampoline_drain},
+    {"thread_pool", thread_pool_create, thread_pool_drain},
+};
+
+/* count -> N x map -> ignore */
+static void * identity(void *element)
+{
+    return element;
+}
+
+static void bench_chain(long elements, int maps)
+{
+    struct rxc_source *source = rxc_source_count(0, elements);
+
+    for (int i = 0; i < maps; i++) {
+        source = rxc_source_via(source, rxc_flow_map(identity));
+    }
+
+    struct rxc_pipeline *pipeline = rxc_source_to(source, rxc_sink_ignore());
+    size_t allocs = allocation_total();
+    uint64_t start = now();
+
+    rxc_pipeline_start(pipeline, rxc_scheduler_trampoline());
+
+    report("chain", "maps", maps, elements, now() - start, allocation_total() - allocs);
+    rxc_pipeline_dealloc(pipeline);
+}
+
+/* count -> N x map_value -> ignore */
+static struct rxc_value identity_value(struct rxc_value value)
+{
+    return value;
+}
+
+static void bench_chain_value(long elements, int maps)
+{
+    struct rxc_source *source = rxc_source_count(0, elements);
+
+    for (int i = 0; i < maps; i++) {
+        source = rxc_source_via(source, rxc_flow_map_value(identity_value));
+    }
+
+    struct rxc_pipeline *pipeline = rxc_source_to(source, rxc_sink_ignore());
+    size_t allocs = allocation_total();
+    uint64_t start = now();
+
+    rxc_pipeline_start(pipeline, rxc_scheduler_trampoline());
+
+    report("chain_value", "maps", maps, elements, now() - start, allocation_total() - allocs);
+    rxc_pipeline_dealloc(pipeline);
+}
+
+/* count -> ignore, with the count written by hand or as a generator */
+struct count_generator {
+    struct rxc_generator base;
+
+    long i, to;
+};
+
+static void count_init(struct rxc_generator *gen, void *ctx)
+{
+    struct count_generator *self = (struct count_generator *) gen;
+
+    self->i = 0;
+    self->to = *(long *) ctx;
+}
+
+static int count_step(struct rxc_generator *gen)
+{
+    struct count_generator *self = (struct count_generator *) gen;
+
+    RXC_GENERATOR_BEGIN(gen);
+    for (; self->i < self->to; self->i++) {
+        RXC_GENERATOR_YIELD(gen, rxc_value_long(self->i));
+    }
+    RXC_GENERATOR_END(gen);
+}
+
+static void bench_source(long elements, int generator)
+{
+    struct rxc_source *source;
+
+    if (generator) {
+        source = rxc_source_generator(count_step, sizeof(struct count_generator),
+                                      count_init, NULL, &elements);
+    } else {
+        source = rxc_source_count(0, elements);
+    }
+
+    struct rxc_pipeline *pipeline = rxc_source_to(source, rxc_sink_ignore());
+    size_t allocs = allocation_total();
+    uint64_t start = now();
+
+    rxc_pipeline_start(pipeline, rxc_scheduler_trampoline());
+
+    report("source", "generator", generator, elements, now() - start, allocation_total() - allocs);
+    rxc_pipeline_dealloc(pipeline);
+}
+
+/* Build, start and deallocate count -> 4 x map -> ignore, optionally from a blueprint */
+static struct rxc_pipeline * setup_build(void *ctx)
+{
+    struct rxc_source *source = rxc_source_count(0, 1);
+
+    for (int i = 0; i < 4; i++) {
+        source = rxc_source_via(source, rxc_flow_map(identity));
+    }
+
+    return rxc_source_to(source, rxc_sink_ignore());
+}
+
+static void bench_setup(long pipelines, int blueprinted)
+{
+    struct rxc_blueprint *blueprint = rxc_blueprint_create(setup_build);
+
+    /* Let the blueprint learn its footprint first */
+    rxc_pipeline_dealloc(rxc_blueprint_materialize(blueprint, NULL));
+
+    size_t allocs = allocation_total();
+    uint64_t start = now();
+
+    for (long i = 0; i < pipelines; i++) {
+        struct rxc_pipeline *pipeline = blueprinted ? rxc_blueprint_materialize(blueprint, NULL)
+                                                    : setup_build(NULL);
+
+        rxc_pipeline_start(pipeline, rxc_scheduler_trampoline());
+        rxc_pipeline_dealloc(pipeline);
+    }
+
+    report("setup", "blueprint", blueprinted, pipelines, now() - start,
+           allocation_total() - allocs);
+    rxc_blueprint_dealloc(blueprint);
+}
+
+/* Scheduler dispatch */
+struct dispatch_ctx {
+    struct rxc_scheduler_worker *worker;
+    atomic_long remaining;
+};
+
+static void dispatch_task(void *arg)
+{
+    struct dispatch_ctx *ctx = arg;
+
+    if (atomic_fetch_sub(&ctx->remaining, 1) > 1) {
+        ctx->worker->schedule(ctx->worker, dispatch_task, ctx);
+    }
+}
+
+static void bench_dispatch(long tasks, struct bench_scheduler *bench)
+{
+    struct rxc_scheduler *scheduler = bench->create();
+    struct dispatch_ctx ctx;
+
+    ctx.worker = scheduler->create_worker(scheduler);
+    atomic_init(&ctx.remaining, tasks);
+
+    size_t allocs = allocation_total();
+    uint64_t start = now();
+
+    ctx.worker->schedule(ctx.worker, dispatch_task, &ctx);
+    bench->drain(scheduler, &ctx.remaining);
+
+    uint64_t elapsed = now() - start;
+
+    printf("{\"bench\": \"dispatch\", \"scheduler\": \"%s\", \"tasks\": %ld, "
+           "\"ns_per_task\": %.2f",
+           bench->name, tasks, (double) elapsed / (double) tasks);
+
+    if (ALLOCATIONS_COUNTED) {
+        printf(", \"allocs_per_task\": %.3f",
+               (double) (allocation_total() - allocs) / (double) tasks);
+    }
+
+    printf("}\n");
+    fflush(stdout);
+
+    ctx.worker->dealloc(ctx.worker);
+    scheduler->dealloc(scheduler);
+}
+
+/* Pull-1 vs. pull-N demand */
+struct batch_sink {
+    struct rxc_sink base;
+    long batch;
+    struct rxc_sink_logic *logic;
+};
+
+struct batch_sink_logic {
+    struct rxc_sink_logic base;
+    long batch;
+    long remaining;
+};
+
+static void batch_on_connect(struct rxc_sink_logic *logic)
+{
+    struct batch_sink_logic *self = (struct batch_sink_logic *) logic;
+
+    /* Without a batch size, demand is signaled from outside the pipeline */
+    if (self->batch == 0) {
+        ((struct batch_sink *) logic->sink)->logic = logic;
+        return;
+    }
+
+    self->remaining = self->batch;
+    rxc_inlet_pull(logic->in, self->batch);
+}
+
+static void batch_on_push(struct rxc_sink_logic *logic, void *element)
+{
+    struct batch_sink_logic *self = (struct batch_sink_logic *) logic;
+
+    free(element);
+
+    /* Only request the next batch once the current one has been received */
+    if (self->batch > 0 && --self->remaining == 0) {
+        self->remaining = self->batch;
+        rxc_inlet_pull(logic->in, self->batch);
+    }
+}
+
+static void batch_on_upstream_finish(struct rxc_sink_logic *self)
+{}
+
+static void batch_on_upstream_failure(struct rxc_sink_logic *self, void *failure)
+{
+    free(failure);
+}
+
+static struct rxc_sink_logic * batch_create_logic(struct rxc_sink *sink)
+{
+    struct batch_sink_logic *logic = malloc(sizeof(struct batch_sink_logic));
+
+    if (!logic) {
+        return NULL;
+    }
+
+    logic->batch = ((struct batch_sink *) sink)->batch;
+    logic->remaining = 0;
+    logic->base.sink = sink;
+    logic->base.dealloc = (void (*)(struct rxc_sink_logic *)) free;
+    logic->base.on_connect = batch_on_connect;
+    logic->base.on_push = batch_on_push;
+    logic->base.on_push_value = NULL;
+    logic->base.on_upstream_finish = batch_on_upstream_finish;
+    logic->base.on_upstream_failure = batch_on_upstream_failure;
+
+    return &logic->base;
+}
+
+static void batch_dealloc(struct rxc_sink *self, int shallow)
+{
+    free(self);
+}
+
+static void bench_demand(long elements, long batch)
+{
+    struct batch_sink *sink = malloc(sizeof(struct batch_sink));
+
+    sink->batch = batch;
+    sink->logic = NULL;
+    sink->base.dealloc = batch_dealloc;
+    sink->base.create_logic = batch_create_logic;
+
+    struct rxc_source *source = rxc_source_via(rxc_source_count(0, elements),
+                                               rxc_flow_map(identity));
+    struct rxc_pipeline *pipeline = rxc_source_to(source, &sink->base);
+    size_t allocs = allocation_total();
+    uint64_t start = now();
+
+    rxc_pipeline_start(pipeline, rxc_scheduler_trampoline());
+
+    report("demand", "batch", batch, elements, now() - start, allocation_total() - allocs);
+    rxc_pipeline_dealloc(pipeline);
+}
+
+/* Demand signaled element by element from outside the pipeline */
+static void bench_demand_external(long elements)
+{
+    struct batch_sink *sink = malloc(sizeof(struct batch_sink));
+
+    sink->batch = 0;
+    sink->logic = NULL;
+    sink->base.dealloc = batch_dealloc;
+    sink->base.create_logic = batch_create_logic;
+
+    struct rxc_source *source = rxc_source_via(rxc_source_count(0, elements),
+                                               rxc_flow_map(identity));
+    struct rxc_pipeline *pipeline = rxc_source_to(source, &sink->base);
+
+    rxc_pipeline_start(pipeline, rxc_scheduler_trampoline());
+
+    size_t allocs = allocation_total();
+    uint64_t start = now();
+
+    for (long i = 0; i < elements; i++) {
+        rxc_inlet_pull(sink->logic->in, 1);
+    }
+
+    report("demand_external", "batch", 1, elements, now() - start, allocation_total() - allocs);
+    rxc_pipeline_dealloc(pipeline);
+}
+
+/* Parallel map of an expensive mapping */
+struct ordered_sink {
+    struct rxc_sink base;
+    long expected;
+    int ordered;
+    atomic_int finished;
+};
+
+static void ordered_on_connect(struct rxc_sink_logic *logic)
+{
+    rxc_inlet_pull(logic->in, LONG_MAX);
+}
+
+static void ordered_on_push(struct rxc_sink_logic *logic, void *element)
+{
+    struct ordered_sink *sink = (struct ordered_sink *) logic->sink;
+
+    if (*(long *) element != sink->expected++) {
+        sink->ordered = 0;
+    }
+
+    free(element);
+}
+
+static void ordered_on_upstream_finish(struct rxc_sink_logic *logic)
+{
+    atomic_store(&((struct ordered_sink *) logic->sink)->finished, 1);
+}
+
+static void ordered_on_upstream_failure(struct rxc_sink_logic *logic, void *failure)
+{
+    free(failure);
+    ordered_on_upstream_finish(logic);
+}
+
+static struct rxc_sink_logic * ordered_create_logic(struct rxc_sink *sink)
+{
+    struct rxc_sink_logic *logic = malloc(sizeof(struct rxc_sink_logic));
+
+    if (!logic) {
+        return NULL;
+    }
+
+    logic->sink = sink;
+    logic->dealloc = (void (*)(struct rxc_sink_logic *)) free;
+    logic->on_connect = ordered_on_connect;
+    logic->on_push = ordered_on_push;
+    logic->on_push_value = NULL;
+    logic->on_upstream_finish = ordered_on_upstream_finish;
+    logic->on_upstream_failure = ordered_on_upstream_failure;
+
+    return logic;
+}
+
+static void * expensive(void *element)
+{
+    volatile uint64_t state = (uint64_t) *(long *) element + 1;
+
+    for (int i = 0; i < 20000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+    }
+
+    return element;
+}
+
+static void bench_map_parallel(long elements, long parallelism, struct rxc_scheduler *pool)
+{
+    struct ordered_sink sink;
+
+    sink.expected = 0;
+    sink.ordered = 1;
+    atomic_init(&sink.finished, 0);
+    sink.base.dealloc = NULL;
+    sink.base.create_logic = ordered_create_logic;
+
+    struct rxc_source *source = rxc_source_via(rxc_source_count(0, elements),
+                                               rxc_flow_map_parallel(expensive, parallelism, pool, NULL));
+    struct rxc_pipeline *pipeline = rxc_source_to(source, &sink.base);
+    uint64_t start = now();
+
+    rxc_pipeline_start(pipeline, rxc_scheduler_trampoline());
+
+    while (!atomic_load(&sink.finished)) {
+        sched_yield();
+    }
+
+    uint64_t elapsed = now() - start;
+
+    printf("{\"bench\": \"map_parallel\", \"parallelism\": %ld, \"elements\": %ld, "
+           "\"ns_per_element\": %.2f, \"ordered\": %s}\n",
+           parallelism, elements, (double) elapsed / (double) elements,
+           sink.ordered && sink.expected == elements ? "true" : "false");
+    fflush(stdout);
+}
+
+/**
+ * Print the usage message of this program.
+ *
+ * @param[in] name The name of this program (most probably given by argv[0]).
+ */
+static void print_usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n elements]\n", name);
+    fprintf(stderr, "\t-n --elements\t\tthe amount of elements per benchmark\n");
+    fprintf(stderr, "\t-h --help\t\tshow a help message\n");
+}
+
+/* Command line options */
+static struct option long_options[] = {
+        {"elements", required_argument, 0, 'n'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+};
+
+/**
+ * Main entry point of the benchmark program, which prints a JSON object per
+ * result on standard output.
+ *
+ * @param[in] argc The amount of arguments passed to the program.
+ * @param[in] argv The command line arguments passed to the program.
+ * @return <code>0</code> on success, otherwise failure.
+ */
+int main(int argc, char **argv)
+{
+    long elements = 1000000;
+
+    /* Parse command line options */
+    while (1) {
+        int option_index = 0;
+        int c = getopt_long(argc, argv, "n:h", long_options, &option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+            case 'n':
+                elements = strtol(optarg, NULL, 10);
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return EXIT_SUCCESS;
+            case '?':
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            default:
+                abort();
+        }
+    }
+
+    if (elements <= 0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    static const int maps[] = {0, 1, 4, 16};
+    static const long batches[] = {1, 16, 256, LONG_MAX};
+
+    for (size_t i = 0; i < sizeof(maps) / sizeof(maps[0]); i++) {
+        bench_chain(elements, maps[i]);
+    }
+
+    for (size_t i = 0; i < sizeof(maps) / sizeof(maps[0]); i++) {
+        bench_chain_value(elements, maps[i]);
+    }
+
+    bench_source(elements, 0);
+    bench_source(elements, 1);
+
+    bench_setup(elements / 100 > 0 ? elements / 100 : 1, 0);
+    bench_setup(elements / 100 > 0 ? elements / 100 : 1, 1);
+
+    for (size_t i = 0; i < sizeof(schedulers) / sizeof(schedulers[0]); i++) {
+        bench_dispatch(elements, &schedulers[i]);
+    }
+
+    for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        bench_demand(elements, batches[i]);
+    }
+
+    bench_demand_external(elements);
+
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    struct rxc_scheduler *pool = rxc_scheduler_thread_pool(threads > 0 ? threads : 1);
+
+    for (long parallelism = 1; parallelism <= 8; parallelism *= 2) {
+        bench_map_parallel(elements / 1000 > 0 ? elements / 1000 : 1, parallelism, pool);
+    }
+
+    return EXIT_SUCCESS;
+}
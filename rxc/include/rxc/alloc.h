@@ -0,0 +1,29 @@
+#ifndef RXC_ALLOC_H
+#define RXC_ALLOC_H
+
+#include <stddef.h>
+
+/**
+ * Allocate memory for a stage, a logic object or another part of the object
+ * graph of a pipeline. While a pipeline is materialized from a blueprint, the
+ * memory is carved from the block of that pipeline; otherwise it comes from
+ * <code>malloc</code>.
+ *
+ * Elements must not be allocated with this function, since they may outlive
+ * the pipeline.
+ *
+ * @param[in] size The amount of bytes to allocate.
+ * @return The allocated memory or <code>NULL</code> on allocation failure.
+ */
+void * rxc_alloc(size_t size);
+
+/**
+ * Release memory allocated with <code>rxc_alloc</code>. Memory that belongs
+ * to the block of a materialized pipeline is released together with the
+ * block when the pipeline is deallocated.
+ *
+ * @param[in] ptr The memory to release or <code>NULL</code>.
+ */
+void rxc_free(void *ptr);
+
+#endif /* RXC_ALLOC_H */
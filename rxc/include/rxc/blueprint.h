@@ -0,0 +1,63 @@
+#ifndef RXC_BLUEPRINT_H
+#define RXC_BLUEPRINT_H
+
+#include <rxc/pipeline.h>
+
+/**
+ * A reusable description of a pipeline from which pipelines are materialized,
+ * for instance once per session of a server.
+ *
+ * A blueprint learns the memory footprint of the object graph of its
+ * pipelines, including the logic objects and connections created when they
+ * are started. Once learned, every stage, logic object and connection of a
+ * materialized pipeline is carved from a single contiguous block, so setting
+ * up a pipeline takes one allocation and its objects are laid out next to
+ * each other. The block is released as a whole when the pipeline is
+ * deallocated.
+ *
+ * Blueprints may be shared between threads.
+ */
+struct rxc_blueprint;
+
+/**
+ * Create a blueprint from the specified build function. The function builds
+ * the pipeline from stages whose memory is allocated with
+ * <code>rxc_alloc</code>, as are the stages of this library, and may be
+ * invoked concurrently.
+ *
+ * @param[in] build The function that builds a pipeline for the specified
+ * context or returns <code>NULL</code> on failure, after releasing the stages
+ * it has built.
+ * @return The blueprint or <code>NULL</code> on allocation failure.
+ */
+struct rxc_blueprint * rxc_blueprint_create(struct rxc_pipeline * (*build)(void *ctx));
+
+/**
+ * Deallocate the specified blueprint. The pipelines materialized from the
+ * blueprint must have been deallocated before.
+ *
+ * @param[in] blueprint The blueprint to deallocate.
+ */
+void rxc_blueprint_dealloc(struct rxc_blueprint *blueprint);
+
+/**
+ * Materialize a pipeline from the specified blueprint. Starting the pipeline
+ * allocates its logic objects from the same block, and
+ * <code>rxc_pipeline_dealloc</code> releases the block.
+ *
+ * @param[in] blueprint The blueprint to materialize.
+ * @param[in] ctx The context to pass to the build function.
+ * @return The pipeline or <code>NULL</code> on failure.
+ */
+struct rxc_pipeline * rxc_blueprint_materialize(struct rxc_blueprint *blueprint, void *ctx);
+
+/**
+ * Determine the footprint the specified blueprint has learned, which is the
+ * size of the block a pipeline is materialized in.
+ *
+ * @param[in] blueprint The blueprint to obtain the footprint of.
+ * @return The footprint in bytes.
+ */
+size_t rxc_blueprint_footprint(struct rxc_blueprint *blueprint);
+
+#endif /* RXC_BLUEPRINT_H */
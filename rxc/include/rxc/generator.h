@@ -0,0 +1,124 @@
+#ifndef RXC_GENERATOR_H
+#define RXC_GENERATOR_H
+
+#include <stddef.h>
+
+#include <rxc/pipeline.h>
+#include <rxc/value.h>
+
+#define RXC_GENERATOR_YIELDED  0 /* The generator has produced a value */
+#define RXC_GENERATOR_FINISHED 1 /* The generator has no more values */
+#define RXC_GENERATOR_FAILED   2 /* The generator has failed */
+
+/**
+ * The state of a generator, which is a stackless coroutine (protothread) that
+ * yields the elements of a source one by one. Generators embed this structure
+ * as their first member and keep every variable that must survive a yield in
+ * their own structure, since the locals of the step function do not.
+ *
+ * A step function is written as a loop between <code>RXC_GENERATOR_BEGIN</code>
+ * and <code>RXC_GENERATOR_END</code> that yields values with
+ * <code>RXC_GENERATOR_YIELD</code>. Each invocation runs until the next yield,
+ * after which the runtime emits the value and resumes the function after that
+ * yield once downstream has demand for another element:
+ *
+ * <pre>
+ * struct count { struct rxc_generator base; long i, to; };
+ *
+ * static int count_step(struct rxc_generator *gen)
+ * {
+ *     struct count *self = (struct count *) gen;
+ *
+ *     RXC_GENERATOR_BEGIN(gen);
+ *     for (; self->i < self->to; self->i++) {
+ *         RXC_GENERATOR_YIELD(gen, rxc_value_long(self->i));
+ *     }
+ *     RXC_GENERATOR_END(gen);
+ * }
+ * </pre>
+ *
+ * A yield may not appear in a nested <code>switch</code> statement, nor may
+ * two yields share a line.
+ */
+struct rxc_generator {
+    /**
+     * The point at which to resume the step function.
+     */
+    int resume;
+
+    /**
+     * The value that was yielded last.
+     */
+    struct rxc_value value;
+
+    /**
+     * The failure the generator has failed with.
+     */
+    void *failure;
+};
+
+/**
+ * Mark the start of the body of a step function.
+ */
+#define RXC_GENERATOR_BEGIN(gen) \
+    switch ((gen)->resume) { \
+        case 0:
+
+/**
+ * Yield the specified value and suspend the step function until downstream
+ * has demand for another element.
+ */
+#define RXC_GENERATOR_YIELD(gen, yielded) \
+    do { \
+        (gen)->resume = __LINE__; \
+        (gen)->value = (yielded); \
+        return RXC_GENERATOR_YIELDED; \
+        case __LINE__:; \
+    } while (0)
+
+/**
+ * Terminate the generator with the specified failure.
+ */
+#define RXC_GENERATOR_FAIL(gen, fail) \
+    do { \
+        (gen)->resume = -1; \
+        (gen)->failure = (fail); \
+        return RXC_GENERATOR_FAILED; \
+    } while (0)
+
+/**
+ * Mark the end of the body of a step function, finishing the generator.
+ */
+#define RXC_GENERATOR_END(gen) \
+    } \
+    (gen)->resume = -1; \
+    return RXC_GENERATOR_FINISHED
+
+/**
+ * Create a source whose elements are produced by a generator. Every
+ * connection to the source runs its own instance of the generator. If a
+ * yielded value cannot be boxed for a sink that does not accept values, the
+ * stream fails with a <code>NULL</code> failure and <code>errno</code> set to
+ * <code>ENOMEM</code>.
+ *
+ * @param[in] step The step function of the generator.
+ * @param[in] size The size of the structure of the generator, which embeds a
+ * <code>struct rxc_generator</code> as its first member.
+ * @param[in] init The function to initialize a new instance with or
+ * <code>NULL</code> to zero it. Members of the embedded structure are set up
+ * by the runtime.
+ * @param[in] release The function to release the resources of an instance
+ * with when it terminates, is canceled or its source is deallocated
+ * mid-stream, or <code>NULL</code>.
+ * @param[in] ctx The context passed to the initialization function, which
+ * must outlive the source.
+ * @return The source that has been created or <code>NULL</code> on allocation
+ * failure.
+ */
+struct rxc_source * rxc_source_generator(int (*step)(struct rxc_generator *gen),
+                                         size_t size,
+                                         void (*init)(struct rxc_generator *gen, void *ctx),
+                                         void (*release)(struct rxc_generator *gen),
+                                         void *ctx);
+
+#endif /* RXC_GENERATOR_H */
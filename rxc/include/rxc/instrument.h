@@ -0,0 +1,121 @@
+#ifndef RXC_INSTRUMENT_H
+#define RXC_INSTRUMENT_H
+
+#include <rxc/pipeline.h>
+
+/**
+ * The amount of buckets in the latency histogram of a stage. Latencies are
+ * recorded in nanoseconds into log-linear buckets: every power of two is split
+ * into 16 linear sub-buckets, which bounds the relative error to 1/16.
+ */
+#define RXC_INSTRUMENT_BUCKETS 592
+
+/**
+ * The kinds of stages that are instrumented. Every instrumented stage records
+ * the elements that flow into it.
+ */
+enum rxc_instrument_kind {
+    RXC_INSTRUMENT_FLOW, /* A flow attached with rxc_source_via */
+    RXC_INSTRUMENT_SINK  /* A sink attached with rxc_flow_to or rxc_source_to */
+};
+
+/**
+ * A point-in-time copy of the counters of an instrumented stage.
+ */
+struct rxc_instrument_snapshot {
+    /**
+     * The identifier of the stage, in order of construction.
+     */
+    long id;
+
+    /**
+     * The kind of the stage.
+     */
+    enum rxc_instrument_kind kind;
+
+    /**
+     * The amount of elements pushed into the stage, which equals the amount of
+     * demand that has been satisfied.
+     */
+    unsigned long pushed;
+
+    /**
+     * The amount of elements requested by the stage. Unbounded requests are
+     * counted as <code>LONG_MAX</code>.
+     */
+    unsigned long requested;
+
+    /**
+     * The time in nanoseconds upstream was blocked on the stage, i.e. the
+     * time the stage had no outstanding demand while connected.
+     */
+    unsigned long blocked;
+
+    /**
+     * The histogram of the time in nanoseconds spent in the push callback of
+     * the stage, including the stages it synchronously pushes into.
+     */
+    unsigned long histogram[RXC_INSTRUMENT_BUCKETS];
+};
+
+/**
+ * Enable or disable the instrumentation of the stages that are constructed
+ * afterwards through <code>rxc_source_via</code>, <code>rxc_flow_to</code> and
+ * <code>rxc_source_to</code>. Instrumentation is disabled by default, in which
+ * case constructing a stage costs a single check.
+ *
+ * @param[in] enabled A flag to indicate whether to instrument new stages.
+ */
+void rxc_instrument_enable(int enabled);
+
+/**
+ * Determine whether new stages are instrumented.
+ *
+ * @return A non-zero value if instrumentation is enabled.
+ */
+int rxc_instrument_enabled(void);
+
+/**
+ * Wrap the specified source, so that the elements it pushes into any sink it
+ * is connected to are recorded.
+ *
+ * @param[in] source The source to instrument.
+ * @param[in] kind The kind of stage the source is connected to.
+ * @return The instrumented source or <code>NULL</code> on allocation failure.
+ */
+struct rxc_source * rxc_instrument_source(struct rxc_source *source,
+                                          enum rxc_instrument_kind kind);
+
+/**
+ * Wrap the specified sink, so that the elements it receives are recorded.
+ *
+ * @param[in] sink The sink to instrument.
+ * @param[in] kind The kind of the stage.
+ * @return The instrumented sink or <code>NULL</code> on allocation failure.
+ */
+struct rxc_sink * rxc_instrument_sink(struct rxc_sink *sink,
+                                      enum rxc_instrument_kind kind);
+
+/**
+ * Take a snapshot of the live instrumented stages. This may be called from any
+ * thread while the stages are running.
+ *
+ * @param[out] snapshots The array to write the snapshots to.
+ * @param[in] max The maximum amount of snapshots to write.
+ * @return The amount of live instrumented stages, which may exceed
+ * <code>max</code>.
+ */
+long rxc_instrument_snapshot(struct rxc_instrument_snapshot *snapshots, long max);
+
+/**
+ * Estimate the push latency at the specified quantile from a snapshot.
+ *
+ * @param[in] snapshot The snapshot to read the histogram of.
+ * @param[in] quantile The quantile in the range [0, 1].
+ * @return The latency in nanoseconds or <code>0</code> if no elements were
+ * recorded.
+ */
+unsigned long rxc_instrument_quantile(const struct rxc_instrument_snapshot *snapshot,
+                                      double quantile);
+
+#endif /* RXC_INSTRUMENT_H */
@@ -2,6 +2,7 @@
 #define RXC_LOGIC_H
 
 #include <rxc/rxc.h>
+#include <rxc/value.h>
 
 /**
  * An inlet represents a one-to-one lifecycle of a sink connecting to a source
@@ -78,6 +79,17 @@ struct rxc_sink_logic {
      */
     void (*on_push)(struct rxc_sink_logic *self, void *element);
 
+    /**
+     * This function is invoked when a new element is available from the source
+     * by value. Logic objects that do not accept values set this member to
+     * <code>NULL</code>, in which case values are boxed and passed to
+     * <code>on_push</code> instead.
+     *
+     * @param[in] self The reference to this handler.
+     * @param[in] value The value that has been pushed.
+     */
+    void (*on_push_value)(struct rxc_sink_logic *self, struct rxc_value value);
+
     /**
      * This function is invoked when the source has finished.
      *
@@ -94,6 +106,36 @@ struct rxc_sink_logic {
     void (*on_upstream_failure)(struct rxc_sink_logic *self, void *failure);
 };
 
+/**
+ * Box the specified value and push it into the given logic, which does not
+ * accept values.
+ *
+ * @param[in] logic The logic to push the value into.
+ * @param[in] value The value to push.
+ * @return <code>RXC_EOK</code> on success, an error code otherwise.
+ */
+int rxc_sink_logic_push_boxed(struct rxc_sink_logic *logic, struct rxc_value value);
+
+/**
+ * Push the specified value into the given logic, boxing it if the logic does
+ * not accept values. This is meant for stages that forward the elements they
+ * receive to an inner logic.
+ *
+ * @param[in] logic The logic to push the value into.
+ * @param[in] value The value to push.
+ * @return <code>RXC_EOK</code> on success, an error code otherwise.
+ */
+static inline int rxc_sink_logic_push_value(struct rxc_sink_logic *logic,
+                                            struct rxc_value value)
+{
+    if (logic->on_push_value) {
+        logic->on_push_value(logic, value);
+        return RXC_EOK;
+    }
+
+    return rxc_sink_logic_push_boxed(logic, value);
+}
+
 /**
  * A helper structure that manages the stream control for a source and exposes
  * a simple outlet interface to communicate with the sink.
@@ -130,6 +172,23 @@ struct rxc_connection {
 void rxc_connection_create(struct rxc_source_logic *source,
                            struct rxc_sink_logic *sink);
 
+/**
+ * Determine the connection that exposes the specified inlet.
+ *
+ * @param[in] in The inlet to determine the connection of.
+ * @return The connection or <code>NULL</code> if the inlet is exposed by
+ * something else, e.g. a stage that controls the stream itself.
+ */
+struct rxc_connection * rxc_inlet_connection(struct rxc_inlet *in);
+
+/**
+ * Deallocate the specified connection together with the source and sink logic
+ * it connects. The connection must have terminated.
+ *
+ * @param[in] conn The connection to deallocate.
+ */
+void rxc_connection_dealloc(struct rxc_connection *conn);
+
 /**
  * An outlet represents a one-to-one lifecycle of a sink connecting to a source
  * from the source's viewpoint and allows the source to emit elements.
@@ -192,6 +251,16 @@ int rxc_outlet_available(struct rxc_outlet *out);
  */
 int rxc_outlet_emit(struct rxc_outlet *out, void *element);
 
+/**
+ * Emit the given value from the given source. Sinks that do not accept values
+ * receive the value boxed on the heap.
+ *
+ * @param[in] out The outlet to emit the value to.
+ * @param[in] value The value to emit.
+ * @return <code>RXC_EOK</code> on success, an error code otherwise.
+ */
+int rxc_outlet_emit_value(struct rxc_outlet *out, struct rxc_value value);
+
 /**
  * Signal a failure that occurred in the stage to the upstream sink.
  *
@@ -1,6 +1,52 @@
 #ifndef RXC_OPS_CORE_H
 #define RXC_OPS_CORE_H
 
+#include <stddef.h>
+
+#include <rxc/value.h>
+
+/**
+ * The strategies to deal with elements that arrive at a full buffer.
+ */
+enum rxc_overflow_strategy {
+    RXC_OVERFLOW_BACKPRESSURE, /* Only request what fits into the buffer */
+    RXC_OVERFLOW_DROP_OLDEST, /* Discard the oldest element in the buffer */
+    RXC_OVERFLOW_DROP_NEWEST, /* Discard the element that has arrived */
+    RXC_OVERFLOW_FAIL         /* Cancel upstream and fail downstream */
+};
+
+/**
+ * A group of elements emitted by <code>rxc_flow_grouped_within</code>.
+ * Downstream owns the batch and its elements, and releases the batch with
+ * <code>free</code> once it has released the elements.
+ */
+struct rxc_batch {
+    /**
+     * The amount of elements in the batch.
+     */
+    long count;
+
+    /**
+     * The sum of the weights of the elements in the batch.
+     */
+    size_t bytes;
+
+    /**
+     * The elements in upstream order.
+     */
+    void *elements[];
+};
+
+/**
+ * Create a source that emits the integers in the range [from, to) by value.
+ * Sinks that do not accept values receive each integer boxed as a
+ * <code>long</code> that they release with <code>free</code>.
+ *
+ * @param[in] from The first integer to emit.
+ * @param[in] to The integer at which to stop.
+ * @return The source that has been created or <code>NULL</code> on allocation
+ * failure.
+ */
 struct rxc_source * rxc_source_count(long from, long to);
 
 /**
@@ -49,9 +95,179 @@ struct rxc_flow * rxc_flow_wrapper(struct rxc_sink * (*wrap)(struct rxc_sink *,
 /**
  * Apply the given mapping over each element in the flow.
  *
+ * The mapping may return <code>NULL</code> to drop an element, for instance
+ * when it cannot be mapped, in which case another element is requested from
+ * upstream in its place.
+ *
  * @param[in] mapping The mapping to apply.
  * @return The flow that applies the mapping.
  */
 struct rxc_flow * rxc_flow_map(void * (*mapping)(void *));
 
+/**
+ * Apply the given mapping over each element in the flow by value, so that no
+ * element needs to be boxed. Elements that arrive by reference are passed to
+ * the mapping as pointer values.
+ *
+ * @param[in] mapping The mapping to apply.
+ * @return The flow that applies the mapping or <code>NULL</code> on
+ * allocation failure.
+ */
+struct rxc_flow * rxc_flow_map_value(struct rxc_value (*mapping)(struct rxc_value));
+
+/**
+ * Apply the given mapping over each element in the flow, threading a state
+ * through the elements. Each time the flow is materialized, a fresh state is
+ * created, which is deallocated once upstream terminates.
+ *
+ * The mapping may return <code>NULL</code> to absorb an element into its
+ * state without emitting anything, in which case another element is requested
+ * from upstream in its place.
+ *
+ * @param[in] create The function to create the state with from the specified
+ * context, which returns <code>NULL</code> on allocation failure.
+ * @param[in] mapping The mapping to apply with the state of the pipeline.
+ * @param[in] dealloc The function to deallocate the state with.
+ * @param[in] ctx The context to create the state with, which must outlive the
+ * flow.
+ * @return The flow that applies the mapping or <code>NULL</code> on
+ * allocation failure.
+ */
+struct rxc_flow * rxc_flow_map_state(void * (*create)(void *ctx),
+                                     void * (*mapping)(void *state, void *element),
+                                     void (*dealloc)(void *state), void *ctx);
+
+/**
+ * Apply the given mapping over each element in the flow, threading a state
+ * through the elements like <code>rxc_flow_map_state</code>, and flush the
+ * state once upstream finishes. The element the state is flushed into, if
+ * any, is emitted as soon as downstream requests it, after which downstream
+ * finishes. The state is not flushed when upstream fails or downstream
+ * cancels.
+ *
+ * @param[in] create The function to create the state with from the specified
+ * context, which returns <code>NULL</code> on allocation failure.
+ * @param[in] mapping The mapping to apply with the state of the pipeline.
+ * @param[in] flush The function to flush the state into a final element with,
+ * which returns <code>NULL</code> if there is nothing left to emit.
+ * @param[in] dealloc The function to deallocate the state with.
+ * @param[in] ctx The context to create the state with, which must outlive the
+ * flow.
+ * @return The flow that applies the mapping or <code>NULL</code> on
+ * allocation failure.
+ */
+struct rxc_flow * rxc_flow_map_state_flush(void * (*create)(void *ctx),
+                                           void * (*mapping)(void *state, void *element),
+                                           void * (*flush)(void *state),
+                                           void (*dealloc)(void *state), void *ctx);
+
+/**
+ * Apply the given mapping over each element in the flow, running it for up to
+ * <code>parallelism</code> elements concurrently on workers of the specified
+ * scheduler, and emit the results in upstream order.
+ *
+ * At most <code>parallelism</code> elements are requested from upstream that
+ * have not been emitted downstream, so backpressure is preserved. The stage
+ * pulls upstream and emits downstream on a worker of its own, so that
+ * downstream may observe its elements on a different thread than upstream.
+ *
+ * The stage may be deallocated while mappings are still running, in which
+ * case their results are discarded once they complete. The workers of the
+ * scheduler must therefore run the tasks that are queued when they are
+ * deallocated, as those of <code>rxc_scheduler_thread_pool</code> do.
+ *
+ * @param[in] mapping The mapping to apply, which must be safe to run
+ * concurrently.
+ * @param[in] parallelism The maximum amount of elements mapped concurrently.
+ * @param[in] scheduler The scheduler to run the mapping on, e.g. a thread pool.
+ * @param[in] discard The function to release discarded elements with or
+ * <code>NULL</code> to use <code>free</code>.
+ * @return The flow or <code>NULL</code> on allocation failure or invalid
+ * arguments.
+ */
+struct rxc_flow * rxc_flow_map_parallel(void * (*mapping)(void *), long parallelism,
+                                        struct rxc_scheduler *scheduler,
+                                        void (*discard)(void *element));
+
+/**
+ * Create an asynchronous boundary that splits the pipeline across two workers
+ * of the specified scheduler, which may run on different threads.
+ *
+ * Elements cross the boundary through a bounded, lock-free single-producer/
+ * single-consumer ring. Upstream is pulled to fill the ring and is pulled
+ * again for every slot that downstream drains. Upstream must be driven by a
+ * single thread at a time, as must downstream.
+ *
+ * @param[in] capacity The amount of elements the boundary may hold.
+ * @param[in] scheduler The scheduler to create the workers of both sides with.
+ * @param[in] discard The function to release discarded elements with or
+ * <code>NULL</code> to use <code>free</code>.
+ * @return The flow or <code>NULL</code> on allocation failure.
+ */
+struct rxc_flow * rxc_flow_async(long capacity, struct rxc_scheduler *scheduler,
+                                 void (*discard)(void *element));
+
+/**
+ * Create a flow that buffers up to <code>size</code> elements from upstream in
+ * a bounded queue and serves downstream demand from that queue.
+ *
+ * With <code>RXC_OVERFLOW_BACKPRESSURE</code>, the buffer prefetches elements
+ * and refills the queue with a single bulk request once the amount of queued
+ * and requested elements drops to the low watermark, so that the queue never
+ * overflows. Elements that upstream emits beyond its requests are discarded.
+ *
+ * With the other strategies, the buffer requests upstream without bounds so
+ * that upstream may run ahead of downstream, and applies the strategy to the
+ * elements that arrive while the queue is full.
+ *
+ * @param[in] size The maximum amount of elements to buffer.
+ * @param[in] low_watermark The amount of elements below which the buffer is
+ * refilled, which must be smaller than the size. It only applies to
+ * <code>RXC_OVERFLOW_BACKPRESSURE</code>.
+ * @param[in] overflow The strategy to apply when the buffer is full.
+ * @param[in] discard The function to release discarded elements with or
+ * <code>NULL</code> to use <code>free</code>.
+ * @return The flow or <code>NULL</code> on allocation failure or invalid
+ * arguments.
+ */
+struct rxc_flow * rxc_flow_buffer(long size, long low_watermark,
+                                  enum rxc_overflow_strategy overflow,
+                                  void (*discard)(void *element));
+
+/**
+ * Group the elements of the flow into batches of type
+ * <code>struct rxc_batch</code>. A batch is closed when it holds
+ * <code>max_elements</code> elements or when its weight reaches
+ * <code>max_bytes</code>; an element that would push the batch past the byte
+ * limit starts a new batch instead. A batch that has not reached either limit
+ * is emitted once <code>max_delay</code> milliseconds have passed since its
+ * first element arrived and downstream has demand, or when upstream
+ * terminates.
+ *
+ * Upstream is pulled ahead of downstream demand to fill the open batch, but
+ * not while a closed batch waits for demand, so the stage holds at most
+ * <code>max_elements</code> elements.
+ *
+ * The time limit is enforced by a worker of an event-loop scheduler. The stage
+ * must then be driven on the thread that runs that event loop, for instance by
+ * starting the pipeline on the same scheduler.
+ *
+ * @param[in] max_elements The maximum amount of elements in a batch.
+ * @param[in] max_bytes The maximum weight of a batch.
+ * @param[in] max_delay The time in milliseconds after which an incomplete
+ * batch is emitted, or <code>0</code> to wait until a batch is full.
+ * @param[in] weigh The function to determine the weight of an element with or
+ * <code>NULL</code> to disable the byte limit.
+ * @param[in] discard The function to release discarded elements with or
+ * <code>NULL</code> to use <code>free</code>.
+ * @param[in] scheduler The event-loop scheduler to enforce the time limit
+ * with, which may be <code>NULL</code> if there is no time limit.
+ * @return The flow or <code>NULL</code> on allocation failure or invalid
+ * arguments.
+ */
+struct rxc_flow * rxc_flow_grouped_within(long max_elements, size_t max_bytes, long max_delay,
+                                          size_t (*weigh)(void *element),
+                                          void (*discard)(void *element),
+                                          struct rxc_scheduler *scheduler);
+
 #endif /* RXC_OPS_CORE_H */
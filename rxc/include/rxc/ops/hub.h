@@ -0,0 +1,150 @@
+#ifndef RXC_OPS_HUB_H
+#define RXC_OPS_HUB_H
+
+#include <rxc/rxc.h>
+
+/**
+ * The policies that determine how a broadcast hub treats consumers that lag
+ * behind the others.
+ */
+enum rxc_hub_lag_policy {
+    RXC_HUB_LAG_SLOWEST, /* Pull upstream at the pace of the slowest consumer */
+    RXC_HUB_LAG_SKIP,    /* Let lagging consumers skip the elements they miss */
+    RXC_HUB_LAG_DETACH   /* Complete the streams of lagging consumers */
+};
+
+/**
+ * A hub that feeds the elements of a single upstream source to a dynamic set
+ * of attached consumers.
+ */
+struct rxc_hub_broadcast;
+
+/**
+ * Create a broadcast hub for the specified upstream source.
+ *
+ * Every element is shared by reference between the consumers: each consumer
+ * receives the reference returned by <code>retain</code> and the hub drops its
+ * own reference with <code>release</code> once all attached consumers have
+ * received the element. Without a retain function, consumers only borrow the
+ * elements for the duration of their push callback.
+ *
+ * The upstream source is connected when the first consumer attaches, and
+ * consumers start receiving the elements that arrive after they attached.
+ * The hub deallocates the logic of the sink of a consumer once the consumer
+ * has terminated or the hub is deallocated.
+ *
+ * @param[in] upstream The source to broadcast the elements of.
+ * @param[in] size The maximum amount of elements buffered by the hub.
+ * @param[in] lag The policy for consumers that fall a full buffer behind.
+ * @param[in] retain The function to create a reference for a consumer with or
+ * <code>NULL</code> to lend elements to consumers.
+ * @param[in] release The function to release the reference of the hub with or
+ * <code>NULL</code> to not release elements.
+ * @return The hub or <code>NULL</code> on allocation failure.
+ */
+struct rxc_hub_broadcast * rxc_hub_broadcast(struct rxc_source *upstream, long size,
+                                             enum rxc_hub_lag_policy lag,
+                                             void * (*retain)(void *element),
+                                             void (*release)(void *element));
+
+/**
+ * Obtain the source through which consumers attach to the hub. Every sink
+ * connected to this source becomes a consumer of the hub.
+ *
+ * The source is owned by the hub; deallocating it has no effect.
+ *
+ * @param[in] hub The hub to obtain the source of.
+ * @return The source of the hub.
+ */
+struct rxc_source * rxc_hub_broadcast_source(struct rxc_hub_broadcast *hub);
+
+/**
+ * Determine the amount of consumers attached to the specified hub.
+ *
+ * @param[in] hub The hub to count the consumers of.
+ * @return The amount of attached consumers.
+ */
+long rxc_hub_broadcast_consumers(struct rxc_hub_broadcast *hub);
+
+/**
+ * Deallocate the specified hub, canceling upstream and releasing the elements
+ * it still holds. The logic of the upstream source and its connection to the
+ * hub are deallocated as well, provided the source connected to the hub
+ * directly.
+ *
+ * @param[in] hub The hub to deallocate.
+ */
+void rxc_hub_broadcast_dealloc(struct rxc_hub_broadcast *hub);
+
+/**
+ * A hub that merges the elements of a dynamic set of attached sources into a
+ * single stream.
+ */
+struct rxc_hub_merge;
+
+/**
+ * Create a merge hub.
+ *
+ * Every attached source is given an equal share of demand: the
+ * <code>size</code> elements the hub may have in flight are split between the
+ * inputs, with at least one element for each input, and the inputs are served
+ * round-robin, one element at a time. An input that finishes or fails only
+ * terminates itself; its buffered elements are still emitted. Once an input
+ * has been drained, the logic of its source and its connection to the hub are
+ * deallocated as well, provided the source connected to the hub directly.
+ *
+ * @param[in] size The amount of elements the inputs may have in flight.
+ * @param[in] discard The function to release discarded elements with or
+ * <code>NULL</code> to use <code>free</code>.
+ * @return The hub or <code>NULL</code> on allocation failure.
+ */
+struct rxc_hub_merge * rxc_hub_merge(long size, void (*discard)(void *element));
+
+/**
+ * Obtain the sink through which sources attach to the hub. Every source that
+ * connects to this sink becomes an input of the hub.
+ *
+ * The sink is owned by the hub; deallocating it has no effect.
+ *
+ * @param[in] hub The hub to obtain the sink of.
+ * @return The sink of the hub.
+ */
+struct rxc_sink * rxc_hub_merge_sink(struct rxc_hub_merge *hub);
+
+/**
+ * Obtain the source that emits the merged stream. The source can only be
+ * connected once.
+ *
+ * The source is owned by the hub; deallocating it has no effect.
+ *
+ * @param[in] hub The hub to obtain the source of.
+ * @return The source of the hub.
+ */
+struct rxc_source * rxc_hub_merge_source(struct rxc_hub_merge *hub);
+
+/**
+ * Determine the amount of inputs attached to the specified hub.
+ *
+ * @param[in] hub The hub to count the inputs of.
+ * @return The amount of attached inputs.
+ */
+long rxc_hub_merge_inputs(struct rxc_hub_merge *hub);
+
+/**
+ * Mark the specified hub as closed, so that the merged stream completes once
+ * all of its current inputs have finished.
+ *
+ * @param[in] hub The hub to close.
+ */
+void rxc_hub_merge_close(struct rxc_hub_merge *hub);
+
+/**
+ * Deallocate the specified hub, canceling its inputs and releasing the
+ * elements it still holds, as well as the logic of the sink of the merged
+ * stream.
+ *
+ * @param[in] hub The hub to deallocate.
+ */
+void rxc_hub_merge_dealloc(struct rxc_hub_merge *hub);
+
+#endif /* RXC_OPS_HUB_H */
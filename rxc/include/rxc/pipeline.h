@@ -3,6 +3,11 @@
 
 #include <rxc/scheduler.h>
 
+/**
+ * An opaque block of memory in which a pipeline is materialized.
+ */
+struct rxc_arena;
+
 /**
  * A closed, runnable pipeline through which elements can flow.
  */
@@ -16,6 +21,12 @@ struct rxc_pipeline {
      * The sink of the pipeline.
      */
     struct rxc_sink *sink;
+
+    /**
+     * The arena of the pipeline if it was materialized from a blueprint,
+     * otherwise <code>NULL</code>.
+     */
+    struct rxc_arena *arena;
 };
 
 /**
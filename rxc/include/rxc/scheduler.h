@@ -58,6 +58,23 @@ struct rxc_scheduler_worker {
     void (*schedule)(struct rxc_scheduler_worker *self,
                      void (*runnable)(void *),
                      void *ctx);
+
+    /**
+     * Run a task on the calling thread right away if the worker is idle, as
+     * well as the tasks scheduled on the worker while it runs. This allows
+     * callers to skip queueing a task when it would run immediately anyway.
+     * Workers that cannot run tasks on the calling thread set this member to
+     * <code>NULL</code>.
+     *
+     * @param[in] self The reference to this scheduler worker object.
+     * @param[in] runnable The runnable to run.
+     * @param[in] ctx The context passed to the runnable.
+     * @return <code>1</code> if the task has run, <code>0</code> if the worker
+     * is busy and the task must be scheduled instead.
+     */
+    int (*try_run)(struct rxc_scheduler_worker *self,
+                   void (*runnable)(void *),
+                   void *ctx);
 };
 
 /**
@@ -0,0 +1,107 @@
+#ifndef RXC_SCHEDULERS_EVENTLOOP_H
+#define RXC_SCHEDULERS_EVENTLOOP_H
+
+#include <rxc/scheduler.h>
+
+#define RXC_EVENTLOOP_READABLE (1 << 0) /* The descriptor can be read from */
+#define RXC_EVENTLOOP_WRITABLE (1 << 1) /* The descriptor can be written to */
+#define RXC_EVENTLOOP_ERROR    (1 << 2) /* An error or hang-up occurred */
+
+/**
+ * A worker of an event-loop scheduler, which in addition to running tasks as
+ * soon as possible is able to run tasks after a delay and when a file
+ * descriptor becomes ready.
+ *
+ * Workers created by <code>rxc_scheduler_eventloop</code> can be cast to this
+ * structure.
+ */
+struct rxc_scheduler_eventloop_worker {
+    struct rxc_scheduler_worker base;
+
+    /**
+     * Schedule a task for execution after the specified delay.
+     *
+     * @param[in] self The reference to this scheduler worker object.
+     * @param[in] runnable The runnable to schedule.
+     * @param[in] ctx The context passed to the runnable.
+     * @param[in] delay The delay in milliseconds after which to run the task.
+     * @return A positive identifier of the timer or <code>-1</code> on failure.
+     */
+    long (*schedule_delayed)(struct rxc_scheduler_eventloop_worker *self,
+                             void (*runnable)(void *),
+                             void *ctx,
+                             long delay);
+
+    /**
+     * Cancel a task that was scheduled with a delay, if it has not run yet.
+     *
+     * @param[in] self The reference to this scheduler worker object.
+     * @param[in] id The identifier of the timer to cancel.
+     */
+    void (*cancel_delayed)(struct rxc_scheduler_eventloop_worker *self, long id);
+
+    /**
+     * Invoke the specified callback whenever the given file descriptor is
+     * ready for one of the specified events, until the descriptor is
+     * unwatched. A descriptor can only be watched once.
+     *
+     * @param[in] self The reference to this scheduler worker object.
+     * @param[in] fd The file descriptor to watch.
+     * @param[in] events A mask of <code>RXC_EVENTLOOP_*</code> events to watch.
+     * @param[in] callback The callback to invoke with the events that occurred.
+     * @param[in] ctx The context passed to the callback.
+     * @return <code>RXC_EOK</code> on success, an error code otherwise.
+     */
+    int (*watch_fd)(struct rxc_scheduler_eventloop_worker *self,
+                    int fd,
+                    int events,
+                    void (*callback)(void *ctx, int events),
+                    void *ctx);
+
+    /**
+     * Stop watching the specified file descriptor.
+     *
+     * @param[in] self The reference to this scheduler worker object.
+     * @param[in] fd The file descriptor to stop watching.
+     */
+    void (*unwatch_fd)(struct rxc_scheduler_eventloop_worker *self, int fd);
+};
+
+/**
+ * Create a scheduler whose workers queue their work on a single event loop
+ * backed by epoll and a timerfd. Work only runs while the loop is run by
+ * <code>rxc_scheduler_eventloop_run</code> or
+ * <code>rxc_scheduler_eventloop_run_once</code>, on the thread that runs it.
+ *
+ * @return The scheduler or <code>NULL</code> on failure.
+ */
+struct rxc_scheduler * rxc_scheduler_eventloop(void);
+
+/**
+ * Run a single iteration of the event loop: run the queued tasks and expired
+ * timers, then wait for file descriptor readiness or the next timer.
+ *
+ * @param[in] scheduler The event-loop scheduler to run.
+ * @param[in] timeout The maximum time to wait in milliseconds or
+ * <code>-1</code> to wait indefinitely.
+ * @return <code>RXC_EOK</code> on success, an error code otherwise.
+ */
+int rxc_scheduler_eventloop_run_once(struct rxc_scheduler *scheduler, long timeout);
+
+/**
+ * Run the event loop until it is stopped or runs out of tasks, timers and
+ * watched file descriptors.
+ *
+ * @param[in] scheduler The event-loop scheduler to run.
+ * @return <code>RXC_EOK</code> on success, an error code otherwise.
+ */
+int rxc_scheduler_eventloop_run(struct rxc_scheduler *scheduler);
+
+/**
+ * Stop the event loop after its current iteration.
+ *
+ * @param[in] scheduler The event-loop scheduler to stop.
+ */
+void rxc_scheduler_eventloop_stop(struct rxc_scheduler *scheduler);
+
+#endif /* RXC_SCHEDULERS_EVENTLOOP_H */
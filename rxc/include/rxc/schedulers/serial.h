@@ -0,0 +1,22 @@
+#ifndef RXC_SCHEDULERS_SERIAL_H
+#define RXC_SCHEDULERS_SERIAL_H
+
+#include <rxc/scheduler.h>
+
+/**
+ * Create a scheduler whose workers are serial executors that any thread may
+ * schedule tasks on. The tasks of a worker run one at a time in the order they
+ * were scheduled, on the thread that schedules a task while the worker is
+ * idle. That thread keeps running tasks until the queue of the worker is
+ * empty, so tasks scheduled by other threads in the meantime, or recursively
+ * by the tasks themselves, run on the draining thread instead.
+ *
+ * Tasks are queued on a lock-free multiple-producer/single-consumer queue, so
+ * scheduling never blocks. A worker must not be deallocated while it is
+ * running tasks.
+ *
+ * @return The scheduler or <code>NULL</code> on allocation failure.
+ */
+struct rxc_scheduler * rxc_scheduler_serial(void);
+
+#endif /* RXC_SCHEDULERS_SERIAL_H */
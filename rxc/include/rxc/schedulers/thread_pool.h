@@ -0,0 +1,27 @@
+#ifndef RXC_SCHEDULERS_THREAD_POOL_H
+#define RXC_SCHEDULERS_THREAD_POOL_H
+
+#include <rxc/scheduler.h>
+
+/**
+ * Create a scheduler backed by a fixed pool of threads. Every worker of the
+ * scheduler remains sequential: its tasks run one at a time in the order they
+ * were scheduled, but possibly on different threads of the pool. Tasks of
+ * different workers run in parallel.
+ *
+ * Every worker keeps a reserve of task nodes, so that scheduling a task does
+ * not allocate, and thus cannot fail, while the worker has at most four tasks
+ * that are queued or running. Beyond that, a task is dropped if its node
+ * cannot be allocated.
+ *
+ * Workers may be deallocated while they still have queued tasks, in which
+ * case they are released once those tasks have run, but must be deallocated
+ * before the scheduler. Deallocating the scheduler stops the threads after
+ * the tasks they are running; queued tasks are discarded.
+ *
+ * @param[in] threads The amount of threads in the pool.
+ * @return The scheduler or <code>NULL</code> on failure.
+ */
+struct rxc_scheduler * rxc_scheduler_thread_pool(int threads);
+
+#endif /* RXC_SCHEDULERS_THREAD_POOL_H */
@@ -0,0 +1,88 @@
+#ifndef RXC_TRACE_H
+#define RXC_TRACE_H
+
+#include <stdatomic.h>
+
+/**
+ * The amount of events kept per thread. Older events are overwritten, where
+ * the dump leaves out the ends of spans whose beginning was overwritten.
+ */
+#define RXC_TRACE_CAPACITY 16384
+
+/**
+ * A flag to indicate whether events are recorded. Use
+ * <code>rxc_trace_enable</code> to change it.
+ */
+extern atomic_int rxc_trace_active;
+
+/**
+ * Record the beginning of a span on the current thread, if tracing is enabled.
+ */
+#define RXC_TRACE_BEGIN(name, arg) \
+    do { \
+        if (atomic_load_explicit(&rxc_trace_active, memory_order_relaxed)) \
+            rxc_trace_record('B', name, arg); \
+    } while (0)
+
+/**
+ * Record the end of the span that was most recently begun on the current
+ * thread, if tracing is enabled.
+ */
+#define RXC_TRACE_END(name, arg) \
+    do { \
+        if (atomic_load_explicit(&rxc_trace_active, memory_order_relaxed)) \
+            rxc_trace_record('E', name, arg); \
+    } while (0)
+
+/**
+ * Record an instantaneous event on the current thread, if tracing is enabled.
+ */
+#define RXC_TRACE_INSTANT(name, arg) \
+    do { \
+        if (atomic_load_explicit(&rxc_trace_active, memory_order_relaxed)) \
+            rxc_trace_record('i', name, arg); \
+    } while (0)
+
+/**
+ * Enable tracing, recording the events of each thread into a ring of that
+ * thread, or disable it.
+ *
+ * @param[in] path The file to dump the trace to or <code>NULL</code> to
+ * disable tracing. The string must remain valid while tracing is enabled.
+ */
+void rxc_trace_enable(const char *path);
+
+/**
+ * Record an event in the ring of the current thread. Prefer the
+ * <code>RXC_TRACE_*</code> macros, which skip the call when tracing is
+ * disabled.
+ *
+ * @param[in] phase The phase of the event in the Chrome trace format.
+ * @param[in] name The name of the event, which must be a string literal.
+ * @param[in] arg An argument recorded with the event.
+ */
+void rxc_trace_record(char phase, const char *name, long arg);
+
+/**
+ * Dump the events recorded by all threads as Chrome trace JSON (viewable in
+ * Perfetto or chrome://tracing) to the file given to
+ * <code>rxc_trace_enable</code>.
+ *
+ * @return <code>RXC_EOK</code> on success, an error code otherwise.
+ */
+int rxc_trace_dump(void);
+
+/**
+ * Request a dump of the trace by the next call to <code>rxc_trace_poll</code>.
+ * This function is async-signal-safe.
+ */
+void rxc_trace_request_dump(void);
+
+/**
+ * Dump the trace if a dump was requested since the last poll.
+ *
+ * @return <code>RXC_EOK</code> on success, an error code otherwise.
+ */
+int rxc_trace_poll(void);
+
+#endif /* RXC_TRACE_H */
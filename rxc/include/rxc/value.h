@@ -0,0 +1,111 @@
+#ifndef RXC_VALUE_H
+#define RXC_VALUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * The kinds of payload an element value may carry.
+ */
+enum rxc_value_tag {
+    RXC_VALUE_POINTER, /* A reference to an element on the heap */
+    RXC_VALUE_LONG,    /* A signed integer */
+    RXC_VALUE_DOUBLE,  /* A floating point number */
+    RXC_VALUE_BYTES    /* Up to eight bytes of a fixed-size structure */
+};
+
+/**
+ * An element passed by value, which carries small scalars and fixed-size
+ * structures inline instead of boxing them on the heap.
+ */
+struct rxc_value {
+    /**
+     * The kind of payload of the value.
+     */
+    enum rxc_value_tag tag;
+
+    union {
+        void *pointer;
+        long integer;
+        double real;
+        uint8_t bytes[8];
+    } as;
+};
+
+/**
+ * Construct a value that refers to an element on the heap.
+ */
+static inline struct rxc_value rxc_value_pointer(void *pointer)
+{
+    struct rxc_value value;
+    value.tag = RXC_VALUE_POINTER;
+    value.as.pointer = pointer;
+    return value;
+}
+
+/**
+ * Construct a value that carries an integer.
+ */
+static inline struct rxc_value rxc_value_long(long integer)
+{
+    struct rxc_value value;
+    value.tag = RXC_VALUE_LONG;
+    value.as.integer = integer;
+    return value;
+}
+
+/**
+ * Construct a value that carries a floating point number.
+ */
+static inline struct rxc_value rxc_value_double(double real)
+{
+    struct rxc_value value;
+    value.tag = RXC_VALUE_DOUBLE;
+    value.as.real = real;
+    return value;
+}
+
+/**
+ * Construct a value that carries a copy of the specified bytes, of which
+ * there must be at most eight. Use <code>rxc_value_bytes</code> instead, which
+ * checks the size at compile time.
+ *
+ * @param[in] bytes The bytes to copy into the value.
+ * @param[in] size The amount of bytes to copy.
+ */
+static inline struct rxc_value rxc_value_copy(const void *bytes, size_t size)
+{
+    struct rxc_value value;
+    value.tag = RXC_VALUE_BYTES;
+    memset(value.as.bytes, 0, sizeof(value.as.bytes));
+    memcpy(value.as.bytes, bytes, size);
+    return value;
+}
+
+/**
+ * Construct a value that carries a copy of the specified fixed-size
+ * structure, of which the bytes past the structure are zeroed. Structures of
+ * more than eight bytes are rejected at compile time rather than truncated.
+ *
+ * @param[in] object The structure to copy into the value, which must be an
+ * lvalue.
+ */
+#define rxc_value_bytes(object) \
+    rxc_value_copy(&(object), sizeof(struct { \
+        _Static_assert(sizeof(object) <= 8, "structure does not fit in a value"); \
+        char bytes[sizeof(object)]; \
+    }))
+
+/**
+ * Box the specified value, so that it can be passed to a sink that only
+ * accepts elements by reference. Pointer values are returned as they are,
+ * while any other payload is copied into a heap allocation that the receiver
+ * releases with <code>free</code>.
+ *
+ * @param[in] value The value to box.
+ * @return The boxed element or <code>NULL</code> on allocation failure.
+ */
+void * rxc_value_box(struct rxc_value value);
+
+#endif /* RXC_VALUE_H */
@@ -0,0 +1,67 @@
+#include <stdlib.h>
+#include <stddef.h>
+
+#include <rxc/alloc.h>
+
+#include "arena.h"
+
+#define ARENA_ALIGNMENT _Alignof(max_align_t)
+
+/**
+ * The arena that serves the allocations of this thread, if any.
+ */
+static _Thread_local struct rxc_arena *active;
+
+/**
+ * The arena whose pipeline is being deallocated on this thread, if any.
+ */
+static _Thread_local struct rxc_arena *releasing;
+
+static int arena_contains(struct rxc_arena *arena, void *ptr)
+{
+    return arena && (char *) ptr >= arena->block && (char *) ptr < arena->block + arena->size;
+}
+
+struct rxc_arena * rxc_arena_activate(struct rxc_arena *arena)
+{
+    struct rxc_arena *previous = active;
+    active = arena;
+    return previous;
+}
+
+struct rxc_arena * rxc_arena_releasing(struct rxc_arena *arena)
+{
+    struct rxc_arena *previous = releasing;
+    releasing = arena;
+    return previous;
+}
+
+void * rxc_alloc(size_t size)
+{
+    struct rxc_arena *arena = active;
+
+    if (arena) {
+        size_t aligned = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+
+        arena->used += aligned;
+
+        if (arena->size - arena->offset >= aligned) {
+            void *ptr = arena->block + arena->offset;
+            arena->offset += aligned;
+            return ptr;
+        }
+    }
+
+    /* Fall back to the heap when the block is exhausted or absent */
+    return malloc(size);
+}
+
+void rxc_free(void *ptr)
+{
+    /* Memory within a block is released together with the block */
+    if (arena_contains(active, ptr) || arena_contains(releasing, ptr)) {
+        return;
+    }
+
+    free(ptr);
+}
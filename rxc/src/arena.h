@@ -0,0 +1,61 @@
+#ifndef RXC_INTERNAL_ARENA_H
+#define RXC_INTERNAL_ARENA_H
+
+#include <stddef.h>
+
+#include <rxc/blueprint.h>
+
+/**
+ * A block of memory from which the object graph of a materialized pipeline is
+ * allocated, followed by the block itself.
+ */
+struct rxc_arena {
+    /**
+     * The blueprint the pipeline was materialized from.
+     */
+    struct rxc_blueprint *blueprint;
+
+    /**
+     * The capacity of the block and the offset of its free space.
+     */
+    size_t size, offset;
+
+    /**
+     * The amount of bytes requested from the arena, including requests that
+     * did not fit in the block.
+     */
+    size_t used;
+
+    /**
+     * The memory of the block.
+     */
+    _Alignas(max_align_t) char block[];
+};
+
+/**
+ * Make the specified arena serve the allocations of the calling thread.
+ *
+ * @param[in] arena The arena to activate or <code>NULL</code> to allocate
+ * from the heap.
+ * @return The arena that was active before.
+ */
+struct rxc_arena * rxc_arena_activate(struct rxc_arena *arena);
+
+/**
+ * Make releases of memory within the specified arena on the calling thread
+ * no-ops, while its pipeline is deallocated.
+ *
+ * @param[in] arena The arena that is being released or <code>NULL</code>.
+ * @return The arena that was being released before.
+ */
+struct rxc_arena * rxc_arena_releasing(struct rxc_arena *arena);
+
+/**
+ * Record the footprint of the specified arena in its blueprint, so that the
+ * next materialization fits in a single block.
+ *
+ * @param[in] arena The arena to learn the footprint from.
+ */
+void rxc_blueprint_learn(struct rxc_arena *arena);
+
+#endif /* RXC_INTERNAL_ARENA_H */
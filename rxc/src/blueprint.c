@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include <rxc/rxc.h>
+#include <rxc/alloc.h>
+#include <rxc/blueprint.h>
+
+#include "arena.h"
+
+struct rxc_blueprint {
+    /**
+     * The function that builds the pipelines.
+     */
+    struct rxc_pipeline * (*build)(void *ctx);
+
+    /**
+     * The largest amount of memory requested by a pipeline of the blueprint.
+     */
+    atomic_size_t footprint;
+};
+
+struct rxc_blueprint * rxc_blueprint_create(struct rxc_pipeline * (*build)(void *ctx))
+{
+    struct rxc_blueprint *blueprint = malloc(sizeof(struct rxc_blueprint));
+
+    if (!blueprint) {
+        return NULL;
+    }
+
+    blueprint->build = build;
+    atomic_init(&blueprint->footprint, 0);
+
+    return blueprint;
+}
+
+void rxc_blueprint_dealloc(struct rxc_blueprint *blueprint)
+{
+    free(blueprint);
+}
+
+void rxc_blueprint_learn(struct rxc_arena *arena)
+{
+    struct rxc_blueprint *blueprint = arena->blueprint;
+    size_t footprint = atomic_load_explicit(&blueprint->footprint, memory_order_relaxed);
+
+    /* Only ever grow the footprint, so that every pipeline fits */
+    while (footprint < arena->used &&
+           !atomic_compare_exchange_weak_explicit(&blueprint->footprint, &footprint, arena->used,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed));
+}
+
+struct rxc_pipeline * rxc_blueprint_materialize(struct rxc_blueprint *blueprint, void *ctx)
+{
+    size_t size = atomic_load_explicit(&blueprint->footprint, memory_order_relaxed);
+    struct rxc_arena *arena = malloc(sizeof(struct rxc_arena) + size);
+
+    if (!arena) {
+        return NULL;
+    }
+
+    arena->blueprint = blueprint;
+    arena->size = size;
+    arena->offset = 0;
+    arena->used = 0;
+
+    struct rxc_arena *previous = rxc_arena_activate(arena);
+    struct rxc_pipeline *pipeline = blueprint->build(ctx);
+    rxc_arena_activate(previous);
+
+    if (!pipeline) {
+        free(arena);
+        return NULL;
+    }
+
+    pipeline->arena = arena;
+    rxc_blueprint_learn(arena);
+
+    return pipeline;
+}
+
+size_t rxc_blueprint_footprint(struct rxc_blueprint *blueprint)
+{
+    return atomic_load_explicit(&blueprint->footprint, memory_order_relaxed);
+}
@@ -0,0 +1,503 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include <rxc/rxc.h>
+#include <rxc/logic.h>
+#include <rxc/alloc.h>
+#include <rxc/instrument.h>
+
+/**
+ * The counters of an instrumented stage, shared by all its materializations.
+ */
+struct instrument_stats {
+    long id;
+    enum rxc_instrument_kind kind;
+
+    /**
+     * The amount of stages and logic objects referring to the counters.
+     */
+    atomic_long refs;
+
+    atomic_ulong pushed;
+    atomic_ulong requested;
+    atomic_ulong blocked;
+    atomic_ulong histogram[RXC_INSTRUMENT_BUCKETS];
+
+    /**
+     * The neighbours in the registry of live stages.
+     */
+    struct instrument_stats *prev, *next;
+};
+
+struct instrument_sink {
+    struct rxc_sink base;
+    struct rxc_sink *inner;
+    struct instrument_stats *stats;
+};
+
+struct instrument_logic {
+    struct rxc_sink_logic base;
+
+    /**
+     * The inlet handed to the inner logic.
+     */
+    struct rxc_inlet in;
+
+    struct rxc_sink_logic *inner;
+    struct instrument_stats *stats;
+
+    /**
+     * The amount of elements requested that have not been pushed yet.
+     */
+    long outstanding;
+
+    /**
+     * The point in time since which upstream has been blocked.
+     */
+    uint64_t blocked_since;
+
+    /**
+     * A flag to indicate the connection has terminated.
+     */
+    int done;
+};
+
+struct instrument_source {
+    struct rxc_source base;
+    struct rxc_source *inner;
+    struct instrument_stats *stats;
+
+    /**
+     * The sinks created for the connections of this source.
+     */
+    struct instrument_source_sink {
+        struct instrument_sink *sink;
+        struct instrument_source_sink *next;
+    } *sinks;
+};
+
+static atomic_int enabled;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct instrument_stats *registry;
+static long registry_count;
+static long registry_next_id;
+
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int bucket(uint64_t value)
+{
+    if (value < 16) {
+        return (int) value;
+    }
+
+    int magnitude = 63 - __builtin_clzll(value);
+
+    if (magnitude >= 40) {
+        return RXC_INSTRUMENT_BUCKETS - 1;
+    }
+
+    return (magnitude - 3) * 16 + (int) ((value >> (magnitude - 4)) & 15);
+}
+
+static inline void counter_add(atomic_ulong *counter, unsigned long n)
+{
+    atomic_fetch_add_explicit(counter, n, memory_order_relaxed);
+}
+
+/* Registry */
+static struct instrument_stats * stats_create(enum rxc_instrument_kind kind)
+{
+    struct instrument_stats *stats = calloc(1, sizeof(struct instrument_stats));
+
+    if (!stats) {
+        return NULL;
+    }
+
+    stats->kind = kind;
+    atomic_init(&stats->refs, 1);
+
+    pthread_mutex_lock(&registry_lock);
+    stats->id = registry_next_id++;
+    stats->prev = NULL;
+    stats->next = registry;
+    if (registry) {
+        registry->prev = stats;
+    }
+    registry = stats;
+    registry_count++;
+    pthread_mutex_unlock(&registry_lock);
+
+    return stats;
+}
+
+static void stats_retain(struct instrument_stats *stats)
+{
+    atomic_fetch_add_explicit(&stats->refs, 1, memory_order_relaxed);
+}
+
+static void stats_release(struct instrument_stats *stats)
+{
+    if (atomic_fetch_sub_explicit(&stats->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    pthread_mutex_lock(&registry_lock);
+    if (stats->prev) {
+        stats->prev->next = stats->next;
+    } else {
+        registry = stats->next;
+    }
+    if (stats->next) {
+        stats->next->prev = stats->prev;
+    }
+    registry_count--;
+    pthread_mutex_unlock(&registry_lock);
+
+    free(stats);
+}
+
+/* Inlet */
+static void logic_unblock(struct instrument_logic *self)
+{
+    if (self->outstanding == 0 && !self->done) {
+        counter_add(&self->stats->blocked, now() - self->blocked_since);
+    }
+}
+
+static void logic_inlet_pull(struct rxc_inlet *in, long n)
+{
+    struct instrument_logic *self = (void *) ((char *) in - offsetof(struct instrument_logic, in));
+
+    if (n <= 0) {
+        return;
+    }
+
+    counter_add(&self->stats->requested, (unsigned long) n);
+    logic_unblock(self);
+
+    self->outstanding += n;
+
+    /* Cap the outstanding amount at the maximum size of a long */
+    if (self->outstanding < 0) {
+        self->outstanding = LONG_MAX;
+    }
+
+    rxc_inlet_pull(self->base.in, n);
+}
+
+static void logic_inlet_cancel(struct rxc_inlet *in)
+{
+    struct instrument_logic *self = (void *) ((char *) in - offsetof(struct instrument_logic, in));
+
+    logic_unblock(self);
+    self->done = 1;
+    rxc_inlet_cancel(self->base.in);
+}
+
+/* Sink logic */
+static void logic_dealloc(struct rxc_sink_logic *logic)
+{
+    struct instrument_logic *self = (struct instrument_logic *) logic;
+
+    self->inner->dealloc(self->inner);
+    stats_release(self->stats);
+    rxc_free(self);
+}
+
+static void logic_on_connect(struct rxc_sink_logic *logic)
+{
+    struct instrument_logic *self = (struct instrument_logic *) logic;
+
+    self->blocked_since = now();
+    self->inner->in = &self->in;
+    self->inner->on_connect(self->inner);
+}
+
+static uint64_t logic_push_begin(struct instrument_logic *self)
+{
+    uint64_t start = now();
+
+    /* LONG_MAX means unbounded */
+    if (self->outstanding > 0 && self->outstanding != LONG_MAX) {
+        self->outstanding--;
+    }
+
+    if (self->outstanding == 0) {
+        self->blocked_since = start;
+    }
+
+    counter_add(&self->stats->pushed, 1);
+    return start;
+}
+
+static void logic_push_end(struct instrument_logic *self, uint64_t start)
+{
+    counter_add(&self->stats->histogram[bucket(now() - start)], 1);
+}
+
+static void logic_on_push(struct rxc_sink_logic *logic, void *element)
+{
+    struct instrument_logic *self = (struct instrument_logic *) logic;
+    uint64_t start = logic_push_begin(self);
+
+    self->inner->on_push(self->inner, element);
+    logic_push_end(self, start);
+}
+
+static void logic_on_push_value(struct rxc_sink_logic *logic, struct rxc_value value)
+{
+    struct instrument_logic *self = (struct instrument_logic *) logic;
+    uint64_t start = logic_push_begin(self);
+
+    rxc_sink_logic_push_value(self->inner, value);
+    logic_push_end(self, start);
+}
+
+static void logic_on_upstream_finish(struct rxc_sink_logic *logic)
+{
+    struct instrument_logic *self = (struct instrument_logic *) logic;
+
+    logic_unblock(self);
+    self->done = 1;
+    self->inner->on_upstream_finish(self->inner);
+}
+
+static void logic_on_upstream_failure(struct rxc_sink_logic *logic, void *failure)
+{
+    struct instrument_logic *self = (struct instrument_logic *) logic;
+
+    logic_unblock(self);
+    self->done = 1;
+    self->inner->on_upstream_failure(self->inner, failure);
+}
+
+/* Sink */
+static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *sink)
+{
+    struct instrument_sink *self = (struct instrument_sink *) sink;
+    struct instrument_logic *logic = rxc_alloc(sizeof(struct instrument_logic));
+
+    if (!logic) {
+        return NULL;
+    }
+
+    logic->inner = self->inner->create_logic(self->inner);
+
+    if (!logic->inner) {
+        rxc_free(logic);
+        return NULL;
+    }
+
+    stats_retain(self->stats);
+
+    logic->stats = self->stats;
+    logic->outstanding = 0;
+    logic->blocked_since = 0;
+    logic->done = 0;
+    logic->in.pull = logic_inlet_pull;
+    logic->in.cancel = logic_inlet_cancel;
+    logic->base.sink = sink;
+    logic->base.dealloc = logic_dealloc;
+    logic->base.on_connect = logic_on_connect;
+    logic->base.on_push = logic_on_push;
+    logic->base.on_push_value = logic_on_push_value;
+    logic->base.on_upstream_finish = logic_on_upstream_finish;
+    logic->base.on_upstream_failure = logic_on_upstream_failure;
+
+    return &logic->base;
+}
+
+static void sink_dealloc(struct rxc_sink *sink, int shallow)
+{
+    struct instrument_sink *self = (struct instrument_sink *) sink;
+
+    /* The decorator is transparent, so the inner sink is not a nested stage */
+    self->inner->dealloc(self->inner, shallow);
+    stats_release(self->stats);
+    rxc_free(self);
+}
+
+static struct instrument_sink * sink_create(struct rxc_sink *inner,
+                                            struct instrument_stats *stats)
+{
+    struct instrument_sink *sink = rxc_alloc(sizeof(struct instrument_sink));
+
+    if (!sink) {
+        return NULL;
+    }
+
+    stats_retain(stats);
+
+    sink->inner = inner;
+    sink->stats = stats;
+    sink->base.dealloc = sink_dealloc;
+    sink->base.create_logic = sink_create_logic;
+
+    return sink;
+}
+
+/* Source */
+static void source_connect(struct rxc_source *source, struct rxc_sink *sink)
+{
+    struct instrument_source *self = (struct instrument_source *) source;
+    struct instrument_source_sink *node = rxc_alloc(sizeof(struct instrument_source_sink));
+    struct instrument_sink *wrapper = node ? sink_create(sink, self->stats) : NULL;
+
+    /* Connect without instrumentation if the wrapper cannot be allocated */
+    if (!wrapper) {
+        rxc_free(node);
+        self->inner->connect(self->inner, sink);
+        return;
+    }
+
+    node->sink = wrapper;
+    node->next = self->sinks;
+    self->sinks = node;
+
+    self->inner->connect(self->inner, &wrapper->base);
+}
+
+static void source_dealloc(struct rxc_source *source, int shallow)
+{
+    struct instrument_source *self = (struct instrument_source *) source;
+    struct instrument_source_sink *node;
+
+    /* The sinks are owned by the stage downstream */
+    while ((node = self->sinks) != NULL) {
+        self->sinks = node->next;
+        stats_release(node->sink->stats);
+        rxc_free(node->sink);
+        rxc_free(node);
+    }
+
+    self->inner->dealloc(self->inner, shallow);
+    stats_release(self->stats);
+    rxc_free(self);
+}
+
+/* Public API */
+void rxc_instrument_enable(int enable)
+{
+    atomic_store_explicit(&enabled, enable != 0, memory_order_relaxed);
+}
+
+int rxc_instrument_enabled(void)
+{
+    return atomic_load_explicit(&enabled, memory_order_relaxed);
+}
+
+struct rxc_source * rxc_instrument_source(struct rxc_source *source,
+                                          enum rxc_instrument_kind kind)
+{
+    struct instrument_source *self = rxc_alloc(sizeof(struct instrument_source));
+
+    if (!self) {
+        return NULL;
+    }
+
+    self->stats = stats_create(kind);
+
+    if (!self->stats) {
+        rxc_free(self);
+        return NULL;
+    }
+
+    self->inner = source;
+    self->sinks = NULL;
+    self->base.dealloc = source_dealloc;
+    self->base.connect = source_connect;
+
+    return &self->base;
+}
+
+struct rxc_sink * rxc_instrument_sink(struct rxc_sink *sink,
+                                      enum rxc_instrument_kind kind)
+{
+    struct instrument_stats *stats = stats_create(kind);
+
+    if (!stats) {
+        return NULL;
+    }
+
+    struct instrument_sink *self = sink_create(sink, stats);
+
+    /* The sink holds the only reference from now on */
+    stats_release(stats);
+
+    return self ? &self->base : NULL;
+}
+
+long rxc_instrument_snapshot(struct rxc_instrument_snapshot *snapshots, long max)
+{
+    struct instrument_stats *stats;
+    long i = 0, count;
+
+    pthread_mutex_lock(&registry_lock);
+    count = registry_count;
+
+    for (stats = registry; stats && i < max; stats = stats->next, i++) {
+        struct rxc_instrument_snapshot *snapshot = &snapshots[i];
+
+        snapshot->id = stats->id;
+        snapshot->kind = stats->kind;
+        snapshot->pushed = atomic_load_explicit(&stats->pushed, memory_order_relaxed);
+        snapshot->requested = atomic_load_explicit(&stats->requested, memory_order_relaxed);
+        snapshot->blocked = atomic_load_explicit(&stats->blocked, memory_order_relaxed);
+
+        for (int j = 0; j < RXC_INSTRUMENT_BUCKETS; j++) {
+            snapshot->histogram[j] = atomic_load_explicit(&stats->histogram[j],
+                                                          memory_order_relaxed);
+        }
+    }
+
+    pthread_mutex_unlock(&registry_lock);
+
+    return count;
+}
+
+unsigned long rxc_instrument_quantile(const struct rxc_instrument_snapshot *snapshot,
+                                      double quantile)
+{
+    unsigned long total = 0, seen = 0;
+
+    for (int i = 0; i < RXC_INSTRUMENT_BUCKETS; i++) {
+        total += snapshot->histogram[i];
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+
+    unsigned long rank = (unsigned long) (quantile * (double) (total - 1)) + 1;
+
+    for (int i = 0; i < RXC_INSTRUMENT_BUCKETS; i++) {
+        seen += snapshot->histogram[i];
+
+        if (seen < rank) {
+            continue;
+        }
+
+        if (i < 16) {
+            return (unsigned long) i;
+        }
+
+        /* Report the middle of the sub-bucket */
+        int magnitude = i / 16 + 3;
+        unsigned long width = 1ul << (magnitude - 4);
+
+        return (unsigned long) (16 + i % 16) * width + width / 2;
+    }
+
+    return 0;
+}
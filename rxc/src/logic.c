@@ -1,8 +1,30 @@
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <limits.h>
 
 #include <rxc/rxc.h>
 #include <rxc/logic.h>
+#include <rxc/alloc.h>
+#include <rxc/trace.h>
+
+_Static_assert(sizeof(struct rxc_value) == 16, "values must fit in 16 bytes");
+
+/* Value */
+void * rxc_value_box(struct rxc_value value)
+{
+    if (value.tag == RXC_VALUE_POINTER) {
+        return value.as.pointer;
+    }
+
+    void *element = malloc(sizeof(value.as));
+
+    if (element) {
+        memcpy(element, &value.as, sizeof(value.as));
+    }
+
+    return element;
+}
 
 /* Inlet */
 void rxc_inlet_pull(struct rxc_inlet *in, long n)
@@ -32,7 +54,9 @@ static void rxc_connection_inlet_pull(struct rxc_inlet *self, long n)
         conn->requested = LONG_MAX;
     }
 
+    RXC_TRACE_BEGIN("on_pull", n);
     conn->source_logic->on_pull(conn->source_logic, n);
+    RXC_TRACE_END("on_pull", n);
 }
 
 static void rxc_connection_inlet_cancel(struct rxc_inlet *self)
@@ -53,7 +77,7 @@ static void rxc_connection_inlet_cancel(struct rxc_inlet *self)
 void rxc_connection_create(struct rxc_source_logic *source,
                            struct rxc_sink_logic *sink)
 {
-    struct rxc_connection *conn = malloc(sizeof(struct rxc_connection));
+    struct rxc_connection *conn = rxc_alloc(sizeof(struct rxc_connection));
 
     conn->in.pull = rxc_connection_inlet_pull;
     conn->in.cancel = rxc_connection_inlet_cancel;
@@ -65,6 +89,18 @@ void rxc_connection_create(struct rxc_source_logic *source,
     sink->in = (void *) conn;
 }
 
+struct rxc_connection * rxc_inlet_connection(struct rxc_inlet *in)
+{
+    return in->pull == rxc_connection_inlet_pull ? (struct rxc_connection *) in : NULL;
+}
+
+void rxc_connection_dealloc(struct rxc_connection *conn)
+{
+    conn->source_logic->dealloc(conn->source_logic);
+    conn->sink_logic->dealloc(conn->sink_logic);
+    rxc_free(conn);
+}
+
 int rxc_outlet_available(struct rxc_outlet *out)
 {
     return out->conn.requested > 0;
@@ -83,7 +119,56 @@ int rxc_outlet_emit(struct rxc_outlet *out, void *element)
     if (conn->requested != LONG_MAX) {
         conn->requested--;
     }
+    RXC_TRACE_BEGIN("on_push", 0);
     conn->sink_logic->on_push(conn->sink_logic, element);
+    RXC_TRACE_END("on_push", 0);
+
+    return RXC_EOK;
+}
+
+int rxc_sink_logic_push_boxed(struct rxc_sink_logic *logic, struct rxc_value value)
+{
+    void *element;
+
+    /* Box the value for logic objects that only accept references */
+    if (!(element = rxc_value_box(value)) && value.tag != RXC_VALUE_POINTER) {
+        return ENOMEM;
+    }
+
+    logic->on_push(logic, element);
+    return RXC_EOK;
+}
+
+int rxc_outlet_emit_value(struct rxc_outlet *out, struct rxc_value value)
+{
+    struct rxc_connection *conn = &out->conn;
+    struct rxc_sink_logic *sink = conn->sink_logic;
+    void *element = NULL;
+
+    /* Check whether the connection is still open */
+    if (conn->requested <= 0) {
+        return -1;
+    }
+
+    /* Box the value before consuming demand, so a failure leaves it intact */
+    if (!sink->on_push_value) {
+        if (!(element = rxc_value_box(value)) && value.tag != RXC_VALUE_POINTER) {
+            return ENOMEM;
+        }
+    }
+
+    /* LONG_MAX means unbounded */
+    if (conn->requested != LONG_MAX) {
+        conn->requested--;
+    }
+
+    RXC_TRACE_BEGIN("on_push", 0);
+    if (sink->on_push_value) {
+        sink->on_push_value(sink, value);
+    } else {
+        sink->on_push(sink, element);
+    }
+    RXC_TRACE_END("on_push", 0);
 
     return RXC_EOK;
 }
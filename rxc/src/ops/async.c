@@ -0,0 +1,356 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+#include <rxc/rxc.h>
+#include <rxc/logic.h>
+#include <rxc/alloc.h>
+#include <rxc/ops/core.h>
+
+#include "../ring.h"
+
+#define ASYNC_FINISHED  (1 << 0) /* Upstream has finished */
+#define ASYNC_FAILED    (1 << 1) /* Upstream has failed */
+#define ASYNC_CANCELED  (1 << 2) /* Downstream has canceled */
+#define ASYNC_SIGNALLED (1 << 3) /* Termination has been signalled downstream */
+
+struct rxc_sink_async {
+    struct rxc_sink base;
+    struct rxc_sink *inner;
+
+    long capacity;
+    struct rxc_scheduler *scheduler;
+    void (*discard)(void *element);
+};
+
+struct rxc_sink_logic_async {
+    struct rxc_sink_logic base;
+    struct rxc_sink_logic *inner;
+
+    /**
+     * The inlet exposed to the downstream logic.
+     */
+    struct rxc_inlet in;
+
+    /**
+     * The worker on which upstream is pulled and canceled.
+     */
+    struct rxc_scheduler_worker *producer;
+
+    /**
+     * The worker on which elements are delivered downstream.
+     */
+    struct rxc_scheduler_worker *consumer;
+
+    /**
+     * The ring through which elements cross the boundary.
+     */
+    struct rxc_ring ring;
+
+    /**
+     * The amount of elements requested by downstream that have not been
+     * delivered yet.
+     */
+    atomic_long demand;
+
+    /**
+     * The amount of ring slots freed by the consumer that have not been
+     * requested from upstream yet.
+     */
+    atomic_long credit;
+
+    /**
+     * Flags to prevent scheduling the same task more than once.
+     */
+    atomic_int drain_pending, request_pending;
+
+    /**
+     * The state flags of the boundary.
+     */
+    atomic_int state;
+
+    /**
+     * The failure reported by upstream.
+     */
+    void *failure;
+};
+
+static void consumer_drain(void *ctx);
+static void producer_request(void *ctx);
+
+static void signal_consumer(struct rxc_sink_logic_async *self)
+{
+    if (!atomic_exchange_explicit(&self->drain_pending, 1, memory_order_acq_rel)) {
+        self->consumer->schedule(self->consumer, consumer_drain, self);
+    }
+}
+
+static void signal_producer(struct rxc_sink_logic_async *self)
+{
+    if (!atomic_exchange_explicit(&self->request_pending, 1, memory_order_acq_rel)) {
+        self->producer->schedule(self->producer, producer_request, self);
+    }
+}
+
+static void producer_request(void *ctx)
+{
+    struct rxc_sink_logic_async *self = ctx;
+
+    atomic_store_explicit(&self->request_pending, 0, memory_order_release);
+
+    if (atomic_load_explicit(&self->state, memory_order_acquire) & ASYNC_CANCELED) {
+        return;
+    }
+
+    long n = atomic_exchange_explicit(&self->credit, 0, memory_order_acq_rel);
+
+    if (n > 0) {
+        rxc_inlet_pull(self->base.in, n);
+    }
+}
+
+static void producer_cancel(void *ctx)
+{
+    struct rxc_sink_logic_async *self = ctx;
+    rxc_inlet_cancel(self->base.in);
+}
+
+static void consumer_connect(void *ctx)
+{
+    struct rxc_sink_logic_async *self = ctx;
+    self->inner->on_connect(self->inner);
+}
+
+static void consumer_drain(void *ctx)
+{
+    struct rxc_sink_logic_async *self = ctx;
+    struct rxc_sink_logic *inner = self->inner;
+    long freed = 0;
+    void *element;
+
+    atomic_store_explicit(&self->drain_pending, 0, memory_order_release);
+
+    while (atomic_load_explicit(&self->demand, memory_order_acquire) > 0) {
+        if (!rxc_ring_pop(&self->ring, &element)) {
+            break;
+        }
+
+        /* LONG_MAX means unbounded */
+        if (atomic_load_explicit(&self->demand, memory_order_relaxed) != LONG_MAX) {
+            atomic_fetch_sub_explicit(&self->demand, 1, memory_order_acq_rel);
+        }
+
+        freed++;
+        inner->on_push(inner, element);
+    }
+
+    /* Propagate the freed slots as demand upstream */
+    if (freed > 0) {
+        atomic_fetch_add_explicit(&self->credit, freed, memory_order_acq_rel);
+        signal_producer(self);
+    }
+
+    int state = atomic_load_explicit(&self->state, memory_order_acquire);
+
+    if (!(state & (ASYNC_FINISHED | ASYNC_FAILED)) || (state & ASYNC_SIGNALLED)) {
+        return;
+    }
+
+    /* Deliver the termination signal once all elements have been drained */
+    if (!rxc_ring_empty(&self->ring)) {
+        return;
+    }
+
+    atomic_fetch_or_explicit(&self->state, ASYNC_SIGNALLED, memory_order_acq_rel);
+
+    if (state & ASYNC_FAILED) {
+        inner->on_upstream_failure(inner, self->failure);
+    } else {
+        inner->on_upstream_finish(inner);
+    }
+}
+
+static void inlet_pull(struct rxc_inlet *in, long n)
+{
+    struct rxc_sink_logic_async *self = (void *) ((char *) in - offsetof(struct rxc_sink_logic_async, in));
+    long demand = atomic_load_explicit(&self->demand, memory_order_relaxed);
+    long next;
+
+    if (n <= 0) {
+        return;
+    }
+
+    /* Cap the requested amount at the maximum size of a long */
+    do {
+        next = demand > LONG_MAX - n ? LONG_MAX : demand + n;
+    } while (!atomic_compare_exchange_weak_explicit(&self->demand, &demand, next,
+                                                    memory_order_acq_rel,
+                                                    memory_order_relaxed));
+
+    signal_consumer(self);
+}
+
+static void inlet_cancel(struct rxc_inlet *in)
+{
+    struct rxc_sink_logic_async *self = (void *) ((char *) in - offsetof(struct rxc_sink_logic_async, in));
+    int state = atomic_fetch_or_explicit(&self->state, ASYNC_CANCELED, memory_order_acq_rel);
+
+    if (!(state & ASYNC_CANCELED)) {
+        self->producer->schedule(self->producer, producer_cancel, self);
+    }
+}
+
+static void sink_logic_dealloc(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_async *self = (struct rxc_sink_logic_async *) logic;
+    void (*discard)(void *) = ((struct rxc_sink_async *) logic->sink)->discard;
+    void *element;
+
+    /* Release the elements that were never delivered downstream */
+    while (rxc_ring_pop(&self->ring, &element)) {
+        discard(element);
+    }
+
+    self->inner->dealloc(self->inner);
+    self->producer->dealloc(self->producer);
+    self->consumer->dealloc(self->consumer);
+    rxc_ring_destroy(&self->ring);
+    free(self);
+}
+
+static void sink_logic_on_connect(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_async *self = (struct rxc_sink_logic_async *) logic;
+
+    self->inner->in = &self->in;
+    self->consumer->schedule(self->consumer, consumer_connect, self);
+
+    /* Prefetch enough elements to fill the ring */
+    signal_producer(self);
+}
+
+static void sink_logic_on_push(struct rxc_sink_logic *logic, void *element)
+{
+    struct rxc_sink_logic_async *self = (struct rxc_sink_logic_async *) logic;
+
+    /* Upstream violated the demand it was given; stop the boundary */
+    if (!rxc_ring_push(&self->ring, element)) {
+        ((struct rxc_sink_async *) logic->sink)->discard(element);
+        self->failure = NULL;
+        atomic_fetch_or_explicit(&self->state, ASYNC_FAILED, memory_order_acq_rel);
+        rxc_inlet_cancel(logic->in);
+    }
+
+    signal_consumer(self);
+}
+
+static void sink_logic_on_upstream_finish(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_async *self = (struct rxc_sink_logic_async *) logic;
+
+    atomic_fetch_or_explicit(&self->state, ASYNC_FINISHED, memory_order_acq_rel);
+    signal_consumer(self);
+}
+
+static void sink_logic_on_upstream_failure(struct rxc_sink_logic *logic, void *failure)
+{
+    struct rxc_sink_logic_async *self = (struct rxc_sink_logic_async *) logic;
+
+    self->failure = failure;
+    atomic_fetch_or_explicit(&self->state, ASYNC_FAILED, memory_order_acq_rel);
+    signal_consumer(self);
+}
+
+static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *sink)
+{
+    struct rxc_sink_async *self = (struct rxc_sink_async *) sink;
+    struct rxc_sink_logic_async *logic = aligned_alloc(RXC_CACHE_LINE_SIZE,
+            (sizeof(struct rxc_sink_logic_async) + RXC_CACHE_LINE_SIZE - 1) & ~(RXC_CACHE_LINE_SIZE - 1));
+
+    if (!logic) {
+        return NULL;
+    }
+
+    if (rxc_ring_init(&logic->ring, self->capacity) != RXC_EOK) {
+        free(logic);
+        return NULL;
+    }
+
+    logic->inner = self->inner->create_logic(self->inner);
+    logic->producer = self->scheduler->create_worker(self->scheduler);
+    logic->consumer = self->scheduler->create_worker(self->scheduler);
+    logic->in.pull = inlet_pull;
+    logic->in.cancel = inlet_cancel;
+    logic->failure = NULL;
+    atomic_init(&logic->demand, 0);
+    atomic_init(&logic->credit, self->capacity);
+    atomic_init(&logic->drain_pending, 0);
+    atomic_init(&logic->request_pending, 0);
+    atomic_init(&logic->state, 0);
+
+    logic->base.sink = sink;
+    logic->base.dealloc = sink_logic_dealloc;
+    logic->base.on_connect = sink_logic_on_connect;
+    logic->base.on_push = sink_logic_on_push;
+    logic->base.on_push_value = NULL;
+    logic->base.on_upstream_finish = sink_logic_on_upstream_finish;
+    logic->base.on_upstream_failure = sink_logic_on_upstream_failure;
+
+    return &logic->base;
+}
+
+static void sink_dealloc(struct rxc_sink *sink, int shallow)
+{
+    struct rxc_sink_async *self = (struct rxc_sink_async *) sink;
+
+    if (!shallow) {
+        self->inner->dealloc(self->inner, shallow);
+    }
+
+    rxc_free(self);
+}
+
+struct async_ctx {
+    long capacity;
+    struct rxc_scheduler *scheduler;
+    void (*discard)(void *element);
+};
+
+static struct rxc_sink * sink_wrap(struct rxc_sink *sink, void *ctx)
+{
+    struct async_ctx *async = ctx;
+    struct rxc_sink_async *wrapper_sink = rxc_alloc(sizeof(struct rxc_sink_async));
+
+    if (!wrapper_sink) {
+        return NULL;
+    }
+
+    wrapper_sink->inner = sink;
+    wrapper_sink->capacity = async->capacity;
+    wrapper_sink->scheduler = async->scheduler;
+    wrapper_sink->discard = async->discard;
+    wrapper_sink->base.dealloc = sink_dealloc;
+    wrapper_sink->base.create_logic = sink_create_logic;
+
+    return &wrapper_sink->base;
+}
+
+struct rxc_flow * rxc_flow_async(long capacity, struct rxc_scheduler *scheduler,
+                                 void (*discard)(void *element))
+{
+    if (capacity <= 0) {
+        return NULL;
+    }
+
+    struct async_ctx *ctx = rxc_alloc(sizeof(struct async_ctx));
+
+    if (!ctx) {
+        return NULL;
+    }
+
+    ctx->capacity = capacity;
+    ctx->scheduler = scheduler;
+    ctx->discard = discard ? discard : free;
+    return rxc_flow_wrapper(sink_wrap, ctx);
+}
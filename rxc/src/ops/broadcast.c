@@ -0,0 +1,463 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+
+#include <rxc/rxc.h>
+#include <rxc/logic.h>
+#include <rxc/alloc.h>
+#include <rxc/ops/hub.h>
+
+struct rxc_hub_broadcast_consumer {
+    struct rxc_source_logic base;
+
+    /**
+     * The hub this consumer is attached to.
+     */
+    struct rxc_hub_broadcast *hub;
+
+    /**
+     * The sequence number of the next element to deliver to the consumer.
+     */
+    long cursor;
+
+    /**
+     * A flag to indicate the consumer has terminated.
+     */
+    int done;
+
+    /**
+     * The next consumer attached to the hub.
+     */
+    struct rxc_hub_broadcast_consumer *next;
+};
+
+struct rxc_hub_broadcast {
+    /**
+     * The sink through which the hub is attached to upstream.
+     */
+    struct rxc_sink sink;
+
+    /**
+     * The logic of the sink attached to upstream.
+     */
+    struct rxc_sink_logic logic;
+
+    /**
+     * The source through which consumers attach to the hub.
+     */
+    struct rxc_source source;
+
+    /**
+     * The upstream source of the hub.
+     */
+    struct rxc_source *upstream;
+
+    /**
+     * The buffer of elements that have not been delivered to every consumer.
+     */
+    void **buffer;
+
+    /**
+     * The size of the buffer.
+     */
+    long size;
+
+    /**
+     * The sequence number of the next element to arrive and the sequence number
+     * of the oldest element in the buffer.
+     */
+    long head, tail;
+
+    /**
+     * The amount of elements requested from upstream that have not arrived.
+     */
+    long outstanding;
+
+    /**
+     * The lag policy of the hub.
+     */
+    enum rxc_hub_lag_policy lag;
+
+    /**
+     * The functions to manage the references to elements.
+     */
+    void * (*retain)(void *element);
+    void (*release)(void *element);
+
+    /**
+     * The consumers attached to the hub.
+     */
+    struct rxc_hub_broadcast_consumer *consumers;
+
+    /**
+     * The amount of attached consumers.
+     */
+    long count;
+
+    /**
+     * Flags to indicate the state of upstream.
+     */
+    int connected, finished, failed;
+
+    /**
+     * The failure reported by upstream.
+     */
+    void *failure;
+
+    /**
+     * Flags to prevent recursively entering the dispatch loop.
+     */
+    int wip, missed;
+};
+
+/* Release the consumer together with the logic of its sink and the connection
+ * between them, which the hub owns once the consumer has attached */
+static void consumer_dealloc(struct rxc_source_logic *self)
+{
+    struct rxc_connection *conn = &self->out->conn;
+    struct rxc_sink_logic *sink_logic = conn->sink_logic;
+
+    sink_logic->dealloc(sink_logic);
+    rxc_free(conn);
+    free(self);
+}
+
+static void consumer_terminate(struct rxc_hub_broadcast_consumer *consumer)
+{
+    struct rxc_hub_broadcast *hub = consumer->hub;
+
+    consumer->done = 1;
+
+    if (hub->failed) {
+        rxc_outlet_fail(consumer->base.out, hub->failure);
+    } else {
+        rxc_outlet_complete(consumer->base.out);
+    }
+}
+
+static void evict(struct rxc_hub_broadcast *hub)
+{
+    struct rxc_hub_broadcast_consumer *consumer;
+
+    /* Consumers still waiting for the oldest element lose it */
+    for (consumer = hub->consumers; consumer; consumer = consumer->next) {
+        if (consumer->done || consumer->cursor != hub->tail) {
+            continue;
+        }
+
+        if (hub->lag == RXC_HUB_LAG_DETACH) {
+            consumer->done = 1;
+            rxc_outlet_complete(consumer->base.out);
+        } else {
+            consumer->cursor++;
+        }
+    }
+
+    if (hub->release) {
+        hub->release(hub->buffer[hub->tail % hub->size]);
+    }
+    hub->tail++;
+}
+
+static void dispatch(struct rxc_hub_broadcast *hub)
+{
+    struct rxc_hub_broadcast_consumer *consumer, **link;
+
+    /* Prevent re-entering the loop from within the callbacks it invokes */
+    if (hub->wip) {
+        hub->missed = 1;
+        return;
+    }
+
+    hub->wip = 1;
+
+    do {
+        hub->missed = 0;
+
+        long min = hub->head;
+        long need = 0;
+
+        for (consumer = hub->consumers; consumer; consumer = consumer->next) {
+            struct rxc_outlet *out = consumer->base.out;
+
+            while (!consumer->done && consumer->cursor < hub->head && rxc_outlet_available(out)) {
+                void *element = hub->buffer[consumer->cursor++ % hub->size];
+                rxc_outlet_emit(out, hub->retain ? hub->retain(element) : element);
+            }
+
+            if (!consumer->done && hub->finished && consumer->cursor == hub->head) {
+                consumer_terminate(consumer);
+            }
+
+            if (consumer->done) {
+                continue;
+            }
+
+            if (consumer->cursor < min) {
+                min = consumer->cursor;
+            }
+
+            /* Consumers with demand have received every buffered element */
+            if (out->conn.requested > need) {
+                need = out->conn.requested;
+            }
+        }
+
+        /* Forget the consumers that have terminated */
+        link = &hub->consumers;
+        while ((consumer = *link) != NULL) {
+            if (consumer->done) {
+                *link = consumer->next;
+                hub->count--;
+                consumer->base.dealloc(&consumer->base);
+            } else {
+                link = &consumer->next;
+            }
+        }
+
+        /* Release the elements every consumer has received */
+        while (hub->tail < min) {
+            if (hub->release) {
+                hub->release(hub->buffer[hub->tail % hub->size]);
+            }
+            hub->tail++;
+        }
+
+        if (!hub->connected || hub->finished || hub->count == 0) {
+            continue;
+        }
+
+        /* Under the slowest policy, only request what fits into the buffer */
+        long room = hub->size;
+
+        if (hub->lag == RXC_HUB_LAG_SLOWEST) {
+            room -= hub->head - hub->tail;
+        }
+
+        long n = (need < room ? need : room) - hub->outstanding;
+
+        if (n > 0) {
+            hub->outstanding += n;
+            rxc_inlet_pull(hub->logic.in, n);
+        }
+    } while (hub->missed);
+
+    hub->wip = 0;
+}
+
+/* Upstream side */
+static void logic_dealloc(struct rxc_sink_logic *self)
+{
+    /* The logic is owned by the hub */
+}
+
+static void logic_on_connect(struct rxc_sink_logic *self)
+{
+    struct rxc_hub_broadcast *hub = (void *) ((char *) self - offsetof(struct rxc_hub_broadcast, logic));
+
+    hub->connected = 1;
+    dispatch(hub);
+}
+
+static void logic_on_push(struct rxc_sink_logic *self, void *element)
+{
+    struct rxc_hub_broadcast *hub = (void *) ((char *) self - offsetof(struct rxc_hub_broadcast, logic));
+
+    if (hub->outstanding > 0) {
+        hub->outstanding--;
+    }
+
+    /* Make room by evicting the oldest element if the buffer is full */
+    if (hub->head - hub->tail == hub->size) {
+        evict(hub);
+    }
+
+    hub->buffer[hub->head++ % hub->size] = element;
+    dispatch(hub);
+}
+
+static void logic_on_upstream_finish(struct rxc_sink_logic *self)
+{
+    struct rxc_hub_broadcast *hub = (void *) ((char *) self - offsetof(struct rxc_hub_broadcast, logic));
+
+    hub->finished = 1;
+    dispatch(hub);
+}
+
+static void logic_on_upstream_failure(struct rxc_sink_logic *self, void *failure)
+{
+    struct rxc_hub_broadcast *hub = (void *) ((char *) self - offsetof(struct rxc_hub_broadcast, logic));
+
+    hub->finished = 1;
+    hub->failed = 1;
+    hub->failure = failure;
+    dispatch(hub);
+}
+
+static void sink_dealloc(struct rxc_sink *self, int shallow)
+{
+    /* The sink is owned by the hub */
+}
+
+static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *self)
+{
+    struct rxc_hub_broadcast *hub = (void *) ((char *) self - offsetof(struct rxc_hub_broadcast, sink));
+    return &hub->logic;
+}
+
+/* Consumer side */
+static void consumer_on_pull(struct rxc_source_logic *self, long n)
+{
+    dispatch(((struct rxc_hub_broadcast_consumer *) self)->hub);
+}
+
+static void consumer_on_downstream_finish(struct rxc_source_logic *self)
+{
+    struct rxc_hub_broadcast_consumer *consumer = (struct rxc_hub_broadcast_consumer *) self;
+
+    consumer->done = 1;
+    dispatch(consumer->hub);
+}
+
+static void source_dealloc(struct rxc_source *self, int shallow)
+{
+    /* The source is owned by the hub */
+}
+
+static void source_connect(struct rxc_source *self, struct rxc_sink *sink)
+{
+    struct rxc_hub_broadcast *hub = (void *) ((char *) self - offsetof(struct rxc_hub_broadcast, source));
+    struct rxc_hub_broadcast_consumer *consumer = malloc(sizeof(struct rxc_hub_broadcast_consumer));
+
+    if (!consumer) {
+        return;
+    }
+
+    consumer->hub = hub;
+    consumer->cursor = hub->head;
+    consumer->done = 0;
+    consumer->base.source = self;
+    consumer->base.dealloc = consumer_dealloc;
+    consumer->base.on_pull = consumer_on_pull;
+    consumer->base.on_downstream_finish = consumer_on_downstream_finish;
+
+    struct rxc_sink_logic *sink_logic = sink->create_logic(sink);
+
+    if (!sink_logic) {
+        free(consumer);
+        return;
+    }
+
+    rxc_connection_create(&consumer->base, sink_logic);
+
+    consumer->next = hub->consumers;
+    hub->consumers = consumer;
+    hub->count++;
+
+    sink_logic->on_connect(sink_logic);
+
+    /* Attach to upstream once the first consumer arrives */
+    if (!hub->connected) {
+        hub->upstream->connect(hub->upstream, &hub->sink);
+    } else {
+        dispatch(hub);
+    }
+}
+
+struct rxc_hub_broadcast * rxc_hub_broadcast(struct rxc_source *upstream, long size,
+                                             enum rxc_hub_lag_policy lag,
+                                             void * (*retain)(void *element),
+                                             void (*release)(void *element))
+{
+    if (size <= 0) {
+        return NULL;
+    }
+
+    struct rxc_hub_broadcast *hub = malloc(sizeof(struct rxc_hub_broadcast));
+
+    if (!hub) {
+        return NULL;
+    }
+
+    hub->buffer = malloc(size * sizeof(void *));
+
+    if (!hub->buffer) {
+        free(hub);
+        return NULL;
+    }
+
+    hub->upstream = upstream;
+    hub->size = size;
+    hub->head = 0;
+    hub->tail = 0;
+    hub->outstanding = 0;
+    hub->lag = lag;
+    hub->retain = retain;
+    hub->release = release;
+    hub->consumers = NULL;
+    hub->count = 0;
+    hub->connected = 0;
+    hub->finished = 0;
+    hub->failed = 0;
+    hub->failure = NULL;
+    hub->wip = 0;
+    hub->missed = 0;
+
+    hub->sink.dealloc = sink_dealloc;
+    hub->sink.create_logic = sink_create_logic;
+    hub->logic.sink = &hub->sink;
+    hub->logic.in = NULL;
+    hub->logic.dealloc = logic_dealloc;
+    hub->logic.on_connect = logic_on_connect;
+    hub->logic.on_push = logic_on_push;
+    hub->logic.on_push_value = NULL;
+    hub->logic.on_upstream_finish = logic_on_upstream_finish;
+    hub->logic.on_upstream_failure = logic_on_upstream_failure;
+    hub->source.dealloc = source_dealloc;
+    hub->source.connect = source_connect;
+
+    return hub;
+}
+
+struct rxc_source * rxc_hub_broadcast_source(struct rxc_hub_broadcast *hub)
+{
+    return &hub->source;
+}
+
+long rxc_hub_broadcast_consumers(struct rxc_hub_broadcast *hub)
+{
+    return hub->count;
+}
+
+void rxc_hub_broadcast_dealloc(struct rxc_hub_broadcast *hub)
+{
+    struct rxc_hub_broadcast_consumer *consumer = hub->consumers;
+
+    if (hub->connected && !hub->finished) {
+        rxc_inlet_cancel(hub->logic.in);
+    }
+
+    /* Sources that connected to the hub directly leave their logic and the
+     * connection to the hub */
+    struct rxc_connection *conn = hub->connected ? rxc_inlet_connection(hub->logic.in) : NULL;
+
+    if (conn) {
+        rxc_connection_dealloc(conn);
+    }
+
+    while (consumer) {
+        struct rxc_hub_broadcast_consumer *next = consumer->next;
+        consumer->base.dealloc(&consumer->base);
+        consumer = next;
+    }
+
+    while (hub->tail < hub->head) {
+        if (hub->release) {
+            hub->release(hub->buffer[hub->tail % hub->size]);
+        }
+        hub->tail++;
+    }
+
+    free(hub->buffer);
+    free(hub);
+}
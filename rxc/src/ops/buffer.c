@@ -0,0 +1,359 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+
+#include <rxc/rxc.h>
+#include <rxc/logic.h>
+#include <rxc/alloc.h>
+#include <rxc/ops/core.h>
+
+struct rxc_sink_buffer {
+    struct rxc_sink base;
+    struct rxc_sink *inner;
+
+    long size, low_watermark;
+    enum rxc_overflow_strategy overflow;
+    void (*discard)(void *element);
+};
+
+struct rxc_sink_logic_buffer {
+    struct rxc_sink_logic base;
+    struct rxc_sink_logic *inner;
+
+    /**
+     * The inlet exposed to the downstream logic.
+     */
+    struct rxc_inlet in;
+
+    /**
+     * The queue of prefetched elements.
+     */
+    void **queue;
+
+    /**
+     * The index of the oldest element and the amount of elements in the queue.
+     */
+    long head, count;
+
+    /**
+     * The amount of elements requested from upstream that have not arrived yet,
+     * where LONG_MAX means upstream was requested without bounds.
+     */
+    long outstanding;
+
+    /**
+     * The amount of elements requested by downstream.
+     */
+    long demand;
+
+    /**
+     * Flags to indicate upstream has terminated or failed, downstream has
+     * canceled and the termination has been signalled downstream.
+     */
+    int finished, failed, canceled, signalled;
+
+    /**
+     * The failure reported by upstream.
+     */
+    void *failure;
+
+    /**
+     * Flags to prevent recursively entering the drain loop.
+     */
+    int wip, missed;
+};
+
+static void discard(struct rxc_sink_logic_buffer *self, void *element)
+{
+    ((struct rxc_sink_buffer *) self->base.sink)->discard(element);
+}
+
+static void * dequeue(struct rxc_sink_logic_buffer *self)
+{
+    struct rxc_sink_buffer *sink = (struct rxc_sink_buffer *) self->base.sink;
+    void *element = self->queue[self->head];
+
+    self->head = (self->head + 1) % sink->size;
+    self->count--;
+
+    return element;
+}
+
+static void enqueue(struct rxc_sink_logic_buffer *self, void *element)
+{
+    struct rxc_sink_buffer *sink = (struct rxc_sink_buffer *) self->base.sink;
+
+    self->queue[(self->head + self->count) % sink->size] = element;
+    self->count++;
+}
+
+static void clear(struct rxc_sink_logic_buffer *self)
+{
+    while (self->count > 0) {
+        discard(self, dequeue(self));
+    }
+}
+
+static void drain(struct rxc_sink_logic_buffer *self)
+{
+    struct rxc_sink_buffer *sink = (struct rxc_sink_buffer *) self->base.sink;
+    struct rxc_sink_logic *inner = self->inner;
+
+    /* Prevent re-entering the loop from within the callbacks it invokes */
+    if (self->wip) {
+        self->missed = 1;
+        return;
+    }
+
+    self->wip = 1;
+
+    do {
+        self->missed = 0;
+
+        while (self->demand > 0 && self->count > 0 && !self->canceled) {
+            /* LONG_MAX means unbounded */
+            if (self->demand != LONG_MAX) {
+                self->demand--;
+            }
+
+            inner->on_push(inner, dequeue(self));
+        }
+
+        if (self->canceled) {
+            break;
+        }
+
+        int backpressure = sink->overflow == RXC_OVERFLOW_BACKPRESSURE;
+
+        /* Let upstream run ahead and apply the strategy once the queue is full */
+        if (!self->finished && !backpressure && self->outstanding != LONG_MAX) {
+            self->outstanding = LONG_MAX;
+            rxc_inlet_pull(self->base.in, LONG_MAX);
+        }
+
+        /* Re-request in bulk once the queue has drained below the watermark */
+        if (!self->finished && backpressure &&
+            self->count + self->outstanding <= sink->low_watermark) {
+            long n = sink->size - self->count - self->outstanding;
+
+            self->outstanding += n;
+            rxc_inlet_pull(self->base.in, n);
+        }
+
+        if (self->finished && self->count == 0 && !self->signalled) {
+            self->signalled = 1;
+
+            if (self->failed) {
+                inner->on_upstream_failure(inner, self->failure);
+            } else {
+                inner->on_upstream_finish(inner);
+            }
+        }
+    } while (self->missed);
+
+    self->wip = 0;
+}
+
+static void inlet_pull(struct rxc_inlet *in, long n)
+{
+    struct rxc_sink_logic_buffer *self = (void *) ((char *) in - offsetof(struct rxc_sink_logic_buffer, in));
+
+    if (n <= 0) {
+        return;
+    }
+
+    /* Cap the requested amount at the maximum size of a long */
+    self->demand = self->demand > LONG_MAX - n ? LONG_MAX : self->demand + n;
+    drain(self);
+}
+
+static void inlet_cancel(struct rxc_inlet *in)
+{
+    struct rxc_sink_logic_buffer *self = (void *) ((char *) in - offsetof(struct rxc_sink_logic_buffer, in));
+
+    if (self->canceled) {
+        return;
+    }
+
+    self->canceled = 1;
+    clear(self);
+    rxc_inlet_cancel(self->base.in);
+}
+
+static void sink_logic_dealloc(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_buffer *self = (struct rxc_sink_logic_buffer *) logic;
+
+    clear(self);
+    self->inner->dealloc(self->inner);
+    rxc_free(self->queue);
+    rxc_free(self);
+}
+
+static void sink_logic_on_connect(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_buffer *self = (struct rxc_sink_logic_buffer *) logic;
+
+    self->inner->in = &self->in;
+    self->inner->on_connect(self->inner);
+
+    /* Start prefetching elements */
+    drain(self);
+}
+
+static void sink_logic_on_push(struct rxc_sink_logic *logic, void *element)
+{
+    struct rxc_sink_logic_buffer *self = (struct rxc_sink_logic_buffer *) logic;
+    struct rxc_sink_buffer *sink = (struct rxc_sink_buffer *) logic->sink;
+
+    if (self->outstanding > 0 && self->outstanding != LONG_MAX) {
+        self->outstanding--;
+    }
+
+    if (self->canceled || self->finished) {
+        discard(self, element);
+        return;
+    }
+
+    if (self->count == sink->size) {
+        switch (sink->overflow) {
+            case RXC_OVERFLOW_DROP_OLDEST:
+                discard(self, dequeue(self));
+                break;
+            case RXC_OVERFLOW_BACKPRESSURE:
+            case RXC_OVERFLOW_DROP_NEWEST:
+                discard(self, element);
+                return;
+            case RXC_OVERFLOW_FAIL:
+            default:
+                discard(self, element);
+                clear(self);
+                self->finished = 1;
+                self->failed = 1;
+                rxc_inlet_cancel(logic->in);
+                drain(self);
+                return;
+        }
+    }
+
+    enqueue(self, element);
+    drain(self);
+}
+
+static void sink_logic_on_upstream_finish(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_buffer *self = (struct rxc_sink_logic_buffer *) logic;
+
+    self->finished = 1;
+    drain(self);
+}
+
+static void sink_logic_on_upstream_failure(struct rxc_sink_logic *logic, void *failure)
+{
+    struct rxc_sink_logic_buffer *self = (struct rxc_sink_logic_buffer *) logic;
+
+    self->finished = 1;
+    self->failed = 1;
+    self->failure = failure;
+    drain(self);
+}
+
+static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *sink)
+{
+    struct rxc_sink_buffer *self = (struct rxc_sink_buffer *) sink;
+    struct rxc_sink_logic_buffer *logic = rxc_alloc(sizeof(struct rxc_sink_logic_buffer));
+
+    if (!logic) {
+        return NULL;
+    }
+
+    logic->queue = rxc_alloc(self->size * sizeof(void *));
+
+    if (!logic->queue) {
+        rxc_free(logic);
+        return NULL;
+    }
+
+    logic->inner = self->inner->create_logic(self->inner);
+    logic->in.pull = inlet_pull;
+    logic->in.cancel = inlet_cancel;
+    logic->head = 0;
+    logic->count = 0;
+    logic->outstanding = 0;
+    logic->demand = 0;
+    logic->finished = 0;
+    logic->failed = 0;
+    logic->canceled = 0;
+    logic->signalled = 0;
+    logic->failure = NULL;
+    logic->wip = 0;
+    logic->missed = 0;
+
+    logic->base.sink = sink;
+    logic->base.dealloc = sink_logic_dealloc;
+    logic->base.on_connect = sink_logic_on_connect;
+    logic->base.on_push = sink_logic_on_push;
+    logic->base.on_push_value = NULL;
+    logic->base.on_upstream_finish = sink_logic_on_upstream_finish;
+    logic->base.on_upstream_failure = sink_logic_on_upstream_failure;
+
+    return &logic->base;
+}
+
+static void sink_dealloc(struct rxc_sink *sink, int shallow)
+{
+    struct rxc_sink_buffer *self = (struct rxc_sink_buffer *) sink;
+
+    if (!shallow) {
+        self->inner->dealloc(self->inner, shallow);
+    }
+
+    rxc_free(self);
+}
+
+struct buffer_ctx {
+    long size, low_watermark;
+    enum rxc_overflow_strategy overflow;
+    void (*discard)(void *element);
+};
+
+static struct rxc_sink * sink_wrap(struct rxc_sink *sink, void *ctx)
+{
+    struct buffer_ctx *buffer = ctx;
+    struct rxc_sink_buffer *wrapper_sink = rxc_alloc(sizeof(struct rxc_sink_buffer));
+
+    if (!wrapper_sink) {
+        return NULL;
+    }
+
+    wrapper_sink->inner = sink;
+    wrapper_sink->size = buffer->size;
+    wrapper_sink->low_watermark = buffer->low_watermark;
+    wrapper_sink->overflow = buffer->overflow;
+    wrapper_sink->discard = buffer->discard;
+    wrapper_sink->base.dealloc = sink_dealloc;
+    wrapper_sink->base.create_logic = sink_create_logic;
+
+    return &wrapper_sink->base;
+}
+
+struct rxc_flow * rxc_flow_buffer(long size, long low_watermark,
+                                  enum rxc_overflow_strategy overflow,
+                                  void (*discard)(void *element))
+{
+    if (size <= 0 || low_watermark < 0 || low_watermark >= size) {
+        return NULL;
+    }
+
+    struct buffer_ctx *ctx = rxc_alloc(sizeof(struct buffer_ctx));
+
+    if (!ctx) {
+        return NULL;
+    }
+
+    ctx->size = size;
+    ctx->low_watermark = low_watermark;
+    ctx->overflow = overflow;
+    ctx->discard = discard ? discard : free;
+    return rxc_flow_wrapper(sink_wrap, ctx);
+}
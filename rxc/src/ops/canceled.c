@@ -4,11 +4,12 @@
 
 #include <rxc/rxc.h>
 #include <rxc/logic.h>
+#include <rxc/alloc.h>
 #include <rxc/ops/core.h>
 
 static void dealloc(struct rxc_sink *self, int shallow)
 {
-    free(self);
+    rxc_free(self);
 }
 
 static void on_connect(struct rxc_sink_logic *self)
@@ -30,16 +31,17 @@ static void on_upstream_failure(struct rxc_sink_logic *self, void *failure)
 
 static struct rxc_sink_logic *  create_logic(struct rxc_sink *self)
 {
-    struct rxc_sink_logic *logic = malloc(sizeof(struct rxc_sink_logic));
+    struct rxc_sink_logic *logic = rxc_alloc(sizeof(struct rxc_sink_logic));
 
     if (!logic) {
         return NULL;
     }
 
     logic->sink = self;
-    logic->dealloc = (void (*)(struct rxc_sink_logic *)) free;
+    logic->dealloc = (void (*)(struct rxc_sink_logic *)) rxc_free;
     logic->on_connect = on_connect;
     logic->on_push = on_push;
+    logic->on_push_value = NULL;
     logic->on_upstream_finish = on_upstream_finish;
     logic->on_upstream_failure = on_upstream_failure;
 
@@ -48,7 +50,7 @@ static struct rxc_sink_logic *  create_logic(struct rxc_sink *self)
 
 struct rxc_sink * rxc_sink_canceled()
 {
-    struct rxc_sink *sink = malloc(sizeof(struct rxc_sink));
+    struct rxc_sink *sink = rxc_alloc(sizeof(struct rxc_sink));
 
     if (!sink) {
         return NULL;
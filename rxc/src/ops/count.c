@@ -5,6 +5,7 @@
 
 #include <rxc/rxc.h>
 #include <rxc/logic.h>
+#include <rxc/alloc.h>
 #include <rxc/ops/core.h>
 
 struct rxc_source_count {
@@ -30,10 +31,8 @@ static void on_pull(struct rxc_source_logic *logic, long n)
             return;
         }
 
-        long *element = malloc(sizeof(long));
-        *element = self->count++;
-
-        rxc_outlet_emit(logic->out, element);
+        /* Sinks that do not accept values receive the count boxed as a long */
+        rxc_outlet_emit_value(logic->out, rxc_value_long(self->count++));
     }
 }
 
@@ -43,7 +42,7 @@ static void on_downstream_finish(struct rxc_source_logic *self)
 static struct rxc_source_logic * create_logic(struct rxc_source *source)
 {
     struct rxc_source_count *self = (struct rxc_source_count *) source;
-    struct rxc_source_logic_count *logic = malloc(sizeof(struct rxc_source_logic_count));
+    struct rxc_source_logic_count *logic = rxc_alloc(sizeof(struct rxc_source_logic_count));
 
     if (!logic) {
         return NULL;
@@ -51,7 +50,7 @@ static struct rxc_source_logic * create_logic(struct rxc_source *source)
 
     logic->count = self->from;
     logic->base.source = source;
-    logic->base.dealloc = (void (*)(struct rxc_source_logic *)) free;
+    logic->base.dealloc = (void (*)(struct rxc_source_logic *)) rxc_free;
     logic->base.on_pull = on_pull;
     logic->base.on_downstream_finish = on_downstream_finish;
 
@@ -60,7 +59,7 @@ static struct rxc_source_logic * create_logic(struct rxc_source *source)
 
 static void dealloc(struct rxc_source *self, int shallow)
 {
-    free(self);
+    rxc_free(self);
 }
 
 static void connect(struct rxc_source *self, struct rxc_sink *sink)
@@ -74,7 +73,7 @@ static void connect(struct rxc_source *self, struct rxc_sink *sink)
 
 struct rxc_source * rxc_source_count(long from, long to)
 {
-    struct rxc_source_count *source = malloc(sizeof(struct rxc_source_count));
+    struct rxc_source_count *source = rxc_alloc(sizeof(struct rxc_source_count));
 
     if (!source) {
         return NULL;
@@ -4,6 +4,7 @@
 
 #include <rxc/rxc.h>
 #include <rxc/logic.h>
+#include <rxc/alloc.h>
 #include <rxc/ops/core.h>
 
 static void on_pull(struct rxc_source_logic *self, long n)
@@ -14,14 +15,14 @@ static void on_downstream_finish(struct rxc_source_logic *self)
 
 static struct rxc_source_logic * create_logic(struct rxc_source *source)
 {
-    struct rxc_source_logic *logic = malloc(sizeof(struct rxc_source_logic));
+    struct rxc_source_logic *logic = rxc_alloc(sizeof(struct rxc_source_logic));
 
     if (!logic) {
         return NULL;
     }
 
     logic->source = source;
-    logic->dealloc = (void (*)(struct rxc_source_logic *)) free;
+    logic->dealloc = (void (*)(struct rxc_source_logic *)) rxc_free;
     logic->on_pull = on_pull;
     logic->on_downstream_finish = on_downstream_finish;
 
@@ -30,7 +31,7 @@ static struct rxc_source_logic * create_logic(struct rxc_source *source)
 
 static void dealloc(struct rxc_source *self, int shallow)
 {
-    free(self);
+    rxc_free(self);
 }
 
 static void connect(struct rxc_source *self, struct rxc_sink *sink)
@@ -44,7 +45,7 @@ static void connect(struct rxc_source *self, struct rxc_sink *sink)
 
 struct rxc_source * rxc_source_empty()
 {
-    struct rxc_source *source = malloc(sizeof(struct rxc_source));
+    struct rxc_source *source = rxc_alloc(sizeof(struct rxc_source));
 
     if (!source) {
         return NULL;
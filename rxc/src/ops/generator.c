@@ -0,0 +1,227 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+
+#include <rxc/rxc.h>
+#include <rxc/logic.h>
+#include <rxc/alloc.h>
+#include <rxc/generator.h>
+
+struct rxc_source_generator {
+    struct rxc_source base;
+
+    int (*step)(struct rxc_generator *gen);
+    size_t size;
+    void (*init)(struct rxc_generator *gen, void *ctx);
+    void (*release)(struct rxc_generator *gen);
+    void *ctx;
+
+    /**
+     * The instances that have not terminated yet, which are released when the
+     * source is deallocated.
+     */
+    struct rxc_source_logic_generator *instances;
+};
+
+struct rxc_source_logic_generator {
+    struct rxc_source_logic base;
+
+    /**
+     * A flag to indicate the generator has terminated.
+     */
+    int done;
+
+    /**
+     * The neighbours of the instance among the live instances of the source.
+     */
+    struct rxc_source_logic_generator *prev, *next;
+
+    /**
+     * A flag to prevent recursively entering the generator loop.
+     */
+    int wip;
+
+    /**
+     * The instance of the generator, allocated together with the logic.
+     */
+    _Alignas(max_align_t) unsigned char gen[];
+};
+
+static void terminate(struct rxc_source_logic_generator *self)
+{
+    struct rxc_source_generator *source = (struct rxc_source_generator *) self->base.source;
+
+    self->done = 1;
+
+    if (self->prev) {
+        self->prev->next = self->next;
+    } else {
+        source->instances = self->next;
+    }
+
+    if (self->next) {
+        self->next->prev = self->prev;
+    }
+
+    if (source->release) {
+        source->release((struct rxc_generator *) self->gen);
+    }
+}
+
+static void on_pull(struct rxc_source_logic *logic, long n)
+{
+    struct rxc_source_logic_generator *self = (struct rxc_source_logic_generator *) logic;
+    struct rxc_source_generator *source = (struct rxc_source_generator *) logic->source;
+    struct rxc_generator *gen = (struct rxc_generator *) self->gen;
+
+    /* Demand added while the loop is running is picked up by the loop */
+    if (self->wip) {
+        return;
+    }
+
+    self->wip = 1;
+
+    /* Resume the generator for as long as downstream has demand */
+    while (!self->done && rxc_outlet_available(logic->out)) {
+        switch (source->step(gen)) {
+            case RXC_GENERATOR_YIELDED:
+                /* Fail the stream if the value could not be boxed */
+                if (rxc_outlet_emit_value(logic->out, gen->value) == ENOMEM) {
+                    terminate(self);
+                    errno = ENOMEM;
+                    rxc_outlet_fail(logic->out, NULL);
+                }
+                break;
+            case RXC_GENERATOR_FINISHED:
+                terminate(self);
+                rxc_outlet_complete(logic->out);
+                break;
+            default:
+                terminate(self);
+                rxc_outlet_fail(logic->out, gen->failure);
+                break;
+        }
+    }
+
+    self->wip = 0;
+}
+
+static void on_downstream_finish(struct rxc_source_logic *logic)
+{
+    struct rxc_source_logic_generator *self = (struct rxc_source_logic_generator *) logic;
+
+    if (!self->done) {
+        terminate(self);
+    }
+}
+
+static void logic_dealloc(struct rxc_source_logic *logic)
+{
+    struct rxc_source_logic_generator *self = (struct rxc_source_logic_generator *) logic;
+
+    if (!self->done) {
+        terminate(self);
+    }
+
+    rxc_free(self);
+}
+
+static struct rxc_source_logic * create_logic(struct rxc_source *source)
+{
+    struct rxc_source_generator *self = (struct rxc_source_generator *) source;
+    struct rxc_source_logic_generator *logic = rxc_alloc(sizeof(struct rxc_source_logic_generator) + self->size);
+
+    if (!logic) {
+        return NULL;
+    }
+
+    struct rxc_generator *gen = (struct rxc_generator *) logic->gen;
+
+    memset(gen, 0, self->size);
+
+    if (self->init) {
+        self->init(gen, self->ctx);
+    }
+
+    gen->resume = 0;
+    gen->failure = NULL;
+
+    logic->done = 0;
+    logic->wip = 0;
+    logic->prev = NULL;
+    logic->next = self->instances;
+
+    if (logic->next) {
+        logic->next->prev = logic;
+    }
+
+    self->instances = logic;
+
+    logic->base.source = source;
+    logic->base.dealloc = logic_dealloc;
+    logic->base.on_pull = on_pull;
+    logic->base.on_downstream_finish = on_downstream_finish;
+
+    return &logic->base;
+}
+
+static void dealloc(struct rxc_source *self, int shallow)
+{
+    struct rxc_source_generator *source = (struct rxc_source_generator *) self;
+
+    /* Release the instances of pipelines that are deallocated mid-stream */
+    while (source->instances) {
+        terminate(source->instances);
+    }
+
+    rxc_free(self);
+}
+
+static void connect(struct rxc_source *self, struct rxc_sink *sink)
+{
+    struct rxc_source_logic *source_logic = create_logic(self);
+
+    if (!source_logic) {
+        return;
+    }
+
+    struct rxc_sink_logic *sink_logic = sink->create_logic(sink);
+
+    if (!sink_logic) {
+        source_logic->dealloc(source_logic);
+        return;
+    }
+
+    rxc_connection_create(source_logic, sink_logic);
+    sink_logic->on_connect(sink_logic);
+}
+
+struct rxc_source * rxc_source_generator(int (*step)(struct rxc_generator *gen),
+                                         size_t size,
+                                         void (*init)(struct rxc_generator *gen, void *ctx),
+                                         void (*release)(struct rxc_generator *gen),
+                                         void *ctx)
+{
+    if (size < sizeof(struct rxc_generator)) {
+        return NULL;
+    }
+
+    struct rxc_source_generator *source = rxc_alloc(sizeof(struct rxc_source_generator));
+
+    if (!source) {
+        return NULL;
+    }
+
+    source->step = step;
+    source->size = size;
+    source->init = init;
+    source->release = release;
+    source->ctx = ctx;
+    source->instances = NULL;
+
+    source->base.dealloc = dealloc;
+    source->base.connect = connect;
+
+    return &source->base;
+}
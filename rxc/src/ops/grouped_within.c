@@ -0,0 +1,475 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+
+#include <rxc/rxc.h>
+#include <rxc/logic.h>
+#include <rxc/alloc.h>
+#include <rxc/ops/core.h>
+#include <rxc/schedulers/eventloop.h>
+
+struct rxc_sink_grouped_within {
+    struct rxc_sink base;
+    struct rxc_sink *inner;
+
+    long max_elements;
+    size_t max_bytes;
+    long max_delay;
+    size_t (*weigh)(void *element);
+    void (*discard)(void *element);
+    struct rxc_scheduler *scheduler;
+};
+
+struct rxc_sink_logic_grouped_within {
+    struct rxc_sink_logic base;
+    struct rxc_sink_logic *inner;
+
+    /**
+     * The inlet exposed to the downstream logic.
+     */
+    struct rxc_inlet in;
+
+    /**
+     * The worker on which the time limit is enforced, or <code>NULL</code>
+     * if the batches have no time limit.
+     */
+    struct rxc_scheduler_eventloop_worker *worker;
+
+    /**
+     * The batch that is being filled, or <code>NULL</code> if no element has
+     * arrived since the last batch was closed.
+     */
+    struct rxc_batch *open;
+
+    /**
+     * The queue of batches that have reached a size limit but have not been
+     * emitted yet.
+     */
+    struct rxc_batch **closed;
+
+    /**
+     * The index of the oldest batch and the amount of batches in the queue.
+     */
+    long head, count;
+
+    /**
+     * The identifier of the timer of the open batch or <code>0</code> if no
+     * timer is pending.
+     */
+    long timer;
+
+    /**
+     * A flag to indicate the time limit of the open batch has expired, so that
+     * it is emitted as soon as downstream has demand.
+     */
+    int due;
+
+    /**
+     * The amount of elements requested from upstream that have not arrived yet.
+     */
+    long outstanding;
+
+    /**
+     * The amount of batches requested by downstream.
+     */
+    long demand;
+
+    /**
+     * Flags to indicate upstream has terminated or failed, downstream has
+     * canceled and the termination has been signalled downstream.
+     */
+    int finished, failed, canceled, signalled;
+
+    /**
+     * The failure reported by upstream.
+     */
+    void *failure;
+
+    /**
+     * Flags to prevent recursively entering the drain loop.
+     */
+    int wip, missed;
+};
+
+static void drain(struct rxc_sink_logic_grouped_within *self);
+
+static void release(struct rxc_sink_logic_grouped_within *self, struct rxc_batch *batch)
+{
+    struct rxc_sink_grouped_within *sink = (struct rxc_sink_grouped_within *) self->base.sink;
+
+    for (long i = 0; i < batch->count; i++) {
+        sink->discard(batch->elements[i]);
+    }
+
+    free(batch);
+}
+
+static void cancel_timer(struct rxc_sink_logic_grouped_within *self)
+{
+    if (self->timer > 0) {
+        self->worker->cancel_delayed(self->worker, self->timer);
+        self->timer = 0;
+    }
+}
+
+static void clear(struct rxc_sink_logic_grouped_within *self)
+{
+    struct rxc_sink_grouped_within *sink = (struct rxc_sink_grouped_within *) self->base.sink;
+
+    cancel_timer(self);
+
+    if (self->open) {
+        release(self, self->open);
+        self->open = NULL;
+    }
+
+    while (self->count > 0) {
+        release(self, self->closed[self->head]);
+        self->head = (self->head + 1) % sink->max_elements;
+        self->count--;
+    }
+}
+
+static void on_timer(void *ctx)
+{
+    struct rxc_sink_logic_grouped_within *self = ctx;
+
+    self->timer = 0;
+    self->due = 1;
+    drain(self);
+}
+
+/**
+ * Move the open batch to the queue of batches to emit.
+ */
+static void close_open(struct rxc_sink_logic_grouped_within *self)
+{
+    struct rxc_sink_grouped_within *sink = (struct rxc_sink_grouped_within *) self->base.sink;
+
+    cancel_timer(self);
+
+    self->closed[(self->head + self->count) % sink->max_elements] = self->open;
+    self->count++;
+    self->open = NULL;
+    self->due = 0;
+}
+
+/**
+ * Take the next batch to emit, if any: the oldest closed batch or otherwise
+ * the open batch once its time limit has expired or upstream has terminated.
+ */
+static struct rxc_batch * take(struct rxc_sink_logic_grouped_within *self)
+{
+    struct rxc_sink_grouped_within *sink = (struct rxc_sink_grouped_within *) self->base.sink;
+    struct rxc_batch *batch = NULL;
+
+    if (self->count > 0) {
+        batch = self->closed[self->head];
+        self->head = (self->head + 1) % sink->max_elements;
+        self->count--;
+    } else if (self->open && (self->due || self->finished)) {
+        cancel_timer(self);
+        batch = self->open;
+        self->open = NULL;
+        self->due = 0;
+    }
+
+    return batch;
+}
+
+static void drain(struct rxc_sink_logic_grouped_within *self)
+{
+    struct rxc_sink_grouped_within *sink = (struct rxc_sink_grouped_within *) self->base.sink;
+    struct rxc_sink_logic *inner = self->inner;
+    struct rxc_batch *batch;
+
+    /* Prevent re-entering the loop from within the callbacks it invokes */
+    if (self->wip) {
+        self->missed = 1;
+        return;
+    }
+
+    self->wip = 1;
+
+    do {
+        self->missed = 0;
+
+        while (self->demand > 0 && !self->canceled && (batch = take(self)) != NULL) {
+            /* LONG_MAX means unbounded */
+            if (self->demand != LONG_MAX) {
+                self->demand--;
+            }
+
+            inner->on_push(inner, batch);
+        }
+
+        if (self->canceled) {
+            break;
+        }
+
+        /*
+         * Only pull upstream while no full batch is waiting for demand, so
+         * that at most max_elements elements are held by the stage.
+         */
+        if (!self->finished && self->count == 0) {
+            long n = sink->max_elements - (self->open ? self->open->count : 0) - self->outstanding;
+
+            if (n > 0) {
+                self->outstanding += n;
+                rxc_inlet_pull(self->base.in, n);
+            }
+        }
+
+        if (self->finished && !self->open && self->count == 0 && !self->signalled) {
+            self->signalled = 1;
+
+            if (self->failed) {
+                inner->on_upstream_failure(inner, self->failure);
+            } else {
+                inner->on_upstream_finish(inner);
+            }
+        }
+    } while (self->missed);
+
+    self->wip = 0;
+}
+
+static void inlet_pull(struct rxc_inlet *in, long n)
+{
+    struct rxc_sink_logic_grouped_within *self = (void *) ((char *) in - offsetof(struct rxc_sink_logic_grouped_within, in));
+
+    if (n <= 0) {
+        return;
+    }
+
+    /* Cap the requested amount at the maximum size of a long */
+    self->demand = self->demand > LONG_MAX - n ? LONG_MAX : self->demand + n;
+    drain(self);
+}
+
+static void inlet_cancel(struct rxc_inlet *in)
+{
+    struct rxc_sink_logic_grouped_within *self = (void *) ((char *) in - offsetof(struct rxc_sink_logic_grouped_within, in));
+
+    if (self->canceled) {
+        return;
+    }
+
+    self->canceled = 1;
+    clear(self);
+    rxc_inlet_cancel(self->base.in);
+}
+
+static void sink_logic_dealloc(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_grouped_within *self = (struct rxc_sink_logic_grouped_within *) logic;
+
+    clear(self);
+    self->inner->dealloc(self->inner);
+
+    if (self->worker) {
+        self->worker->base.dealloc(&self->worker->base);
+    }
+
+    rxc_free(self->closed);
+    rxc_free(self);
+}
+
+static void sink_logic_on_connect(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_grouped_within *self = (struct rxc_sink_logic_grouped_within *) logic;
+
+    self->inner->in = &self->in;
+    self->inner->on_connect(self->inner);
+
+    /* Start filling the first batch */
+    drain(self);
+}
+
+static void sink_logic_on_push(struct rxc_sink_logic *logic, void *element)
+{
+    struct rxc_sink_logic_grouped_within *self = (struct rxc_sink_logic_grouped_within *) logic;
+    struct rxc_sink_grouped_within *sink = (struct rxc_sink_grouped_within *) logic->sink;
+    size_t weight = sink->weigh ? sink->weigh(element) : 0;
+
+    if (self->outstanding > 0) {
+        self->outstanding--;
+    }
+
+    if (self->canceled || self->finished) {
+        sink->discard(element);
+        return;
+    }
+
+    /* Close the open batch if the element would exceed its byte limit */
+    if (self->open && sink->weigh && self->open->bytes + weight > sink->max_bytes) {
+        close_open(self);
+    }
+
+    if (!self->open) {
+        self->open = malloc(sizeof(struct rxc_batch) + sink->max_elements * sizeof(void *));
+
+        if (!self->open) {
+            sink->discard(element);
+            clear(self);
+            self->finished = 1;
+            self->failed = 1;
+            rxc_inlet_cancel(logic->in);
+            drain(self);
+            return;
+        }
+
+        self->open->count = 0;
+        self->open->bytes = 0;
+
+        /* The time limit starts with the first element of the batch */
+        if (self->worker) {
+            self->timer = self->worker->schedule_delayed(self->worker, on_timer, self, sink->max_delay);
+        }
+    }
+
+    self->open->elements[self->open->count++] = element;
+    self->open->bytes += weight;
+
+    if (self->open->count == sink->max_elements || (sink->weigh && self->open->bytes >= sink->max_bytes)) {
+        close_open(self);
+    }
+
+    drain(self);
+}
+
+static void sink_logic_on_upstream_finish(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_grouped_within *self = (struct rxc_sink_logic_grouped_within *) logic;
+
+    self->finished = 1;
+    drain(self);
+}
+
+static void sink_logic_on_upstream_failure(struct rxc_sink_logic *logic, void *failure)
+{
+    struct rxc_sink_logic_grouped_within *self = (struct rxc_sink_logic_grouped_within *) logic;
+
+    self->finished = 1;
+    self->failed = 1;
+    self->failure = failure;
+    drain(self);
+}
+
+static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *sink)
+{
+    struct rxc_sink_grouped_within *self = (struct rxc_sink_grouped_within *) sink;
+    struct rxc_sink_logic_grouped_within *logic = rxc_alloc(sizeof(struct rxc_sink_logic_grouped_within));
+
+    if (!logic) {
+        return NULL;
+    }
+
+    /* Every closed batch holds at least one element */
+    logic->closed = rxc_alloc(self->max_elements * sizeof(struct rxc_batch *));
+
+    if (!logic->closed) {
+        rxc_free(logic);
+        return NULL;
+    }
+
+    logic->worker = NULL;
+
+    if (self->scheduler) {
+        logic->worker = (struct rxc_scheduler_eventloop_worker *) self->scheduler->create_worker(self->scheduler);
+    }
+
+    logic->inner = self->inner->create_logic(self->inner);
+    logic->in.pull = inlet_pull;
+    logic->in.cancel = inlet_cancel;
+    logic->open = NULL;
+    logic->head = 0;
+    logic->count = 0;
+    logic->timer = 0;
+    logic->due = 0;
+    logic->outstanding = 0;
+    logic->demand = 0;
+    logic->finished = 0;
+    logic->failed = 0;
+    logic->canceled = 0;
+    logic->signalled = 0;
+    logic->failure = NULL;
+    logic->wip = 0;
+    logic->missed = 0;
+
+    logic->base.sink = sink;
+    logic->base.dealloc = sink_logic_dealloc;
+    logic->base.on_connect = sink_logic_on_connect;
+    logic->base.on_push = sink_logic_on_push;
+    logic->base.on_push_value = NULL;
+    logic->base.on_upstream_finish = sink_logic_on_upstream_finish;
+    logic->base.on_upstream_failure = sink_logic_on_upstream_failure;
+
+    return &logic->base;
+}
+
+static void sink_dealloc(struct rxc_sink *sink, int shallow)
+{
+    struct rxc_sink_grouped_within *self = (struct rxc_sink_grouped_within *) sink;
+
+    if (!shallow) {
+        self->inner->dealloc(self->inner, shallow);
+    }
+
+    rxc_free(self);
+}
+
+struct grouped_within_ctx {
+    long max_elements;
+    size_t max_bytes;
+    long max_delay;
+    size_t (*weigh)(void *element);
+    void (*discard)(void *element);
+    struct rxc_scheduler *scheduler;
+};
+
+static struct rxc_sink * sink_wrap(struct rxc_sink *sink, void *ctx)
+{
+    struct grouped_within_ctx *grouped = ctx;
+    struct rxc_sink_grouped_within *wrapper_sink = rxc_alloc(sizeof(struct rxc_sink_grouped_within));
+
+    if (!wrapper_sink) {
+        return NULL;
+    }
+
+    wrapper_sink->inner = sink;
+    wrapper_sink->max_elements = grouped->max_elements;
+    wrapper_sink->max_bytes = grouped->max_bytes;
+    wrapper_sink->max_delay = grouped->max_delay;
+    wrapper_sink->weigh = grouped->weigh;
+    wrapper_sink->discard = grouped->discard;
+    wrapper_sink->scheduler = grouped->scheduler;
+    wrapper_sink->base.dealloc = sink_dealloc;
+    wrapper_sink->base.create_logic = sink_create_logic;
+
+    return &wrapper_sink->base;
+}
+
+struct rxc_flow * rxc_flow_grouped_within(long max_elements, size_t max_bytes, long max_delay,
+                                          size_t (*weigh)(void *element),
+                                          void (*discard)(void *element),
+                                          struct rxc_scheduler *scheduler)
+{
+    if (max_elements <= 0 || (weigh && max_bytes == 0) || (max_delay > 0 && !scheduler)) {
+        return NULL;
+    }
+
+    struct grouped_within_ctx *ctx = rxc_alloc(sizeof(struct grouped_within_ctx));
+
+    if (!ctx) {
+        return NULL;
+    }
+
+    ctx->max_elements = max_elements;
+    ctx->max_bytes = max_bytes;
+    ctx->max_delay = max_delay;
+    ctx->weigh = weigh;
+    ctx->discard = discard ? discard : free;
+    ctx->scheduler = max_delay > 0 ? scheduler : NULL;
+    return rxc_flow_wrapper(sink_wrap, ctx);
+}
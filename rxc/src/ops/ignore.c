@@ -5,11 +5,12 @@
 
 #include <rxc/rxc.h>
 #include <rxc/logic.h>
+#include <rxc/alloc.h>
 #include <rxc/ops/core.h>
 
 static void dealloc(struct rxc_sink *self, int shallow)
 {
-    free(self);
+    rxc_free(self);
 }
 
 static void on_connect(struct rxc_sink_logic *self)
@@ -22,6 +23,12 @@ static void on_push(struct rxc_sink_logic *self, void *element)
     free(element);
 }
 
+static void on_push_value(struct rxc_sink_logic *self, struct rxc_value value)
+{
+    if (value.tag == RXC_VALUE_POINTER) {
+        free(value.as.pointer);
+    }
+}
 
 static void on_upstream_finish(struct rxc_sink_logic *self)
 {}
@@ -33,16 +40,17 @@ static void on_upstream_failure(struct rxc_sink_logic *self, void *failure)
 
 static struct rxc_sink_logic * create_logic(struct rxc_sink *self)
 {
-    struct rxc_sink_logic *logic = malloc(sizeof(struct rxc_sink_logic));
+    struct rxc_sink_logic *logic = rxc_alloc(sizeof(struct rxc_sink_logic));
 
     if (!logic) {
         return NULL;
     }
 
     logic->sink = self;
-    logic->dealloc = (void (*)(struct rxc_sink_logic *)) free;
+    logic->dealloc = (void (*)(struct rxc_sink_logic *)) rxc_free;
     logic->on_connect = on_connect;
     logic->on_push = on_push;
+    logic->on_push_value = on_push_value;
     logic->on_upstream_finish = on_upstream_finish;
     logic->on_upstream_failure = on_upstream_failure;
 
@@ -51,7 +59,7 @@ static struct rxc_sink_logic * create_logic(struct rxc_sink *self)
 
 struct rxc_sink * rxc_sink_ignore()
 {
-    struct rxc_sink *sink = malloc(sizeof(struct rxc_sink));
+    struct rxc_sink *sink = rxc_alloc(sizeof(struct rxc_sink));
 
     if (!sink) {
         return NULL;
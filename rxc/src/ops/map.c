@@ -2,6 +2,7 @@
 
 #include <rxc/rxc.h>
 #include <rxc/logic.h>
+#include <rxc/alloc.h>
 #include <rxc/ops/core.h>
 
 struct rxc_sink_map {
@@ -21,7 +22,7 @@ static void sink_logic_dealloc(struct rxc_sink_logic *logic)
     struct rxc_sink_logic_map *self = (struct rxc_sink_logic_map *) logic;
 
     self->inner->dealloc(self->inner);
-    free(self);
+    rxc_free(self);
 }
 
 static void sink_logic_on_connect(struct rxc_sink_logic *self)
@@ -35,8 +36,15 @@ static void sink_logic_on_push(struct rxc_sink_logic *logic, void *element)
 {
     struct rxc_sink_logic_map *self = (struct rxc_sink_logic_map *) logic;
     struct rxc_sink_logic *inner = self->inner;
+    void *mapped = ((struct rxc_sink_map *) self->base.sink)->mapping(element);
 
-    inner->on_push(inner, ((struct rxc_sink_map *) self->base.sink)->mapping(element));
+    /* Request another element in place of the one that was dropped */
+    if (!mapped) {
+        rxc_inlet_pull(logic->in, 1);
+        return;
+    }
+
+    inner->on_push(inner, mapped);
 }
 
 
@@ -48,14 +56,14 @@ static void sink_logic_on_upstream_finish(struct rxc_sink_logic *self)
 
 static void sink_logic_on_upstream_failure(struct rxc_sink_logic *self, void *failure)
 {
-    struct rxc_sink_logic *inner = ((struct rxc_sink_logic_map *) self->sink)->inner;
+    struct rxc_sink_logic *inner = ((struct rxc_sink_logic_map *) self)->inner;
     inner->on_upstream_failure(inner, failure);
 }
 
 static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *sink)
 {
     struct rxc_sink_map *self = (struct rxc_sink_map *) sink;
-    struct rxc_sink_logic_map *logic = malloc(sizeof(struct rxc_sink_logic_map));
+    struct rxc_sink_logic_map *logic = rxc_alloc(sizeof(struct rxc_sink_logic_map));
 
     if (!logic) {
         return NULL;
@@ -66,6 +74,7 @@ static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *sink)
     logic->base.dealloc = sink_logic_dealloc;
     logic->base.on_connect = sink_logic_on_connect;
     logic->base.on_push = sink_logic_on_push;
+    logic->base.on_push_value = NULL;
     logic->base.on_upstream_finish = sink_logic_on_upstream_finish;
     logic->base.on_upstream_failure = sink_logic_on_upstream_failure;
 
@@ -80,7 +89,7 @@ static void sink_dealloc(struct rxc_sink *sink, int shallow)
         self->inner->dealloc(self->inner, shallow);
     }
 
-    free(self);
+    rxc_free(self);
 }
 
 struct map_ctx {
@@ -89,7 +98,7 @@ struct map_ctx {
 
 static struct rxc_sink * sink_wrap(struct rxc_sink *sink, void *ctx)
 {
-    struct rxc_sink_map *wrapper_sink = malloc(sizeof(struct rxc_sink_map));
+    struct rxc_sink_map *wrapper_sink = rxc_alloc(sizeof(struct rxc_sink_map));
 
     if (!wrapper_sink) {
         return NULL;
@@ -105,7 +114,7 @@ static struct rxc_sink * sink_wrap(struct rxc_sink *sink, void *ctx)
 
 struct rxc_flow * rxc_flow_map(void * (*mapping)(void *))
 {
-    struct map_ctx *ctx = malloc(sizeof(struct map_ctx));
+    struct map_ctx *ctx = rxc_alloc(sizeof(struct map_ctx));
     ctx->mapping = mapping;
     return rxc_flow_wrapper(sink_wrap, ctx);
 }
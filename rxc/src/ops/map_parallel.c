@@ -0,0 +1,495 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+#include <rxc/rxc.h>
+#include <rxc/logic.h>
+#include <rxc/alloc.h>
+#include <rxc/ops/core.h>
+
+#define PARALLEL_FINISHED  (1 << 0) /* Upstream has finished */
+#define PARALLEL_FAILED    (1 << 1) /* Upstream has failed */
+#define PARALLEL_CANCELED  (1 << 2) /* Downstream has canceled */
+#define PARALLEL_SIGNALLED (1 << 3) /* Termination has been signalled downstream */
+#define PARALLEL_DISPOSED  (1 << 4) /* The pipeline has deallocated the stage */
+
+struct rxc_sink_map_parallel {
+    struct rxc_sink base;
+    struct rxc_sink *inner;
+
+    void * (*mapping)(void *element);
+    long parallelism;
+    struct rxc_scheduler *scheduler;
+    void (*discard)(void *element);
+};
+
+/**
+ * A slot holding an element while it is being mapped.
+ */
+struct map_parallel_slot {
+    struct rxc_sink_logic_map_parallel *owner;
+    void *input;
+    void *result;
+
+    /**
+     * A flag to indicate the result of the mapping is available.
+     */
+    atomic_int done;
+};
+
+struct rxc_sink_logic_map_parallel {
+    struct rxc_sink_logic base;
+    struct rxc_sink_logic *inner;
+
+    /**
+     * The inlet exposed to the downstream logic.
+     */
+    struct rxc_inlet in;
+
+    void * (*mapping)(void *element);
+    void (*discard)(void *element);
+    long parallelism;
+
+    /**
+     * The worker on which the stage pulls upstream and emits downstream.
+     */
+    struct rxc_scheduler_worker *stage;
+
+    /**
+     * The workers on which the mapping runs, one for each slot.
+     */
+    struct rxc_scheduler_worker **compute;
+
+    /**
+     * The slots of the elements in flight, used in upstream order.
+     */
+    struct map_parallel_slot *slots;
+
+    /**
+     * The sequence number of the next slot to fill, advanced by upstream.
+     */
+    atomic_long tail;
+
+    /**
+     * The sequence number of the next slot to emit, owned by the stage worker.
+     */
+    long head;
+
+    /**
+     * The amount of elements requested by downstream that have not been
+     * delivered yet.
+     */
+    atomic_long demand;
+
+    /**
+     * The amount of free slots that have not been requested from upstream.
+     */
+    atomic_long credit;
+
+    /**
+     * A flag to prevent scheduling the drain task more than once.
+     */
+    atomic_int drain_pending;
+
+    /**
+     * The state flags of the stage.
+     */
+    atomic_int state;
+
+    /**
+     * The failure reported by upstream.
+     */
+    void *failure;
+
+    /**
+     * The amount of references to the logic: one held by the pipeline and
+     * one for every task that is scheduled but has not run yet. Tasks may
+     * still run after the pipeline has deallocated the stage, so the logic
+     * is released by whoever drops the last reference.
+     */
+    atomic_long refs;
+};
+
+static void stage_drain(void *ctx);
+
+static void logic_retain(struct rxc_sink_logic_map_parallel *self)
+{
+    atomic_fetch_add_explicit(&self->refs, 1, memory_order_relaxed);
+}
+
+static void logic_release(struct rxc_sink_logic_map_parallel *self)
+{
+    if (atomic_fetch_sub_explicit(&self->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    /* Release the elements that are still in flight */
+    for (long i = self->head; i < atomic_load_explicit(&self->tail, memory_order_relaxed); i++) {
+        struct map_parallel_slot *slot = &self->slots[i % self->parallelism];
+
+        if (atomic_load_explicit(&slot->done, memory_order_relaxed)) {
+            self->discard(slot->result);
+        } else {
+            self->discard(slot->input);
+        }
+    }
+
+    int state = atomic_load_explicit(&self->state, memory_order_relaxed);
+
+    if ((state & PARALLEL_FAILED) && !(state & PARALLEL_SIGNALLED)) {
+        free(self->failure);
+    }
+
+    for (long i = 0; i < self->parallelism; i++) {
+        self->compute[i]->dealloc(self->compute[i]);
+    }
+
+    self->stage->dealloc(self->stage);
+    free(self->compute);
+    free(self->slots);
+    free(self);
+}
+
+static void schedule(struct rxc_sink_logic_map_parallel *self, struct rxc_scheduler_worker *worker,
+                     void (*runnable)(void *), void *ctx)
+{
+    logic_retain(self);
+    worker->schedule(worker, runnable, ctx);
+}
+
+static int disposed(struct rxc_sink_logic_map_parallel *self)
+{
+    return atomic_load_explicit(&self->state, memory_order_acquire) & PARALLEL_DISPOSED;
+}
+
+static void signal_stage(struct rxc_sink_logic_map_parallel *self)
+{
+    if (!atomic_exchange_explicit(&self->drain_pending, 1, memory_order_acq_rel)) {
+        schedule(self, self->stage, stage_drain, self);
+    }
+}
+
+static void compute_run(void *ctx)
+{
+    struct map_parallel_slot *slot = ctx;
+    struct rxc_sink_logic_map_parallel *self = slot->owner;
+
+    /* The input is released with the logic if the stage is gone */
+    if (!disposed(self)) {
+        slot->result = self->mapping(slot->input);
+
+        /* Publish the result to the stage worker */
+        atomic_store_explicit(&slot->done, 1, memory_order_release);
+        signal_stage(self);
+    }
+
+    logic_release(self);
+}
+
+static void stage_emit(struct rxc_sink_logic_map_parallel *self)
+{
+    struct rxc_sink_logic *inner = self->inner;
+    long tail, freed = 0;
+
+    atomic_store_explicit(&self->drain_pending, 0, memory_order_release);
+
+    int state = atomic_load_explicit(&self->state, memory_order_acquire);
+    tail = atomic_load_explicit(&self->tail, memory_order_acquire);
+
+    /* Emit the results in upstream order while downstream has demand */
+    while (self->head < tail) {
+        struct map_parallel_slot *slot = &self->slots[self->head % self->parallelism];
+
+        if (!atomic_load_explicit(&slot->done, memory_order_acquire)) {
+            break;
+        }
+
+        /* Results that arrive after cancellation are discarded, which
+         * downstream may request while it receives an element */
+        state = atomic_load_explicit(&self->state, memory_order_acquire);
+
+        if (state & PARALLEL_CANCELED) {
+            self->discard(slot->result);
+        } else if (atomic_load_explicit(&self->demand, memory_order_acquire) > 0) {
+            /* LONG_MAX means unbounded */
+            if (atomic_load_explicit(&self->demand, memory_order_relaxed) != LONG_MAX) {
+                atomic_fetch_sub_explicit(&self->demand, 1, memory_order_acq_rel);
+            }
+
+            inner->on_push(inner, slot->result);
+        } else {
+            break;
+        }
+
+        atomic_store_explicit(&slot->done, 0, memory_order_relaxed);
+        self->head++;
+        freed++;
+    }
+
+    if (state & PARALLEL_CANCELED) {
+        return;
+    }
+
+    /* Request an element from upstream for every free slot */
+    if (freed > 0) {
+        atomic_fetch_add_explicit(&self->credit, freed, memory_order_acq_rel);
+    }
+
+    if (!(state & (PARALLEL_FINISHED | PARALLEL_FAILED))) {
+        long n = atomic_exchange_explicit(&self->credit, 0, memory_order_acq_rel);
+
+        if (n > 0) {
+            rxc_inlet_pull(self->base.in, n);
+        }
+        return;
+    }
+
+    /* Deliver the termination signal once all elements have been emitted */
+    if ((state & PARALLEL_SIGNALLED) || self->head != atomic_load_explicit(&self->tail, memory_order_acquire)) {
+        return;
+    }
+
+    atomic_fetch_or_explicit(&self->state, PARALLEL_SIGNALLED, memory_order_acq_rel);
+
+    if (state & PARALLEL_FAILED) {
+        inner->on_upstream_failure(inner, self->failure);
+    } else {
+        inner->on_upstream_finish(inner);
+    }
+}
+
+static void stage_drain(void *ctx)
+{
+    struct rxc_sink_logic_map_parallel *self = ctx;
+
+    if (!disposed(self)) {
+        stage_emit(self);
+    }
+
+    logic_release(self);
+}
+
+static void stage_connect(void *ctx)
+{
+    struct rxc_sink_logic_map_parallel *self = ctx;
+
+    if (!disposed(self)) {
+        self->inner->on_connect(self->inner);
+
+        /* Fill the slots */
+        signal_stage(self);
+    }
+
+    logic_release(self);
+}
+
+static void stage_cancel(void *ctx)
+{
+    struct rxc_sink_logic_map_parallel *self = ctx;
+
+    if (!disposed(self)) {
+        rxc_inlet_cancel(self->base.in);
+    }
+
+    logic_release(self);
+}
+
+static void inlet_pull(struct rxc_inlet *in, long n)
+{
+    struct rxc_sink_logic_map_parallel *self = (void *) ((char *) in - offsetof(struct rxc_sink_logic_map_parallel, in));
+    long demand = atomic_load_explicit(&self->demand, memory_order_relaxed);
+    long next;
+
+    if (n <= 0) {
+        return;
+    }
+
+    /* Cap the requested amount at the maximum size of a long */
+    do {
+        next = demand > LONG_MAX - n ? LONG_MAX : demand + n;
+    } while (!atomic_compare_exchange_weak_explicit(&self->demand, &demand, next,
+                                                    memory_order_acq_rel,
+                                                    memory_order_relaxed));
+
+    signal_stage(self);
+}
+
+static void inlet_cancel(struct rxc_inlet *in)
+{
+    struct rxc_sink_logic_map_parallel *self = (void *) ((char *) in - offsetof(struct rxc_sink_logic_map_parallel, in));
+    int state = atomic_fetch_or_explicit(&self->state, PARALLEL_CANCELED, memory_order_acq_rel);
+
+    if (!(state & PARALLEL_CANCELED)) {
+        schedule(self, self->stage, stage_cancel, self);
+    }
+}
+
+static void sink_logic_dealloc(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_map_parallel *self = (struct rxc_sink_logic_map_parallel *) logic;
+
+    /* Tasks that are still queued find the stage disposed and only drop
+     * their reference */
+    atomic_fetch_or_explicit(&self->state, PARALLEL_DISPOSED, memory_order_acq_rel);
+
+    self->inner->dealloc(self->inner);
+
+    /* The workers are released with the logic, since a running task may
+     * still schedule mappings on them */
+    logic_release(self);
+}
+
+static void sink_logic_on_connect(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_map_parallel *self = (struct rxc_sink_logic_map_parallel *) logic;
+
+    self->inner->in = &self->in;
+    schedule(self, self->stage, stage_connect, self);
+}
+
+static void sink_logic_on_push(struct rxc_sink_logic *logic, void *element)
+{
+    struct rxc_sink_logic_map_parallel *self = (struct rxc_sink_logic_map_parallel *) logic;
+    long tail = atomic_load_explicit(&self->tail, memory_order_relaxed);
+    long index = tail % self->parallelism;
+    struct map_parallel_slot *slot = &self->slots[index];
+
+    /* Upstream only receives demand for free slots */
+    slot->input = element;
+    atomic_store_explicit(&self->tail, tail + 1, memory_order_release);
+
+    schedule(self, self->compute[index], compute_run, slot);
+}
+
+static void sink_logic_on_upstream_finish(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_map_parallel *self = (struct rxc_sink_logic_map_parallel *) logic;
+
+    atomic_fetch_or_explicit(&self->state, PARALLEL_FINISHED, memory_order_acq_rel);
+    signal_stage(self);
+}
+
+static void sink_logic_on_upstream_failure(struct rxc_sink_logic *logic, void *failure)
+{
+    struct rxc_sink_logic_map_parallel *self = (struct rxc_sink_logic_map_parallel *) logic;
+
+    self->failure = failure;
+    atomic_fetch_or_explicit(&self->state, PARALLEL_FAILED, memory_order_acq_rel);
+    signal_stage(self);
+}
+
+static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *sink)
+{
+    struct rxc_sink_map_parallel *self = (struct rxc_sink_map_parallel *) sink;
+    /* The logic, its slots and workers may outlive the pipeline, so they are not
+     * allocated from its block */
+    struct rxc_sink_logic_map_parallel *logic = malloc(sizeof(struct rxc_sink_logic_map_parallel));
+
+    if (!logic) {
+        return NULL;
+    }
+
+    logic->slots = malloc(self->parallelism * sizeof(struct map_parallel_slot));
+    logic->compute = malloc(self->parallelism * sizeof(struct rxc_scheduler_worker *));
+
+    if (!logic->slots || !logic->compute) {
+        free(logic->slots);
+        free(logic->compute);
+        free(logic);
+        return NULL;
+    }
+
+    for (long i = 0; i < self->parallelism; i++) {
+        logic->slots[i].owner = logic;
+        logic->slots[i].input = NULL;
+        logic->slots[i].result = NULL;
+        atomic_init(&logic->slots[i].done, 0);
+        logic->compute[i] = self->scheduler->create_worker(self->scheduler);
+    }
+
+    logic->inner = self->inner->create_logic(self->inner);
+    logic->stage = self->scheduler->create_worker(self->scheduler);
+    logic->mapping = self->mapping;
+    logic->discard = self->discard;
+    logic->parallelism = self->parallelism;
+    logic->head = 0;
+    logic->failure = NULL;
+    logic->in.pull = inlet_pull;
+    logic->in.cancel = inlet_cancel;
+    atomic_init(&logic->tail, 0);
+    atomic_init(&logic->demand, 0);
+    atomic_init(&logic->credit, self->parallelism);
+    atomic_init(&logic->drain_pending, 0);
+    atomic_init(&logic->state, 0);
+    atomic_init(&logic->refs, 1);
+
+    logic->base.sink = sink;
+    logic->base.dealloc = sink_logic_dealloc;
+    logic->base.on_connect = sink_logic_on_connect;
+    logic->base.on_push = sink_logic_on_push;
+    logic->base.on_push_value = NULL;
+    logic->base.on_upstream_finish = sink_logic_on_upstream_finish;
+    logic->base.on_upstream_failure = sink_logic_on_upstream_failure;
+
+    return &logic->base;
+}
+
+static void sink_dealloc(struct rxc_sink *sink, int shallow)
+{
+    struct rxc_sink_map_parallel *self = (struct rxc_sink_map_parallel *) sink;
+
+    if (!shallow) {
+        self->inner->dealloc(self->inner, shallow);
+    }
+
+    rxc_free(self);
+}
+
+struct map_parallel_ctx {
+    void * (*mapping)(void *element);
+    long parallelism;
+    struct rxc_scheduler *scheduler;
+    void (*discard)(void *element);
+};
+
+static struct rxc_sink * sink_wrap(struct rxc_sink *sink, void *ctx)
+{
+    struct map_parallel_ctx *parallel = ctx;
+    struct rxc_sink_map_parallel *wrapper_sink = rxc_alloc(sizeof(struct rxc_sink_map_parallel));
+
+    if (!wrapper_sink) {
+        return NULL;
+    }
+
+    wrapper_sink->inner = sink;
+    wrapper_sink->mapping = parallel->mapping;
+    wrapper_sink->parallelism = parallel->parallelism;
+    wrapper_sink->scheduler = parallel->scheduler;
+    wrapper_sink->discard = parallel->discard;
+    wrapper_sink->base.dealloc = sink_dealloc;
+    wrapper_sink->base.create_logic = sink_create_logic;
+
+    return &wrapper_sink->base;
+}
+
+struct rxc_flow * rxc_flow_map_parallel(void * (*mapping)(void *), long parallelism,
+                                        struct rxc_scheduler *scheduler,
+                                        void (*discard)(void *element))
+{
+    if (parallelism <= 0) {
+        return NULL;
+    }
+
+    struct map_parallel_ctx *ctx = rxc_alloc(sizeof(struct map_parallel_ctx));
+
+    if (!ctx) {
+        return NULL;
+    }
+
+    ctx->mapping = mapping;
+    ctx->parallelism = parallelism;
+    ctx->scheduler = scheduler;
+    ctx->discard = discard ? discard : free;
+    return rxc_flow_wrapper(sink_wrap, ctx);
+}
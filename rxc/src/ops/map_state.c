@@ -0,0 +1,278 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+
+#include <rxc/rxc.h>
+#include <rxc/logic.h>
+#include <rxc/alloc.h>
+#include <rxc/ops/core.h>
+
+struct map_state_ctx {
+    void * (*create)(void *ctx);
+    void * (*mapping)(void *state, void *element);
+    void * (*flush)(void *state);
+    void (*dealloc)(void *state);
+    void *ctx;
+};
+
+struct rxc_sink_map_state {
+    struct rxc_sink base;
+    struct rxc_sink *inner;
+    struct map_state_ctx *ctx;
+};
+
+struct rxc_sink_logic_map_state {
+    struct rxc_sink_logic base;
+    struct rxc_sink_logic *inner;
+    void *state;
+
+    /**
+     * The inlet exposed to the downstream logic if the state is flushed, which
+     * keeps track of the demand of downstream.
+     */
+    struct rxc_inlet in;
+
+    /**
+     * The amount of elements requested by downstream.
+     */
+    long demand;
+
+    /**
+     * Flags to indicate upstream has finished and the state has been flushed.
+     */
+    int finished, flushed;
+};
+
+/* Release the state as soon as the stream terminates, like generators release
+ * their resources */
+static void release(struct rxc_sink_logic_map_state *self)
+{
+    struct map_state_ctx *ctx = ((struct rxc_sink_map_state *) self->base.sink)->ctx;
+
+    if (self->state) {
+        ctx->dealloc(self->state);
+        self->state = NULL;
+    }
+}
+
+/* Emit the element the state is flushed into and finish downstream */
+static void flush(struct rxc_sink_logic_map_state *self)
+{
+    struct map_state_ctx *ctx = ((struct rxc_sink_map_state *) self->base.sink)->ctx;
+    struct rxc_sink_logic *inner = self->inner;
+    void *element;
+
+    if (self->flushed) {
+        return;
+    }
+
+    self->flushed = 1;
+    element = self->state ? ctx->flush(self->state) : NULL;
+    release(self);
+
+    if (element) {
+        inner->on_push(inner, element);
+    }
+
+    inner->on_upstream_finish(inner);
+}
+
+static void inlet_pull(struct rxc_inlet *in, long n)
+{
+    struct rxc_sink_logic_map_state *self = (void *) ((char *) in - offsetof(struct rxc_sink_logic_map_state, in));
+
+    if (n <= 0) {
+        return;
+    }
+
+    /* Cap the requested amount at the maximum size of a long */
+    self->demand = self->demand > LONG_MAX - n ? LONG_MAX : self->demand + n;
+
+    if (self->finished) {
+        flush(self);
+        return;
+    }
+
+    rxc_inlet_pull(self->base.in, n);
+}
+
+static void inlet_cancel(struct rxc_inlet *in)
+{
+    struct rxc_sink_logic_map_state *self = (void *) ((char *) in - offsetof(struct rxc_sink_logic_map_state, in));
+
+    /* Nothing will be flushed once downstream has lost interest, while the
+     * state is still needed for the elements that upstream may send until it
+     * terminates */
+    self->flushed = 1;
+
+    if (self->finished) {
+        release(self);
+        return;
+    }
+
+    rxc_inlet_cancel(self->base.in);
+}
+
+static void sink_logic_dealloc(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_map_state *self = (struct rxc_sink_logic_map_state *) logic;
+
+    release(self);
+    self->inner->dealloc(self->inner);
+    rxc_free(self);
+}
+
+static void sink_logic_on_connect(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_map_state *self = (struct rxc_sink_logic_map_state *) logic;
+    struct map_state_ctx *ctx = ((struct rxc_sink_map_state *) logic->sink)->ctx;
+    struct rxc_sink_logic *inner = self->inner;
+
+    /* Only track the demand of downstream if there is something to flush */
+    inner->in = ctx->flush ? &self->in : logic->in;
+    inner->on_connect(inner);
+}
+
+static void sink_logic_on_push(struct rxc_sink_logic *logic, void *element)
+{
+    struct rxc_sink_logic_map_state *self = (struct rxc_sink_logic_map_state *) logic;
+    struct map_state_ctx *ctx = ((struct rxc_sink_map_state *) self->base.sink)->ctx;
+    struct rxc_sink_logic *inner = self->inner;
+    void *mapped = ctx->mapping(self->state, element);
+
+    /* Request another element in place of the one that was absorbed */
+    if (!mapped) {
+        rxc_inlet_pull(logic->in, 1);
+        return;
+    }
+
+    /* LONG_MAX means unbounded */
+    if (self->demand > 0 && self->demand != LONG_MAX) {
+        self->demand--;
+    }
+
+    inner->on_push(inner, mapped);
+}
+
+static void sink_logic_on_upstream_finish(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_map_state *self = (struct rxc_sink_logic_map_state *) logic;
+    struct map_state_ctx *ctx = ((struct rxc_sink_map_state *) logic->sink)->ctx;
+    struct rxc_sink_logic *inner = self->inner;
+
+    /* Nothing is flushed into downstream once it has canceled */
+    if (!ctx->flush || self->flushed) {
+        release(self);
+        inner->on_upstream_finish(inner);
+        return;
+    }
+
+    /* Flush the state once downstream has room for the element it yields */
+    self->finished = 1;
+
+    if (self->demand > 0) {
+        flush(self);
+    }
+}
+
+static void sink_logic_on_upstream_failure(struct rxc_sink_logic *logic, void *failure)
+{
+    struct rxc_sink_logic_map_state *self = (struct rxc_sink_logic_map_state *) logic;
+    struct rxc_sink_logic *inner = self->inner;
+
+    release(self);
+    inner->on_upstream_failure(inner, failure);
+}
+
+static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *sink)
+{
+    struct rxc_sink_map_state *self = (struct rxc_sink_map_state *) sink;
+    struct rxc_sink_logic_map_state *logic = rxc_alloc(sizeof(struct rxc_sink_logic_map_state));
+
+    if (!logic) {
+        return NULL;
+    }
+
+    logic->state = self->ctx->create(self->ctx->ctx);
+
+    if (!logic->state) {
+        rxc_free(logic);
+        return NULL;
+    }
+
+    logic->inner = self->inner->create_logic(self->inner);
+
+    if (!logic->inner) {
+        self->ctx->dealloc(logic->state);
+        rxc_free(logic);
+        return NULL;
+    }
+
+    logic->in.pull = inlet_pull;
+    logic->in.cancel = inlet_cancel;
+    logic->demand = 0;
+    logic->finished = 0;
+    logic->flushed = 0;
+    logic->base.sink = sink;
+    logic->base.dealloc = sink_logic_dealloc;
+    logic->base.on_connect = sink_logic_on_connect;
+    logic->base.on_push = sink_logic_on_push;
+    logic->base.on_push_value = NULL;
+    logic->base.on_upstream_finish = sink_logic_on_upstream_finish;
+    logic->base.on_upstream_failure = sink_logic_on_upstream_failure;
+
+    return &logic->base;
+}
+
+static void sink_dealloc(struct rxc_sink *sink, int shallow)
+{
+    struct rxc_sink_map_state *self = ((struct rxc_sink_map_state *) sink);
+
+    if (!shallow) {
+        self->inner->dealloc(self->inner, shallow);
+    }
+
+    rxc_free(self);
+}
+
+static struct rxc_sink * sink_wrap(struct rxc_sink *sink, void *ctx)
+{
+    struct rxc_sink_map_state *wrapper_sink = rxc_alloc(sizeof(struct rxc_sink_map_state));
+
+    if (!wrapper_sink) {
+        return NULL;
+    }
+
+    wrapper_sink->inner = sink;
+    wrapper_sink->ctx = ctx;
+    wrapper_sink->base.dealloc = sink_dealloc;
+    wrapper_sink->base.create_logic = sink_create_logic;
+
+    return &wrapper_sink->base;
+}
+
+struct rxc_flow * rxc_flow_map_state(void * (*create)(void *ctx),
+                                     void * (*mapping)(void *state, void *element),
+                                     void (*dealloc)(void *state), void *ctx)
+{
+    return rxc_flow_map_state_flush(create, mapping, NULL, dealloc, ctx);
+}
+
+struct rxc_flow * rxc_flow_map_state_flush(void * (*create)(void *ctx),
+                                           void * (*mapping)(void *state, void *element),
+                                           void * (*flush)(void *state),
+                                           void (*dealloc)(void *state), void *ctx)
+{
+    struct map_state_ctx *state_ctx = rxc_alloc(sizeof(struct map_state_ctx));
+
+    if (!state_ctx) {
+        return NULL;
+    }
+
+    state_ctx->create = create;
+    state_ctx->mapping = mapping;
+    state_ctx->flush = flush;
+    state_ctx->dealloc = dealloc;
+    state_ctx->ctx = ctx;
+    return rxc_flow_wrapper(sink_wrap, state_ctx);
+}
@@ -0,0 +1,122 @@
+#include <stdlib.h>
+
+#include <rxc/rxc.h>
+#include <rxc/logic.h>
+#include <rxc/alloc.h>
+#include <rxc/ops/core.h>
+
+struct rxc_sink_map_value {
+    struct rxc_sink base;
+    struct rxc_sink *inner;
+
+    struct rxc_value (*mapping)(struct rxc_value value);
+};
+
+struct rxc_sink_logic_map_value {
+    struct rxc_sink_logic base;
+    struct rxc_sink_logic *inner;
+};
+
+static void sink_logic_dealloc(struct rxc_sink_logic *logic)
+{
+    struct rxc_sink_logic_map_value *self = (struct rxc_sink_logic_map_value *) logic;
+
+    self->inner->dealloc(self->inner);
+    rxc_free(self);
+}
+
+static void sink_logic_on_connect(struct rxc_sink_logic *self)
+{
+    struct rxc_sink_logic *inner = ((struct rxc_sink_logic_map_value *) self)->inner;
+    inner->in = self->in;
+    inner->on_connect(inner);
+}
+
+static void sink_logic_on_push_value(struct rxc_sink_logic *logic, struct rxc_value value)
+{
+    struct rxc_sink_logic_map_value *self = (struct rxc_sink_logic_map_value *) logic;
+    struct rxc_sink_map_value *sink = (struct rxc_sink_map_value *) self->base.sink;
+
+    rxc_sink_logic_push_value(self->inner, sink->mapping(value));
+}
+
+static void sink_logic_on_push(struct rxc_sink_logic *logic, void *element)
+{
+    sink_logic_on_push_value(logic, rxc_value_pointer(element));
+}
+
+static void sink_logic_on_upstream_finish(struct rxc_sink_logic *self)
+{
+    struct rxc_sink_logic *inner = ((struct rxc_sink_logic_map_value *) self)->inner;
+    inner->on_upstream_finish(inner);
+}
+
+static void sink_logic_on_upstream_failure(struct rxc_sink_logic *self, void *failure)
+{
+    struct rxc_sink_logic *inner = ((struct rxc_sink_logic_map_value *) self)->inner;
+    inner->on_upstream_failure(inner, failure);
+}
+
+static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *sink)
+{
+    struct rxc_sink_map_value *self = (struct rxc_sink_map_value *) sink;
+    struct rxc_sink_logic_map_value *logic = rxc_alloc(sizeof(struct rxc_sink_logic_map_value));
+
+    if (!logic) {
+        return NULL;
+    }
+
+    logic->inner = self->inner->create_logic(self->inner);
+    logic->base.sink = sink;
+    logic->base.dealloc = sink_logic_dealloc;
+    logic->base.on_connect = sink_logic_on_connect;
+    logic->base.on_push = sink_logic_on_push;
+    logic->base.on_push_value = sink_logic_on_push_value;
+    logic->base.on_upstream_finish = sink_logic_on_upstream_finish;
+    logic->base.on_upstream_failure = sink_logic_on_upstream_failure;
+
+    return &logic->base;
+}
+
+static void sink_dealloc(struct rxc_sink *sink, int shallow)
+{
+    struct rxc_sink_map_value *self = ((struct rxc_sink_map_value *) sink);
+
+    if (!shallow) {
+        self->inner->dealloc(self->inner, shallow);
+    }
+
+    rxc_free(self);
+}
+
+struct map_value_ctx {
+    struct rxc_value (*mapping)(struct rxc_value value);
+};
+
+static struct rxc_sink * sink_wrap(struct rxc_sink *sink, void *ctx)
+{
+    struct rxc_sink_map_value *wrapper_sink = rxc_alloc(sizeof(struct rxc_sink_map_value));
+
+    if (!wrapper_sink) {
+        return NULL;
+    }
+
+    wrapper_sink->inner = sink;
+    wrapper_sink->mapping = ((struct map_value_ctx *) ctx)->mapping;
+    wrapper_sink->base.dealloc = sink_dealloc;
+    wrapper_sink->base.create_logic = sink_create_logic;
+
+    return &wrapper_sink->base;
+}
+
+struct rxc_flow * rxc_flow_map_value(struct rxc_value (*mapping)(struct rxc_value))
+{
+    struct map_value_ctx *ctx = rxc_alloc(sizeof(struct map_value_ctx));
+
+    if (!ctx) {
+        return NULL;
+    }
+
+    ctx->mapping = mapping;
+    return rxc_flow_wrapper(sink_wrap, ctx);
+}
@@ -0,0 +1,529 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+
+#include <rxc/rxc.h>
+#include <rxc/logic.h>
+#include <rxc/alloc.h>
+#include <rxc/ops/hub.h>
+
+struct rxc_hub_merge_input {
+    struct rxc_sink_logic base;
+
+    /**
+     * The hub this input is attached to.
+     */
+    struct rxc_hub_merge *hub;
+
+    /**
+     * The queue of elements received from the input.
+     */
+    void **queue;
+
+    /**
+     * The amount of elements the queue can hold, which follows the share of
+     * the input in the hub.
+     */
+    long capacity;
+
+    /**
+     * The index of the oldest element and the amount of elements in the queue.
+     */
+    long head, count;
+
+    /**
+     * The amount of elements requested from the input that have not arrived.
+     */
+    long outstanding;
+
+    /**
+     * A flag to indicate the input has terminated.
+     */
+    int done;
+
+    /**
+     * The next input attached to the hub.
+     */
+    struct rxc_hub_merge_input *next;
+};
+
+struct rxc_hub_merge {
+    /**
+     * The sink through which inputs attach to the hub.
+     */
+    struct rxc_sink sink;
+
+    /**
+     * The source through which the merged stream is emitted.
+     */
+    struct rxc_source source;
+
+    /**
+     * The logic of the source connected downstream.
+     */
+    struct rxc_source_logic logic;
+
+    /**
+     * The amount of elements the inputs may have in flight together.
+     */
+    long size;
+
+    /**
+     * The function to release discarded elements with.
+     */
+    void (*discard)(void *element);
+
+    /**
+     * The inputs attached to the hub in the order they are served.
+     */
+    struct rxc_hub_merge_input *head, *tail;
+
+    /**
+     * The inputs that have been detached from the hub, but may still be on the
+     * stack of their own callbacks.
+     */
+    struct rxc_hub_merge_input *retired;
+
+    /**
+     * The amount of attached inputs.
+     */
+    long count;
+
+    /**
+     * Flags to indicate the state of the hub.
+     */
+    int connected, closed, canceled, finished;
+
+    /**
+     * Flags to prevent recursively entering the dispatch loop.
+     */
+    int wip, missed;
+};
+
+static void * input_dequeue(struct rxc_hub_merge_input *input)
+{
+    void *element = input->queue[input->head];
+
+    input->head = (input->head + 1) % input->capacity;
+    input->count--;
+
+    return element;
+}
+
+/* Grow the queue of the input to the specified capacity */
+static int input_resize(struct rxc_hub_merge_input *input, long capacity)
+{
+    void **queue = malloc(capacity * sizeof(void *));
+
+    if (!queue) {
+        return -1;
+    }
+
+    for (long i = 0; i < input->count; i++) {
+        queue[i] = input->queue[(input->head + i) % input->capacity];
+    }
+
+    free(input->queue);
+    input->queue = queue;
+    input->capacity = capacity;
+    input->head = 0;
+
+    return 0;
+}
+
+static void input_free(struct rxc_hub_merge_input *input)
+{
+    struct rxc_connection *conn = input->base.in ? rxc_inlet_connection(input->base.in) : NULL;
+
+    /* Sources that connected to the hub directly leave their logic and the
+     * connection to the hub */
+    if (conn) {
+        rxc_connection_dealloc(conn);
+    }
+
+    free(input->queue);
+    free(input);
+}
+
+/* Release the inputs that were detached, which may only happen once none of
+ * their callbacks is running */
+static void reap(struct rxc_hub_merge *hub)
+{
+    while (hub->retired) {
+        struct rxc_hub_merge_input *input = hub->retired;
+
+        hub->retired = input->next;
+        input_free(input);
+    }
+}
+
+/* The amount of elements each input may have in flight */
+static long share(struct rxc_hub_merge *hub)
+{
+    return hub->count > 0 ? (hub->size + hub->count - 1) / hub->count : hub->size;
+}
+
+static void dispatch(struct rxc_hub_merge *hub)
+{
+    struct rxc_hub_merge_input *input, **link;
+
+    /* Prevent re-entering the loop from within the callbacks it invokes */
+    if (hub->wip) {
+        hub->missed = 1;
+        return;
+    }
+
+    hub->wip = 1;
+
+    do {
+        hub->missed = 0;
+
+        /* Serve the inputs round-robin, one element each per round */
+        while (hub->connected && !hub->finished && rxc_outlet_available(hub->logic.out)) {
+            int progress = 0;
+            long rounds = hub->count;
+
+            while (rounds-- > 0 && rxc_outlet_available(hub->logic.out)) {
+                input = hub->head;
+
+                /* Move the input to the back of the line */
+                if (input->next) {
+                    hub->head = input->next;
+                    hub->tail->next = input;
+                    hub->tail = input;
+                    input->next = NULL;
+                }
+
+                if (input->count > 0) {
+                    progress = 1;
+                    rxc_outlet_emit(hub->logic.out, input_dequeue(input));
+                }
+            }
+
+            if (!progress) {
+                break;
+            }
+        }
+
+        /* Forget the inputs that have terminated and were drained */
+        hub->tail = NULL;
+        link = &hub->head;
+        while ((input = *link) != NULL) {
+            if (input->done && (input->count == 0 || hub->canceled)) {
+                *link = input->next;
+                hub->count--;
+                input->next = hub->retired;
+                hub->retired = input;
+            } else {
+                hub->tail = input;
+                link = &input->next;
+            }
+        }
+
+        /* Refill the inputs that have drained below half of their share */
+        long limit = share(hub);
+
+        for (input = hub->head; input; input = input->next) {
+            /* Grow the queue if inputs have left, or make do with it */
+            if (input->capacity < limit && !input->done) {
+                input_resize(input, limit);
+            }
+
+            long quota = input->capacity < limit ? input->capacity : limit;
+
+            if (input->done || input->count + input->outstanding > quota / 2) {
+                continue;
+            }
+
+            long n = quota - input->count - input->outstanding;
+
+            if (n <= 0) {
+                continue;
+            }
+
+            input->outstanding += n;
+            rxc_inlet_pull(input->base.in, n);
+        }
+
+        if (hub->connected && hub->closed && hub->count == 0 && !hub->finished) {
+            hub->finished = 1;
+            rxc_outlet_complete(hub->logic.out);
+        }
+    } while (hub->missed);
+
+    hub->wip = 0;
+}
+
+/* Input side */
+static void input_dealloc(struct rxc_sink_logic *self)
+{
+    /* Inputs are owned by the hub */
+}
+
+static void input_on_connect(struct rxc_sink_logic *self)
+{
+    struct rxc_hub_merge_input *input = (struct rxc_hub_merge_input *) self;
+
+    if (input->hub->canceled) {
+        input->done = 1;
+        rxc_inlet_cancel(self->in);
+    }
+
+    dispatch(input->hub);
+}
+
+static void input_on_push(struct rxc_sink_logic *self, void *element)
+{
+    struct rxc_hub_merge_input *input = (struct rxc_hub_merge_input *) self;
+    struct rxc_hub_merge *hub = input->hub;
+
+    if (input->outstanding > 0) {
+        input->outstanding--;
+    }
+
+    /* Inputs may not emit more than they were asked for */
+    if (input->count == input->capacity || hub->canceled) {
+        hub->discard(element);
+        return;
+    }
+
+    input->queue[(input->head + input->count) % input->capacity] = element;
+    input->count++;
+    dispatch(hub);
+}
+
+static void input_on_upstream_finish(struct rxc_sink_logic *self)
+{
+    struct rxc_hub_merge_input *input = (struct rxc_hub_merge_input *) self;
+
+    input->done = 1;
+    dispatch(input->hub);
+}
+
+static void input_on_upstream_failure(struct rxc_sink_logic *self, void *failure)
+{
+    struct rxc_hub_merge_input *input = (struct rxc_hub_merge_input *) self;
+
+    /* A failing input only terminates itself */
+    free(failure);
+    input->done = 1;
+    dispatch(input->hub);
+}
+
+static void sink_dealloc(struct rxc_sink *self, int shallow)
+{
+    /* The sink is owned by the hub */
+}
+
+static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *self)
+{
+    struct rxc_hub_merge *hub = (void *) ((char *) self - offsetof(struct rxc_hub_merge, sink));
+    struct rxc_hub_merge_input *input = malloc(sizeof(struct rxc_hub_merge_input));
+
+    if (!input) {
+        return NULL;
+    }
+
+    /* Size the queue to the share of the input among the inputs attached so
+     * far, which grows when other inputs leave */
+    hub->count++;
+    input->capacity = share(hub);
+    hub->count--;
+    input->queue = malloc(input->capacity * sizeof(void *));
+
+    if (!input->queue) {
+        free(input);
+        return NULL;
+    }
+
+    input->hub = hub;
+    input->head = 0;
+    input->count = 0;
+    input->outstanding = 0;
+    input->done = 0;
+    input->next = NULL;
+    input->base.sink = self;
+    input->base.in = NULL;
+    input->base.dealloc = input_dealloc;
+    input->base.on_connect = input_on_connect;
+    input->base.on_push = input_on_push;
+    input->base.on_push_value = NULL;
+    input->base.on_upstream_finish = input_on_upstream_finish;
+    input->base.on_upstream_failure = input_on_upstream_failure;
+
+    if (hub->tail) {
+        hub->tail->next = input;
+    } else {
+        hub->head = input;
+    }
+    hub->tail = input;
+    hub->count++;
+
+    return &input->base;
+}
+
+/* Output side */
+static void logic_dealloc(struct rxc_source_logic *self)
+{
+    /* The logic is owned by the hub */
+}
+
+static void logic_on_pull(struct rxc_source_logic *self, long n)
+{
+    struct rxc_hub_merge *hub = (void *) ((char *) self - offsetof(struct rxc_hub_merge, logic));
+
+    dispatch(hub);
+
+    /* Downstream only pulls outside the callbacks of the inputs when the hub
+     * is not dispatching */
+    if (!hub->wip) {
+        reap(hub);
+    }
+}
+
+static void logic_on_downstream_finish(struct rxc_source_logic *self)
+{
+    struct rxc_hub_merge *hub = (void *) ((char *) self - offsetof(struct rxc_hub_merge, logic));
+    struct rxc_hub_merge_input *input;
+
+    hub->canceled = 1;
+    hub->finished = 1;
+
+    for (input = hub->head; input; input = input->next) {
+        if (!input->done) {
+            input->done = 1;
+            rxc_inlet_cancel(input->base.in);
+        }
+
+        while (input->count > 0) {
+            hub->discard(input_dequeue(input));
+        }
+    }
+
+    dispatch(hub);
+}
+
+static void source_dealloc(struct rxc_source *self, int shallow)
+{
+    /* The source is owned by the hub */
+}
+
+static void source_connect(struct rxc_source *self, struct rxc_sink *sink)
+{
+    struct rxc_hub_merge *hub = (void *) ((char *) self - offsetof(struct rxc_hub_merge, source));
+
+    /* The merged stream can only be consumed once */
+    if (hub->connected) {
+        return;
+    }
+
+    struct rxc_sink_logic *sink_logic = sink->create_logic(sink);
+
+    if (!sink_logic) {
+        return;
+    }
+
+    rxc_connection_create(&hub->logic, sink_logic);
+    hub->connected = 1;
+    sink_logic->on_connect(sink_logic);
+    dispatch(hub);
+}
+
+struct rxc_hub_merge * rxc_hub_merge(long size, void (*discard)(void *element))
+{
+    if (size <= 0) {
+        return NULL;
+    }
+
+    struct rxc_hub_merge *hub = malloc(sizeof(struct rxc_hub_merge));
+
+    if (!hub) {
+        return NULL;
+    }
+
+    hub->size = size;
+    hub->discard = discard ? discard : free;
+    hub->head = NULL;
+    hub->tail = NULL;
+    hub->retired = NULL;
+    hub->count = 0;
+    hub->connected = 0;
+    hub->closed = 0;
+    hub->canceled = 0;
+    hub->finished = 0;
+    hub->wip = 0;
+    hub->missed = 0;
+
+    hub->sink.dealloc = sink_dealloc;
+    hub->sink.create_logic = sink_create_logic;
+    hub->source.dealloc = source_dealloc;
+    hub->source.connect = source_connect;
+    hub->logic.source = &hub->source;
+    hub->logic.out = NULL;
+    hub->logic.dealloc = logic_dealloc;
+    hub->logic.on_pull = logic_on_pull;
+    hub->logic.on_downstream_finish = logic_on_downstream_finish;
+
+    return hub;
+}
+
+struct rxc_sink * rxc_hub_merge_sink(struct rxc_hub_merge *hub)
+{
+    return &hub->sink;
+}
+
+struct rxc_source * rxc_hub_merge_source(struct rxc_hub_merge *hub)
+{
+    return &hub->source;
+}
+
+long rxc_hub_merge_inputs(struct rxc_hub_merge *hub)
+{
+    return hub->count;
+}
+
+void rxc_hub_merge_close(struct rxc_hub_merge *hub)
+{
+    hub->closed = 1;
+    dispatch(hub);
+
+    if (!hub->wip) {
+        reap(hub);
+    }
+}
+
+void rxc_hub_merge_dealloc(struct rxc_hub_merge *hub)
+{
+    struct rxc_hub_merge_input *input = hub->head;
+
+    /* Inputs that terminate once canceled must not be detached meanwhile */
+    hub->wip = 1;
+
+    while (input) {
+        struct rxc_hub_merge_input *next = input->next;
+
+        if (!input->done) {
+            rxc_inlet_cancel(input->base.in);
+        }
+
+        while (input->count > 0) {
+            hub->discard(input_dequeue(input));
+        }
+
+        input_free(input);
+        input = next;
+    }
+
+    reap(hub);
+
+    /* Release the logic of the sink of the merged stream and its connection,
+     * which the hub owns once the sink has connected */
+    if (hub->connected) {
+        struct rxc_connection *conn = &hub->logic.out->conn;
+
+        conn->sink_logic->dealloc(conn->sink_logic);
+        rxc_free(conn);
+    }
+
+    free(hub);
+}
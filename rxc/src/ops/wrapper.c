@@ -2,6 +2,7 @@
 
 #include <rxc/rxc.h>
 #include <rxc/logic.h>
+#include <rxc/alloc.h>
 #include <rxc/ops/core.h>
 
 struct rxc_flow_wrapper {
@@ -31,7 +32,7 @@ static void source_dealloc(struct rxc_source *self, int shallow)
         flow->base.dealloc(&flow->base, shallow);
     }
 
-    free(self);
+    rxc_free(self);
 }
 
 static void source_connect(struct rxc_source *self, struct rxc_sink *sink)
@@ -46,7 +47,7 @@ static void source_connect(struct rxc_source *self, struct rxc_sink *sink)
 static struct rxc_source * flow_connect_source(struct rxc_flow *self,
                                                struct rxc_source *source)
 {
-    struct rxc_source_wrapper *wrapper = malloc(sizeof(struct rxc_source_wrapper));
+    struct rxc_source_wrapper *wrapper = rxc_alloc(sizeof(struct rxc_source_wrapper));
 
     if (!wrapper) {
         return NULL;
@@ -64,14 +65,14 @@ static struct rxc_source * flow_connect_source(struct rxc_flow *self,
 static void flow_dealloc(struct rxc_flow *flow, int shallow)
 {
     struct rxc_flow_wrapper *self = (struct rxc_flow_wrapper *) flow;
-    free(self->ctx);
-    free(self);
+    rxc_free(self->ctx);
+    rxc_free(self);
 }
 
 struct rxc_flow * rxc_flow_wrapper(struct rxc_sink * (*wrap)(struct rxc_sink *, void *),
                                    void *ctx)
 {
-    struct rxc_flow_wrapper *flow = malloc(sizeof(struct rxc_flow_wrapper));
+    struct rxc_flow_wrapper *flow = rxc_alloc(sizeof(struct rxc_flow_wrapper));
 
     flow->ctx = ctx;
     flow->wrap = wrap;
@@ -3,6 +3,10 @@
 
 #include <rxc/rxc.h>
 #include <rxc/logic.h>
+#include <rxc/instrument.h>
+#include <rxc/alloc.h>
+
+#include "arena.h"
 
 /* Stage operations */
 void rxc_source_dealloc(struct rxc_source *source)
@@ -13,14 +17,20 @@ void rxc_source_dealloc(struct rxc_source *source)
 struct rxc_pipeline * rxc_source_to(struct rxc_source *source,
                                     struct rxc_sink *sink)
 {
-    struct rxc_pipeline *pipeline = malloc(sizeof(struct rxc_pipeline));
+    struct rxc_pipeline *pipeline = rxc_alloc(sizeof(struct rxc_pipeline));
 
     if (!pipeline) {
         return NULL;
     }
 
+    if (rxc_instrument_enabled()) {
+        struct rxc_sink *instrumented = rxc_instrument_sink(sink, RXC_INSTRUMENT_SINK);
+        sink = instrumented ? instrumented : sink;
+    }
+
     pipeline->source = source;
     pipeline->sink = sink;
+    pipeline->arena = NULL;
 
     return pipeline;
 }
@@ -28,6 +38,11 @@ struct rxc_pipeline * rxc_source_to(struct rxc_source *source,
 struct rxc_source * rxc_source_via(struct rxc_source *source,
                                    struct rxc_flow *flow)
 {
+    if (rxc_instrument_enabled()) {
+        struct rxc_source *instrumented = rxc_instrument_source(source, RXC_INSTRUMENT_FLOW);
+        source = instrumented ? instrumented : source;
+    }
+
     return flow->connect_source(flow, source);
 }
 
@@ -43,6 +58,11 @@ struct rxc_flow * rxc_flow_via(struct rxc_flow *a, struct rxc_flow *b)
 
 struct rxc_sink * rxc_flow_to(struct rxc_flow *flow, struct rxc_sink *sink)
 {
+    if (rxc_instrument_enabled()) {
+        struct rxc_sink *instrumented = rxc_instrument_sink(sink, RXC_INSTRUMENT_SINK);
+        sink = instrumented ? instrumented : sink;
+    }
+
     return flow->connect_sink(flow, sink);
 }
 
@@ -51,11 +71,17 @@ void rxc_pipeline_dealloc(struct rxc_pipeline *pipeline)
 {
     struct rxc_source *source = pipeline->source;
     struct rxc_sink *sink = pipeline->sink;
+    struct rxc_arena *arena = pipeline->arena;
+    struct rxc_arena *previous = rxc_arena_releasing(arena);
 
     rxc_source_dealloc(source);
     rxc_sink_dealloc(sink);
+    rxc_free(pipeline);
 
-    free(pipeline);
+    rxc_arena_releasing(previous);
+
+    /* Release the objects of a materialized pipeline all at once */
+    free(arena);
 }
 
 struct rxc_sink_scheduler {
@@ -81,10 +107,26 @@ struct rxc_request {
     long n;
 };
 
-static void pipeline_executor(void *ctx)
+/**
+ * The maximum amount of pulls that run synchronously within each other on a
+ * thread, before pulls are queued on the worker again.
+ */
+#define RXC_PIPELINE_MAX_SYNC_DEPTH 32
+
+/**
+ * The amount of synchronous pulls the current thread is running.
+ */
+static _Thread_local int sync_depth;
+
+static void pipeline_run(void *ctx)
 {
     struct rxc_request *req = ctx;
     req->in->pull(req->in, req->n);
+}
+
+static void pipeline_executor(void *ctx)
+{
+    pipeline_run(ctx);
     free(ctx);
 }
 
@@ -98,6 +140,24 @@ static void pipeline_inlet_pull(struct rxc_inlet *self, long n)
 
     struct rxc_scheduler_worker *worker = ((struct rxc_inlet_scheduler *) self)->worker;
 
+    /*
+     * Pull directly when the worker is idle on this thread, which saves
+     * allocating the request and queueing it. Pulls issued while the worker
+     * is running are queued to guard against re-entrancy.
+     */
+    if (worker->try_run && sync_depth < RXC_PIPELINE_MAX_SYNC_DEPTH) {
+        struct rxc_request local = { parent, n };
+        int ran;
+
+        sync_depth++;
+        ran = worker->try_run(worker, pipeline_run, &local);
+        sync_depth--;
+
+        if (ran) {
+            return;
+        }
+    }
+
     struct rxc_request *req = malloc(sizeof(struct rxc_request));
     req->in = parent;
     req->n = n;
@@ -117,7 +177,7 @@ static void pipeline_inlet_cancel(struct rxc_inlet *in)
 static struct rxc_inlet * pipeline_inlet_create(struct rxc_inlet *parent,
                                                 struct rxc_scheduler_worker *worker)
 {
-    struct rxc_inlet_scheduler *in = malloc(sizeof(struct rxc_inlet_scheduler));
+    struct rxc_inlet_scheduler *in = rxc_alloc(sizeof(struct rxc_inlet_scheduler));
 
     in->parent = parent;
     in->worker = worker;
@@ -132,7 +192,7 @@ static void pipeline_sink_logic_dealloc(struct rxc_sink_logic *logic)
     struct rxc_sink_logic_scheduler *self = (struct rxc_sink_logic_scheduler *) logic;
     self->inner->dealloc(self->inner);
     self->worker->dealloc(self->worker);
-    free(self);
+    rxc_free(self);
 }
 
 static void pipeline_sink_logic_on_connect(struct rxc_sink_logic *logic)
@@ -140,7 +200,12 @@ static void pipeline_sink_logic_on_connect(struct rxc_sink_logic *logic)
     struct rxc_sink_logic_scheduler *self = (struct rxc_sink_logic_scheduler *) logic;
     struct rxc_inlet *in = pipeline_inlet_create(logic->in, self->worker);
     self->inner->in = in;
+
+    /* The object graph is complete once the pipeline sink connects, so the
+     * allocations of the stages that start streaming come from the heap */
+    struct rxc_arena *arena = rxc_arena_activate(NULL);
     self->inner->on_connect(self->inner);
+    rxc_arena_activate(arena);
 }
 
 static void pipeline_sink_logic_on_push(struct rxc_sink_logic *self, void *element)
@@ -149,6 +214,11 @@ static void pipeline_sink_logic_on_push(struct rxc_sink_logic *self, void *eleme
     logic->on_push(logic, element);
 }
 
+static void pipeline_sink_logic_on_push_value(struct rxc_sink_logic *self, struct rxc_value value)
+{
+    struct rxc_sink_logic *logic = ((struct rxc_sink_logic_scheduler *) self)->inner;
+    rxc_sink_logic_push_value(logic, value);
+}
 
 static void pipeline_sink_logic_on_upstream_finish(struct rxc_sink_logic *self)
 {
@@ -166,7 +236,7 @@ static void pipeline_sink_logic_on_upstream_failure(struct rxc_sink_logic *self,
 static struct rxc_sink_logic * pipeline_sink_create_logic(struct rxc_sink *sink)
 {
     struct rxc_sink_scheduler *self = (struct rxc_sink_scheduler *) sink;
-    struct rxc_sink_logic_scheduler *logic = malloc(sizeof(struct rxc_sink_logic_scheduler));
+    struct rxc_sink_logic_scheduler *logic = rxc_alloc(sizeof(struct rxc_sink_logic_scheduler));
 
     if (!logic) {
         return NULL;
@@ -178,6 +248,7 @@ static struct rxc_sink_logic * pipeline_sink_create_logic(struct rxc_sink *sink)
     logic->base.dealloc = pipeline_sink_logic_dealloc;
     logic->base.on_connect = pipeline_sink_logic_on_connect;
     logic->base.on_push = pipeline_sink_logic_on_push;
+    logic->base.on_push_value = pipeline_sink_logic_on_push_value;
     logic->base.on_upstream_finish = pipeline_sink_logic_on_upstream_finish;
     logic->base.on_upstream_failure = pipeline_sink_logic_on_upstream_failure;
 
@@ -193,12 +264,12 @@ static void pipeline_sink_dealloc(struct rxc_sink *sink, int shallow)
         self->scheduler->dealloc(self->scheduler);
     }
 
-    free(self);
+    rxc_free(self);
 }
 
 static struct rxc_sink * pipeline_sink(struct rxc_sink *sink, struct rxc_scheduler *scheduler)
 {
-    struct rxc_sink_scheduler *wrapper_sink = malloc(sizeof(struct rxc_sink_scheduler));
+    struct rxc_sink_scheduler *wrapper_sink = rxc_alloc(sizeof(struct rxc_sink_scheduler));
 
     if (!wrapper_sink) {
         return NULL;
@@ -216,9 +287,21 @@ int rxc_pipeline_start(struct rxc_pipeline *pipeline,
                        struct rxc_scheduler *scheduler)
 {
     struct rxc_source *source = pipeline->source;
+    struct rxc_arena *previous = NULL;
+
+    /* The logic objects of a materialized pipeline join its stages */
+    if (pipeline->arena) {
+        previous = rxc_arena_activate(pipeline->arena);
+    }
+
     struct rxc_sink *sink = pipeline_sink(pipeline->sink, scheduler);
 
     source->connect(source, sink);
 
+    if (pipeline->arena) {
+        rxc_arena_activate(previous);
+        rxc_blueprint_learn(pipeline->arena);
+    }
+
     return RXC_EOK;
 }
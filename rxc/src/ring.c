@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <errno.h>
+
+#include <rxc/rxc.h>
+
+#include "ring.h"
+
+int rxc_ring_init(struct rxc_ring *ring, size_t capacity)
+{
+    size_t size = 1;
+
+    /* Round the amount of slots up to a power of two to allow masking */
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    ring->slots = malloc(size * sizeof(void *));
+
+    if (!ring->slots) {
+        return ENOMEM;
+    }
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->head_cache = 0;
+    ring->tail_cache = 0;
+    ring->mask = size - 1;
+    ring->capacity = capacity;
+
+    return RXC_EOK;
+}
+
+void rxc_ring_destroy(struct rxc_ring *ring)
+{
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+int rxc_ring_push(struct rxc_ring *ring, void *element)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    /* Only reload the head of the consumer when the ring appears to be full */
+    if (tail - ring->head_cache >= ring->capacity) {
+        ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        if (tail - ring->head_cache >= ring->capacity) {
+            return 0;
+        }
+    }
+
+    ring->slots[tail & ring->mask] = element;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    return 1;
+}
+
+int rxc_ring_pop(struct rxc_ring *ring, void **element)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    /* Only reload the tail of the producer when the ring appears to be empty */
+    if (head == ring->tail_cache) {
+        ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+        if (head == ring->tail_cache) {
+            return 0;
+        }
+    }
+
+    *element = ring->slots[head & ring->mask];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return 1;
+}
+
+int rxc_ring_empty(struct rxc_ring *ring)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    return head == atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
@@ -0,0 +1,96 @@
+#ifndef RXC_INTERNAL_RING_H
+#define RXC_INTERNAL_RING_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define RXC_CACHE_LINE_SIZE 64
+
+/**
+ * A bounded, lock-free single-producer/single-consumer ring of elements.
+ *
+ * Exactly one thread may push into the ring and exactly one (possibly
+ * different) thread may pop from it at any time.
+ */
+struct rxc_ring {
+    /**
+     * The index of the next slot to pop, owned by the consumer.
+     */
+    _Alignas(RXC_CACHE_LINE_SIZE) atomic_size_t head;
+
+    /**
+     * The last value of the tail index observed by the consumer.
+     */
+    size_t tail_cache;
+
+    /**
+     * The index of the next slot to push, owned by the producer.
+     */
+    _Alignas(RXC_CACHE_LINE_SIZE) atomic_size_t tail;
+
+    /**
+     * The last value of the head index observed by the producer.
+     */
+    size_t head_cache;
+
+    /**
+     * The mask to map an index onto a slot (the slot count minus one).
+     */
+    _Alignas(RXC_CACHE_LINE_SIZE) size_t mask;
+
+    /**
+     * The amount of elements the ring may hold.
+     */
+    size_t capacity;
+
+    /**
+     * The slots of the ring.
+     */
+    void **slots;
+};
+
+/**
+ * Initialize the specified ring to hold the given amount of elements.
+ *
+ * @param[in] ring The ring to initialize.
+ * @param[in] capacity The amount of elements the ring must be able to hold.
+ * @return <code>RXC_EOK</code> on success, an error code otherwise.
+ */
+int rxc_ring_init(struct rxc_ring *ring, size_t capacity);
+
+/**
+ * Release the resources held by the specified ring.
+ *
+ * @param[in] ring The ring to destroy.
+ */
+void rxc_ring_destroy(struct rxc_ring *ring);
+
+/**
+ * Push an element into the ring. May only be called by the producer.
+ *
+ * @param[in] ring The ring to push the element into.
+ * @param[in] element The element to push.
+ * @return <code>1</code> if the element was pushed, <code>0</code> if the ring
+ * is full.
+ */
+int rxc_ring_push(struct rxc_ring *ring, void *element);
+
+/**
+ * Pop an element from the ring. May only be called by the consumer.
+ *
+ * @param[in] ring The ring to pop the element from.
+ * @param[out] element The location to store the element in.
+ * @return <code>1</code> if an element was popped, <code>0</code> if the ring
+ * is empty.
+ */
+int rxc_ring_pop(struct rxc_ring *ring, void **element);
+
+/**
+ * Determine whether the ring is empty from the viewpoint of the consumer.
+ *
+ * @param[in] ring The ring to check.
+ * @return <code>1</code> if the ring is empty, otherwise <code>0</code>.
+ */
+int rxc_ring_empty(struct rxc_ring *ring);
+
+#endif /* RXC_INTERNAL_RING_H */
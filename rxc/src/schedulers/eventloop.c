@@ -0,0 +1,550 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include <rxc/rxc.h>
+#include <rxc/scheduler.h>
+#include <rxc/schedulers/eventloop.h>
+#include <rxc/trace.h>
+
+#define EVENTLOOP_MAX_EVENTS          64
+#define EVENTLOOP_HEAP_INITIAL_CAPACITY 16
+
+struct eventloop_task {
+    void (*runnable)(void *);
+    void *ctx;
+    struct eventloop_task *next;
+};
+
+struct eventloop_timer {
+    /**
+     * The identifier of the timer.
+     */
+    long id;
+
+    /**
+     * The point in time (in nanoseconds) at which the timer expires.
+     */
+    uint64_t deadline;
+
+    void (*runnable)(void *);
+    void *ctx;
+};
+
+struct eventloop_watch {
+    int fd;
+    void (*callback)(void *ctx, int events);
+    void *ctx;
+    struct eventloop_watch *next;
+};
+
+struct eventloop {
+    struct rxc_scheduler base;
+
+    /**
+     * The epoll instance of the loop.
+     */
+    int epfd;
+
+    /**
+     * The timer descriptor armed for the earliest timer.
+     */
+    int timerfd;
+
+    /**
+     * Head and tail of the queue of tasks ready to run.
+     */
+    struct eventloop_task *head, *tail;
+
+    /**
+     * The min-heap of pending timers ordered by their deadline.
+     */
+    struct eventloop_timer **timers;
+    int timer_count, timer_capacity;
+
+    /**
+     * The identifier of the next timer.
+     */
+    long next_timer;
+
+    /**
+     * The watched file descriptors.
+     */
+    struct eventloop_watch *watches;
+    int watch_count;
+
+    /**
+     * The watches removed during this iteration, which may still be referenced
+     * by pending events.
+     */
+    struct eventloop_watch *retired;
+
+    /**
+     * A flag to indicate the loop should stop.
+     */
+    int stopped;
+};
+
+struct eventloop_worker {
+    struct rxc_scheduler_eventloop_worker base;
+    struct eventloop *loop;
+};
+
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Timer heap */
+static void heap_swap(struct eventloop *loop, int a, int b)
+{
+    struct eventloop_timer *tmp = loop->timers[a];
+    loop->timers[a] = loop->timers[b];
+    loop->timers[b] = tmp;
+}
+
+static void heap_up(struct eventloop *loop, int index)
+{
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+
+        if (loop->timers[parent]->deadline <= loop->timers[index]->deadline) {
+            break;
+        }
+
+        heap_swap(loop, index, parent);
+        index = parent;
+    }
+}
+
+static void heap_down(struct eventloop *loop, int index)
+{
+    while (1) {
+        int left = 2 * index + 1;
+        int right = left + 1;
+        int lowest = index;
+
+        if (left < loop->timer_count &&
+            loop->timers[left]->deadline < loop->timers[lowest]->deadline) {
+            lowest = left;
+        }
+
+        if (right < loop->timer_count &&
+            loop->timers[right]->deadline < loop->timers[lowest]->deadline) {
+            lowest = right;
+        }
+
+        if (lowest == index) {
+            break;
+        }
+
+        heap_swap(loop, index, lowest);
+        index = lowest;
+    }
+}
+
+static void heap_remove(struct eventloop *loop, int index)
+{
+    loop->timers[index] = loop->timers[--loop->timer_count];
+
+    if (index < loop->timer_count) {
+        heap_down(loop, index);
+        heap_up(loop, index);
+    }
+}
+
+/* Loop */
+static void run_ready(struct eventloop *loop)
+{
+    struct eventloop_task *task;
+
+    while ((task = loop->head) != NULL) {
+        loop->head = task->next;
+
+        if (loop->head == NULL) {
+            loop->tail = NULL;
+        }
+
+        RXC_TRACE_BEGIN("task", 0);
+        task->runnable(task->ctx);
+        RXC_TRACE_END("task", 0);
+        free(task);
+    }
+}
+
+static void run_timers(struct eventloop *loop)
+{
+    uint64_t time = now();
+
+    while (loop->timer_count > 0 && loop->timers[0]->deadline <= time) {
+        struct eventloop_timer *timer = loop->timers[0];
+
+        heap_remove(loop, 0);
+        RXC_TRACE_BEGIN("timer", timer->id);
+        timer->runnable(timer->ctx);
+        RXC_TRACE_END("timer", timer->id);
+        free(timer);
+    }
+}
+
+static int arm_timer(struct eventloop *loop)
+{
+    struct itimerspec spec;
+
+    memset(&spec, 0, sizeof(spec));
+
+    /* A zeroed specification disarms the timer */
+    if (loop->timer_count > 0) {
+        uint64_t deadline = loop->timers[0]->deadline;
+
+        spec.it_value.tv_sec = deadline / 1000000000ull;
+        spec.it_value.tv_nsec = deadline % 1000000000ull;
+
+        /* A deadline of zero would disarm the timer */
+        if (deadline == 0) {
+            spec.it_value.tv_nsec = 1;
+        }
+    }
+
+    if (timerfd_settime(loop->timerfd, TFD_TIMER_ABSTIME, &spec, NULL) < 0) {
+        return errno;
+    }
+
+    return RXC_EOK;
+}
+
+int rxc_scheduler_eventloop_run_once(struct rxc_scheduler *scheduler, long timeout)
+{
+    struct eventloop *loop = (struct eventloop *) scheduler;
+    struct epoll_event events[EVENTLOOP_MAX_EVENTS];
+    struct eventloop_watch *watch;
+    int err, n;
+
+    run_ready(loop);
+    run_timers(loop);
+
+    if ((err = arm_timer(loop)) != RXC_EOK) {
+        return err;
+    }
+
+    /* Do not block when new tasks have been queued in the meantime or when
+     * there is nothing left to wait for */
+    if (loop->head != NULL || (loop->timer_count == 0 && loop->watch_count == 0)) {
+        timeout = 0;
+    }
+
+    n = epoll_wait(loop->epfd, events, EVENTLOOP_MAX_EVENTS, (int) timeout);
+
+    if (n < 0) {
+        return errno == EINTR ? RXC_EOK : errno;
+    }
+
+    for (int i = 0; i < n; i++) {
+        int mask = 0;
+
+        watch = events[i].data.ptr;
+
+        /* The timer descriptor is registered without a watch */
+        if (watch == NULL) {
+            uint64_t expirations;
+            (void) !read(loop->timerfd, &expirations, sizeof(expirations));
+            continue;
+        }
+
+        if (events[i].events & EPOLLIN) {
+            mask |= RXC_EVENTLOOP_READABLE;
+        }
+        if (events[i].events & EPOLLOUT) {
+            mask |= RXC_EVENTLOOP_WRITABLE;
+        }
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+            mask |= RXC_EVENTLOOP_ERROR;
+        }
+
+        /* Skip the descriptors unwatched by an earlier callback */
+        if (watch->callback) {
+            watch->callback(watch->ctx, mask);
+        }
+    }
+
+    while ((watch = loop->retired) != NULL) {
+        loop->retired = watch->next;
+        free(watch);
+    }
+
+    run_timers(loop);
+    run_ready(loop);
+
+    return RXC_EOK;
+}
+
+int rxc_scheduler_eventloop_run(struct rxc_scheduler *scheduler)
+{
+    struct eventloop *loop = (struct eventloop *) scheduler;
+    int err;
+
+    loop->stopped = 0;
+
+    while (!loop->stopped && (loop->head || loop->timer_count > 0 || loop->watch_count > 0)) {
+        if ((err = rxc_scheduler_eventloop_run_once(scheduler, -1)) != RXC_EOK) {
+            return err;
+        }
+    }
+
+    return RXC_EOK;
+}
+
+void rxc_scheduler_eventloop_stop(struct rxc_scheduler *scheduler)
+{
+    ((struct eventloop *) scheduler)->stopped = 1;
+}
+
+/* Worker */
+static void worker_dealloc(struct rxc_scheduler_worker *self)
+{
+    free(self);
+}
+
+static void worker_schedule(struct rxc_scheduler_worker *worker,
+                            void (*runnable)(void *),
+                            void *ctx)
+{
+    struct eventloop *loop = ((struct eventloop_worker *) worker)->loop;
+    struct eventloop_task *task = malloc(sizeof(struct eventloop_task));
+
+    if (task == NULL) {
+        return;
+    }
+
+    task->runnable = runnable;
+    task->ctx = ctx;
+    task->next = NULL;
+
+    if (loop->head == NULL) {
+        loop->head = task;
+    } else {
+        loop->tail->next = task;
+    }
+    loop->tail = task;
+}
+
+static long worker_schedule_delayed(struct rxc_scheduler_eventloop_worker *worker,
+                                    void (*runnable)(void *),
+                                    void *ctx,
+                                    long delay)
+{
+    struct eventloop *loop = ((struct eventloop_worker *) worker)->loop;
+
+    /* Resize (double) heap on maximum size */
+    if (loop->timer_count == loop->timer_capacity) {
+        int capacity = loop->timer_capacity * 2;
+        struct eventloop_timer **timers = realloc(loop->timers,
+                                                  capacity * sizeof(struct eventloop_timer *));
+
+        if (timers == NULL) {
+            return -1;
+        }
+
+        loop->timers = timers;
+        loop->timer_capacity = capacity;
+    }
+
+    struct eventloop_timer *timer = malloc(sizeof(struct eventloop_timer));
+
+    if (timer == NULL) {
+        return -1;
+    }
+
+    timer->id = loop->next_timer++;
+    timer->deadline = now() + (uint64_t) (delay > 0 ? delay : 0) * 1000000ull;
+    timer->runnable = runnable;
+    timer->ctx = ctx;
+
+    loop->timers[loop->timer_count] = timer;
+    heap_up(loop, loop->timer_count++);
+
+    return timer->id;
+}
+
+static void worker_cancel_delayed(struct rxc_scheduler_eventloop_worker *worker, long id)
+{
+    struct eventloop *loop = ((struct eventloop_worker *) worker)->loop;
+
+    for (int i = 0; i < loop->timer_count; i++) {
+        if (loop->timers[i]->id == id) {
+            struct eventloop_timer *timer = loop->timers[i];
+
+            heap_remove(loop, i);
+            free(timer);
+            return;
+        }
+    }
+}
+
+static int worker_watch_fd(struct rxc_scheduler_eventloop_worker *worker,
+                           int fd,
+                           int events,
+                           void (*callback)(void *ctx, int events),
+                           void *ctx)
+{
+    struct eventloop *loop = ((struct eventloop_worker *) worker)->loop;
+    struct eventloop_watch *watch = malloc(sizeof(struct eventloop_watch));
+    struct epoll_event event;
+
+    if (watch == NULL) {
+        return ENOMEM;
+    }
+
+    watch->fd = fd;
+    watch->callback = callback;
+    watch->ctx = ctx;
+
+    memset(&event, 0, sizeof(event));
+    event.data.ptr = watch;
+
+    if (events & RXC_EVENTLOOP_READABLE) {
+        event.events |= EPOLLIN;
+    }
+    if (events & RXC_EVENTLOOP_WRITABLE) {
+        event.events |= EPOLLOUT;
+    }
+
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        int err = errno;
+        free(watch);
+        return err;
+    }
+
+    watch->next = loop->watches;
+    loop->watches = watch;
+    loop->watch_count++;
+
+    return RXC_EOK;
+}
+
+static void worker_unwatch_fd(struct rxc_scheduler_eventloop_worker *worker, int fd)
+{
+    struct eventloop *loop = ((struct eventloop_worker *) worker)->loop;
+    struct eventloop_watch **link = &loop->watches;
+    struct eventloop_watch *watch;
+
+    while ((watch = *link) != NULL) {
+        if (watch->fd == fd) {
+            *link = watch->next;
+            loop->watch_count--;
+            epoll_ctl(loop->epfd, EPOLL_CTL_DEL, fd, NULL);
+
+            watch->callback = NULL;
+            watch->next = loop->retired;
+            loop->retired = watch;
+            return;
+        }
+
+        link = &watch->next;
+    }
+}
+
+static struct rxc_scheduler_worker * scheduler_create_worker(struct rxc_scheduler *self)
+{
+    struct eventloop_worker *worker = malloc(sizeof(struct eventloop_worker));
+
+    if (worker == NULL) {
+        return NULL;
+    }
+
+    worker->loop = (struct eventloop *) self;
+    worker->base.base.scheduler = self;
+    worker->base.base.dealloc = worker_dealloc;
+    worker->base.base.schedule = worker_schedule;
+    worker->base.base.try_run = NULL;
+    worker->base.schedule_delayed = worker_schedule_delayed;
+    worker->base.cancel_delayed = worker_cancel_delayed;
+    worker->base.watch_fd = worker_watch_fd;
+    worker->base.unwatch_fd = worker_unwatch_fd;
+
+    return &worker->base.base;
+}
+
+static void scheduler_dealloc(struct rxc_scheduler *self)
+{
+    struct eventloop *loop = (struct eventloop *) self;
+    struct eventloop_task *task;
+    struct eventloop_watch *watch;
+
+    while ((task = loop->head) != NULL) {
+        loop->head = task->next;
+        free(task);
+    }
+
+    while ((watch = loop->watches) != NULL) {
+        loop->watches = watch->next;
+        free(watch);
+    }
+
+    while ((watch = loop->retired) != NULL) {
+        loop->retired = watch->next;
+        free(watch);
+    }
+
+    for (int i = 0; i < loop->timer_count; i++) {
+        free(loop->timers[i]);
+    }
+
+    close(loop->timerfd);
+    close(loop->epfd);
+    free(loop->timers);
+    free(loop);
+}
+
+struct rxc_scheduler * rxc_scheduler_eventloop(void)
+{
+    struct eventloop *loop = malloc(sizeof(struct eventloop));
+    struct epoll_event event;
+
+    if (loop == NULL) {
+        return NULL;
+    }
+
+    loop->timers = malloc(EVENTLOOP_HEAP_INITIAL_CAPACITY * sizeof(struct eventloop_timer *));
+    loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+    loop->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+
+    if (loop->timers == NULL || loop->epfd < 0 || loop->timerfd < 0 ||
+        epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->timerfd, &event) < 0) {
+        if (loop->epfd >= 0) {
+            close(loop->epfd);
+        }
+        if (loop->timerfd >= 0) {
+            close(loop->timerfd);
+        }
+        free(loop->timers);
+        free(loop);
+        return NULL;
+    }
+
+    loop->head = NULL;
+    loop->tail = NULL;
+    loop->timer_count = 0;
+    loop->timer_capacity = EVENTLOOP_HEAP_INITIAL_CAPACITY;
+    loop->next_timer = 1;
+    loop->watches = NULL;
+    loop->watch_count = 0;
+    loop->retired = NULL;
+    loop->stopped = 0;
+    loop->base.dealloc = scheduler_dealloc;
+    loop->base.create_worker = scheduler_create_worker;
+
+    return &loop->base;
+}
@@ -0,0 +1,215 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include <rxc/rxc.h>
+#include <rxc/scheduler.h>
+#include <rxc/schedulers/serial.h>
+#include <rxc/trace.h>
+
+#define SERIAL_IDLE    0 /* No thread is running the tasks of the worker */
+#define SERIAL_RUNNING 1 /* A thread is running the tasks of the worker */
+
+struct serial_node {
+    void (*runnable)(void *);
+    void *ctx;
+    struct serial_node *_Atomic next;
+};
+
+/**
+ * A worker whose queue is an intrusive multiple-producer/single-consumer
+ * queue as described by Dmitry Vyukov. Producers append to the tail with a
+ * single exchange, while the thread that owns the drain flag consumes from the
+ * head. The queue always holds at least one node, initially the stub.
+ */
+struct serial_worker {
+    struct rxc_scheduler_worker base;
+
+    /**
+     * The most recently scheduled node, to which producers append.
+     */
+    struct serial_node *_Atomic tail;
+
+    /**
+     * The node before the next task to run, owned by the draining thread.
+     */
+    struct serial_node *head;
+
+    /**
+     * The state of the worker, which grants the right to drain the queue.
+     */
+    atomic_int state;
+
+    /**
+     * The node the queue starts with.
+     */
+    struct serial_node stub;
+};
+
+static void push(struct serial_worker *self, struct serial_node *node)
+{
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+
+    struct serial_node *prev = atomic_exchange_explicit(&self->tail, node, memory_order_acq_rel);
+
+    /* Until this store, the node is invisible to the consumer */
+    atomic_store_explicit(&prev->next, node, memory_order_seq_cst);
+}
+
+/**
+ * Pop the next node of the queue. Returns <code>NULL</code> when the queue is
+ * empty or a producer has not linked its node yet; such a producer will find
+ * the worker idle afterwards and drain the queue itself.
+ */
+static struct serial_node * pop(struct serial_worker *self)
+{
+    struct serial_node *head = self->head;
+    struct serial_node *next = atomic_load_explicit(&head->next, memory_order_acquire);
+
+    if (head == &self->stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+
+        /* Skip the stub */
+        self->head = next;
+        head = next;
+        next = atomic_load_explicit(&head->next, memory_order_acquire);
+    }
+
+    if (next != NULL) {
+        self->head = next;
+        return head;
+    }
+
+    /* The head is the last node; requeue the stub behind it to detach it */
+    if (head != atomic_load_explicit(&self->tail, memory_order_acquire)) {
+        return NULL;
+    }
+
+    push(self, &self->stub);
+    next = atomic_load_explicit(&head->next, memory_order_acquire);
+
+    if (next != NULL) {
+        self->head = next;
+        return head;
+    }
+
+    return NULL;
+}
+
+static void drain(struct serial_worker *self)
+{
+    struct serial_node *node;
+
+    do {
+        while ((node = pop(self)) != NULL) {
+            RXC_TRACE_BEGIN("task", 0);
+            node->runnable(node->ctx);
+            RXC_TRACE_END("task", 0);
+            free(node);
+        }
+
+        atomic_store_explicit(&self->state, SERIAL_IDLE, memory_order_seq_cst);
+
+        /*
+         * A producer that linked its node while this thread was draining may
+         * have found the worker running and left; take over its task.
+         */
+        if (atomic_load_explicit(&self->head->next, memory_order_seq_cst) == NULL) {
+            break;
+        }
+    } while (atomic_exchange_explicit(&self->state, SERIAL_RUNNING, memory_order_seq_cst) == SERIAL_IDLE);
+}
+
+static void worker_dealloc(struct rxc_scheduler_worker *worker)
+{
+    struct serial_worker *self = (struct serial_worker *) worker;
+    struct serial_node *node;
+
+    /* Release the tasks that did not run */
+    while ((node = pop(self)) != NULL) {
+        free(node);
+    }
+
+    free(self);
+}
+
+static void worker_schedule(struct rxc_scheduler_worker *worker,
+                            void (*runnable)(void *),
+                            void *ctx)
+{
+    struct serial_worker *self = (struct serial_worker *) worker;
+    struct serial_node *node = malloc(sizeof(struct serial_node));
+
+    if (node == NULL) {
+        return;
+    }
+
+    node->runnable = runnable;
+    node->ctx = ctx;
+    push(self, node);
+
+    /* Drain the queue on this thread if no other thread is */
+    if (atomic_exchange_explicit(&self->state, SERIAL_RUNNING, memory_order_seq_cst) == SERIAL_IDLE) {
+        drain(self);
+    }
+}
+
+static int worker_try_run(struct rxc_scheduler_worker *worker,
+                          void (*runnable)(void *),
+                          void *ctx)
+{
+    struct serial_worker *self = (struct serial_worker *) worker;
+
+    if (atomic_exchange_explicit(&self->state, SERIAL_RUNNING, memory_order_seq_cst) != SERIAL_IDLE) {
+        return 0;
+    }
+
+    RXC_TRACE_BEGIN("task", 0);
+    runnable(ctx);
+    RXC_TRACE_END("task", 0);
+
+    drain(self);
+    return 1;
+}
+
+static struct rxc_scheduler_worker * scheduler_create_worker(struct rxc_scheduler *self)
+{
+    struct serial_worker *worker = malloc(sizeof(struct serial_worker));
+
+    if (worker == NULL) {
+        return NULL;
+    }
+
+    worker->stub.runnable = NULL;
+    worker->stub.ctx = NULL;
+    atomic_init(&worker->stub.next, NULL);
+    atomic_init(&worker->tail, &worker->stub);
+    worker->head = &worker->stub;
+    atomic_init(&worker->state, SERIAL_IDLE);
+    worker->base.scheduler = self;
+    worker->base.dealloc = worker_dealloc;
+    worker->base.schedule = worker_schedule;
+    worker->base.try_run = worker_try_run;
+
+    return &worker->base;
+}
+
+static void scheduler_dealloc(struct rxc_scheduler *self)
+{
+    free(self);
+}
+
+struct rxc_scheduler * rxc_scheduler_serial(void)
+{
+    struct rxc_scheduler *scheduler = malloc(sizeof(struct rxc_scheduler));
+
+    if (scheduler == NULL) {
+        return NULL;
+    }
+
+    scheduler->dealloc = scheduler_dealloc;
+    scheduler->create_worker = scheduler_create_worker;
+
+    return scheduler;
+}
@@ -0,0 +1,354 @@
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <rxc/rxc.h>
+#include <rxc/scheduler.h>
+#include <rxc/schedulers/thread_pool.h>
+#include <rxc/trace.h>
+
+#define POOL_WORKER_IDLE    0 /* The worker has no queued tasks */
+#define POOL_WORKER_QUEUED  1 /* The worker waits for a thread */
+#define POOL_WORKER_RUNNING 2 /* A thread runs a task of the worker */
+
+/**
+ * The amount of task nodes every worker keeps in reserve, so that scheduling
+ * does not allocate while a worker has no more tasks pending than this.
+ */
+#define POOL_WORKER_RESERVE 4
+
+struct pool_task {
+    void (*runnable)(void *);
+    void *ctx;
+    struct pool_task *next;
+};
+
+struct pool_worker {
+    struct rxc_scheduler_worker base;
+
+    /**
+     * Head and tail of the queue of tasks of this worker.
+     */
+    struct pool_task *head, *tail;
+
+    /**
+     * The task nodes that are not in use, of which there are at most
+     * <code>POOL_WORKER_RESERVE</code>.
+     */
+    struct pool_task *spare;
+    int spare_count;
+
+    /**
+     * The state of the worker.
+     */
+    int state;
+
+    /**
+     * A flag to indicate the worker should be released once it runs out of
+     * tasks.
+     */
+    int disposed;
+
+    /**
+     * The next worker in the queue of the pool.
+     */
+    struct pool_worker *next;
+};
+
+struct pool {
+    struct rxc_scheduler base;
+
+    /**
+     * The lock that guards the pool and the queues of its workers.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * The condition on which idle threads wait for workers.
+     */
+    pthread_cond_t available;
+
+    /**
+     * Head and tail of the queue of workers that have tasks to run.
+     */
+    struct pool_worker *head, *tail;
+
+    /**
+     * A flag to indicate the threads should stop.
+     */
+    int shutdown;
+
+    /**
+     * The threads of the pool.
+     */
+    pthread_t *threads;
+    int thread_count;
+};
+
+static void pool_enqueue(struct pool *pool, struct pool_worker *worker)
+{
+    worker->state = POOL_WORKER_QUEUED;
+    worker->next = NULL;
+
+    if (pool->tail) {
+        pool->tail->next = worker;
+    } else {
+        pool->head = worker;
+    }
+    pool->tail = worker;
+
+    pthread_cond_signal(&pool->available);
+}
+
+static void worker_free(struct pool_worker *worker)
+{
+    struct pool_task *task;
+
+    while ((task = worker->head) != NULL) {
+        worker->head = task->next;
+        free(task);
+    }
+
+    while ((task = worker->spare) != NULL) {
+        worker->spare = task->next;
+        free(task);
+    }
+
+    free(worker);
+}
+
+/**
+ * Return a task node to the reserve of the worker, which must be called with
+ * the lock of the pool held.
+ */
+static void worker_recycle(struct pool_worker *worker, struct pool_task *task)
+{
+    if (worker->spare_count >= POOL_WORKER_RESERVE) {
+        free(task);
+        return;
+    }
+
+    task->next = worker->spare;
+    worker->spare = task;
+    worker->spare_count++;
+}
+
+static void * pool_run(void *arg)
+{
+    struct pool *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (1) {
+        while (!pool->shutdown && !pool->head) {
+            pthread_cond_wait(&pool->available, &pool->lock);
+        }
+
+        if (pool->shutdown) {
+            break;
+        }
+
+        struct pool_worker *worker = pool->head;
+        struct pool_task *task = worker->head;
+
+        pool->head = worker->next;
+        if (!pool->head) {
+            pool->tail = NULL;
+        }
+
+        worker->head = task->next;
+        if (!worker->head) {
+            worker->tail = NULL;
+        }
+        worker->state = POOL_WORKER_RUNNING;
+
+        pthread_mutex_unlock(&pool->lock);
+
+        RXC_TRACE_BEGIN("task", 0);
+        task->runnable(task->ctx);
+        RXC_TRACE_END("task", 0);
+
+        pthread_mutex_lock(&pool->lock);
+
+        worker_recycle(worker, task);
+
+        /* Move the worker to the back of the queue to share the threads */
+        if (worker->head) {
+            pool_enqueue(pool, worker);
+        } else if (worker->disposed) {
+            worker_free(worker);
+        } else {
+            worker->state = POOL_WORKER_IDLE;
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void worker_dealloc(struct rxc_scheduler_worker *self)
+{
+    struct pool_worker *worker = (struct pool_worker *) self;
+    struct pool *pool = (struct pool *) self->scheduler;
+
+    pthread_mutex_lock(&pool->lock);
+
+    /* Let the thread running the worker release it */
+    if (worker->state == POOL_WORKER_IDLE) {
+        worker_free(worker);
+    } else {
+        worker->disposed = 1;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void worker_schedule(struct rxc_scheduler_worker *self,
+                            void (*runnable)(void *),
+                            void *ctx)
+{
+    struct pool_worker *worker = (struct pool_worker *) self;
+    struct pool *pool = (struct pool *) self->scheduler;
+
+    pthread_mutex_lock(&pool->lock);
+
+    struct pool_task *task = worker->spare;
+
+    if (task) {
+        worker->spare = task->next;
+        worker->spare_count--;
+    } else {
+        /* Only workers with more tasks pending than the reserve allocate */
+        pthread_mutex_unlock(&pool->lock);
+        task = malloc(sizeof(struct pool_task));
+
+        if (task == NULL) {
+            return;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+    }
+
+    task->runnable = runnable;
+    task->ctx = ctx;
+    task->next = NULL;
+
+    if (worker->tail) {
+        worker->tail->next = task;
+    } else {
+        worker->head = task;
+    }
+    worker->tail = task;
+
+    if (worker->state == POOL_WORKER_IDLE) {
+        pool_enqueue(pool, worker);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static struct rxc_scheduler_worker * scheduler_create_worker(struct rxc_scheduler *self)
+{
+    struct pool_worker *worker = malloc(sizeof(struct pool_worker));
+
+    if (worker == NULL) {
+        return NULL;
+    }
+
+    worker->head = NULL;
+    worker->tail = NULL;
+    worker->spare = NULL;
+    worker->spare_count = 0;
+
+    /* Fill the reserve up front, so that scheduling cannot fail later on */
+    for (int i = 0; i < POOL_WORKER_RESERVE; i++) {
+        struct pool_task *task = malloc(sizeof(struct pool_task));
+
+        if (task == NULL) {
+            worker_free(worker);
+            return NULL;
+        }
+
+        task->next = worker->spare;
+        worker->spare = task;
+        worker->spare_count++;
+    }
+
+    worker->state = POOL_WORKER_IDLE;
+    worker->disposed = 0;
+    worker->next = NULL;
+    worker->base.scheduler = self;
+    worker->base.dealloc = worker_dealloc;
+    worker->base.schedule = worker_schedule;
+    worker->base.try_run = NULL;
+
+    return &worker->base;
+}
+
+static void scheduler_dealloc(struct rxc_scheduler *self)
+{
+    struct pool *pool = (struct pool *) self;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->available);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    /* Release the workers that were waiting to be released */
+    while (pool->head) {
+        struct pool_worker *worker = pool->head;
+        pool->head = worker->next;
+
+        if (worker->disposed) {
+            worker_free(worker);
+        }
+    }
+
+    pthread_cond_destroy(&pool->available);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+struct rxc_scheduler * rxc_scheduler_thread_pool(int threads)
+{
+    if (threads <= 0) {
+        return NULL;
+    }
+
+    struct pool *pool = malloc(sizeof(struct pool));
+
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->threads = malloc(threads * sizeof(pthread_t));
+
+    if (pool->threads == NULL) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->available, NULL);
+    pool->head = NULL;
+    pool->tail = NULL;
+    pool->shutdown = 0;
+    pool->thread_count = 0;
+    pool->base.dealloc = scheduler_dealloc;
+    pool->base.create_worker = scheduler_create_worker;
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, pool_run, pool) != 0) {
+            scheduler_dealloc(&pool->base);
+            return NULL;
+        }
+
+        pool->thread_count++;
+    }
+
+    return &pool->base;
+}
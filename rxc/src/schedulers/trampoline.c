@@ -2,6 +2,7 @@
 #include <stdlib.h>
 
 #include <rxc/scheduler.h>
+#include <rxc/trace.h>
 
 static struct rxc_scheduler trampoline;
 
@@ -75,6 +76,18 @@ static void worker_dealloc(struct rxc_scheduler_worker *self)
     free(self);
 }
 
+static void worker_drain(struct trampoline_worker *self)
+{
+    struct trampoline_queue_node *node = NULL;
+
+    while ((node = worker_dequeue(self)) != NULL) {
+        RXC_TRACE_BEGIN("task", 0);
+        node->runnable(node->ctx);
+        RXC_TRACE_END("task", 0);
+        free(node);
+    }
+}
+
 static void worker_schedule(struct rxc_scheduler_worker *worker,
                             void (*runnable)(void *),
                             void *ctx)
@@ -82,26 +95,43 @@ static void worker_schedule(struct rxc_scheduler_worker *worker,
     struct trampoline_worker *self = (struct trampoline_worker *) worker;
     worker_enqueue(self, runnable, ctx);
 
-    struct trampoline_queue_node *node = NULL;
-
     /* Prevent the same thread to recursively enter this loop
      * Not thread-safe at the moment */
     if (!self->wip) {
         self->wip = 1;
-        while ((node = worker_dequeue(self)) != NULL) {
-            node->runnable(node->ctx);
-            free(node);
-        }
+        worker_drain(self);
         self->wip = 0;
     }
 }
 
+static int worker_try_run(struct rxc_scheduler_worker *worker,
+                          void (*runnable)(void *),
+                          void *ctx)
+{
+    struct trampoline_worker *self = (struct trampoline_worker *) worker;
+
+    /* Tasks scheduled from within the loop must wait for their turn */
+    if (self->wip) {
+        return 0;
+    }
+
+    self->wip = 1;
+    RXC_TRACE_BEGIN("task", 0);
+    runnable(ctx);
+    RXC_TRACE_END("task", 0);
+    worker_drain(self);
+    self->wip = 0;
+
+    return 1;
+}
+
 static struct rxc_scheduler_worker * scheduler_create_worker(struct rxc_scheduler *self)
 {
     struct trampoline_worker *worker = malloc(sizeof(struct trampoline_worker));
 
     worker->base.dealloc = worker_dealloc;
     worker->base.schedule = worker_schedule;
+    worker->base.try_run = worker_try_run;
 
     worker->head = NULL;
     worker->tail = NULL;
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <rxc/rxc.h>
+#include <rxc/trace.h>
+
+struct trace_event {
+    uint64_t timestamp;
+    const char *name;
+    long arg;
+    char phase;
+};
+
+/**
+ * The ring of events recorded by a single thread. Only the owning thread
+ * writes into the ring; dumps read it concurrently on a best-effort basis.
+ */
+struct trace_ring {
+    /**
+     * The amount of events ever recorded into the ring.
+     */
+    atomic_ulong head;
+
+    /**
+     * The identifier of the thread in the trace.
+     */
+    long tid;
+
+    /**
+     * The next ring in the registry.
+     */
+    struct trace_ring *next;
+
+    struct trace_event events[RXC_TRACE_CAPACITY];
+};
+
+atomic_int rxc_trace_active;
+
+static const char *trace_path;
+static volatile sig_atomic_t trace_requested;
+
+static _Thread_local struct trace_ring *ring;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct trace_ring *registry;
+static long registry_next_tid = 1;
+
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static struct trace_ring * ring_create(void)
+{
+    struct trace_ring *self = malloc(sizeof(struct trace_ring));
+
+    if (!self) {
+        return NULL;
+    }
+
+    atomic_init(&self->head, 0);
+
+    /* Rings outlive their threads, so events of finished threads are kept */
+    pthread_mutex_lock(&registry_lock);
+    self->tid = registry_next_tid++;
+    self->next = registry;
+    registry = self;
+    pthread_mutex_unlock(&registry_lock);
+
+    return self;
+}
+
+void rxc_trace_enable(const char *path)
+{
+    trace_path = path;
+    atomic_store_explicit(&rxc_trace_active, path != NULL, memory_order_relaxed);
+}
+
+void rxc_trace_record(char phase, const char *name, long arg)
+{
+    if (!ring && !(ring = ring_create())) {
+        return;
+    }
+
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    struct trace_event *event = &ring->events[head % RXC_TRACE_CAPACITY];
+
+    event->timestamp = now();
+    event->name = name;
+    event->arg = arg;
+    event->phase = phase;
+
+    /* Publish the event to concurrent dumps */
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+int rxc_trace_dump(void)
+{
+    struct trace_ring *entry;
+    const char *path = trace_path;
+    int first = 1;
+
+    if (!path) {
+        return EINVAL;
+    }
+
+    FILE *file = fopen(path, "w");
+
+    if (!file) {
+        return errno;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+    pthread_mutex_lock(&registry_lock);
+
+    for (entry = registry; entry; entry = entry->next) {
+        unsigned long head = atomic_load_explicit(&entry->head, memory_order_acquire);
+        unsigned long i = head > RXC_TRACE_CAPACITY ? head - RXC_TRACE_CAPACITY : 0;
+        long depth = 0;
+
+        for (; i < head; i++) {
+            struct trace_event *event = &entry->events[i % RXC_TRACE_CAPACITY];
+
+            /* Skip the ends of spans whose beginning has been overwritten by
+             * the ring, which would otherwise close unrelated spans */
+            if (event->phase == 'B') {
+                depth++;
+            } else if (event->phase == 'E') {
+                if (depth == 0) {
+                    continue;
+                }
+
+                depth--;
+            }
+
+            fprintf(file, "%s\n{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, "
+                          "\"pid\": %ld, \"tid\": %ld, \"args\": {\"arg\": %ld}%s}",
+                    first ? "" : ",", event->name, event->phase,
+                    event->timestamp / 1000.0, (long) getpid(), entry->tid, event->arg,
+                    event->phase == 'i' ? ", \"s\": \"t\"" : "");
+            first = 0;
+        }
+    }
+
+    pthread_mutex_unlock(&registry_lock);
+
+    fprintf(file, "\n]}\n");
+
+    if (fclose(file) != 0) {
+        return errno;
+    }
+
+    return RXC_EOK;
+}
+
+void rxc_trace_request_dump(void)
+{
+    trace_requested = 1;
+}
+
+int rxc_trace_poll(void)
+{
+    if (!trace_requested) {
+        return RXC_EOK;
+    }
+
+    trace_requested = 0;
+    return rxc_trace_dump();
+}
@@ -0,0 +1,144 @@
+#include <stdlib.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+#include <rxc/ops/hub.h>
+
+#include "test.h"
+
+#define ELEMENTS 50
+#define SIZE 4
+
+static void * retain(void *element)
+{
+    long *copy = malloc(sizeof(long));
+
+    TEST_ASSERT(copy != NULL);
+    *copy = *(long *) element;
+    return copy;
+}
+
+static void assert_sequence(const struct test_probe *probe, long count)
+{
+    TEST_ASSERT(probe->count == count);
+
+    for (long i = 0; i < count; i++) {
+        TEST_ASSERT(test_probe_long(probe, i) == i);
+    }
+}
+
+/**
+ * A fast consumer never runs more than a buffer ahead of a slow one, and both
+ * receive every element.
+ */
+static void test_slowest(void)
+{
+    struct rxc_source *upstream = rxc_source_count(0, ELEMENTS);
+    struct rxc_hub_broadcast *hub = rxc_hub_broadcast(upstream, SIZE, RXC_HUB_LAG_SLOWEST,
+                                                      retain, free);
+    struct rxc_source *source = rxc_hub_broadcast_source(hub);
+    struct test_probe fast, slow;
+
+    test_probe_init(&fast);
+    test_probe_init(&slow);
+    source->connect(source, &fast.sink);
+    source->connect(source, &slow.sink);
+    TEST_ASSERT(rxc_hub_broadcast_consumers(hub) == 2);
+
+    while (!slow.finished) {
+        /* The hub releases consumers once they terminate */
+        if (!fast.finished) {
+            test_probe_pull(&fast, SIZE * 2);
+        }
+
+        test_probe_pull(&slow, 1);
+        TEST_ASSERT(fast.count - slow.count <= SIZE);
+    }
+
+    TEST_ASSERT(fast.finished);
+    assert_sequence(&fast, ELEMENTS);
+    assert_sequence(&slow, ELEMENTS);
+    TEST_ASSERT(rxc_hub_broadcast_consumers(hub) == 0);
+
+    rxc_hub_broadcast_dealloc(hub);
+    rxc_source_dealloc(upstream);
+    test_probe_destroy(&fast, NULL);
+    test_probe_destroy(&slow, NULL);
+}
+
+/**
+ * A consumer that falls a full buffer behind is completed under the detach
+ * policy, while the others continue.
+ */
+static void test_detach(void)
+{
+    struct rxc_source *upstream = rxc_source_count(0, ELEMENTS);
+    struct rxc_hub_broadcast *hub = rxc_hub_broadcast(upstream, SIZE, RXC_HUB_LAG_DETACH,
+                                                      retain, free);
+    struct rxc_source *source = rxc_hub_broadcast_source(hub);
+    struct test_probe fast, idle;
+
+    test_probe_init(&fast);
+    test_probe_init(&idle);
+    source->connect(source, &fast.sink);
+    source->connect(source, &idle.sink);
+
+    while (!fast.finished) {
+        test_probe_pull(&fast, 1);
+    }
+
+    assert_sequence(&fast, ELEMENTS);
+    TEST_ASSERT(idle.finished);
+    TEST_ASSERT(idle.count == 0);
+
+    rxc_hub_broadcast_dealloc(hub);
+    rxc_source_dealloc(upstream);
+    test_probe_destroy(&fast, NULL);
+    test_probe_destroy(&idle, NULL);
+}
+
+/**
+ * Consumers may cancel at any point, and the hub may be deallocated while
+ * upstream is still running and consumers are still attached, which releases
+ * the consumers and the elements the hub holds.
+ */
+static void test_teardown(void)
+{
+    struct rxc_source *upstream = rxc_source_count(0, ELEMENTS);
+    struct rxc_hub_broadcast *hub = rxc_hub_broadcast(upstream, SIZE, RXC_HUB_LAG_SKIP,
+                                                      retain, free);
+    struct rxc_source *source = rxc_hub_broadcast_source(hub);
+    struct test_probe first, second, canceled;
+
+    test_probe_init(&first);
+    test_probe_init(&second);
+    test_probe_init(&canceled);
+    source->connect(source, &first.sink);
+    source->connect(source, &second.sink);
+    source->connect(source, &canceled.sink);
+
+    test_probe_pull(&first, 3);
+    test_probe_pull(&canceled, 2);
+    test_probe_cancel(&canceled);
+    TEST_ASSERT(rxc_hub_broadcast_consumers(hub) == 2);
+
+    /* The second consumer has not received the buffered elements yet */
+    test_probe_pull(&first, 2);
+    TEST_ASSERT(first.count == 5);
+    TEST_ASSERT(second.count == 0);
+    TEST_ASSERT(!first.finished && !second.finished);
+
+    rxc_hub_broadcast_dealloc(hub);
+    rxc_source_dealloc(upstream);
+    test_probe_destroy(&first, NULL);
+    test_probe_destroy(&second, NULL);
+    test_probe_destroy(&canceled, NULL);
+}
+
+int main(void)
+{
+    test_slowest();
+    test_detach();
+    test_teardown();
+    return EXIT_SUCCESS;
+}
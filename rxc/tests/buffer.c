@@ -0,0 +1,96 @@
+#include <stdlib.h>
+#include <limits.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+
+#include "test.h"
+
+#define ELEMENTS 1000
+#define SIZE 8
+
+static struct rxc_source * source_create(enum rxc_overflow_strategy overflow)
+{
+    struct rxc_source *source = rxc_source_via(rxc_source_count(0, ELEMENTS),
+                                               rxc_flow_buffer(SIZE, 2, overflow, NULL));
+
+    TEST_ASSERT(source != NULL);
+    return source;
+}
+
+/**
+ * Under backpressure, every element arrives in order, however slowly
+ * downstream pulls.
+ */
+static void test_backpressure(void)
+{
+    struct rxc_source *source = source_create(RXC_OVERFLOW_BACKPRESSURE);
+    struct test_probe probe;
+
+    test_probe_init(&probe);
+    source->connect(source, &probe.sink);
+
+    for (long i = 0; i <= ELEMENTS && !probe.finished; i++) {
+        test_probe_pull(&probe, 1);
+    }
+
+    TEST_ASSERT(probe.finished);
+    TEST_ASSERT(probe.count == ELEMENTS);
+
+    for (long i = 0; i < ELEMENTS; i++) {
+        TEST_ASSERT(test_probe_long(&probe, i) == i);
+    }
+
+    test_probe_destroy(&probe, NULL);
+    rxc_source_dealloc(source);
+}
+
+/**
+ * The other strategies let upstream run ahead, which the synchronous source
+ * does completely before downstream pulls.
+ */
+static void test_drop(enum rxc_overflow_strategy overflow, long first)
+{
+    struct rxc_source *source = source_create(overflow);
+    struct test_probe probe;
+
+    test_probe_init(&probe);
+    source->connect(source, &probe.sink);
+    test_probe_pull(&probe, LONG_MAX);
+
+    TEST_ASSERT(probe.finished);
+    TEST_ASSERT(probe.count == SIZE);
+
+    for (long i = 0; i < SIZE; i++) {
+        TEST_ASSERT(test_probe_long(&probe, i) == first + i);
+    }
+
+    test_probe_destroy(&probe, NULL);
+    rxc_source_dealloc(source);
+}
+
+static void test_fail(void)
+{
+    struct rxc_source *source = source_create(RXC_OVERFLOW_FAIL);
+    struct test_probe probe;
+
+    test_probe_init(&probe);
+    source->connect(source, &probe.sink);
+    test_probe_pull(&probe, LONG_MAX);
+
+    /* The queued elements are discarded along with the overflowing one */
+    TEST_ASSERT(probe.failed);
+    TEST_ASSERT(probe.count == 0);
+
+    test_probe_destroy(&probe, NULL);
+    rxc_source_dealloc(source);
+}
+
+int main(void)
+{
+    test_backpressure();
+    test_drop(RXC_OVERFLOW_DROP_OLDEST, ELEMENTS - SIZE);
+    test_drop(RXC_OVERFLOW_DROP_NEWEST, 0);
+    test_fail();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,333 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+#include <rxc/schedulers/thread_pool.h>
+
+#include "test.h"
+
+#define ELEMENTS 500
+#define PARALLELISM 8
+#define THREADS 4
+
+/**
+ * The amount of mappings that are running and the most that ran at once.
+ */
+static atomic_long running, running_max;
+
+/**
+ * A sink that collects the elements the stage emits on its own worker, while
+ * the test waits for them on the main thread. It pulls <code>demand</code>
+ * elements on connect and cancels after receiving <code>limit</code> elements.
+ */
+struct collector {
+    struct rxc_sink sink;
+    struct rxc_sink_logic logic;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    long elements[ELEMENTS];
+    long count, demand, limit;
+    int finished, failed, disposed;
+};
+
+static struct collector * collector_of(struct rxc_sink_logic *logic)
+{
+    return (void *) ((char *) logic - offsetof(struct collector, logic));
+}
+
+static void sink_dealloc(struct rxc_sink *self, int shallow)
+{
+    /* The sink is owned by the collector */
+}
+
+static void logic_dealloc(struct rxc_sink_logic *self)
+{
+    struct collector *collector = collector_of(self);
+
+    pthread_mutex_lock(&collector->lock);
+    collector->disposed = 1;
+    pthread_mutex_unlock(&collector->lock);
+}
+
+static void logic_on_connect(struct rxc_sink_logic *self)
+{
+    rxc_inlet_pull(self->in, collector_of(self)->demand);
+}
+
+static void logic_on_push(struct rxc_sink_logic *self, void *element)
+{
+    struct collector *collector = collector_of(self);
+    int cancel;
+
+    pthread_mutex_lock(&collector->lock);
+    TEST_ASSERT(!collector->disposed);
+    TEST_ASSERT(collector->count < collector->limit && collector->count < ELEMENTS);
+    collector->elements[collector->count++] = *(long *) element;
+    cancel = collector->count == collector->limit;
+    pthread_cond_broadcast(&collector->cond);
+    pthread_mutex_unlock(&collector->lock);
+
+    free(element);
+
+    if (cancel) {
+        rxc_inlet_cancel(self->in);
+    }
+}
+
+static void logic_on_upstream_finish(struct rxc_sink_logic *self)
+{
+    struct collector *collector = collector_of(self);
+
+    pthread_mutex_lock(&collector->lock);
+    TEST_ASSERT(!collector->finished && !collector->failed);
+    collector->finished = 1;
+    pthread_cond_broadcast(&collector->cond);
+    pthread_mutex_unlock(&collector->lock);
+}
+
+static void logic_on_upstream_failure(struct rxc_sink_logic *self, void *failure)
+{
+    struct collector *collector = collector_of(self);
+
+    free(failure);
+
+    pthread_mutex_lock(&collector->lock);
+    TEST_ASSERT(!collector->finished && !collector->failed);
+    collector->failed = 1;
+    pthread_cond_broadcast(&collector->cond);
+    pthread_mutex_unlock(&collector->lock);
+}
+
+static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *self)
+{
+    return &((struct collector *) ((char *) self - offsetof(struct collector, sink)))->logic;
+}
+
+static void collector_init(struct collector *collector, long demand, long limit)
+{
+    collector->sink.dealloc = sink_dealloc;
+    collector->sink.create_logic = sink_create_logic;
+    collector->logic.sink = &collector->sink;
+    collector->logic.in = NULL;
+    collector->logic.dealloc = logic_dealloc;
+    collector->logic.on_connect = logic_on_connect;
+    collector->logic.on_push = logic_on_push;
+    collector->logic.on_push_value = NULL;
+    collector->logic.on_upstream_finish = logic_on_upstream_finish;
+    collector->logic.on_upstream_failure = logic_on_upstream_failure;
+    pthread_mutex_init(&collector->lock, NULL);
+    pthread_cond_init(&collector->cond, NULL);
+    collector->count = 0;
+    collector->demand = demand;
+    collector->limit = limit;
+    collector->finished = 0;
+    collector->failed = 0;
+    collector->disposed = 0;
+}
+
+static void collector_destroy(struct collector *collector)
+{
+    pthread_cond_destroy(&collector->cond);
+    pthread_mutex_destroy(&collector->lock);
+}
+
+/**
+ * Wait until the collector has received the specified amount of elements or
+ * has terminated, and fail the test if that takes longer than ten seconds.
+ */
+static long collector_wait(struct collector *collector, long count)
+{
+    struct timespec deadline;
+    long result;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 10;
+
+    pthread_mutex_lock(&collector->lock);
+
+    while (collector->count < count && !collector->finished && !collector->failed) {
+        int err = pthread_cond_timedwait(&collector->cond, &collector->lock, &deadline);
+
+        TEST_ASSERT(err != ETIMEDOUT);
+    }
+
+    result = collector->count;
+    pthread_mutex_unlock(&collector->lock);
+    return result;
+}
+
+/**
+ * A sink that records the logic the stage creates, which the pipeline never
+ * deallocates, so that the test can tear the stage down itself.
+ */
+struct capture {
+    struct rxc_sink base;
+    struct rxc_source *source;
+    struct rxc_sink *inner;
+    struct rxc_sink_logic *logic;
+};
+
+static struct rxc_sink_logic * capture_create_logic(struct rxc_sink *self)
+{
+    struct capture *capture = (struct capture *) self;
+
+    return capture->logic = capture->inner->create_logic(capture->inner);
+}
+
+/**
+ * Double the element after a delay that varies per element, so that the
+ * mappings complete out of order.
+ */
+static void * mapping(void *element)
+{
+    long *value = element;
+    long current = atomic_fetch_add(&running, 1) + 1;
+    long max = atomic_load(&running_max);
+
+    while (current > max && !atomic_compare_exchange_weak(&running_max, &max, current)) {}
+
+    usleep((*value * 37) % 7 * 100);
+    *value *= 2;
+
+    atomic_fetch_sub(&running, 1);
+    return element;
+}
+
+static void stage_connect(struct capture *capture, struct rxc_scheduler *scheduler,
+                          struct collector *collector)
+{
+    struct rxc_flow *flow = rxc_flow_map_parallel(mapping, PARALLELISM, scheduler, NULL);
+
+    TEST_ASSERT(flow != NULL);
+
+    capture->base.dealloc = sink_dealloc;
+    capture->base.create_logic = capture_create_logic;
+    capture->inner = rxc_flow_to(flow, &collector->sink);
+    capture->source = rxc_source_count(0, ELEMENTS);
+    capture->logic = NULL;
+    TEST_ASSERT(capture->inner != NULL && capture->source != NULL);
+
+    capture->source->connect(capture->source, &capture->base);
+    TEST_ASSERT(capture->logic != NULL);
+}
+
+static void stage_dealloc(struct capture *capture, struct rxc_scheduler *scheduler)
+{
+    capture->logic->dealloc(capture->logic);
+    rxc_scheduler_dealloc(scheduler);
+    rxc_sink_dealloc(capture->inner);
+    rxc_source_dealloc(capture->source);
+}
+
+/**
+ * The results are emitted in upstream order, however the mappings interleave,
+ * and no more than the parallelism of the stage run at once.
+ */
+static void test_order(void)
+{
+    struct rxc_scheduler *scheduler = rxc_scheduler_thread_pool(THREADS);
+    struct collector collector;
+    struct capture capture;
+
+    TEST_ASSERT(scheduler != NULL);
+    atomic_store(&running_max, 0);
+
+    collector_init(&collector, LONG_MAX, LONG_MAX);
+    stage_connect(&capture, scheduler, &collector);
+    TEST_ASSERT(collector_wait(&collector, ELEMENTS + 1) == ELEMENTS);
+
+    TEST_ASSERT(collector.finished);
+
+    for (long i = 0; i < ELEMENTS; i++) {
+        TEST_ASSERT(collector.elements[i] == i * 2);
+    }
+
+    TEST_ASSERT(atomic_load(&running_max) <= PARALLELISM);
+
+    stage_dealloc(&capture, scheduler);
+    TEST_ASSERT(collector.disposed);
+    collector_destroy(&collector);
+}
+
+/**
+ * Downstream receives nothing after it cancels, and the stage may be
+ * deallocated while the results of the elements in flight are discarded.
+ */
+static void test_cancel(void)
+{
+    struct rxc_scheduler *scheduler = rxc_scheduler_thread_pool(THREADS);
+    struct collector collector;
+    struct capture capture;
+    long limit = ELEMENTS / 4;
+
+    TEST_ASSERT(scheduler != NULL);
+
+    collector_init(&collector, LONG_MAX, limit);
+    stage_connect(&capture, scheduler, &collector);
+    TEST_ASSERT(collector_wait(&collector, limit) == limit);
+
+    /* Give the mappings in flight time to complete */
+    usleep(20000);
+
+    pthread_mutex_lock(&collector.lock);
+    TEST_ASSERT(collector.count == limit);
+    TEST_ASSERT(!collector.finished && !collector.failed);
+    pthread_mutex_unlock(&collector.lock);
+
+    for (long i = 0; i < limit; i++) {
+        TEST_ASSERT(collector.elements[i] == i * 2);
+    }
+
+    stage_dealloc(&capture, scheduler);
+    collector_destroy(&collector);
+}
+
+/**
+ * The stage may be deallocated while it waits for demand and the mappings
+ * that refill its slots are still running, after which downstream receives
+ * nothing.
+ */
+static void test_teardown(void)
+{
+    struct rxc_scheduler *scheduler = rxc_scheduler_thread_pool(THREADS);
+    struct collector collector;
+    struct capture capture;
+    long demand = ELEMENTS / 4;
+
+    TEST_ASSERT(scheduler != NULL);
+
+    collector_init(&collector, demand, LONG_MAX);
+    stage_connect(&capture, scheduler, &collector);
+    TEST_ASSERT(collector_wait(&collector, demand) == demand);
+
+    capture.logic->dealloc(capture.logic);
+
+    /* The mappings in flight complete without reaching downstream */
+    usleep(20000);
+
+    pthread_mutex_lock(&collector.lock);
+    TEST_ASSERT(collector.disposed);
+    TEST_ASSERT(collector.count == demand);
+    TEST_ASSERT(!collector.finished);
+    pthread_mutex_unlock(&collector.lock);
+
+    rxc_scheduler_dealloc(scheduler);
+    rxc_sink_dealloc(capture.inner);
+    rxc_source_dealloc(capture.source);
+    collector_destroy(&collector);
+}
+
+int main(void)
+{
+    test_order();
+    test_cancel();
+    test_teardown();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#include <stdlib.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+#include <rxc/ops/hub.h>
+
+#include "test.h"
+
+#define INPUTS 3
+#define ELEMENTS 20
+#define SIZE 4
+
+/**
+ * The inputs emit the integers from <code>i * 1000</code> on, so that the
+ * merged elements can be traced back to their input.
+ */
+static void inputs_attach(struct rxc_hub_merge *hub, struct rxc_source **inputs)
+{
+    struct rxc_sink *sink = rxc_hub_merge_sink(hub);
+
+    for (long i = 0; i < INPUTS; i++) {
+        inputs[i] = rxc_source_count(i * 1000, i * 1000 + ELEMENTS);
+        TEST_ASSERT(inputs[i] != NULL);
+        inputs[i]->connect(inputs[i], sink);
+    }
+
+    TEST_ASSERT(rxc_hub_merge_inputs(hub) == INPUTS);
+}
+
+static void inputs_dealloc(struct rxc_source **inputs)
+{
+    for (long i = 0; i < INPUTS; i++) {
+        rxc_source_dealloc(inputs[i]);
+    }
+}
+
+/**
+ * The inputs are served round-robin and each of them in order, and the merged
+ * stream completes once the closed hub has drained its inputs.
+ */
+static void test_round_robin(void)
+{
+    struct rxc_hub_merge *hub = rxc_hub_merge(SIZE, NULL);
+    struct rxc_source *inputs[INPUTS];
+    struct rxc_source *source = rxc_hub_merge_source(hub);
+    struct test_probe probe;
+    long next[INPUTS] = { 0 };
+
+    inputs_attach(hub, inputs);
+    rxc_hub_merge_close(hub);
+
+    test_probe_init(&probe);
+    source->connect(source, &probe.sink);
+
+    while (!probe.finished) {
+        test_probe_pull(&probe, 1);
+    }
+
+    TEST_ASSERT(probe.count == INPUTS * ELEMENTS);
+
+    for (long i = 0; i < probe.count; i++) {
+        long element = test_probe_long(&probe, i);
+        long input = element / 1000;
+
+        TEST_ASSERT(input >= 0 && input < INPUTS);
+        TEST_ASSERT(element % 1000 == next[input]++);
+
+        /* No input gets ahead of the others by more than a round */
+        for (long j = 0; j < INPUTS; j++) {
+            TEST_ASSERT(next[input] - next[j] <= 1);
+        }
+    }
+
+    TEST_ASSERT(rxc_hub_merge_inputs(hub) == 0);
+
+    rxc_hub_merge_dealloc(hub);
+    inputs_dealloc(inputs);
+    test_probe_destroy(&probe, NULL);
+}
+
+/**
+ * The hub may be deallocated while its inputs are still running, after
+ * downstream has canceled or while it is still attached.
+ */
+static void test_teardown(int cancel)
+{
+    struct rxc_hub_merge *hub = rxc_hub_merge(SIZE, NULL);
+    struct rxc_source *inputs[INPUTS];
+    struct rxc_source *source = rxc_hub_merge_source(hub);
+    struct test_probe probe;
+
+    inputs_attach(hub, inputs);
+
+    test_probe_init(&probe);
+    source->connect(source, &probe.sink);
+    test_probe_pull(&probe, ELEMENTS);
+    TEST_ASSERT(probe.count == ELEMENTS);
+
+    if (cancel) {
+        test_probe_cancel(&probe);
+    }
+
+    TEST_ASSERT(!probe.finished && !probe.failed);
+
+    rxc_hub_merge_dealloc(hub);
+    inputs_dealloc(inputs);
+    test_probe_destroy(&probe, NULL);
+}
+
+int main(void)
+{
+    test_round_robin();
+    test_teardown(0);
+    test_teardown(1);
+    return EXIT_SUCCESS;
+}
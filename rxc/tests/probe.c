@@ -0,0 +1,115 @@
+#include <stdlib.h>
+#include <stddef.h>
+
+#include "test.h"
+
+static struct test_probe * probe_of(struct rxc_sink_logic *logic)
+{
+    return (void *) ((char *) logic - offsetof(struct test_probe, logic));
+}
+
+static void sink_dealloc(struct rxc_sink *self, int shallow)
+{
+    /* The sink is owned by the probe */
+}
+
+static void logic_dealloc(struct rxc_sink_logic *self)
+{
+    /* The logic is owned by the probe */
+}
+
+static void logic_on_connect(struct rxc_sink_logic *self)
+{
+    probe_of(self)->connected = 1;
+}
+
+static void logic_on_push(struct rxc_sink_logic *self, void *element)
+{
+    struct test_probe *probe = probe_of(self);
+
+    if (probe->count == probe->capacity) {
+        probe->capacity = probe->capacity ? probe->capacity * 2 : 16;
+        probe->elements = realloc(probe->elements, probe->capacity * sizeof(void *));
+        TEST_ASSERT(probe->elements != NULL);
+    }
+
+    probe->elements[probe->count++] = element;
+}
+
+static void logic_on_upstream_finish(struct rxc_sink_logic *self)
+{
+    struct test_probe *probe = probe_of(self);
+
+    TEST_ASSERT(!probe->finished && !probe->failed);
+    probe->finished = 1;
+}
+
+static void logic_on_upstream_failure(struct rxc_sink_logic *self, void *failure)
+{
+    struct test_probe *probe = probe_of(self);
+
+    TEST_ASSERT(!probe->finished && !probe->failed);
+    probe->failed = 1;
+    probe->failure = failure;
+}
+
+static struct rxc_sink_logic * sink_create_logic(struct rxc_sink *self)
+{
+    struct test_probe *probe = (void *) ((char *) self - offsetof(struct test_probe, sink));
+
+    TEST_ASSERT(!probe->connected);
+    return &probe->logic;
+}
+
+void test_probe_init(struct test_probe *probe)
+{
+    probe->sink.dealloc = sink_dealloc;
+    probe->sink.create_logic = sink_create_logic;
+    probe->logic.sink = &probe->sink;
+    probe->logic.in = NULL;
+    probe->logic.dealloc = logic_dealloc;
+    probe->logic.on_connect = logic_on_connect;
+    probe->logic.on_push = logic_on_push;
+    probe->logic.on_push_value = NULL;
+    probe->logic.on_upstream_finish = logic_on_upstream_finish;
+    probe->logic.on_upstream_failure = logic_on_upstream_failure;
+    probe->connected = 0;
+    probe->elements = NULL;
+    probe->count = 0;
+    probe->capacity = 0;
+    probe->finished = 0;
+    probe->failed = 0;
+    probe->failure = NULL;
+}
+
+void test_probe_pull(struct test_probe *probe, long n)
+{
+    TEST_ASSERT(probe->connected);
+    rxc_inlet_pull(probe->logic.in, n);
+}
+
+void test_probe_cancel(struct test_probe *probe)
+{
+    TEST_ASSERT(probe->connected);
+    rxc_inlet_cancel(probe->logic.in);
+}
+
+long test_probe_long(const struct test_probe *probe, long index)
+{
+    TEST_ASSERT(index >= 0 && index < probe->count);
+    return *(long *) probe->elements[index];
+}
+
+void test_probe_destroy(struct test_probe *probe, void (*release)(void *element))
+{
+    for (long i = 0; i < probe->count; i++) {
+        (release ? release : free)(probe->elements[i]);
+    }
+
+    free(probe->elements);
+    free(probe->failure);
+    probe->elements = NULL;
+    probe->count = 0;
+    probe->capacity = 0;
+    probe->failure = NULL;
+}
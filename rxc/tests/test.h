@@ -0,0 +1,93 @@
+#ifndef RXC_TEST_H
+#define RXC_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <rxc/rxc.h>
+#include <rxc/logic.h>
+
+/**
+ * Fail the test with the location of the specified condition if it does not
+ * hold. Unlike <code>assert</code>, the condition is also checked in release
+ * builds.
+ */
+#define TEST_ASSERT(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+/**
+ * A sink that records the elements it receives and only pulls when the test
+ * asks it to, so that a test controls the demand of the stages before it. A
+ * probe is owned by the test and accepts a single connection.
+ */
+struct test_probe {
+    struct rxc_sink sink;
+    struct rxc_sink_logic logic;
+
+    /**
+     * A flag to indicate the probe has been connected to a source.
+     */
+    int connected;
+
+    /**
+     * The elements the probe has received.
+     */
+    void **elements;
+    long count;
+    long capacity;
+
+    /**
+     * Flags to indicate how the source has terminated and the failure it
+     * reported.
+     */
+    int finished, failed;
+    void *failure;
+};
+
+/**
+ * Initialize the specified probe.
+ *
+ * @param[out] probe The probe to initialize.
+ */
+void test_probe_init(struct test_probe *probe);
+
+/**
+ * Request the specified amount of elements through the probe.
+ *
+ * @param[in] probe The probe to pull with, which must be connected.
+ * @param[in] n The amount of elements to request.
+ */
+void test_probe_pull(struct test_probe *probe, long n);
+
+/**
+ * Stop receiving elements through the probe.
+ *
+ * @param[in] probe The probe to cancel, which must be connected.
+ */
+void test_probe_cancel(struct test_probe *probe);
+
+/**
+ * Obtain the integer of a received element that was boxed as a
+ * <code>long</code>.
+ *
+ * @param[in] probe The probe that received the element.
+ * @param[in] index The index of the element.
+ * @return The integer of the element.
+ */
+long test_probe_long(const struct test_probe *probe, long index);
+
+/**
+ * Release the elements and failure the specified probe has received.
+ *
+ * @param[in] probe The probe to destroy.
+ * @param[in] release The function to release the elements with or
+ * <code>NULL</code> to use <code>free</code>.
+ */
+void test_probe_destroy(struct test_probe *probe, void (*release)(void *element));
+
+#endif /* RXC_TEST_H */
@@ -6,6 +6,8 @@
 
 #include <rxc/rxc.h>
 
+#include <sas/codec.h>
+
 /**
  * A client for the sas-server.
  */
@@ -30,9 +32,22 @@ void sas_client_dealloc(struct sas_client *client);
  *
  * @param[in] client The client to initialize.
  * @param[in] sink The sink to pipe the audio to.
+ * @param[in] codec The codec to request from the server. The server may fall
+ * back to another codec, which is decoded transparently.
  * @return <code>0</code> on success, otherwise an error code.
  */
-int sas_client_init(struct sas_client *client, struct rxc_sink *sink);
+int sas_client_init(struct sas_client *client, struct rxc_sink *sink,
+                    const struct sas_codec *codec);
+
+/**
+ * Set the sample rate to request from the server, which resamples the stream
+ * if the file has another sample rate.
+ *
+ * @param[in] client The client to configure.
+ * @param[in] sample_rate The sample rate in Hz or <code>0</code> to receive
+ * the stream at the sample rate of the file.
+ */
+void sas_client_set_sample_rate(struct sas_client *client, int32_t sample_rate);
 
 /**
  * Connect to the specified hostname with the client.
@@ -15,6 +15,8 @@
 #include <rxc/rxc.h>
 #include <rxc/logic.h>
 
+#include <sas/codec.h>
+#include <sas/convert.h>
 #include <sas/log.h>
 #include <sas/client.h>
 #include <sas/transport.h>
@@ -42,10 +44,13 @@ void sas_client_dealloc(struct sas_client *client)
     free(client);
 }
 
-int sas_client_init(struct sas_client *client, struct rxc_sink *sink)
+int sas_client_init(struct sas_client *client, struct rxc_sink *sink,
+                    const struct sas_codec *codec)
 {
     client->fd = -1;
     client->sink = sink;
+    client->codec = codec;
+    client->sample_rate = 0;
 
     client->session.seq = 0;
     client->session.ack = 0;
@@ -58,6 +63,11 @@ int sas_client_init(struct sas_client *client, struct rxc_sink *sink)
     return 0;
 }
 
+void sas_client_set_sample_rate(struct sas_client *client, int32_t sample_rate)
+{
+    client->sample_rate = sample_rate;
+}
+
 int sas_client_connect_hostname(struct sas_client *client, const char *hostname,
                                 int port)
 {
@@ -143,13 +153,14 @@ int sas_client_session_syn(struct sas_client *client, const char *name)
         return ENOMEM;
     }
 
-    header->flags = SAS_TRANSPORT_PACKET_FLAG_SYN;
+    header->flags = SAS_TRANSPORT_PACKET_FLAG_SYN | SAS_TRANSPORT_PACKET_FLAG_RAT;
     header->length = sizeof(struct sas_transport_packet_cfg) + name_len;
 
     client->session.state = SAS_TRANSPORT_STATE_SYN_SENT;
 
     struct sas_transport_packet_cfg *cfg = (void *) &header[1];
-    cfg->codec = 0;
+    cfg->sample_rate = client->sample_rate;
+    cfg->codec = client->codec->id;
 
     sas_transport_packet_cfg_encode(cfg);
 
@@ -221,19 +232,42 @@ int sas_client_session_state_machine(struct sas_client *client,
             struct sas_transport_packet_cfg_ack *cfg = (void *) &header[1];
             sas_transport_packet_cfg_ack_decode(cfg);
 
+            struct sas_format format = {
+                .sample_rate = cfg->sample_rate,
+                .sample_size = cfg->sample_size,
+                .channels = cfg->channels,
+                .sample = (uint8_t) sas_convert_integer_format(cfg->sample_size),
+                .layout = SAS_LAYOUT_INTERLEAVED,
+                .codec = cfg->codec,
+            };
+
             client->session.chunk.dealloc = chunk_dealloc;
-            client->session.chunk.sample_rate = cfg->sample_rate;
-            client->session.chunk.sample_size = cfg->sample_size;
-            client->session.chunk.channels = cfg->channels;
-            client->session.chunk.codec = cfg->codec;
+            client->session.chunk.format = sas_format_intern(&format);
+
+            if (!client->session.chunk.format) {
+                return ENOMEM;
+            }
+
             client->session.chunk.size = header->length - sizeof(struct sas_transport_packet_cfg_ack);
             client->session.chunk.buffer = (void *) &cfg[1];
 
             sas_log(LOG_INFO "%d %d %d\n", cfg->sample_rate, cfg->sample_size, cfg->channels);
 
+            /* The server may fall back to another codec than requested */
+            const struct sas_codec *codec = sas_codec_find(cfg->codec);
+
+            if (!codec) {
+                return EPROTO;
+            }
+
             /* Setup the streaming pipeline */
             int err;
             struct rxc_source *source = sas_client_session_source(client);
+
+            if (codec->decoder) {
+                source = rxc_source_via(source, codec->decoder());
+            }
+
             client->session.pipeline = rxc_source_to(source, client->sink);
 
             if ((err = rxc_pipeline_start(client->session.pipeline, rxc_scheduler_trampoline())) != 0) {
@@ -249,7 +283,7 @@ int sas_client_session_state_machine(struct sas_client *client,
         }
         case SAS_TRANSPORT_STATE_ESTABLSH: {
             /* Push chunk to sink */
-            client->session.chunk.size = header->length - sizeof(struct sas_transport_packet_cfg_ack);
+            client->session.chunk.size = header->length;
             client->session.chunk.buffer = (void *) &header[1];
             client->session.sink_logic->on_push(client->session.sink_logic, &client->session.chunk);
             client->session.receive_window = 0;
@@ -5,6 +5,7 @@
 
 #include <sas/client.h>
 #include <sas/chunk.h>
+#include <sas/codec.h>
 
 #define SAS_CLIENT_SESSION_WINDOW_SIZE 1024
 
@@ -19,6 +20,17 @@ struct sas_client {
      */
     struct rxc_sink *sink;
 
+    /**
+     * The codec to request from the server.
+     */
+    const struct sas_codec *codec;
+
+    /**
+     * The sample rate to request from the server or <code>0</code> for the
+     * sample rate of the file.
+     */
+    int32_t sample_rate;
+
     /**
      * The session of the client.
      */
@@ -46,6 +46,7 @@ static struct rxc_sink_logic * create_logic(struct rxc_sink *self)
     logic->dealloc = (void (*)(struct rxc_sink_logic *)) free;
     logic->on_connect = on_connect;
     logic->on_push = on_push;
+    logic->on_push_value = NULL;
     logic->on_upstream_finish = on_upstream_finish;
     logic->on_upstream_failure = on_upstream_failure;
 
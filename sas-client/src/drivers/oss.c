@@ -97,7 +97,8 @@ static void on_push(struct rxc_sink_logic *logic, void *element)
     struct sas_chunk *chunk = (void *) element;
 
     if (self->fd <= 0 && !self->finished) {
-        self->fd = open_audio_fd(chunk->sample_rate, chunk->sample_size, chunk->channels);
+        self->fd = open_audio_fd(chunk->format->sample_rate, chunk->format->sample_size,
+                                 chunk->format->channels);
         rxc_inlet_pull(logic->in, 1);
         return;
     }
@@ -139,6 +140,7 @@ static struct rxc_sink_logic * create_logic(struct rxc_sink *self)
     logic->base.dealloc = dealloc;
     logic->base.on_connect = on_connect;
     logic->base.on_push = on_push;
+    logic->base.on_push_value = NULL;
     logic->base.on_upstream_finish = on_upstream_finish;
     logic->base.on_upstream_failure = on_upstream_failure;
 
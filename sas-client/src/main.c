@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <errno.h>
 
 #include <getopt.h>
@@ -9,6 +10,7 @@
 #include <sys/socket.h>
 #include <netdb.h>
 
+#include <sas/codec.h>
 #include <sas/log.h>
 #include <sas/client.h>
 
@@ -20,13 +22,17 @@
  * @param[in] name The name of this program (most probably given by argv[0]).
  */
 static void print_usage(const char *name) {
-    fprintf(stderr, "usage: %s host file\n", name);
+    fprintf(stderr, "usage: %s [-c codec] [-r rate] host file\n", name);
     fprintf(stderr, "\t-h --help\t\tshow a help message\n");
+    fprintf(stderr, "\t-c --codec CODEC\tthe codec to request (none, ima-adpcm, ulaw, alaw, lossless, opus)\n");
+    fprintf(stderr, "\t-r --rate RATE\t\tthe sample rate to request in Hz\n");
 }
 
 /* Command line options */
 static struct option long_options[] = {
         {"help", no_argument, 0, 'h'},
+        {"codec", required_argument, 0, 'c'},
+        {"rate", required_argument, 0, 'r'},
         {0, 0, 0, 0}
 };
 
@@ -39,10 +45,13 @@ static struct option long_options[] = {
  */
 int main(int argc, char **argv)
 {
+    const struct sas_codec *codec = &sas_codec_none;
+    long sample_rate = 0;
+
     /* Parse command line options */
     while (1) {
         int option_index = 0;
-        int c = getopt_long(argc, argv, "h", long_options, &option_index);
+        int c = getopt_long(argc, argv, "hc:r:", long_options, &option_index);
 
         if (c == -1) {
             break;
@@ -56,6 +65,20 @@ int main(int argc, char **argv)
             case 'h':
                 print_usage(argv[0]);
                 return EXIT_SUCCESS;
+            case 'c':
+                if (!(codec = sas_codec_find_name(optarg))) {
+                    sas_log(LOG_ERR "Unknown codec %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'r':
+                sample_rate = strtol(optarg, NULL, 10);
+
+                if (sample_rate <= 0 || sample_rate > INT32_MAX) {
+                    sas_log(LOG_ERR "Invalid sample rate %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
             case '?':
                 print_usage(argv[0]);
                 return EXIT_FAILURE;
@@ -64,7 +87,7 @@ int main(int argc, char **argv)
         }
     }
 
-    if (argc <= 2) {
+    if (argc - optind < 2) {
         print_usage(argv[0]);
         return EXIT_FAILURE;
     }
@@ -77,24 +100,27 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
-    if ((err = sas_client_init(client, sas_drivers_ignore())) != 0) {
+    if ((err = sas_client_init(client, sas_drivers_ignore(), codec)) != 0) {
         sas_log(LOG_ERR "Failed to initialize client: %s\n", strerror(err));
         sas_client_dealloc(client);
         return EXIT_FAILURE;
     }
 
+    sas_client_set_sample_rate(client, (int32_t) sample_rate);
+
     int port = 3456;
-    char *addr = argv[1];
+    char *addr = argv[optind];
+    char *file = argv[optind + 1];
 
     if ((err = sas_client_connect_hostname(client, addr, port)) != 0) {
-        sas_log(LOG_ERR "Failed to connect to address %s: %s\n", argv[1], gai_strerror(err));
+        sas_log(LOG_ERR "Failed to connect to address %s: %s\n", addr, gai_strerror(err));
         sas_client_dealloc(client);
         return EXIT_FAILURE;
     }
 
     sas_log(LOG_INFO "Connected to address %s:%d\n", addr, port);
-    sas_log(LOG_INFO "Requesting %s\n", argv[2]);
-    if ((err = sas_client_receive(client, argv[2])) != 0) {
+    sas_log(LOG_INFO "Requesting %s\n", file);
+    if ((err = sas_client_receive(client, file)) != 0) {
         sas_log(LOG_ERR "Failed to receive: %s\n", strerror(err));
         sas_client_dealloc(client);
         return EXIT_FAILURE;
@@ -0,0 +1,581 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+#include <rxc/rxc.h>
+#include <rxc/generator.h>
+#include <rxc/logic.h>
+
+#include <sas/chain.h>
+#include <sas/chunk.h>
+#include <sas/codec.h>
+#include <sas/convert.h>
+#include <sas/cpu.h>
+#include <sas/eq.h>
+#include <sas/gain.h>
+#include <sas/limiter.h>
+#include <sas/resample.h>
+#include <sas/codecs/g711.h>
+#include <sas/codecs/ima_adpcm.h>
+#include <sas/codecs/lossless.h>
+
+/* The streams the benchmarks are based on: 44.1 kHz stereo in chunks of 1024
+ * bytes, like the server streams WAV files */
+#define SAMPLE_RATE 44100
+#define CHANNELS 2
+#define CHUNK_FRAMES 256
+
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Generate a test signal of two tones with a little noise.
+ */
+static int16_t * signal_create(size_t frames)
+{
+    int16_t *pcm = malloc(frames * CHANNELS * sizeof(int16_t));
+
+    srand(42);
+    for (size_t i = 0; i < frames; i++) {
+        for (int c = 0; c < CHANNELS; c++) {
+            double t = (double) i / SAMPLE_RATE;
+            double x = 8000 * sin(2 * M_PI * 440 * (c + 1) * t) + 4000 * sin(2 * M_PI * 97 * t);
+            pcm[i * CHANNELS + c] = (int16_t) (x + rand() % 200 - 100);
+        }
+    }
+
+    return pcm;
+}
+
+/* Codec kernels */
+struct kernel {
+    const char *codec;
+    size_t (*encode)(const int16_t *pcm, size_t frames, int channels, uint8_t *out);
+    long (*decode)(const uint8_t *in, size_t size, int channels, int16_t *pcm);
+};
+
+static size_t none_encode(const int16_t *pcm, size_t frames, int channels, uint8_t *out)
+{
+    memcpy(out, pcm, frames * channels * sizeof(int16_t));
+    return frames * channels * sizeof(int16_t);
+}
+
+static long none_decode(const uint8_t *in, size_t size, int channels, int16_t *pcm)
+{
+    memcpy(pcm, in, size);
+    return size / (channels * sizeof(int16_t));
+}
+
+static size_t ulaw_encode(const int16_t *pcm, size_t frames, int channels, uint8_t *out)
+{
+    sas_codec_g711_ulaw_encode(pcm, frames * channels, out);
+    return frames * channels;
+}
+
+static long ulaw_decode(const uint8_t *in, size_t size, int channels, int16_t *pcm)
+{
+    sas_codec_g711_ulaw_decode(in, size, pcm);
+    return size / channels;
+}
+
+static size_t alaw_encode(const int16_t *pcm, size_t frames, int channels, uint8_t *out)
+{
+    sas_codec_g711_alaw_encode(pcm, frames * channels, out);
+    return frames * channels;
+}
+
+static long alaw_decode(const uint8_t *in, size_t size, int channels, int16_t *pcm)
+{
+    sas_codec_g711_alaw_decode(in, size, pcm);
+    return size / channels;
+}
+
+static const struct kernel kernels[] = {
+    {"none", none_encode, none_decode},
+    {"ima-adpcm", sas_codec_ima_adpcm_encode, sas_codec_ima_adpcm_decode},
+    {"ulaw", ulaw_encode, ulaw_decode},
+    {"alaw", alaw_encode, alaw_decode},
+    {"lossless", sas_codec_lossless_encode, sas_codec_lossless_decode},
+};
+
+/**
+ * Encode and decode a signal chunk by chunk with the kernels of a codec.
+ */
+static void bench_kernel(const struct kernel *kernel, const char *isa,
+                         const int16_t *pcm, size_t frames)
+{
+    size_t chunks = frames / CHUNK_FRAMES;
+    size_t slot = sas_codec_lossless_bound(CHUNK_FRAMES, CHANNELS);
+    uint8_t *encoded = malloc(chunks * slot);
+    size_t *sizes = malloc(chunks * sizeof(size_t));
+    int16_t *decoded = malloc(frames * CHANNELS * sizeof(int16_t));
+    size_t bytes = 0;
+
+    uint64_t start = now();
+    for (size_t i = 0; i < chunks; i++) {
+        sizes[i] = kernel->encode(&pcm[i * CHUNK_FRAMES * CHANNELS], CHUNK_FRAMES, CHANNELS,
+                                  &encoded[i * slot]);
+        bytes += sizes[i];
+    }
+    uint64_t encode = now() - start;
+
+    start = now();
+    for (size_t i = 0; i < chunks; i++) {
+        kernel->decode(&encoded[i * slot], sizes[i], CHANNELS,
+                       &decoded[i * CHUNK_FRAMES * CHANNELS]);
+    }
+    uint64_t decode = now() - start;
+
+    double signal = 0, noise = 0;
+    size_t samples = chunks * CHUNK_FRAMES * CHANNELS;
+
+    for (size_t i = 0; i < samples; i++) {
+        double error = (double) pcm[i] - decoded[i];
+        signal += (double) pcm[i] * pcm[i];
+        noise += error * error;
+    }
+
+    printf("{\"bench\": \"codec\", \"codec\": \"%s\", \"kernel\": \"%s\", \"ratio\": %.2f, "
+           "\"encode_ns_per_sample\": %.3f, \"decode_ns_per_sample\": %.3f, ",
+           kernel->codec, isa, (double) samples * sizeof(int16_t) / bytes,
+           (double) encode / samples, (double) decode / samples);
+
+    if (noise > 0) {
+        printf("\"snr_db\": %.1f}\n", 10 * log10(signal / noise));
+    } else {
+        printf("\"snr_db\": null}\n");
+    }
+
+    free(encoded);
+    free(sizes);
+    free(decoded);
+}
+
+/* Sample format conversions */
+struct conversion {
+    const char *name;
+    int from;
+    int to;
+    int dither;
+};
+
+static const struct conversion conversions[] = {
+    {"u8-s16", SAS_SAMPLE_U8, SAS_SAMPLE_S16, 0},
+    {"s16-u8", SAS_SAMPLE_S16, SAS_SAMPLE_U8, 1},
+    {"s16-s24", SAS_SAMPLE_S16, SAS_SAMPLE_S24, 0},
+    {"s24-s16", SAS_SAMPLE_S24, SAS_SAMPLE_S16, 1},
+    {"s16-s32", SAS_SAMPLE_S16, SAS_SAMPLE_S32, 0},
+    {"s32-s16", SAS_SAMPLE_S32, SAS_SAMPLE_S16, 1},
+    {"s16-f32", SAS_SAMPLE_S16, SAS_SAMPLE_F32, 0},
+    {"f32-s16", SAS_SAMPLE_F32, SAS_SAMPLE_S16, 1},
+    {"f32-s32", SAS_SAMPLE_F32, SAS_SAMPLE_S32, 0},
+};
+
+/**
+ * Convert a signal chunk by chunk between two sample formats. The checksum of
+ * the output shows whether all instruction sets produce the same samples.
+ */
+static void bench_convert(const struct conversion *conversion, const char *isa,
+                          const int16_t *pcm, size_t frames)
+{
+    size_t samples = frames / CHUNK_FRAMES * CHUNK_FRAMES * CHANNELS;
+    size_t chunk = CHUNK_FRAMES * CHANNELS;
+    size_t in_size = sas_convert_size(conversion->from);
+    size_t out_size = sas_convert_size(conversion->to);
+    uint8_t *in = malloc(samples * in_size);
+    uint8_t *out = malloc(samples * out_size);
+    uint32_t dither = 0;
+
+    sas_convert(pcm, SAS_SAMPLE_S16, in, conversion->from, samples, NULL);
+
+    uint64_t start = now();
+    for (size_t i = 0; i < samples; i += chunk) {
+        sas_convert(&in[i * in_size], conversion->from, &out[i * out_size], conversion->to,
+                    chunk, conversion->dither ? &dither : NULL);
+    }
+    uint64_t elapsed = now() - start;
+
+    /* FNV-1a over the converted samples */
+    uint32_t checksum = 2166136261u;
+
+    for (size_t i = 0; i < samples * out_size; i++) {
+        checksum = (checksum ^ out[i]) * 16777619u;
+    }
+
+    printf("{\"bench\": \"convert\", \"conversion\": \"%s\", \"kernel\": \"%s\", "
+           "\"dither\": %s, \"ns_per_sample\": %.3f, \"checksum\": \"%08x\"}\n",
+           conversion->name, isa, conversion->dither ? "true" : "false",
+           (double) elapsed / samples, checksum);
+
+    free(in);
+    free(out);
+}
+
+/* A source of raw chunks */
+struct chunks {
+    struct rxc_generator base;
+    const struct sas_format *format;
+    const int16_t *pcm;
+    size_t frames;
+    size_t offset;
+};
+
+struct chunks_ctx {
+    const struct sas_format *format;
+    const int16_t *pcm;
+    size_t frames;
+};
+
+static void chunks_init(struct rxc_generator *gen, void *ctx)
+{
+    struct chunks *self = (struct chunks *) gen;
+
+    self->format = ((struct chunks_ctx *) ctx)->format;
+    self->pcm = ((struct chunks_ctx *) ctx)->pcm;
+    self->frames = ((struct chunks_ctx *) ctx)->frames;
+    self->offset = 0;
+}
+
+static int chunks_step(struct rxc_generator *gen)
+{
+    struct chunks *self = (struct chunks *) gen;
+
+    RXC_GENERATOR_BEGIN(gen);
+    for (; self->offset + CHUNK_FRAMES <= self->frames; self->offset += CHUNK_FRAMES) {
+        struct sas_chunk *chunk = sas_chunk_alloc(self->format, CHUNK_FRAMES);
+        const int16_t *pcm = &self->pcm[self->offset * CHANNELS];
+
+        if (self->format->layout == SAS_LAYOUT_PLANAR) {
+            for (int c = 0; c < CHANNELS; c++) {
+                int16_t *plane = (int16_t *) sas_chunk_plane(chunk, c);
+
+                for (size_t i = 0; i < CHUNK_FRAMES; i++) {
+                    plane[i] = pcm[i * CHANNELS + c];
+                }
+            }
+        } else {
+            memcpy(chunk->buffer, pcm, chunk->size);
+        }
+
+        RXC_GENERATOR_YIELD(gen, rxc_value_pointer(chunk));
+    }
+    RXC_GENERATOR_END(gen);
+}
+
+/* A sink that drops the chunks it receives */
+static void drop_on_connect(struct rxc_sink_logic *logic)
+{
+    rxc_inlet_pull(logic->in, LONG_MAX);
+}
+
+static void drop_on_push(struct rxc_sink_logic *logic, void *element)
+{
+    sas_chunk_dealloc(element);
+}
+
+static void drop_on_upstream_finish(struct rxc_sink_logic *self)
+{}
+
+static void drop_on_upstream_failure(struct rxc_sink_logic *self, void *failure)
+{
+    free(failure);
+}
+
+static struct rxc_sink_logic * drop_create_logic(struct rxc_sink *sink)
+{
+    struct rxc_sink_logic *logic = malloc(sizeof(struct rxc_sink_logic));
+
+    if (!logic) {
+        return NULL;
+    }
+
+    logic->sink = sink;
+    logic->dealloc = (void (*)(struct rxc_sink_logic *)) free;
+    logic->on_connect = drop_on_connect;
+    logic->on_push = drop_on_push;
+    logic->on_push_value = NULL;
+    logic->on_upstream_finish = drop_on_upstream_finish;
+    logic->on_upstream_failure = drop_on_upstream_failure;
+
+    return logic;
+}
+
+static void drop_dealloc(struct rxc_sink *self, int shallow)
+{
+    free(self);
+}
+
+/**
+ * Stream a signal through the encoder and decoder of a codec, which measures
+ * the processor time a single stream costs on the server and client.
+ */
+static void bench_stream(const struct sas_codec *codec, const struct sas_format *format,
+                         const int16_t *pcm, size_t frames)
+{
+    struct chunks_ctx ctx = { format, pcm, frames };
+    struct rxc_source *source = rxc_source_generator(chunks_step, sizeof(struct chunks),
+                                                     chunks_init, NULL, &ctx);
+    struct rxc_sink *sink = malloc(sizeof(struct rxc_sink));
+
+    sink->dealloc = drop_dealloc;
+    sink->create_logic = drop_create_logic;
+
+    if (codec->encoder) {
+        source = rxc_source_via(source, codec->encoder());
+    }
+    if (codec->decoder) {
+        source = rxc_source_via(source, codec->decoder());
+    }
+
+    struct rxc_pipeline *pipeline = rxc_source_to(source, sink);
+    uint64_t start = now();
+
+    rxc_pipeline_start(pipeline, rxc_scheduler_trampoline());
+
+    uint64_t elapsed = now() - start;
+    size_t chunks = frames / CHUNK_FRAMES;
+    double ns = (double) elapsed / chunks;
+
+    printf("{\"bench\": \"stream\", \"codec\": \"%s\", \"chunks\": %zu, \"ns_per_chunk\": %.1f, "
+           "\"cpu_per_stream_pct\": %.4f}\n",
+           codec->name, chunks, ns, ns * SAMPLE_RATE / CHUNK_FRAMES / 1e7);
+    rxc_pipeline_dealloc(pipeline);
+}
+
+/**
+ * Stream a signal through a resampler from 44.1 kHz to 48 kHz.
+ */
+static void bench_resample(const char *isa, const struct sas_format *format,
+                           const int16_t *pcm, size_t frames)
+{
+    struct chunks_ctx ctx = { format, pcm, frames };
+    struct rxc_source *source = rxc_source_generator(chunks_step, sizeof(struct chunks),
+                                                     chunks_init, NULL, &ctx);
+    struct rxc_sink *sink = malloc(sizeof(struct rxc_sink));
+    struct sas_filter *filter = sas_resample_filter(48000);
+
+    sink->dealloc = drop_dealloc;
+    sink->create_logic = drop_create_logic;
+
+    filter->init(filter);
+    source = rxc_source_via(source, filter->flow);
+
+    struct rxc_pipeline *pipeline = rxc_source_to(source, sink);
+    uint64_t start = now();
+
+    rxc_pipeline_start(pipeline, rxc_scheduler_trampoline());
+
+    uint64_t elapsed = now() - start;
+    size_t samples = frames / CHUNK_FRAMES * CHUNK_FRAMES * CHANNELS;
+
+    printf("{\"bench\": \"resample\", \"from\": %d, \"to\": %d, \"kernel\": \"%s\", "
+           "\"layout\": \"%s\", \"ns_per_sample\": %.3f}\n",
+           SAMPLE_RATE, 48000, isa,
+           format->layout == SAS_LAYOUT_PLANAR ? "planar" : "interleaved",
+           (double) elapsed / samples);
+    rxc_pipeline_dealloc(pipeline);
+    filter->dealloc(filter);
+}
+
+/* A sink that hashes the chunks it receives */
+struct checksum {
+    struct rxc_sink base;
+    uint32_t checksum;
+    size_t size;
+};
+
+static void checksum_on_push(struct rxc_sink_logic *logic, void *element)
+{
+    struct checksum *self = (struct checksum *) logic->sink;
+    struct sas_chunk *chunk = element;
+
+    /* FNV-1a over the bytes of the chunks */
+    for (size_t i = 0; i < chunk->size; i++) {
+        self->checksum = (self->checksum ^ chunk->buffer[i]) * 16777619u;
+    }
+
+    self->size += chunk->size;
+    sas_chunk_dealloc(chunk);
+}
+
+static struct rxc_sink_logic * checksum_create_logic(struct rxc_sink *sink)
+{
+    struct rxc_sink_logic *logic = drop_create_logic(sink);
+
+    if (logic) {
+        logic->on_push = checksum_on_push;
+    }
+
+    return logic;
+}
+
+/* Effects applied to streams */
+static struct sas_filter * effect_eq(void)
+{
+    static const struct sas_eq_band bands[] = {
+        {SAS_EQ_HIGH_PASS, 40, 0, 0.707},
+        {SAS_EQ_LOW_SHELF, 120, 3, 0.707},
+        {SAS_EQ_PEAK, 1000, -2, 1.4},
+        {SAS_EQ_PEAK, 3500, 2, 1},
+        {SAS_EQ_HIGH_SHELF, 8000, -3, 0.707},
+    };
+
+    return sas_eq_filter(bands, sizeof(bands) / sizeof(bands[0]));
+}
+
+static struct sas_filter * effect_gain(void)
+{
+    return sas_gain_filter(-6, 10);
+}
+
+static struct sas_filter * effect_limiter(void)
+{
+    return sas_limiter_filter(-1, 5, 50);
+}
+
+static const struct {
+    const char *name;
+    struct sas_filter * (*create)(void);
+} effects[] = {
+    {"eq", effect_eq},
+    {"gain", effect_gain},
+    {"limiter", effect_limiter},
+};
+
+/**
+ * Stream a signal through the specified effects, which measures the processor
+ * time they cost a stream. The effects are either connected one after another
+ * or fused into a chain, which the checksum of the output shows to produce the
+ * same samples.
+ */
+static void bench_effects(const char *name, const char *isa, size_t first, size_t count,
+                          int fused, const int16_t *pcm, size_t frames)
+{
+    struct chunks_ctx ctx = { NULL, pcm, frames };
+    struct sas_format format = { SAMPLE_RATE, 16, CHANNELS, SAS_SAMPLE_S16,
+                                 SAS_LAYOUT_INTERLEAVED, SAS_CODEC_NONE };
+    struct sas_filter *filters[sizeof(effects) / sizeof(effects[0])];
+
+    ctx.format = sas_format_intern(&format);
+
+    for (size_t i = 0; i < count; i++) {
+        filters[i] = effects[first + i].create();
+    }
+
+    struct sas_filter *chain = fused ? sas_chain_filter(filters, count) : NULL;
+    struct rxc_source *source = rxc_source_generator(chunks_step, sizeof(struct chunks),
+                                                     chunks_init, NULL, &ctx);
+    struct checksum *sink = malloc(sizeof(struct checksum));
+
+    sink->base.dealloc = drop_dealloc;
+    sink->base.create_logic = checksum_create_logic;
+    sink->checksum = 2166136261u;
+    sink->size = 0;
+
+    for (size_t i = 0; i < (fused ? 1 : count); i++) {
+        struct sas_filter *filter = fused ? chain : filters[i];
+
+        filter->init(filter);
+        source = rxc_source_via(source, filter->flow);
+    }
+
+    struct rxc_pipeline *pipeline = rxc_source_to(source, &sink->base);
+    uint64_t start = now();
+
+    rxc_pipeline_start(pipeline, rxc_scheduler_trampoline());
+
+    uint64_t elapsed = now() - start;
+    size_t samples = frames / CHUNK_FRAMES * CHUNK_FRAMES * CHANNELS;
+
+    printf("{\"bench\": \"effects\", \"effects\": \"%s\", \"fused\": %s, \"kernel\": \"%s\", "
+           "\"ns_per_sample\": %.3f, \"bytes\": %zu, \"checksum\": \"%08x\"}\n",
+           name, fused ? "true" : "false", isa, (double) elapsed / samples, sink->size,
+           sink->checksum);
+    rxc_pipeline_dealloc(pipeline);
+
+    if (fused) {
+        chain->dealloc(chain);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            filters[i]->dealloc(filters[i]);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long seconds = argc > 1 ? atol(argv[1]) : 60;
+    size_t frames = (size_t) (seconds > 0 ? seconds : 1) * SAMPLE_RATE;
+    int16_t *pcm = signal_create(frames);
+    size_t count = sizeof(kernels) / sizeof(kernels[0]);
+    struct sas_format format = { SAMPLE_RATE, 16, CHANNELS, SAS_SAMPLE_S16,
+                                 SAS_LAYOUT_INTERLEAVED, SAS_CODEC_NONE };
+    const struct sas_format *interleaved = sas_format_intern(&format);
+
+    format.layout = SAS_LAYOUT_PLANAR;
+    const struct sas_format *planar = sas_format_intern(&format);
+
+    for (size_t i = 0; i < count; i++) {
+        bench_stream(sas_codec_find_name(kernels[i].codec), interleaved, pcm, frames);
+    }
+
+    /* Run the kernels with the widest instructions first and compare against
+     * the narrower fallbacks by disabling each level afterwards */
+    static const struct {
+        int mask;
+        const char *name;
+    } levels[] = {
+        {SAS_CPU_AVX512, "avx512"},
+        {SAS_CPU_AVX2, "avx2"},
+        {SAS_CPU_SSE2, "sse2"},
+        {0, "scalar"},
+    };
+
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        if (levels[l].mask && !sas_cpu_supports(levels[l].mask)) {
+            continue;
+        }
+
+        /* The codecs are only vectorized with AVX2 */
+        if (levels[l].mask == SAS_CPU_AVX2 || !levels[l].mask) {
+            for (size_t i = 0; i < count; i++) {
+                bench_kernel(&kernels[i], levels[l].name, pcm, frames);
+            }
+        }
+
+        for (size_t i = 0; i < sizeof(conversions) / sizeof(conversions[0]); i++) {
+            bench_convert(&conversions[i], levels[l].name, pcm, frames);
+        }
+
+        /* The resampler is vectorized up to AVX2 */
+        if (levels[l].mask != SAS_CPU_AVX512) {
+            bench_resample(levels[l].name, interleaved, pcm, frames);
+            bench_resample(levels[l].name, planar, pcm, frames);
+        }
+
+        /* The effects are vectorized up to AVX2 */
+        if (levels[l].mask != SAS_CPU_AVX512) {
+            size_t effects_count = sizeof(effects) / sizeof(effects[0]);
+
+            for (size_t i = 0; i < effects_count; i++) {
+                bench_effects(effects[i].name, levels[l].name, i, 1, 0, pcm, frames);
+            }
+
+            bench_effects("eq+gain+limiter", levels[l].name, 0, effects_count, 0, pcm, frames);
+            bench_effects("eq+gain+limiter", levels[l].name, 0, effects_count, 1, pcm, frames);
+        }
+
+        sas_cpu_disable(levels[l].mask);
+    }
+
+    free(pcm);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,41 @@
+#ifndef SAS_CHAIN_H
+#define SAS_CHAIN_H
+
+#include <stddef.h>
+
+#include <rxc/rxc.h>
+
+#include <sas/filter.h>
+
+/**
+ * Create a filter that applies the specified filters in order as a single
+ * stage. Each chunk is passed through all filters one block of
+ * <code>SAS_FILTER_BLOCK</code> frames at a time, so that the samples stay in
+ * cache, instead of walking the whole chunk once for every filter. The samples
+ * are rounded to the format of the stream between the filters, so that the
+ * output is identical to connecting the filters one after another.
+ *
+ * The chain takes ownership of the filters and deallocates them along with
+ * itself. The chain processes blocks itself, so chains may be nested.
+ *
+ * @param[in] filters The filters to chain, which must all process blocks.
+ * @param[in] count The amount of filters to chain.
+ * @return The filter or <code>NULL</code> on allocation failure or if one of
+ * the filters does not process blocks.
+ */
+struct sas_filter * sas_chain_filter(struct sas_filter *const *filters, size_t count);
+
+/**
+ * Create a flow that passes the raw chunks of a stream in place through a
+ * filter that processes blocks, which such filters use as their flow. Encoded
+ * chunks and chunks that do not match the format of the first chunk of the
+ * stream are passed through unchanged. The frames the filter still holds once
+ * the stream finishes are emitted in a last chunk.
+ *
+ * @param[in] filter The filter to create the flow for, which must outlive the
+ * flow.
+ * @return The flow or <code>NULL</code> on allocation failure.
+ */
+struct rxc_flow * sas_chain_flow(struct sas_filter *filter);
+
+#endif /* SAS_CHAIN_H */
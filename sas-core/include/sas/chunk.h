@@ -4,6 +4,15 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#include <sas/format.h>
+
+/**
+ * The alignment of the buffers and planes of chunks created by
+ * <code>sas_chunk_alloc</code>, which is the size of a cache line and of the
+ * widest vector registers.
+ */
+#define SAS_CHUNK_ALIGNMENT 64
+
 /**
  * A chunk of audio data with using the specified configuration.
  */
@@ -14,35 +23,119 @@ struct sas_chunk {
     void (*dealloc)(struct sas_chunk *chunk);
 
     /**
-     * The size of the chunk.
+     * The interned format of the chunk.
      */
-    size_t size;
+    const struct sas_format *format;
 
     /**
-     * The sample rate that is used.
+     * The size of the chunk, which for planar chunks is the size of the
+     * samples of all planes without the padding between them.
      */
-    int32_t sample_rate;
+    size_t size;
 
     /**
-     * The sample size that is used.
+     * The buffer of this chunk. The planes of a planar chunk are stored
+     * consecutively at a stride of <code>sas_chunk_stride</code>.
      */
-    int8_t sample_size;
+    uint8_t *buffer;
+};
 
-    /**
-     * The channels used.
-     */
-    int8_t channels;
+/**
+ * Allocate a raw chunk for the specified amount of frames, of which the
+ * buffer and each plane are aligned to <code>SAS_CHUNK_ALIGNMENT</code> bytes.
+ *
+ * @param[in] format The format of the chunk.
+ * @param[in] frames The amount of frames in the chunk.
+ * @return The chunk or <code>NULL</code> on allocation failure or if the
+ * format is not a raw format.
+ */
+struct sas_chunk * sas_chunk_alloc(const struct sas_format *format, size_t frames);
 
-    /**
-     * The codec that is used.
-     */
-    uint8_t codec;
+/**
+ * Allocate a chunk with a buffer of the specified size, for instance for an
+ * encoded chunk, of which the buffer is aligned to
+ * <code>SAS_CHUNK_ALIGNMENT</code> bytes. The size of the chunk may be
+ * lowered afterwards to the amount of bytes that is actually used.
+ *
+ * @param[in] format The format of the chunk.
+ * @param[in] size The size of the buffer in bytes.
+ * @return The chunk or <code>NULL</code> on allocation failure.
+ */
+struct sas_chunk * sas_chunk_alloc_size(const struct sas_format *format, size_t size);
 
-    /**
-     * The buffer of this chunk.
-     */
-    uint8_t *buffer;
-};
+/**
+ * A pool of raw chunks of the same format and size, which takes chunks back
+ * when they are deallocated so that they can be handed out again without
+ * allocating. Chunks must be taken from the pool by one thread at a time, but
+ * may be deallocated on any thread, also after the pool itself.
+ */
+struct sas_chunk_pool;
+
+/**
+ * Create a pool of raw chunks.
+ *
+ * @param[in] format The format of the chunks.
+ * @param[in] frames The amount of frames in each chunk.
+ * @return The pool or <code>NULL</code> on allocation failure or if the
+ * format is not a raw format.
+ */
+struct sas_chunk_pool * sas_chunk_pool_alloc(const struct sas_format *format, size_t frames);
+
+/**
+ * Take a chunk from the pool, which is allocated if the pool has no chunks
+ * left. The size of the chunk may be lowered afterwards, for instance for
+ * the last chunk of a stream.
+ *
+ * @param[in] pool The pool to take the chunk from.
+ * @return The chunk or <code>NULL</code> on allocation failure.
+ */
+struct sas_chunk * sas_chunk_pool_get(struct sas_chunk_pool *pool);
+
+/**
+ * Deallocate the specified pool. The chunks that are still in use are
+ * released once they are deallocated.
+ *
+ * @param[in] pool The pool to deallocate.
+ */
+void sas_chunk_pool_dealloc(struct sas_chunk_pool *pool);
+
+/**
+ * Determine the amount of whole frames in a raw chunk.
+ *
+ * @param[in] chunk The chunk to determine the amount of frames of.
+ * @return The amount of frames or <code>0</code> if the chunk is encoded.
+ */
+size_t sas_chunk_frames(const struct sas_chunk *chunk);
+
+/**
+ * Determine the distance in bytes between the planes of a planar chunk
+ * created by <code>sas_chunk_alloc</code>.
+ *
+ * @param[in] chunk The chunk to determine the stride of.
+ * @return The stride of the planes in bytes.
+ */
+size_t sas_chunk_stride(const struct sas_chunk *chunk);
+
+/**
+ * Obtain the samples of a channel in a planar chunk.
+ *
+ * @param[in] chunk The chunk to obtain the plane of.
+ * @param[in] channel The channel of the plane.
+ * @return The first sample of the channel.
+ */
+uint8_t * sas_chunk_plane(const struct sas_chunk *chunk, int channel);
+
+/**
+ * Convert a raw chunk into the specified layout, which deallocates the
+ * specified chunk on success.
+ *
+ * @param[in] chunk The chunk to convert.
+ * @param[in] layout The layout to convert the chunk into.
+ * @return The chunk in the specified layout, the specified chunk if it is
+ * already in the layout or encoded, or <code>NULL</code> on allocation
+ * failure, in which case the specified chunk is left untouched.
+ */
+struct sas_chunk * sas_chunk_layout(struct sas_chunk *chunk, int layout);
 
 /**
  * Deallocate the specified chunk.
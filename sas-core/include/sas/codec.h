@@ -1,40 +1,82 @@
 #ifndef SAS_CODEC_H
 #define SAS_CODEC_H
 
+#include <stdint.h>
+
 #include <rxc/rxc.h>
 
+#define SAS_CODEC_NONE 0 /* The raw PCM stream */
+
 /**
- * A codec allows special encoding and decoding of the audio stream.
+ * A codec allows special encoding and decoding of the audio stream. Codecs
+ * are immutable descriptors that create the flows which transform the chunks
+ * of a stream, so a single codec may serve any amount of sessions.
  */
 struct sas_codec {
     /**
-     * Deallocate the specified codec.
-     *
-     * @param[in] codec The codec to deallocate.
+     * The identifier of the codec, which is negotiated in the configuration
+     * packets of a session.
+     */
+    uint8_t id;
+
+    /**
+     * The name of the codec.
      */
-    void (*dealloc)(struct sas_codec *);
+    const char *name;
 
     /**
-     * Initialize the specified codec.
+     * Determine whether the codec is able to encode a stream with the
+     * specified configuration.
      *
-     * @param[in] codec The codec to initialize.
+     * @param[in] sample_rate The sample rate of the stream.
+     * @param[in] sample_size The sample size of the stream.
+     * @param[in] channels The amount of channels of the stream.
+     * @return A non-zero value if the stream can be encoded, <code>0</code>
+     * otherwise.
      */
-    void (*init)(struct sas_codec *);
+    int (*supports)(int32_t sample_rate, int8_t sample_size, int8_t channels);
 
     /**
-     * The encoder that encodes messages to a specific codec.
+     * A flag to indicate that the chunks of a stream are coded independently
+     * of each other, so that encoded chunks may be shared between streams of
+     * the same file.
      */
-    struct rxc_flow *encoder;
+    int independent;
 
     /**
-     * The decoder that decodes messages into a raw PCM stream.
+     * Create the flow that encodes raw PCM chunks with this codec or
+     * <code>NULL</code> if the chunks do not need encoding. Chunks that cannot
+     * be encoded, e.g. on allocation failure, are dropped rather than passed
+     * on raw, since the receiver decodes every chunk with this codec.
      */
-    struct rxc_flow *decoder;
+    struct rxc_flow * (*encoder)(void);
+
+    /**
+     * Create the flow that decodes chunks of this codec into raw PCM chunks or
+     * <code>NULL</code> if the chunks do not need decoding.
+     */
+    struct rxc_flow * (*decoder)(void);
 };
 
 /**
  * This is an empty codec.
  */
-extern struct sas_codec sas_codec_none;
+extern const struct sas_codec sas_codec_none;
+
+/**
+ * Find the codec with the specified identifier.
+ *
+ * @param[in] id The identifier of the codec to find.
+ * @return The codec or <code>NULL</code> if the codec is not known.
+ */
+const struct sas_codec * sas_codec_find(uint8_t id);
+
+/**
+ * Find the codec with the specified name.
+ *
+ * @param[in] name The name of the codec to find.
+ * @return The codec or <code>NULL</code> if the codec is not known.
+ */
+const struct sas_codec * sas_codec_find_name(const char *name);
 
 #endif /* SAS_CODEC_H */
@@ -0,0 +1,64 @@
+#ifndef SAS_CODECS_G711_H
+#define SAS_CODECS_G711_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sas/codec.h>
+
+#define SAS_CODEC_G711_ULAW 2 /* The G.711 μ-law codec */
+#define SAS_CODEC_G711_ALAW 3 /* The G.711 A-law codec */
+
+/**
+ * A codec that compands 16-bit PCM streams 2:1 into 8-bit G.711 μ-law
+ * samples, which is meant for voice-grade channels.
+ */
+extern const struct sas_codec sas_codec_g711_ulaw;
+
+/**
+ * A codec that compands 16-bit PCM streams 2:1 into 8-bit G.711 A-law
+ * samples, which is meant for voice-grade channels.
+ */
+extern const struct sas_codec sas_codec_g711_alaw;
+
+/**
+ * Encode the specified 16-bit PCM samples into μ-law samples.
+ *
+ * @param[in] pcm The samples to encode.
+ * @param[in] count The amount of samples to encode.
+ * @param[out] out The buffer to write the <code>count</code> encoded samples
+ * to.
+ */
+void sas_codec_g711_ulaw_encode(const int16_t *pcm, size_t count, uint8_t *out);
+
+/**
+ * Decode the specified μ-law samples into 16-bit PCM samples.
+ *
+ * @param[in] in The samples to decode.
+ * @param[in] count The amount of samples to decode.
+ * @param[out] pcm The buffer to write the <code>count</code> decoded samples
+ * to.
+ */
+void sas_codec_g711_ulaw_decode(const uint8_t *in, size_t count, int16_t *pcm);
+
+/**
+ * Encode the specified 16-bit PCM samples into A-law samples.
+ *
+ * @param[in] pcm The samples to encode.
+ * @param[in] count The amount of samples to encode.
+ * @param[out] out The buffer to write the <code>count</code> encoded samples
+ * to.
+ */
+void sas_codec_g711_alaw_encode(const int16_t *pcm, size_t count, uint8_t *out);
+
+/**
+ * Decode the specified A-law samples into 16-bit PCM samples.
+ *
+ * @param[in] in The samples to decode.
+ * @param[in] count The amount of samples to decode.
+ * @param[out] pcm The buffer to write the <code>count</code> decoded samples
+ * to.
+ */
+void sas_codec_g711_alaw_decode(const uint8_t *in, size_t count, int16_t *pcm);
+
+#endif /* SAS_CODECS_G711_H */
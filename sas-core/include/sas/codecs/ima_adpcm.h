@@ -0,0 +1,94 @@
+#ifndef SAS_CODECS_IMA_ADPCM_H
+#define SAS_CODECS_IMA_ADPCM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sas/codec.h>
+
+#define SAS_CODEC_IMA_ADPCM 1 /* The IMA-ADPCM codec */
+
+/**
+ * The amount of independently coded lanes in a chunk.
+ */
+#define SAS_CODEC_IMA_ADPCM_LANES 8
+
+/**
+ * The size of the header of an encoded chunk.
+ */
+#define SAS_CODEC_IMA_ADPCM_HEADER (4 + 4 * SAS_CODEC_IMA_ADPCM_LANES)
+
+/**
+ * A codec that compresses 16-bit PCM streams 4:1 with IMA-ADPCM.
+ *
+ * Every chunk is coded independently, so that a lost chunk does not corrupt
+ * the chunks that follow it. The frames of a chunk are split into eight lanes
+ * that each cover a contiguous run of frames of one channel, which allows the
+ * lanes to be coded in parallel. An encoded chunk has the following layout,
+ * where all fields are little-endian:
+ *
+ * <pre>
+ * uint32_t frames;                      The amount of frames in the chunk.
+ * struct {
+ *     int16_t predictor;                The initial predictor of the lane.
+ *     uint8_t index;                    The initial step index of the lane.
+ *     uint8_t reserved;
+ * } lanes[8];
+ * uint32_t steps[];                     The codes of the lanes, one nibble
+ *                                       each, starting at the low nibble.
+ * </pre>
+ *
+ * Lane <code>k</code> codes channel <code>k % channels</code> from frame
+ * <code>(k / channels) * n</code> onwards, where <code>n</code> is the amount
+ * of steps in the chunk.
+ */
+extern const struct sas_codec sas_codec_ima_adpcm;
+
+/**
+ * Determine the size of an encoded chunk.
+ *
+ * @param[in] frames The amount of frames in the chunk.
+ * @param[in] channels The amount of channels of the stream.
+ * @return The size of the encoded chunk in bytes.
+ */
+size_t sas_codec_ima_adpcm_size(size_t frames, int channels);
+
+/**
+ * Encode the specified 16-bit PCM frames.
+ *
+ * @param[in] pcm The interleaved frames to encode.
+ * @param[in] frames The amount of frames to encode.
+ * @param[in] channels The amount of channels of the stream, which must divide
+ * the amount of lanes.
+ * @param[out] out The buffer to write the encoded chunk to, which must be
+ * able to hold <code>sas_codec_ima_adpcm_size(frames, channels)</code> bytes.
+ * @return The size of the encoded chunk in bytes.
+ */
+size_t sas_codec_ima_adpcm_encode(const int16_t *pcm, size_t frames, int channels,
+                                  uint8_t *out);
+
+/**
+ * Determine the amount of frames in an encoded chunk.
+ *
+ * @param[in] in The encoded chunk.
+ * @param[in] size The size of the encoded chunk in bytes.
+ * @param[in] channels The amount of channels of the stream.
+ * @return The amount of frames or <code>-1</code> if the chunk is malformed.
+ */
+long sas_codec_ima_adpcm_frames(const uint8_t *in, size_t size, int channels);
+
+/**
+ * Decode the specified chunk into 16-bit PCM frames.
+ *
+ * @param[in] in The encoded chunk.
+ * @param[in] size The size of the encoded chunk in bytes.
+ * @param[in] channels The amount of channels of the stream.
+ * @param[out] pcm The buffer to write the interleaved frames to, which must be
+ * able to hold the amount of frames in the chunk.
+ * @return The amount of frames decoded or <code>-1</code> if the chunk is
+ * malformed.
+ */
+long sas_codec_ima_adpcm_decode(const uint8_t *in, size_t size, int channels,
+                                int16_t *pcm);
+
+#endif /* SAS_CODECS_IMA_ADPCM_H */
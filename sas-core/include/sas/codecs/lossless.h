@@ -0,0 +1,89 @@
+#ifndef SAS_CODECS_LOSSLESS_H
+#define SAS_CODECS_LOSSLESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sas/codec.h>
+
+#define SAS_CODEC_LOSSLESS 4 /* The lossless codec */
+
+/**
+ * The maximum amount of frames in a block.
+ */
+#define SAS_CODEC_LOSSLESS_BLOCK 4096
+
+/**
+ * A codec that compresses 16-bit PCM streams without loss, along the lines of
+ * FLAC.
+ *
+ * The frames of a chunk are split into blocks of at most
+ * <code>SAS_CODEC_LOSSLESS_BLOCK</code> frames, which are coded independently.
+ * Each block starts with a header that carries its boundaries:
+ *
+ * <pre>
+ * uint16_t size;                        The size of the block in bytes,
+ *                                       excluding this header.
+ * uint16_t frames;                      The amount of frames in the block.
+ * </pre>
+ *
+ * The header is followed by a bit stream, padded to a whole byte, with the
+ * way a stereo block is decorrelated (independent, left/side, side/right or
+ * mid/side) and a subframe for each channel. A subframe holds its samples
+ * either as a constant, verbatim, or as the residual of a fixed polynomial or
+ * quantized linear predictor, which is Rice coded in partitions that each have
+ * their own parameter.
+ *
+ * Streams with one or two channels are supported.
+ */
+extern const struct sas_codec sas_codec_lossless;
+
+/**
+ * Determine the maximum size of an encoded chunk.
+ *
+ * @param[in] frames The amount of frames in the chunk.
+ * @param[in] channels The amount of channels of the stream.
+ * @return The maximum size of the encoded chunk in bytes.
+ */
+size_t sas_codec_lossless_bound(size_t frames, int channels);
+
+/**
+ * Encode the specified 16-bit PCM frames.
+ *
+ * @param[in] pcm The interleaved frames to encode.
+ * @param[in] frames The amount of frames to encode.
+ * @param[in] channels The amount of channels of the stream.
+ * @param[out] out The buffer to write the encoded chunk to, which must be
+ * able to hold <code>sas_codec_lossless_bound(frames, channels)</code> bytes.
+ * @return The size of the encoded chunk in bytes or <code>0</code> on
+ * allocation failure or if the stream does not have one or two channels.
+ */
+size_t sas_codec_lossless_encode(const int16_t *pcm, size_t frames, int channels,
+                                 uint8_t *out);
+
+/**
+ * Determine the amount of frames in an encoded chunk.
+ *
+ * @param[in] in The encoded chunk.
+ * @param[in] size The size of the encoded chunk in bytes.
+ * @param[in] channels The amount of channels of the stream.
+ * @return The amount of frames or <code>-1</code> if the chunk is malformed
+ * or the stream does not have one or two channels.
+ */
+long sas_codec_lossless_frames(const uint8_t *in, size_t size, int channels);
+
+/**
+ * Decode the specified chunk into 16-bit PCM frames.
+ *
+ * @param[in] in The encoded chunk.
+ * @param[in] size The size of the encoded chunk in bytes.
+ * @param[in] channels The amount of channels of the stream.
+ * @param[out] pcm The buffer to write the interleaved frames to, which must be
+ * able to hold the amount of frames in the chunk.
+ * @return The amount of frames decoded or <code>-1</code> if the chunk is
+ * malformed or the stream does not have one or two channels.
+ */
+long sas_codec_lossless_decode(const uint8_t *in, size_t size, int channels,
+                               int16_t *pcm);
+
+#endif /* SAS_CODECS_LOSSLESS_H */
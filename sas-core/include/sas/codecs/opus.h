@@ -0,0 +1,41 @@
+#ifndef SAS_CODECS_OPUS_H
+#define SAS_CODECS_OPUS_H
+
+#include <sas/codec.h>
+
+#define SAS_CODEC_OPUS 5 /* The Opus codec */
+
+/**
+ * The duration of an Opus frame in milliseconds.
+ */
+#define SAS_CODEC_OPUS_FRAME_MS 20
+
+/**
+ * The bit rate the Opus encoder aims at in bits per second.
+ */
+#define SAS_CODEC_OPUS_BITRATE 96000
+
+/**
+ * A codec that compresses 16-bit PCM streams into Opus frames of
+ * <code>SAS_CODEC_OPUS_FRAME_MS</code> milliseconds at about
+ * <code>SAS_CODEC_OPUS_BITRATE</code> bits per second, which is meant for
+ * listeners on low-bandwidth links.
+ *
+ * The encoder and decoder carry state across the chunks of a stream, so the
+ * frames do not need to align with the chunks. An encoded chunk holds the
+ * frames that were completed by its samples, each preceded by its size. The
+ * frames still pending at the end of the stream are padded with silence into
+ * a final frame:
+ *
+ * <pre>
+ * uint16_t size;                        The size of the frame in bytes.
+ * uint8_t frame[size];                  The Opus frame.
+ * </pre>
+ *
+ * Streams with one or two channels at 8, 12, 16, 24 or 48 kHz are supported.
+ * The codec is only available if the library was built against libopus, in
+ * which case <code>SAS_HAVE_OPUS</code> is defined.
+ */
+extern const struct sas_codec sas_codec_opus;
+
+#endif /* SAS_CODECS_OPUS_H */
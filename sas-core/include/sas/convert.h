@@ -0,0 +1,63 @@
+#ifndef SAS_CONVERT_H
+#define SAS_CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sas/filter.h>
+
+/**
+ * Determine the size of a sample in the specified format.
+ *
+ * @param[in] format The format of the sample.
+ * @return The size of the sample in bytes or <code>0</code> if the format is
+ * not known.
+ */
+size_t sas_convert_size(int format);
+
+/**
+ * Determine the integer format of samples of the specified size.
+ *
+ * @param[in] sample_size The size of the samples in bits.
+ * @return The format of the samples or <code>0</code> if there is no integer
+ * format of the size.
+ */
+int sas_convert_integer_format(int sample_size);
+
+/**
+ * Convert samples from one format into another.
+ *
+ * Integer samples are scaled by their full range, so that converting to a
+ * format with more bits and back yields the original samples. Converting to
+ * a format with fewer bits rounds to the nearest sample, or, if a dither
+ * state is specified, adds triangular (TPDF) dither of one least significant
+ * bit of the target format before rounding, which turns the quantization
+ * error into uncorrelated noise. Floating point samples are clipped to
+ * [-1, 1].
+ *
+ * The kernels use the widest vector instructions the processor supports, and
+ * produce the same samples regardless of the instructions that are used.
+ *
+ * @param[in] in The samples to convert.
+ * @param[in] from The format of the samples to convert.
+ * @param[out] out The buffer to write the converted samples to.
+ * @param[in] to The format to convert the samples into.
+ * @param[in] count The amount of samples to convert.
+ * @param[in,out] dither The state of the dither, which is advanced by the
+ * amount of samples, or <code>NULL</code> to round without dither.
+ */
+void sas_convert(const void *in, int from, void *out, int to, size_t count,
+                 uint32_t *dither);
+
+/**
+ * Create a filter that converts the raw chunks of a stream into the specified
+ * format. Chunks that are encoded or already in the format pass through.
+ *
+ * @param[in] format The format to convert the chunks into.
+ * @param[in] dither A flag to indicate that dither should be added when the
+ * conversion loses precision.
+ * @return The filter or <code>NULL</code> on allocation failure.
+ */
+struct sas_filter * sas_convert_filter(int format, int dither);
+
+#endif /* SAS_CONVERT_H */
@@ -0,0 +1,27 @@
+#ifndef SAS_CPU_H
+#define SAS_CPU_H
+
+#define SAS_CPU_SSE2 (1 << 0) /* The SSE2 instruction set */
+#define SAS_CPU_AVX2 (1 << 1) /* The AVX2 instruction set */
+#define SAS_CPU_AVX512 (1 << 2) /* The AVX-512 foundation instruction set */
+
+/**
+ * Determine whether the processor supports the specified features. Kernels
+ * that have vectorized implementations use this function to select the
+ * implementation to run.
+ *
+ * @param[in] features The bitmask of features to test for.
+ * @return A non-zero value if all features are supported, <code>0</code>
+ * otherwise.
+ */
+int sas_cpu_supports(int features);
+
+/**
+ * Prevent kernels from using the specified features, for instance to compare
+ * a vectorized implementation against its scalar fallback.
+ *
+ * @param[in] features The bitmask of features to disable.
+ */
+void sas_cpu_disable(int features);
+
+#endif /* SAS_CPU_H */
@@ -0,0 +1,58 @@
+#ifndef SAS_EQ_H
+#define SAS_EQ_H
+
+#include <stddef.h>
+
+#include <sas/filter.h>
+
+#define SAS_EQ_PEAK       1 /* Boosts or cuts the frequencies around a center */
+#define SAS_EQ_LOW_SHELF  2 /* Boosts or cuts the frequencies below a corner */
+#define SAS_EQ_HIGH_SHELF 3 /* Boosts or cuts the frequencies above a corner */
+#define SAS_EQ_LOW_PASS   4 /* Removes the frequencies above a corner */
+#define SAS_EQ_HIGH_PASS  5 /* Removes the frequencies below a corner */
+
+/**
+ * The maximum amount of bands of an equalizer.
+ */
+#define SAS_EQ_MAX_BANDS 16
+
+/**
+ * A band of an equalizer.
+ */
+struct sas_eq_band {
+    /**
+     * The type of the band.
+     */
+    int type;
+
+    /**
+     * The center or corner frequency of the band in Hz.
+     */
+    double frequency;
+
+    /**
+     * The gain of the band in dB, which the pass filters ignore.
+     */
+    double gain;
+
+    /**
+     * The quality of the band, which determines its width (e.g. 0.707 for a
+     * flat pass filter).
+     */
+    double q;
+};
+
+/**
+ * Create a filter that equalizes the raw chunks of a stream with a cascade of
+ * biquad sections, one for each band. The coefficients are computed once for
+ * the sample rate of each stream, while bands above the Nyquist frequency of
+ * a stream are left out. The channels are filtered four at a time with SSE2.
+ *
+ * @param[in] bands The bands of the equalizer.
+ * @param[in] count The amount of bands, at most <code>SAS_EQ_MAX_BANDS</code>.
+ * @return The filter or <code>NULL</code> on allocation failure or if the
+ * bands are invalid.
+ */
+struct sas_filter * sas_eq_filter(const struct sas_eq_band *bands, size_t count);
+
+#endif /* SAS_EQ_H */
@@ -1,8 +1,18 @@
 #ifndef SAS_FILTER_H
 #define SAS_FILTER_H
 
+#include <stddef.h>
+
 #include <rxc/rxc.h>
 
+#include <sas/chunk.h>
+
+/**
+ * The maximum amount of frames in the blocks filters process, which keeps a
+ * block of a stereo stream within a few kilobytes of cache.
+ */
+#define SAS_FILTER_BLOCK 256
+
 /**
  * An audio stream filter.
  */
@@ -15,7 +25,9 @@ struct sas_filter {
     void (*dealloc)(struct sas_filter *filter);
 
     /**
-     * Initialize the specified filter.
+     * Initialize the specified filter, which creates a fresh flow in
+     * <code>flow</code>. Since a flow is consumed by the pipeline it is
+     * connected to, the filter is initialized once for every pipeline.
      *
      * @param[in] filter The filter to initialize.
     */
@@ -25,6 +37,52 @@ struct sas_filter {
      * The flow that acts as the filter.
      */
     struct rxc_flow *flow;
+
+    /**
+     * Create the state of the filter for a stream of the specified raw
+     * format. Filters that preserve the format of a stream may implement
+     * <code>create_state</code>, <code>process</code> and
+     * <code>dealloc_state</code>, so that a chain of filters is able to
+     * process a chunk in a single pass (see <code>sas/chain.h</code>). This
+     * member is <code>NULL</code> for other filters.
+     *
+     * @param[in] filter The filter to create the state for.
+     * @param[in] format The format of the stream.
+     * @return The state or <code>NULL</code> on allocation failure.
+     */
+    void * (*create_state)(struct sas_filter *filter, const struct sas_format *format);
+
+    /**
+     * Process a block of at most <code>SAS_FILTER_BLOCK</code> frames of a
+     * stream in place. The samples of each channel are stored as floating
+     * point numbers in a separate plane aligned to
+     * <code>SAS_CHUNK_ALIGNMENT</code> bytes.
+     *
+     * @param[in] state The state of the filter in the stream.
+     * @param[in] planes The planes of the block.
+     * @param[in] frames The amount of frames in the block.
+     */
+    void (*process)(void *state, float *const *planes, size_t frames);
+
+    /**
+     * Flush a block of at most <code>SAS_FILTER_BLOCK</code> frames the
+     * filter still holds once its stream finishes into the planes, which is
+     * called until it returns <code>0</code>. This member is
+     * <code>NULL</code> for filters that do not delay their stream.
+     *
+     * @param[in] state The state of the filter in the stream.
+     * @param[in] planes The planes to flush the block into.
+     * @return The amount of frames in the block or <code>0</code> if the
+     * filter holds no more frames.
+     */
+    size_t (*flush)(void *state, float *const *planes);
+
+    /**
+     * Deallocate the state of the filter in a stream.
+     *
+     * @param[in] state The state to deallocate.
+     */
+    void (*dealloc_state)(void *state);
 };
 
 #endif /* SAS_FILTER_H */
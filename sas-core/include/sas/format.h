@@ -0,0 +1,74 @@
+#ifndef SAS_FORMAT_H
+#define SAS_FORMAT_H
+
+#include <stdint.h>
+
+#define SAS_SAMPLE_U8  1 /* Unsigned 8-bit integers */
+#define SAS_SAMPLE_S16 2 /* Signed 16-bit integers */
+#define SAS_SAMPLE_S24 3 /* Signed 24-bit integers packed in three bytes */
+#define SAS_SAMPLE_S32 4 /* Signed 32-bit integers */
+#define SAS_SAMPLE_F32 5 /* 32-bit floating point numbers in [-1, 1] */
+
+#define SAS_LAYOUT_INTERLEAVED 0 /* The samples of a frame are adjacent */
+#define SAS_LAYOUT_PLANAR      1 /* The samples of a channel are adjacent */
+
+/**
+ * The format of the chunks of a stream. Formats are interned, so that all
+ * chunks of a stream share a single immutable descriptor and formats may be
+ * compared by their address.
+ */
+struct sas_format {
+    /**
+     * The sample rate that is used.
+     */
+    int32_t sample_rate;
+
+    /**
+     * The sample size that is used.
+     */
+    int8_t sample_size;
+
+    /**
+     * The channels used.
+     */
+    int8_t channels;
+
+    /**
+     * The format of the samples in little endian byte order, which for
+     * encoded chunks is the format of the decoded samples.
+     */
+    uint8_t sample;
+
+    /**
+     * The layout of the samples in the buffer of a chunk. Encoded chunks are
+     * always interleaved.
+     */
+    uint8_t layout;
+
+    /**
+     * The codec that is used.
+     */
+    uint8_t codec;
+};
+
+/**
+ * Find the interned descriptor that is equal to the specified format or
+ * create it. Descriptors live for the remainder of the process. This function
+ * is thread-safe.
+ *
+ * @param[in] format The format to intern.
+ * @return The interned descriptor or <code>NULL</code> on allocation failure.
+ */
+const struct sas_format * sas_format_intern(const struct sas_format *format);
+
+/**
+ * Find the interned descriptor of the specified format with another codec.
+ *
+ * @param[in] format The interned format to derive the descriptor from.
+ * @param[in] codec The codec of the descriptor.
+ * @return The interned descriptor or <code>NULL</code> on allocation failure.
+ */
+const struct sas_format * sas_format_with_codec(const struct sas_format *format,
+                                                uint8_t codec);
+
+#endif /* SAS_FORMAT_H */
@@ -0,0 +1,27 @@
+#ifndef SAS_GAIN_H
+#define SAS_GAIN_H
+
+#include <sas/filter.h>
+
+/**
+ * Create a filter that applies a gain to the raw chunks of a stream. Changes
+ * of the gain are ramped linearly over the specified time, so that they do not
+ * click. The samples are scaled eight frames at a time with AVX2.
+ *
+ * @param[in] gain The initial gain in dB.
+ * @param[in] ramp The duration of a change of the gain in milliseconds.
+ * @return The filter or <code>NULL</code> on allocation failure.
+ */
+struct sas_filter * sas_gain_filter(double gain, double ramp);
+
+/**
+ * Change the gain of a gain filter, which the streams the filter is
+ * initialized for ramp towards from their next block. The gain may be changed
+ * from another thread than the one processing the streams.
+ *
+ * @param[in] filter The gain filter to change.
+ * @param[in] gain The gain in dB.
+ */
+void sas_gain_set(struct sas_filter *filter, double gain);
+
+#endif /* SAS_GAIN_H */
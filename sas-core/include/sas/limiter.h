@@ -0,0 +1,23 @@
+#ifndef SAS_LIMITER_H
+#define SAS_LIMITER_H
+
+#include <sas/filter.h>
+
+/**
+ * Create a filter that limits the peaks of the raw chunks of a stream to the
+ * specified ceiling. The stream is delayed by the look-ahead, so that the gain
+ * is lowered smoothly before a peak arrives, and recovers over the release
+ * time afterwards. The peaks are detected and the gain is applied eight frames
+ * at a time with AVX2, while the envelope is followed once for every frame.
+ *
+ * The frames that are still delayed when the stream finishes are pushed out
+ * with silence, so that the stream grows by the look-ahead.
+ *
+ * @param[in] ceiling The maximum magnitude of the samples in dBFS.
+ * @param[in] lookahead The look-ahead in milliseconds.
+ * @param[in] release The release time in milliseconds.
+ * @return The filter or <code>NULL</code> on allocation failure.
+ */
+struct sas_filter * sas_limiter_filter(double ceiling, double lookahead, double release);
+
+#endif /* SAS_LIMITER_H */
@@ -0,0 +1,40 @@
+#ifndef SAS_RESAMPLE_H
+#define SAS_RESAMPLE_H
+
+#include <stdint.h>
+
+#include <sas/filter.h>
+
+/**
+ * Determine whether the resampler is able to convert streams between the
+ * specified sample rates. The ratio of the rates is reduced to a fraction
+ * <code>up / down</code>, which is supported if the filter table of its
+ * <code>up</code> phases is of reasonable size (e.g. 44.1 kHz to 48 kHz is
+ * 160 / 147).
+ *
+ * @param[in] from The sample rate of the input stream.
+ * @param[in] to The sample rate of the output stream.
+ * @return A non-zero value if the conversion is supported, <code>0</code>
+ * otherwise.
+ */
+int sas_resample_supports(int32_t from, int32_t to);
+
+/**
+ * Create a filter that converts the raw chunks of a stream to the specified
+ * sample rate with a polyphase windowed-sinc filter. The filter tables are
+ * computed once per input sample rate and shared by all streams the filter
+ * is initialized for, while the history of each stream is carried across its
+ * chunks, so that the chunk boundaries are inaudible.
+ *
+ * The samples are filtered as floating point and converted back into the
+ * format of the input chunks with dither. Chunks that are encoded, already at
+ * the sample rate or of an unsupported ratio pass through. The history of the
+ * filter is padded with silence when the stream finishes, so that the last
+ * few milliseconds of the stream are emitted as well.
+ *
+ * @param[in] rate The sample rate to convert the chunks to.
+ * @return The filter or <code>NULL</code> on allocation failure.
+ */
+struct sas_filter * sas_resample_filter(int32_t rate);
+
+#endif /* SAS_RESAMPLE_H */
@@ -8,6 +8,7 @@
 #define SAS_TRANSPORT_PACKET_FLAG_RST (1 << 2)
 #define SAS_TRANSPORT_PACKET_FLAG_ACK (1 << 3)
 #define SAS_TRANSPORT_PACKET_FLAG_ERR (1 << 4)
+#define SAS_TRANSPORT_PACKET_FLAG_RAT (1 << 5)
 
 #define SAS_TRANSPORT_STATE_INITIAL     0 /* Initial state of a session */
 #define SAS_TRANSPORT_STATE_SYN_RCVD    1 /* A SYN has been received */
@@ -74,9 +75,17 @@ void sas_transport_packet_header_encode(struct sas_transport_packet_header *head
 void sas_transport_packet_header_decode(struct sas_transport_packet_header *header);
 
 /**
- * A packet sent to the synchronize with the server.
+ * A packet sent to the synchronize with the server, which is sent with the RAT
+ * flag bit set. Clients of the first version of the protocol do not set the
+ * flag and only send the codec.
  */
 struct sas_transport_packet_cfg {
+    /**
+     * The preferred sample rate or <code>0</code> for the sample rate of the
+     * file.
+     */
+    int32_t sample_rate;
+
     /**
      * The preferred codec to use.
      */
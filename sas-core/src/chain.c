@@ -0,0 +1,429 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+
+#include <sas/chain.h>
+#include <sas/chunk.h>
+#include <sas/codec.h>
+#include <sas/convert.h>
+
+/**
+ * A filter that applies several filters in a single pass.
+ */
+struct chain_filter {
+    struct sas_filter base;
+    struct sas_filter **filters;
+    size_t count;
+};
+
+/**
+ * The state of a chain in a single stream.
+ */
+struct chain_state {
+    const struct chain_filter *chain;
+    const struct sas_format *format;
+
+    /**
+     * The filter that is flushed at the end of the stream.
+     */
+    size_t flushing;
+
+    /**
+     * The samples of a plane rounded to the format of the stream.
+     */
+    uint8_t rounded[SAS_FILTER_BLOCK * sizeof(int32_t)];
+
+    /**
+     * The state of each filter in the stream.
+     */
+    void *states[];
+};
+
+/**
+ * The state of the flow of a filter in a single stream.
+ */
+struct block_state {
+    struct sas_filter *filter;
+
+    /**
+     * The format of the stream or <code>NULL</code> if the stream has not
+     * started yet.
+     */
+    const struct sas_format *format;
+
+    /**
+     * The state of the filter in the stream.
+     */
+    void *state;
+
+    /**
+     * The planes of the block, which are stored consecutively in
+     * <code>samples</code>, and room for the interleaved samples of a block.
+     */
+    float **planes;
+    float *samples;
+    float *interleaved;
+};
+
+static void * chain_create_state(struct sas_filter *filter, const struct sas_format *format)
+{
+    struct chain_filter *chain = (struct chain_filter *) filter;
+    struct chain_state *state = malloc(sizeof(struct chain_state) + chain->count * sizeof(void *));
+
+    if (!state) {
+        return NULL;
+    }
+
+    state->chain = chain;
+    state->format = format;
+    state->flushing = 0;
+
+    for (size_t i = 0; i < chain->count; i++) {
+        struct sas_filter *stage = chain->filters[i];
+
+        if (!(state->states[i] = stage->create_state(stage, format))) {
+            while (i-- > 0) {
+                chain->filters[i]->dealloc_state(state->states[i]);
+            }
+
+            free(state);
+            return NULL;
+        }
+    }
+
+    return state;
+}
+
+/**
+ * Process a block with the filters of the chain from the specified filter on.
+ */
+static void chain_run(struct chain_state *state, size_t from, float *const *planes,
+                      size_t frames)
+{
+    const struct chain_filter *chain = state->chain;
+    int sample = state->format->sample;
+
+    for (size_t i = from; i < chain->count; i++) {
+        /* Round the samples like the filter before would when writing them
+         * back into the chunk, which floating point samples are not */
+        if (i > 0 && sample != SAS_SAMPLE_F32) {
+            for (int c = 0; c < state->format->channels; c++) {
+                sas_convert(planes[c], SAS_SAMPLE_F32, state->rounded, sample, frames, NULL);
+                sas_convert(state->rounded, sample, planes[c], SAS_SAMPLE_F32, frames, NULL);
+            }
+        }
+
+        chain->filters[i]->process(state->states[i], planes, frames);
+    }
+}
+
+static void chain_process(void *state_ptr, float *const *planes, size_t frames)
+{
+    chain_run(state_ptr, 0, planes, frames);
+}
+
+static size_t chain_flush(void *state_ptr, float *const *planes)
+{
+    struct chain_state *state = state_ptr;
+    const struct chain_filter *chain = state->chain;
+
+    /* Flush the filters in order, where the frames one filter flushes pass
+     * through the filters after it */
+    for (; state->flushing < chain->count; state->flushing++) {
+        size_t i = state->flushing;
+        struct sas_filter *stage = chain->filters[i];
+        size_t n = stage->flush ? stage->flush(state->states[i], planes) : 0;
+
+        if (n > 0) {
+            chain_run(state, i + 1, planes, n);
+            return n;
+        }
+    }
+
+    return 0;
+}
+
+static void chain_dealloc_state(void *state_ptr)
+{
+    struct chain_state *state = state_ptr;
+    const struct chain_filter *chain = state->chain;
+
+    for (size_t i = 0; i < chain->count; i++) {
+        chain->filters[i]->dealloc_state(state->states[i]);
+    }
+
+    free(state);
+}
+
+static void chain_init(struct sas_filter *filter)
+{
+    filter->flow = sas_chain_flow(filter);
+}
+
+static void chain_dealloc(struct sas_filter *filter)
+{
+    struct chain_filter *chain = (struct chain_filter *) filter;
+
+    for (size_t i = 0; i < chain->count; i++) {
+        chain->filters[i]->dealloc(chain->filters[i]);
+    }
+
+    free(chain->filters);
+    free(chain);
+}
+
+struct sas_filter * sas_chain_filter(struct sas_filter *const *filters, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (!filters[i]->process) {
+            return NULL;
+        }
+    }
+
+    struct chain_filter *chain = malloc(sizeof(struct chain_filter));
+
+    if (!chain) {
+        return NULL;
+    } else if (!(chain->filters = malloc((count ? count : 1) * sizeof(struct sas_filter *)))) {
+        free(chain);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        chain->filters[i] = filters[i];
+    }
+
+    chain->count = count;
+    chain->base.dealloc = chain_dealloc;
+    chain->base.init = chain_init;
+    chain->base.flow = NULL;
+    chain->base.create_state = chain_create_state;
+    chain->base.process = chain_process;
+    chain->base.dealloc_state = chain_dealloc_state;
+    chain->base.flush = chain_flush;
+
+    return &chain->base;
+}
+
+static void * block_create(void *ctx)
+{
+    struct block_state *state = malloc(sizeof(struct block_state));
+
+    if (!state) {
+        return NULL;
+    }
+
+    state->filter = ctx;
+    state->format = NULL;
+    state->state = NULL;
+    state->planes = NULL;
+    state->samples = NULL;
+    state->interleaved = NULL;
+    return state;
+}
+
+static void block_dealloc(void *state_ptr)
+{
+    struct block_state *state = state_ptr;
+
+    if (state->state) {
+        state->filter->dealloc_state(state->state);
+    }
+
+    free(state->planes);
+    free(state->samples);
+    free(state->interleaved);
+    free(state);
+}
+
+/**
+ * Start the stream with the format of its first chunk.
+ */
+static int block_start(struct block_state *state, const struct sas_format *format)
+{
+    size_t channels = (size_t) format->channels;
+    size_t size = channels * SAS_FILTER_BLOCK * sizeof(float);
+
+    state->planes = malloc(channels * sizeof(float *));
+    state->samples = aligned_alloc(SAS_CHUNK_ALIGNMENT, size);
+    state->interleaved = malloc(size);
+
+    if (!state->planes || !state->samples || !state->interleaved ||
+        !(state->state = state->filter->create_state(state->filter, format))) {
+        free(state->planes);
+        free(state->samples);
+        free(state->interleaved);
+        state->planes = NULL;
+        state->samples = NULL;
+        state->interleaved = NULL;
+        return -1;
+    }
+
+    for (size_t c = 0; c < channels; c++) {
+        state->planes[c] = &state->samples[c * SAS_FILTER_BLOCK];
+    }
+
+    state->format = format;
+    return 0;
+}
+
+/**
+ * Read a block of frames of a chunk into the planes.
+ */
+static void block_read(struct block_state *state, const struct sas_chunk *chunk,
+                       size_t offset, size_t frames)
+{
+    const struct sas_format *format = state->format;
+    size_t channels = (size_t) format->channels;
+    size_t size = sas_convert_size(format->sample);
+
+    if (format->layout == SAS_LAYOUT_PLANAR) {
+        for (size_t c = 0; c < channels; c++) {
+            sas_convert(sas_chunk_plane(chunk, (int) c) + offset * size, format->sample,
+                        state->planes[c], SAS_SAMPLE_F32, frames, NULL);
+        }
+
+        return;
+    }
+
+    sas_convert(&chunk->buffer[offset * channels * size], format->sample, state->interleaved,
+                SAS_SAMPLE_F32, frames * channels, NULL);
+
+    for (size_t c = 0; c < channels; c++) {
+        float *plane = state->planes[c];
+
+        for (size_t i = 0; i < frames; i++) {
+            plane[i] = state->interleaved[i * channels + c];
+        }
+    }
+}
+
+/**
+ * Write the planes back into a block of frames of a chunk.
+ */
+static void block_write(struct block_state *state, struct sas_chunk *chunk,
+                        size_t offset, size_t frames)
+{
+    const struct sas_format *format = state->format;
+    size_t channels = (size_t) format->channels;
+    size_t size = sas_convert_size(format->sample);
+
+    if (format->layout == SAS_LAYOUT_PLANAR) {
+        for (size_t c = 0; c < channels; c++) {
+            sas_convert(state->planes[c], SAS_SAMPLE_F32,
+                        sas_chunk_plane(chunk, (int) c) + offset * size, format->sample,
+                        frames, NULL);
+        }
+
+        return;
+    }
+
+    for (size_t c = 0; c < channels; c++) {
+        const float *plane = state->planes[c];
+
+        for (size_t i = 0; i < frames; i++) {
+            state->interleaved[i * channels + c] = plane[i];
+        }
+    }
+
+    sas_convert(state->interleaved, SAS_SAMPLE_F32, &chunk->buffer[offset * channels * size],
+                format->sample, frames * channels, NULL);
+}
+
+static void * block_process(void *state_ptr, void *element)
+{
+    struct block_state *state = state_ptr;
+    struct sas_chunk *chunk = element;
+    const struct sas_format *format = chunk->format;
+
+    if (format->codec != SAS_CODEC_NONE || !sas_convert_size(format->sample) ||
+        format->channels <= 0) {
+        return chunk;
+    } else if (!state->format && block_start(state, format) != 0) {
+        return chunk;
+    } else if (format != state->format) {
+        /* The configuration of a stream does not change */
+        return chunk;
+    }
+
+    size_t frames = sas_chunk_frames(chunk);
+
+    for (size_t offset = 0; offset < frames; offset += SAS_FILTER_BLOCK) {
+        size_t n = frames - offset < SAS_FILTER_BLOCK ? frames - offset : SAS_FILTER_BLOCK;
+
+        block_read(state, chunk, offset, n);
+        state->filter->process(state->state, state->planes, n);
+        block_write(state, chunk, offset, n);
+    }
+
+    return chunk;
+}
+
+/**
+ * Collect the frames the filter still holds at the end of the stream into a
+ * last chunk.
+ */
+static void * block_flush(void *state_ptr)
+{
+    struct block_state *state = state_ptr;
+    struct sas_filter *filter = state->filter;
+
+    if (!state->state || !filter->flush) {
+        return NULL;
+    }
+
+    size_t channels = (size_t) state->format->channels;
+    size_t frames = 0;
+    size_t capacity = 0;
+    size_t n;
+    float *tail = NULL;
+
+    /* The frames are interleaved into a buffer until the length of the chunk
+     * is known */
+    while ((n = filter->flush(state->state, state->planes)) > 0) {
+        if (frames + n > capacity) {
+            capacity = capacity ? capacity * 2 : SAS_FILTER_BLOCK;
+            float *grown = realloc(tail, capacity * channels * sizeof(float));
+
+            if (!grown) {
+                free(tail);
+                return NULL;
+            }
+
+            tail = grown;
+        }
+
+        for (size_t c = 0; c < channels; c++) {
+            for (size_t i = 0; i < n; i++) {
+                tail[(frames + i) * channels + c] = state->planes[c][i];
+            }
+        }
+
+        frames += n;
+    }
+
+    struct sas_chunk *chunk = frames > 0 ? sas_chunk_alloc(state->format, frames) : NULL;
+
+    for (size_t offset = 0; chunk && offset < frames; offset += SAS_FILTER_BLOCK) {
+        n = frames - offset < SAS_FILTER_BLOCK ? frames - offset : SAS_FILTER_BLOCK;
+
+        for (size_t c = 0; c < channels; c++) {
+            for (size_t i = 0; i < n; i++) {
+                state->planes[c][i] = tail[(offset + i) * channels + c];
+            }
+        }
+
+        block_write(state, chunk, offset, n);
+    }
+
+    free(tail);
+    return chunk;
+}
+
+struct rxc_flow * sas_chain_flow(struct sas_filter *filter)
+{
+    return rxc_flow_map_state_flush(block_create, block_process, block_flush, block_dealloc,
+                                    filter);
+}
@@ -1,4 +1,278 @@
+#include <string.h>
+#include <stdatomic.h>
+
 #include <sas/chunk.h>
+#include <sas/codec.h>
+#include <sas/convert.h>
+
+/**
+ * Round the specified size up to the alignment of chunks.
+ */
+static size_t align(size_t size)
+{
+    return (size + SAS_CHUNK_ALIGNMENT - 1) & ~(size_t) (SAS_CHUNK_ALIGNMENT - 1);
+}
+
+static void chunk_dealloc(struct sas_chunk *chunk)
+{
+    /* The buffer is part of the chunk allocation */
+    free(chunk);
+}
+
+/**
+ * Allocate a chunk of which the header of the specified size is followed by
+ * a buffer of the specified size.
+ */
+static struct sas_chunk * chunk_alloc(const struct sas_format *format, size_t header, size_t size)
+{
+    header = align(header);
+    struct sas_chunk *chunk = aligned_alloc(SAS_CHUNK_ALIGNMENT, header + align(size));
+
+    if (!chunk) {
+        return NULL;
+    }
+
+    chunk->dealloc = chunk_dealloc;
+    chunk->format = format;
+    chunk->size = size;
+    chunk->buffer = (uint8_t *) chunk + header;
+    return chunk;
+}
+
+/**
+ * Determine the size of the samples of a raw chunk and the capacity of its
+ * buffer, which includes the padding between the planes of planar chunks.
+ *
+ * @return <code>0</code> on success or <code>-1</code> if the format is not a
+ * raw format.
+ */
+static int chunk_size(const struct sas_format *format, size_t frames, size_t *size, size_t *capacity)
+{
+    size_t sample = sas_convert_size(format->sample);
+
+    if (format->codec != SAS_CODEC_NONE || !sample || format->channels <= 0) {
+        return -1;
+    }
+
+    *size = frames * format->channels * sample;
+    *capacity = format->layout == SAS_LAYOUT_PLANAR ?
+                align(frames * sample) * format->channels : *size;
+    return 0;
+}
+
+struct sas_chunk * sas_chunk_alloc(const struct sas_format *format, size_t frames)
+{
+    size_t size, capacity;
+
+    if (chunk_size(format, frames, &size, &capacity) < 0) {
+        return NULL;
+    }
+
+    struct sas_chunk *chunk = sas_chunk_alloc_size(format, capacity);
+
+    if (!chunk) {
+        return NULL;
+    }
+
+    chunk->size = size;
+
+    /* Clear the padding between the planes, so that kernels may process
+     * whole vectors */
+    if (capacity > size) {
+        memset(chunk->buffer, 0, capacity);
+    }
+
+    return chunk;
+}
+
+struct sas_chunk * sas_chunk_alloc_size(const struct sas_format *format, size_t size)
+{
+    return chunk_alloc(format, sizeof(struct sas_chunk), size);
+}
+
+/**
+ * A chunk that returns to its pool when it is deallocated.
+ */
+struct pool_chunk {
+    struct sas_chunk base;
+    struct sas_chunk_pool *pool;
+    struct pool_chunk *next;
+};
+
+struct sas_chunk_pool {
+    /**
+     * The format and size of the chunks of the pool.
+     */
+    const struct sas_format *format;
+    size_t size, capacity;
+
+    /**
+     * The chunks that have been deallocated, to which any thread may push.
+     */
+    struct pool_chunk *_Atomic returned;
+
+    /**
+     * The chunks that are ready to be taken, owned by the taking thread.
+     */
+    struct pool_chunk *spare;
+
+    /**
+     * The amount of references to the pool: one held by its owner and one
+     * for every chunk that has been taken and not returned yet.
+     */
+    atomic_long refs;
+};
+
+static void pool_free_list(struct pool_chunk *chunk)
+{
+    while (chunk) {
+        struct pool_chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+static void pool_release(struct sas_chunk_pool *pool)
+{
+    if (atomic_fetch_sub_explicit(&pool->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    pool_free_list(pool->spare);
+    pool_free_list(atomic_load_explicit(&pool->returned, memory_order_acquire));
+    free(pool);
+}
+
+static void pool_chunk_dealloc(struct sas_chunk *chunk)
+{
+    struct pool_chunk *self = (struct pool_chunk *) chunk;
+    struct sas_chunk_pool *pool = self->pool;
+
+    self->next = atomic_load_explicit(&pool->returned, memory_order_relaxed);
+
+    while (!atomic_compare_exchange_weak_explicit(&pool->returned, &self->next, self,
+                                                  memory_order_release,
+                                                  memory_order_relaxed));
+
+    pool_release(pool);
+}
+
+struct sas_chunk_pool * sas_chunk_pool_alloc(const struct sas_format *format, size_t frames)
+{
+    size_t size, capacity;
+
+    if (chunk_size(format, frames, &size, &capacity) < 0) {
+        return NULL;
+    }
+
+    struct sas_chunk_pool *pool = malloc(sizeof(struct sas_chunk_pool));
+
+    if (!pool) {
+        return NULL;
+    }
+
+    pool->format = format;
+    pool->size = size;
+    pool->capacity = capacity;
+    pool->spare = NULL;
+    atomic_init(&pool->returned, NULL);
+    atomic_init(&pool->refs, 1);
+    return pool;
+}
+
+struct sas_chunk * sas_chunk_pool_get(struct sas_chunk_pool *pool)
+{
+    /* Take over the chunks that have been returned since the last time */
+    if (!pool->spare) {
+        pool->spare = atomic_exchange_explicit(&pool->returned, NULL, memory_order_acquire);
+    }
+
+    struct pool_chunk *chunk = pool->spare;
+
+    if (chunk) {
+        pool->spare = chunk->next;
+    } else if (!(chunk = (struct pool_chunk *) chunk_alloc(pool->format, sizeof(struct pool_chunk),
+                                                            pool->capacity))) {
+        return NULL;
+    }
+
+    chunk->base.dealloc = pool_chunk_dealloc;
+    chunk->base.format = pool->format;
+    chunk->base.size = pool->size;
+    chunk->pool = pool;
+
+    if (pool->capacity > pool->size) {
+        memset(chunk->base.buffer, 0, pool->capacity);
+    }
+
+    atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+    return &chunk->base;
+}
+
+void sas_chunk_pool_dealloc(struct sas_chunk_pool *pool)
+{
+    pool_release(pool);
+}
+
+size_t sas_chunk_frames(const struct sas_chunk *chunk)
+{
+    size_t sample = sas_convert_size(chunk->format->sample);
+
+    if (chunk->format->codec != SAS_CODEC_NONE || !sample || chunk->format->channels <= 0) {
+        return 0;
+    }
+
+    return chunk->size / (sample * chunk->format->channels);
+}
+
+size_t sas_chunk_stride(const struct sas_chunk *chunk)
+{
+    return align(sas_chunk_frames(chunk) * sas_convert_size(chunk->format->sample));
+}
+
+uint8_t * sas_chunk_plane(const struct sas_chunk *chunk, int channel)
+{
+    return chunk->buffer + channel * sas_chunk_stride(chunk);
+}
+
+struct sas_chunk * sas_chunk_layout(struct sas_chunk *chunk, int layout)
+{
+    if (chunk->format->codec != SAS_CODEC_NONE || chunk->format->layout == layout) {
+        return chunk;
+    }
+
+    struct sas_format format = *chunk->format;
+    format.layout = (uint8_t) layout;
+
+    const struct sas_format *interned = sas_format_intern(&format);
+    size_t frames = sas_chunk_frames(chunk);
+    struct sas_chunk *converted = interned ? sas_chunk_alloc(interned, frames) : NULL;
+
+    if (!converted) {
+        return NULL;
+    }
+
+    struct sas_chunk *planar = layout == SAS_LAYOUT_PLANAR ? converted : chunk;
+    struct sas_chunk *interleaved = layout == SAS_LAYOUT_PLANAR ? chunk : converted;
+    size_t sample = sas_convert_size(format.sample);
+    size_t frame = sample * format.channels;
+
+    for (int c = 0; c < format.channels; c++) {
+        uint8_t *plane = sas_chunk_plane(planar, c);
+        uint8_t *samples = &interleaved->buffer[c * sample];
+
+        for (size_t i = 0; i < frames; i++) {
+            if (layout == SAS_LAYOUT_PLANAR) {
+                memcpy(&plane[i * sample], &samples[i * frame], sample);
+            } else {
+                memcpy(&samples[i * frame], &plane[i * sample], sample);
+            }
+        }
+    }
+
+    sas_chunk_dealloc(chunk);
+    return converted;
+}
 
 void sas_chunk_dealloc(struct sas_chunk *chunk)
 {
@@ -0,0 +1,57 @@
+#include <string.h>
+
+#include <sas/codec.h>
+#include <sas/codecs/g711.h>
+#include <sas/codecs/ima_adpcm.h>
+#include <sas/codecs/lossless.h>
+#include <sas/codecs/opus.h>
+
+static int none_supports(int32_t sample_rate, int8_t sample_size, int8_t channels)
+{
+    return 1;
+}
+
+const struct sas_codec sas_codec_none = {
+    .id = SAS_CODEC_NONE,
+    .name = "none",
+    .supports = none_supports,
+    .independent = 1,
+    .encoder = NULL,
+    .decoder = NULL,
+};
+
+/**
+ * The codecs that can be negotiated.
+ */
+static const struct sas_codec *codecs[] = {
+    &sas_codec_none,
+    &sas_codec_ima_adpcm,
+    &sas_codec_g711_ulaw,
+    &sas_codec_g711_alaw,
+    &sas_codec_lossless,
+#ifdef SAS_HAVE_OPUS
+    &sas_codec_opus,
+#endif
+};
+
+const struct sas_codec * sas_codec_find(uint8_t id)
+{
+    for (size_t i = 0; i < sizeof(codecs) / sizeof(codecs[0]); i++) {
+        if (codecs[i]->id == id) {
+            return codecs[i];
+        }
+    }
+
+    return NULL;
+}
+
+const struct sas_codec * sas_codec_find_name(const char *name)
+{
+    for (size_t i = 0; i < sizeof(codecs) / sizeof(codecs[0]); i++) {
+        if (strcmp(codecs[i]->name, name) == 0) {
+            return codecs[i];
+        }
+    }
+
+    return NULL;
+}
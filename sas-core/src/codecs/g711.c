@@ -0,0 +1,421 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+
+#include <sas/chunk.h>
+#include <sas/cpu.h>
+#include <sas/codecs/g711.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SAS_G711_AVX2 1
+#endif
+
+#define ULAW_BIAS 0x21 /* The bias added to 14-bit μ-law magnitudes */
+#define ULAW_CLIP 8158 /* The largest 14-bit magnitude that can be encoded */
+#define ALAW_CLIP 4095 /* The largest 13-bit magnitude that can be encoded */
+
+/**
+ * The exponent of a μ-law sample, indexed by the biased 14-bit magnitude
+ * shifted right by five bits.
+ */
+static const uint8_t ulaw_exponent[256] = {
+    0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3,
+    4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7
+};
+
+/**
+ * The exponent of an A-law sample, indexed by the 13-bit magnitude shifted
+ * right by five bits.
+ */
+static const uint8_t alaw_exponent[128] = {
+    1, 1, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7
+};
+
+/**
+ * The linear value of each μ-law sample.
+ */
+static const int16_t ulaw_linear[256] = {
+    -32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956,
+    -23932, -22908, -21884, -20860, -19836, -18812, -17788, -16764,
+    -15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+    -11900, -11388, -10876, -10364, -9852, -9340, -8828, -8316,
+    -7932, -7676, -7420, -7164, -6908, -6652, -6396, -6140,
+    -5884, -5628, -5372, -5116, -4860, -4604, -4348, -4092,
+    -3900, -3772, -3644, -3516, -3388, -3260, -3132, -3004,
+    -2876, -2748, -2620, -2492, -2364, -2236, -2108, -1980,
+    -1884, -1820, -1756, -1692, -1628, -1564, -1500, -1436,
+    -1372, -1308, -1244, -1180, -1116, -1052, -988, -924,
+    -876, -844, -812, -780, -748, -716, -684, -652,
+    -620, -588, -556, -524, -492, -460, -428, -396,
+    -372, -356, -340, -324, -308, -292, -276, -260,
+    -244, -228, -212, -196, -180, -164, -148, -132,
+    -120, -112, -104, -96, -88, -80, -72, -64,
+    -56, -48, -40, -32, -24, -16, -8, 0,
+    32124, 31100, 30076, 29052, 28028, 27004, 25980, 24956,
+    23932, 22908, 21884, 20860, 19836, 18812, 17788, 16764,
+    15996, 15484, 14972, 14460, 13948, 13436, 12924, 12412,
+    11900, 11388, 10876, 10364, 9852, 9340, 8828, 8316,
+    7932, 7676, 7420, 7164, 6908, 6652, 6396, 6140,
+    5884, 5628, 5372, 5116, 4860, 4604, 4348, 4092,
+    3900, 3772, 3644, 3516, 3388, 3260, 3132, 3004,
+    2876, 2748, 2620, 2492, 2364, 2236, 2108, 1980,
+    1884, 1820, 1756, 1692, 1628, 1564, 1500, 1436,
+    1372, 1308, 1244, 1180, 1116, 1052, 988, 924,
+    876, 844, 812, 780, 748, 716, 684, 652,
+    620, 588, 556, 524, 492, 460, 428, 396,
+    372, 356, 340, 324, 308, 292, 276, 260,
+    244, 228, 212, 196, 180, 164, 148, 132,
+    120, 112, 104, 96, 88, 80, 72, 64,
+    56, 48, 40, 32, 24, 16, 8, 0
+};
+
+/**
+ * The linear value of each A-law sample.
+ */
+static const int16_t alaw_linear[256] = {
+    -5504, -5248, -6016, -5760, -4480, -4224, -4992, -4736,
+    -7552, -7296, -8064, -7808, -6528, -6272, -7040, -6784,
+    -2752, -2624, -3008, -2880, -2240, -2112, -2496, -2368,
+    -3776, -3648, -4032, -3904, -3264, -3136, -3520, -3392,
+    -22016, -20992, -24064, -23040, -17920, -16896, -19968, -18944,
+    -30208, -29184, -32256, -31232, -26112, -25088, -28160, -27136,
+    -11008, -10496, -12032, -11520, -8960, -8448, -9984, -9472,
+    -15104, -14592, -16128, -15616, -13056, -12544, -14080, -13568,
+    -344, -328, -376, -360, -280, -264, -312, -296,
+    -472, -456, -504, -488, -408, -392, -440, -424,
+    -88, -72, -120, -104, -24, -8, -56, -40,
+    -216, -200, -248, -232, -152, -136, -184, -168,
+    -1376, -1312, -1504, -1440, -1120, -1056, -1248, -1184,
+    -1888, -1824, -2016, -1952, -1632, -1568, -1760, -1696,
+    -688, -656, -752, -720, -560, -528, -624, -592,
+    -944, -912, -1008, -976, -816, -784, -880, -848,
+    5504, 5248, 6016, 5760, 4480, 4224, 4992, 4736,
+    7552, 7296, 8064, 7808, 6528, 6272, 7040, 6784,
+    2752, 2624, 3008, 2880, 2240, 2112, 2496, 2368,
+    3776, 3648, 4032, 3904, 3264, 3136, 3520, 3392,
+    22016, 20992, 24064, 23040, 17920, 16896, 19968, 18944,
+    30208, 29184, 32256, 31232, 26112, 25088, 28160, 27136,
+    11008, 10496, 12032, 11520, 8960, 8448, 9984, 9472,
+    15104, 14592, 16128, 15616, 13056, 12544, 14080, 13568,
+    344, 328, 376, 360, 280, 264, 312, 296,
+    472, 456, 504, 488, 408, 392, 440, 424,
+    88, 72, 120, 104, 24, 8, 56, 40,
+    216, 200, 248, 232, 152, 136, 184, 168,
+    1376, 1312, 1504, 1440, 1120, 1056, 1248, 1184,
+    1888, 1824, 2016, 1952, 1632, 1568, 1760, 1696,
+    688, 656, 752, 720, 560, 528, 624, 592,
+    944, 912, 1008, 976, 816, 784, 880, 848
+};
+
+/*
+ * The encoders quantize like the reference implementation of G.711, which
+ * takes the magnitude of negative samples after reducing their precision.
+ */
+static inline uint8_t ulaw_encode(int16_t x)
+{
+    int sample = x >> 2;
+    int mask = 0xff;
+
+    if (sample < 0) {
+        sample = -sample;
+        mask = 0x7f;
+    }
+    if (sample > ULAW_CLIP) {
+        sample = ULAW_CLIP;
+    }
+
+    sample += ULAW_BIAS;
+
+    int exponent = ulaw_exponent[sample >> 5];
+    int mantissa = (sample >> (exponent + 1)) & 0x0f;
+
+    return ((exponent << 4) | mantissa) ^ mask;
+}
+
+static inline uint8_t alaw_encode(int16_t x)
+{
+    int sample = x >> 3;
+    int mask = 0xd5;
+    int compressed;
+
+    if (sample < 0) {
+        sample = -sample - 1;
+        mask = 0x55;
+    }
+    if (sample > ALAW_CLIP) {
+        sample = ALAW_CLIP;
+    }
+
+    if (sample >= 32) {
+        int exponent = alaw_exponent[sample >> 5];
+        compressed = (exponent << 4) | ((sample >> exponent) & 0x0f);
+    } else {
+        compressed = sample >> 1;
+    }
+
+    return compressed ^ mask;
+}
+
+static void decode_scalar(const int16_t *table, const uint8_t *in, size_t count,
+                          int16_t *pcm)
+{
+    for (size_t i = 0; i < count; i++) {
+        pcm[i] = table[in[i]];
+    }
+}
+
+#ifdef SAS_G711_AVX2
+/*
+ * The vectorized decoders expand sixteen samples at once in 16-bit lanes. The
+ * shift by the exponent of each sample is done as a multiplication by a power
+ * of two, which is looked up with a byte shuffle.
+ */
+__attribute__((target("avx2")))
+static void ulaw_decode_avx2(const uint8_t *in, size_t count, int16_t *pcm)
+{
+    const __m256i pow2 = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+                                          1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i ones = _mm256_set1_epi16(0xff);
+    const __m256i mantissa = _mm256_set1_epi16(0x0f);
+    const __m256i exponent = _mm256_set1_epi16(0x07);
+    const __m256i sign = _mm256_set1_epi16(0x80);
+    const __m256i bias = _mm256_set1_epi16(0x84);
+    const __m256i high = _mm256_set1_epi16((short) 0x8000);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256i u = _mm256_xor_si256(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) &in[i])), ones);
+        __m256i t = _mm256_add_epi16(_mm256_slli_epi16(_mm256_and_si256(u, mantissa), 3), bias);
+
+        /* Zero the high byte of each lane by shuffling in index 0x80 */
+        __m256i index = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(u, 4), exponent), high);
+        t = _mm256_mullo_epi16(t, _mm256_shuffle_epi8(pow2, index));
+        t = _mm256_sub_epi16(t, bias);
+
+        __m256i negative = _mm256_cmpeq_epi16(_mm256_and_si256(u, sign), sign);
+        t = _mm256_sub_epi16(_mm256_xor_si256(t, negative), negative);
+
+        _mm256_storeu_si256((__m256i *) &pcm[i], t);
+    }
+
+    decode_scalar(ulaw_linear, &in[i], count - i, &pcm[i]);
+}
+
+__attribute__((target("avx2")))
+static void alaw_decode_avx2(const uint8_t *in, size_t count, int16_t *pcm)
+{
+    const __m256i pow2 = _mm256_setr_epi8(1, 1, 2, 4, 8, 16, 32, 64, 0, 0, 0, 0, 0, 0, 0, 0,
+                                          1, 1, 2, 4, 8, 16, 32, 64, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i toggle = _mm256_set1_epi16(0x55);
+    const __m256i mantissa = _mm256_set1_epi16(0x0f);
+    const __m256i exponent = _mm256_set1_epi16(0x07);
+    const __m256i sign = _mm256_set1_epi16(0x80);
+    const __m256i bias = _mm256_set1_epi16(0x108);
+    const __m256i bias_low = _mm256_set1_epi16(0x100);
+    const __m256i high = _mm256_set1_epi16((short) 0x8000);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_xor_si256(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) &in[i])), toggle);
+        __m256i t = _mm256_slli_epi16(_mm256_and_si256(a, mantissa), 4);
+        __m256i seg = _mm256_and_si256(_mm256_srli_epi16(a, 4), exponent);
+
+        /* The lowest segment is biased by 8 rather than 0x108 and not shifted */
+        __m256i lowest = _mm256_cmpeq_epi16(seg, zero);
+        t = _mm256_sub_epi16(_mm256_add_epi16(t, bias), _mm256_and_si256(lowest, bias_low));
+        t = _mm256_mullo_epi16(t, _mm256_shuffle_epi8(pow2, _mm256_or_si256(seg, high)));
+
+        __m256i negative = _mm256_cmpeq_epi16(_mm256_and_si256(a, sign), zero);
+        t = _mm256_sub_epi16(_mm256_xor_si256(t, negative), negative);
+
+        _mm256_storeu_si256((__m256i *) &pcm[i], t);
+    }
+
+    decode_scalar(alaw_linear, &in[i], count - i, &pcm[i]);
+}
+#endif
+
+void sas_codec_g711_ulaw_encode(const int16_t *pcm, size_t count, uint8_t *out)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = ulaw_encode(pcm[i]);
+    }
+}
+
+void sas_codec_g711_ulaw_decode(const uint8_t *in, size_t count, int16_t *pcm)
+{
+#ifdef SAS_G711_AVX2
+    if (sas_cpu_supports(SAS_CPU_AVX2)) {
+        ulaw_decode_avx2(in, count, pcm);
+        return;
+    }
+#endif
+    decode_scalar(ulaw_linear, in, count, pcm);
+}
+
+void sas_codec_g711_alaw_encode(const int16_t *pcm, size_t count, uint8_t *out)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = alaw_encode(pcm[i]);
+    }
+}
+
+void sas_codec_g711_alaw_decode(const uint8_t *in, size_t count, int16_t *pcm)
+{
+#ifdef SAS_G711_AVX2
+    if (sas_cpu_supports(SAS_CPU_AVX2)) {
+        alaw_decode_avx2(in, count, pcm);
+        return;
+    }
+#endif
+    decode_scalar(alaw_linear, in, count, pcm);
+}
+
+static int supports(int32_t sample_rate, int8_t sample_size, int8_t channels)
+{
+    return sample_size == 16;
+}
+
+static struct sas_chunk * chunk_encode(struct sas_chunk *chunk, uint8_t codec,
+                                       void (*kernel)(const int16_t *, size_t, uint8_t *))
+{
+    const struct sas_format *format = chunk->format;
+
+    /* Chunks from the cache are encoded already */
+    if (format->codec == codec) {
+        return chunk;
+    }
+
+    /* The client decodes every chunk with the negotiated codec, so chunks
+     * that cannot be encoded are dropped rather than sent raw */
+    if (format->codec != SAS_CODEC_NONE ||
+        !supports(format->sample_rate, format->sample_size, format->channels)) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    struct sas_chunk *interleaved = sas_chunk_layout(chunk, SAS_LAYOUT_INTERLEAVED);
+
+    if (!interleaved) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    chunk = interleaved;
+
+    size_t count = chunk->size / sizeof(int16_t);
+    struct sas_chunk *encoded = (format = sas_format_with_codec(chunk->format, codec)) ?
+                                sas_chunk_alloc_size(format, count) : NULL;
+
+    if (!encoded) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    kernel((const int16_t *) chunk->buffer, count, encoded->buffer);
+
+    sas_chunk_dealloc(chunk);
+    return encoded;
+}
+
+static struct sas_chunk * chunk_decode(struct sas_chunk *chunk,
+                                       void (*kernel)(const uint8_t *, size_t, int16_t *))
+{
+    const struct sas_format *format = sas_format_with_codec(chunk->format, SAS_CODEC_NONE);
+    size_t count = chunk->size;
+    struct sas_chunk *decoded;
+
+    /* Drop the chunk rather than passing it on still encoded */
+    if (!format || !(decoded = sas_chunk_alloc_size(format, count * sizeof(int16_t)))) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    kernel(chunk->buffer, count, (int16_t *) decoded->buffer);
+
+    sas_chunk_dealloc(chunk);
+    return decoded;
+}
+
+static void * ulaw_encode_chunk(void *element)
+{
+    return chunk_encode(element, SAS_CODEC_G711_ULAW, sas_codec_g711_ulaw_encode);
+}
+
+static void * ulaw_decode_chunk(void *element)
+{
+    return chunk_decode(element, sas_codec_g711_ulaw_decode);
+}
+
+static void * alaw_encode_chunk(void *element)
+{
+    return chunk_encode(element, SAS_CODEC_G711_ALAW, sas_codec_g711_alaw_encode);
+}
+
+static void * alaw_decode_chunk(void *element)
+{
+    return chunk_decode(element, sas_codec_g711_alaw_decode);
+}
+
+static struct rxc_flow * ulaw_encoder(void)
+{
+    return rxc_flow_map(ulaw_encode_chunk);
+}
+
+static struct rxc_flow * ulaw_decoder(void)
+{
+    return rxc_flow_map(ulaw_decode_chunk);
+}
+
+static struct rxc_flow * alaw_encoder(void)
+{
+    return rxc_flow_map(alaw_encode_chunk);
+}
+
+static struct rxc_flow * alaw_decoder(void)
+{
+    return rxc_flow_map(alaw_decode_chunk);
+}
+
+const struct sas_codec sas_codec_g711_ulaw = {
+    .id = SAS_CODEC_G711_ULAW,
+    .name = "ulaw",
+    .supports = supports,
+    .independent = 1,
+    .encoder = ulaw_encoder,
+    .decoder = ulaw_decoder,
+};
+
+const struct sas_codec sas_codec_g711_alaw = {
+    .id = SAS_CODEC_G711_ALAW,
+    .name = "alaw",
+    .supports = supports,
+    .independent = 1,
+    .encoder = alaw_encoder,
+    .decoder = alaw_decoder,
+};
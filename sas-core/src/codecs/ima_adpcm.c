@@ -0,0 +1,532 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+
+#include <sas/chunk.h>
+#include <sas/cpu.h>
+#include <sas/codecs/ima_adpcm.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SAS_IMA_ADPCM_AVX2 1
+#endif
+
+#define LANES SAS_CODEC_IMA_ADPCM_LANES
+#define HEADER SAS_CODEC_IMA_ADPCM_HEADER
+
+/**
+ * The amount of steps that are coded at once.
+ */
+#define BLOCK 64
+
+static const int32_t step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+    45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209,
+    230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876,
+    963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749,
+    3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630,
+    9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+    27086, 29794, 32767
+};
+
+static const int32_t index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+/**
+ * The coder state of the lanes of a chunk.
+ */
+struct state {
+    int32_t predictor[LANES];
+    int32_t index[LANES];
+};
+
+static inline int32_t clamp(int32_t x, int32_t low, int32_t high)
+{
+    return x < low ? low : (x > high ? high : x);
+}
+
+static inline uint32_t load_le32(const uint8_t *src)
+{
+    return (uint32_t) src[0] | (uint32_t) src[1] << 8 |
+           (uint32_t) src[2] << 16 | (uint32_t) src[3] << 24;
+}
+
+static inline void store_le32(uint8_t *dst, uint32_t x)
+{
+    dst[0] = x;
+    dst[1] = x >> 8;
+    dst[2] = x >> 16;
+    dst[3] = x >> 24;
+}
+
+static void encode_scalar(const int32_t *in, size_t steps, struct state *state,
+                          uint32_t *words)
+{
+    for (size_t t = 0; t < steps; t++) {
+        uint32_t word = 0;
+
+        for (int k = 0; k < LANES; k++) {
+            int32_t step = step_table[state->index[k]];
+            int32_t diff = in[t * LANES + k] - state->predictor[k];
+            int32_t vpdiff = step >> 3;
+            int32_t code = 0;
+
+            if (diff < 0) {
+                code = 8;
+                diff = -diff;
+            }
+
+            if (diff >= step) {
+                code |= 4;
+                diff -= step;
+                vpdiff += step;
+            }
+
+            step >>= 1;
+            if (diff >= step) {
+                code |= 2;
+                diff -= step;
+                vpdiff += step;
+            }
+
+            step >>= 1;
+            if (diff >= step) {
+                code |= 1;
+                vpdiff += step;
+            }
+
+            state->predictor[k] = clamp(state->predictor[k] + (code & 8 ? -vpdiff : vpdiff),
+                                        INT16_MIN, INT16_MAX);
+            state->index[k] = clamp(state->index[k] + index_table[code], 0, 88);
+            word |= (uint32_t) code << (4 * k);
+        }
+
+        words[t] = word;
+    }
+}
+
+static void decode_scalar(const uint32_t *words, size_t steps, struct state *state,
+                          int32_t *out)
+{
+    for (size_t t = 0; t < steps; t++) {
+        for (int k = 0; k < LANES; k++) {
+            int32_t code = (words[t] >> (4 * k)) & 0xf;
+            int32_t step = step_table[state->index[k]];
+            int32_t vpdiff = step >> 3;
+
+            if (code & 4) {
+                vpdiff += step;
+            }
+            if (code & 2) {
+                vpdiff += step >> 1;
+            }
+            if (code & 1) {
+                vpdiff += step >> 2;
+            }
+
+            state->predictor[k] = clamp(state->predictor[k] + (code & 8 ? -vpdiff : vpdiff),
+                                        INT16_MIN, INT16_MAX);
+            state->index[k] = clamp(state->index[k] + index_table[code], 0, 88);
+            out[t * LANES + k] = state->predictor[k];
+        }
+    }
+}
+
+#ifdef SAS_IMA_ADPCM_AVX2
+/*
+ * The vectorized kernels code the eight lanes of a chunk in the lanes of a
+ * vector register and produce exactly the same output as the scalar kernels.
+ */
+__attribute__((target("avx2")))
+static void encode_avx2(const int32_t *in, size_t steps, struct state *state,
+                        uint32_t *words)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+    const __m256i four = _mm256_set1_epi32(4);
+    const __m256i eight = _mm256_set1_epi32(8);
+    const __m256i low = _mm256_set1_epi32(INT16_MIN);
+    const __m256i high = _mm256_set1_epi32(INT16_MAX);
+    const __m256i max_index = _mm256_set1_epi32(88);
+    const __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+
+    __m256i predictor = _mm256_loadu_si256((const __m256i *) state->predictor);
+    __m256i index = _mm256_loadu_si256((const __m256i *) state->index);
+
+    for (size_t t = 0; t < steps; t++) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) &in[t * LANES]);
+        __m256i step = _mm256_i32gather_epi32((const int *) step_table, index, 4);
+        __m256i diff = _mm256_sub_epi32(x, predictor);
+        __m256i sign = _mm256_cmpgt_epi32(zero, diff);
+        __m256i vpdiff = _mm256_srai_epi32(step, 3);
+        __m256i code = _mm256_and_si256(sign, eight);
+        __m256i below;
+
+        diff = _mm256_abs_epi32(diff);
+
+        /* Lanes where the difference is below the step keep their bit unset */
+        below = _mm256_cmpgt_epi32(step, diff);
+        code = _mm256_or_si256(code, _mm256_andnot_si256(below, four));
+        diff = _mm256_sub_epi32(diff, _mm256_andnot_si256(below, step));
+        vpdiff = _mm256_add_epi32(vpdiff, _mm256_andnot_si256(below, step));
+
+        step = _mm256_srai_epi32(step, 1);
+        below = _mm256_cmpgt_epi32(step, diff);
+        code = _mm256_or_si256(code, _mm256_andnot_si256(below, two));
+        diff = _mm256_sub_epi32(diff, _mm256_andnot_si256(below, step));
+        vpdiff = _mm256_add_epi32(vpdiff, _mm256_andnot_si256(below, step));
+
+        step = _mm256_srai_epi32(step, 1);
+        below = _mm256_cmpgt_epi32(step, diff);
+        code = _mm256_or_si256(code, _mm256_andnot_si256(below, one));
+        vpdiff = _mm256_add_epi32(vpdiff, _mm256_andnot_si256(below, step));
+
+        vpdiff = _mm256_sub_epi32(_mm256_xor_si256(vpdiff, sign), sign);
+        predictor = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(predictor, vpdiff), low), high);
+        index = _mm256_add_epi32(index, _mm256_i32gather_epi32((const int *) index_table, code, 4));
+        index = _mm256_min_epi32(_mm256_max_epi32(index, zero), max_index);
+
+        /* Gather the nibbles of the lanes into a single word */
+        __m256i nibbles = _mm256_sllv_epi32(code, shifts);
+        __m128i word = _mm_or_si128(_mm256_castsi256_si128(nibbles),
+                                    _mm256_extracti128_si256(nibbles, 1));
+        word = _mm_or_si128(word, _mm_shuffle_epi32(word, _MM_SHUFFLE(1, 0, 3, 2)));
+        word = _mm_or_si128(word, _mm_shuffle_epi32(word, _MM_SHUFFLE(2, 3, 0, 1)));
+        words[t] = (uint32_t) _mm_cvtsi128_si32(word);
+    }
+
+    _mm256_storeu_si256((__m256i *) state->predictor, predictor);
+    _mm256_storeu_si256((__m256i *) state->index, index);
+}
+
+__attribute__((target("avx2")))
+static void decode_avx2(const uint32_t *words, size_t steps, struct state *state,
+                        int32_t *out)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+    const __m256i four = _mm256_set1_epi32(4);
+    const __m256i eight = _mm256_set1_epi32(8);
+    const __m256i nibble = _mm256_set1_epi32(0xf);
+    const __m256i low = _mm256_set1_epi32(INT16_MIN);
+    const __m256i high = _mm256_set1_epi32(INT16_MAX);
+    const __m256i max_index = _mm256_set1_epi32(88);
+    const __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+
+    __m256i predictor = _mm256_loadu_si256((const __m256i *) state->predictor);
+    __m256i index = _mm256_loadu_si256((const __m256i *) state->index);
+
+    for (size_t t = 0; t < steps; t++) {
+        __m256i code = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int) words[t]), shifts),
+                                        nibble);
+        __m256i step = _mm256_i32gather_epi32((const int *) step_table, index, 4);
+        __m256i vpdiff = _mm256_srai_epi32(step, 3);
+        __m256i set;
+
+        set = _mm256_cmpeq_epi32(_mm256_and_si256(code, four), four);
+        vpdiff = _mm256_add_epi32(vpdiff, _mm256_and_si256(set, step));
+        set = _mm256_cmpeq_epi32(_mm256_and_si256(code, two), two);
+        vpdiff = _mm256_add_epi32(vpdiff, _mm256_and_si256(set, _mm256_srai_epi32(step, 1)));
+        set = _mm256_cmpeq_epi32(_mm256_and_si256(code, one), one);
+        vpdiff = _mm256_add_epi32(vpdiff, _mm256_and_si256(set, _mm256_srai_epi32(step, 2)));
+
+        set = _mm256_cmpeq_epi32(_mm256_and_si256(code, eight), eight);
+        vpdiff = _mm256_sub_epi32(_mm256_xor_si256(vpdiff, set), set);
+        predictor = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(predictor, vpdiff), low), high);
+        index = _mm256_add_epi32(index, _mm256_i32gather_epi32((const int *) index_table, code, 4));
+        index = _mm256_min_epi32(_mm256_max_epi32(index, zero), max_index);
+
+        _mm256_storeu_si256((__m256i *) &out[t * LANES], predictor);
+    }
+
+    _mm256_storeu_si256((__m256i *) state->predictor, predictor);
+    _mm256_storeu_si256((__m256i *) state->index, index);
+}
+#endif
+
+static void encode_kernel(const int32_t *in, size_t steps, struct state *state,
+                          uint32_t *words)
+{
+#ifdef SAS_IMA_ADPCM_AVX2
+    if (sas_cpu_supports(SAS_CPU_AVX2)) {
+        encode_avx2(in, steps, state, words);
+        return;
+    }
+#endif
+    encode_scalar(in, steps, state, words);
+}
+
+static void decode_kernel(const uint32_t *words, size_t steps, struct state *state,
+                          int32_t *out)
+{
+#ifdef SAS_IMA_ADPCM_AVX2
+    if (sas_cpu_supports(SAS_CPU_AVX2)) {
+        decode_avx2(words, steps, state, out);
+        return;
+    }
+#endif
+    decode_scalar(words, steps, state, out);
+}
+
+/**
+ * Determine the amount of steps each lane codes for a chunk.
+ */
+static size_t steps_of(size_t frames, int channels)
+{
+    size_t segments = LANES / channels;
+    return (frames + segments - 1) / segments;
+}
+
+/**
+ * Determine the first frame and the channel that each lane codes.
+ */
+static void lanes_of(size_t steps, int channels, size_t *base, int *channel)
+{
+    for (int k = 0; k < LANES; k++) {
+        base[k] = (k / channels) * steps;
+        channel[k] = k % channels;
+    }
+}
+
+/**
+ * Read a sample of a lane, where lanes that run past the end of the chunk
+ * repeat its last frame.
+ */
+static inline int32_t sample_of(const int16_t *pcm, size_t frames, int channels,
+                                size_t frame, int channel)
+{
+    if (frame >= frames) {
+        frame = frames - 1;
+    }
+
+    return pcm[frame * channels + channel];
+}
+
+size_t sas_codec_ima_adpcm_size(size_t frames, int channels)
+{
+    return HEADER + 4 * steps_of(frames, channels);
+}
+
+size_t sas_codec_ima_adpcm_encode(const int16_t *pcm, size_t frames, int channels,
+                                  uint8_t *out)
+{
+    size_t steps = steps_of(frames, channels);
+    size_t base[LANES];
+    int channel[LANES];
+    struct state state;
+    int32_t in[BLOCK * LANES];
+    uint32_t words[BLOCK];
+
+    lanes_of(steps, channels, base, channel);
+    store_le32(out, (uint32_t) frames);
+
+    /* Start each lane at its first sample with a step size that fits the
+     * first difference, which avoids a burst of noise while the coder adapts */
+    for (int k = 0; k < LANES; k++) {
+        int32_t first = 0;
+        int32_t delta = 0;
+        int32_t index = 0;
+
+        if (frames > 0) {
+            first = sample_of(pcm, frames, channels, base[k], channel[k]);
+            delta = abs(sample_of(pcm, frames, channels, base[k] + 1, channel[k]) - first);
+        }
+
+        while (index < 88 && step_table[index] < delta) {
+            index++;
+        }
+
+        state.predictor[k] = first;
+        state.index[k] = index;
+
+        uint8_t *lane = &out[4 + 4 * k];
+        lane[0] = (uint16_t) first;
+        lane[1] = (uint16_t) first >> 8;
+        lane[2] = index;
+        lane[3] = 0;
+    }
+
+    uint8_t *dst = &out[HEADER];
+
+    for (size_t offset = 0; offset < steps; offset += BLOCK) {
+        size_t count = steps - offset < BLOCK ? steps - offset : BLOCK;
+
+        for (size_t t = 0; t < count; t++) {
+            for (int k = 0; k < LANES; k++) {
+                in[t * LANES + k] = sample_of(pcm, frames, channels, base[k] + offset + t, channel[k]);
+            }
+        }
+
+        encode_kernel(in, count, &state, words);
+
+        for (size_t t = 0; t < count; t++) {
+            store_le32(&dst[4 * (offset + t)], words[t]);
+        }
+    }
+
+    return HEADER + 4 * steps;
+}
+
+long sas_codec_ima_adpcm_frames(const uint8_t *in, size_t size, int channels)
+{
+    if (channels <= 0 || LANES % channels != 0 || size < HEADER) {
+        return -1;
+    }
+
+    uint32_t frames = load_le32(in);
+
+    if ((size - HEADER) / 4 < steps_of(frames, channels)) {
+        return -1;
+    }
+
+    return frames;
+}
+
+long sas_codec_ima_adpcm_decode(const uint8_t *in, size_t size, int channels,
+                                int16_t *pcm)
+{
+    long frames = sas_codec_ima_adpcm_frames(in, size, channels);
+
+    if (frames < 0) {
+        return -1;
+    }
+
+    size_t steps = steps_of(frames, channels);
+    size_t base[LANES];
+    int channel[LANES];
+    struct state state;
+    int32_t out[BLOCK * LANES];
+    uint32_t words[BLOCK];
+
+    lanes_of(steps, channels, base, channel);
+
+    for (int k = 0; k < LANES; k++) {
+        const uint8_t *lane = &in[4 + 4 * k];
+
+        state.predictor[k] = (int16_t) (lane[0] | lane[1] << 8);
+        state.index[k] = clamp(lane[2], 0, 88);
+    }
+
+    const uint8_t *src = &in[HEADER];
+
+    for (size_t offset = 0; offset < steps; offset += BLOCK) {
+        size_t count = steps - offset < BLOCK ? steps - offset : BLOCK;
+
+        for (size_t t = 0; t < count; t++) {
+            words[t] = load_le32(&src[4 * (offset + t)]);
+        }
+
+        decode_kernel(words, count, &state, out);
+
+        for (size_t t = 0; t < count; t++) {
+            for (int k = 0; k < LANES; k++) {
+                size_t frame = base[k] + offset + t;
+
+                /* Drop the padding of the lanes past the end of the chunk */
+                if (frame < (size_t) frames) {
+                    pcm[frame * channels + channel[k]] = out[t * LANES + k];
+                }
+            }
+        }
+    }
+
+    return frames;
+}
+
+static int supports(int32_t sample_rate, int8_t sample_size, int8_t channels)
+{
+    return sample_size == 16 && channels > 0 && LANES % channels == 0;
+}
+
+static void * encode(void *element)
+{
+    struct sas_chunk *chunk = element;
+    const struct sas_format *format = chunk->format;
+
+    /* Chunks from the cache are encoded already */
+    if (format->codec == SAS_CODEC_IMA_ADPCM) {
+        return chunk;
+    }
+
+    /* The client decodes every chunk with the negotiated codec, so chunks
+     * that cannot be encoded are dropped rather than sent raw */
+    if (format->codec != SAS_CODEC_NONE ||
+        !supports(format->sample_rate, format->sample_size, format->channels)) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    struct sas_chunk *interleaved = sas_chunk_layout(chunk, SAS_LAYOUT_INTERLEAVED);
+
+    if (!interleaved) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    chunk = interleaved;
+
+    size_t frames = chunk->size / (sizeof(int16_t) * chunk->format->channels);
+    struct sas_chunk *encoded = (format = sas_format_with_codec(chunk->format, SAS_CODEC_IMA_ADPCM)) ?
+            sas_chunk_alloc_size(format, sas_codec_ima_adpcm_size(frames, format->channels)) : NULL;
+
+    if (!encoded) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    encoded->size = sas_codec_ima_adpcm_encode((const int16_t *) chunk->buffer, frames,
+                                               format->channels, encoded->buffer);
+
+    sas_chunk_dealloc(chunk);
+    return encoded;
+}
+
+static void * decode(void *element)
+{
+    struct sas_chunk *chunk = element;
+    const struct sas_format *format = sas_format_with_codec(chunk->format, SAS_CODEC_NONE);
+    long frames = sas_codec_ima_adpcm_frames(chunk->buffer, chunk->size, chunk->format->channels);
+
+    /* Malformed chunks are decoded into an empty chunk */
+    size_t size = frames > 0 ? frames * sizeof(int16_t) * chunk->format->channels : 0;
+    struct sas_chunk *decoded = format ? sas_chunk_alloc_size(format, size) : NULL;
+
+    /* Drop the chunk rather than passing it on still encoded */
+    if (!decoded) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    if (frames > 0) {
+        sas_codec_ima_adpcm_decode(chunk->buffer, chunk->size, chunk->format->channels,
+                                   (int16_t *) decoded->buffer);
+    }
+
+    sas_chunk_dealloc(chunk);
+    return decoded;
+}
+
+static struct rxc_flow * encoder(void)
+{
+    return rxc_flow_map(encode);
+}
+
+static struct rxc_flow * decoder(void)
+{
+    return rxc_flow_map(decode);
+}
+
+const struct sas_codec sas_codec_ima_adpcm = {
+    .id = SAS_CODEC_IMA_ADPCM,
+    .name = "ima-adpcm",
+    .supports = supports,
+    .independent = 1,
+    .encoder = encoder,
+    .decoder = decoder,
+};
@@ -0,0 +1,960 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+
+#include <sas/chunk.h>
+#include <sas/codecs/lossless.h>
+
+#define BLOCK SAS_CODEC_LOSSLESS_BLOCK
+
+#define MAX_FIXED_ORDER 4      /* The maximum order of the fixed predictors */
+#define MAX_LPC_ORDER 12       /* The maximum order of the linear predictors */
+#define MIN_LPC_FRAMES 32      /* The minimum block size to try linear prediction */
+#define PRECISION 15           /* The precision of the predictor coefficients */
+#define MAX_SHIFT 20           /* The maximum shift of the predictor */
+#define MAX_PARTITION_ORDER 6  /* The maximum order of Rice partitions */
+#define MAX_RICE 30            /* The maximum Rice parameter */
+#define MAX_QUOTIENT (1 << 20) /* The maximum quotient accepted by the decoder */
+
+#define TYPE_CONSTANT 0 /* All samples have the same value */
+#define TYPE_VERBATIM 1 /* The samples are stored as is */
+#define TYPE_FIXED    2 /* The residual of a fixed polynomial predictor */
+#define TYPE_LPC      3 /* The residual of a quantized linear predictor */
+
+#define STEREO_INDEPENDENT 0 /* Left and right */
+#define STEREO_LEFT_SIDE   1 /* Left and left minus right */
+#define STEREO_SIDE_RIGHT  2 /* Left minus right and right */
+#define STEREO_MID_SIDE    3 /* The average and the difference */
+
+static const int32_t fixed_coefficients[MAX_FIXED_ORDER + 1][MAX_FIXED_ORDER] = {
+    {0, 0, 0, 0},
+    {1, 0, 0, 0},
+    {2, -1, 0, 0},
+    {3, -3, 1, 0},
+    {4, -6, 4, -1}
+};
+
+/**
+ * A writer of a bit stream, most significant bit first.
+ */
+struct writer {
+    uint8_t *buffer;
+    size_t offset;
+    uint64_t bits;
+    int count;
+};
+
+/**
+ * A reader of a bit stream, which reads zero bits past its end and flags the
+ * stream as malformed.
+ */
+struct reader {
+    const uint8_t *buffer;
+    size_t size;
+    size_t offset;
+    uint64_t bits;
+    int count;
+    int error;
+};
+
+static inline uint64_t mask_of(int n)
+{
+    return ((uint64_t) 1 << n) - 1;
+}
+
+static inline void put(struct writer *w, uint32_t value, int n)
+{
+    w->bits = (w->bits << n) | (value & mask_of(n));
+    w->count += n;
+
+    while (w->count >= 8) {
+        w->count -= 8;
+        w->buffer[w->offset++] = (uint8_t) (w->bits >> w->count);
+    }
+}
+
+static inline void put_unary(struct writer *w, uint32_t zeros)
+{
+    for (; zeros >= 31; zeros -= 31) {
+        put(w, 0, 31);
+    }
+
+    put(w, 1, zeros + 1);
+}
+
+static void align(struct writer *w)
+{
+    if (w->count > 0) {
+        put(w, 0, 8 - w->count);
+    }
+}
+
+static inline void refill(struct reader *r)
+{
+    uint8_t byte = 0;
+
+    if (r->offset < r->size) {
+        byte = r->buffer[r->offset++];
+    } else {
+        r->error = 1;
+    }
+
+    r->bits = (r->bits << 8) | byte;
+    r->count += 8;
+}
+
+static inline uint32_t get(struct reader *r, int n)
+{
+    while (r->count < n) {
+        refill(r);
+    }
+
+    r->count -= n;
+    return (uint32_t) ((r->bits >> r->count) & mask_of(n));
+}
+
+static inline int32_t get_signed(struct reader *r, int n)
+{
+    uint32_t value = get(r, n);
+
+    /* Sign-extend the value */
+    return (int32_t) (value ^ (1u << (n - 1))) - (int32_t) (1u << (n - 1));
+}
+
+static inline uint32_t get_unary(struct reader *r)
+{
+    uint32_t zeros = 0;
+
+    while (!r->error && zeros < MAX_QUOTIENT) {
+        uint64_t window = r->bits & mask_of(r->count);
+
+        if (window) {
+            int leading = r->count - (64 - __builtin_clzll(window));
+            r->count -= leading + 1;
+            return zeros + leading;
+        }
+
+        zeros += r->count;
+        r->count = 0;
+        refill(r);
+    }
+
+    r->error = 1;
+    return 0;
+}
+
+static inline uint32_t zigzag(int32_t x)
+{
+    return ((uint32_t) x << 1) ^ (uint32_t) (x >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t u)
+{
+    return (int32_t) (u >> 1) ^ -(int32_t) (u & 1);
+}
+
+/**
+ * Compute the residual of a predictor, which fails if a residual does not fit
+ * in 31 bits.
+ */
+static int residual_of(const int32_t *x, size_t n, const int32_t *coefficients,
+                       int order, int shift, int32_t *residual)
+{
+    for (size_t i = order; i < n; i++) {
+        int64_t sum = 0;
+
+        for (int j = 0; j < order; j++) {
+            sum += (int64_t) coefficients[j] * x[i - 1 - j];
+        }
+
+        int64_t error = x[i] - (sum >> shift);
+
+        if (error >= (1 << 30) || error <= -(1 << 30)) {
+            return -1;
+        }
+
+        residual[i - order] = (int32_t) error;
+    }
+
+    return 0;
+}
+
+/**
+ * The way the residual of a subframe is partitioned and Rice coded.
+ */
+struct rice {
+    int order;
+    int parameters[1 << MAX_PARTITION_ORDER];
+};
+
+/**
+ * Choose the partitioning and Rice parameters of a residual, which returns
+ * the estimated size of the coded residual in bits.
+ */
+static uint64_t rice_plan(const int32_t *residual, size_t n, int order, struct rice *rice)
+{
+    uint64_t best = UINT64_MAX;
+    int max = 0;
+
+    while (max < MAX_PARTITION_ORDER && n % (2u << max) == 0 && (n >> (max + 1)) > (size_t) order) {
+        max++;
+    }
+
+    for (int p = 0; p <= max; p++) {
+        size_t length = n >> p;
+        size_t offset = 0;
+        uint64_t bits = 4;
+        int parameters[1 << MAX_PARTITION_ORDER];
+
+        for (size_t k = 0; k < ((size_t) 1 << p); k++) {
+            size_t count = length - (k == 0 ? order : 0);
+            uint64_t sum = 0;
+            int parameter = 0;
+
+            for (size_t i = 0; i < count; i++) {
+                sum += zigzag(residual[offset + i]);
+            }
+            offset += count;
+
+            while (parameter < MAX_RICE && ((uint64_t) count << (parameter + 1)) < sum) {
+                parameter++;
+            }
+
+            parameters[k] = parameter;
+            bits += 5 + count * (parameter + 1) + (sum >> parameter);
+        }
+
+        if (bits < best) {
+            best = bits;
+            rice->order = p;
+            memcpy(rice->parameters, parameters, sizeof(int) << p);
+        }
+    }
+
+    return best;
+}
+
+static void rice_write(struct writer *w, const int32_t *residual, size_t n, int order,
+                       const struct rice *rice)
+{
+    size_t length = n >> rice->order;
+    size_t offset = 0;
+
+    put(w, rice->order, 4);
+
+    for (size_t k = 0; k < ((size_t) 1 << rice->order); k++) {
+        size_t count = length - (k == 0 ? order : 0);
+        int parameter = rice->parameters[k];
+
+        put(w, parameter, 5);
+
+        for (size_t i = 0; i < count; i++) {
+            uint32_t u = zigzag(residual[offset + i]);
+            put_unary(w, u >> parameter);
+            put(w, u, parameter);
+        }
+        offset += count;
+    }
+}
+
+static int rice_read(struct reader *r, int32_t *residual, size_t n, int order)
+{
+    int p = get(r, 4);
+
+    if (p > MAX_PARTITION_ORDER || n % ((size_t) 1 << p) != 0 || (n >> p) < (size_t) order) {
+        return -1;
+    }
+
+    size_t length = n >> p;
+    size_t offset = 0;
+
+    for (size_t k = 0; k < ((size_t) 1 << p); k++) {
+        size_t count = length - (k == 0 ? order : 0);
+        int parameter = get(r, 5);
+
+        if (parameter > MAX_RICE) {
+            return -1;
+        }
+
+        for (size_t i = 0; i < count && !r->error; i++) {
+            uint32_t quotient = get_unary(r);
+            residual[offset + i] = unzigzag((quotient << parameter) | get(r, parameter));
+        }
+        offset += count;
+    }
+
+    return r->error ? -1 : 0;
+}
+
+/**
+ * Compute the linear predictors of all orders up to the specified order with
+ * the autocorrelation method, together with their prediction error, which
+ * returns the amount of predictors.
+ */
+static int lpc_compute(const int32_t *x, size_t n, int max_order, double *window,
+                       double lpc[MAX_LPC_ORDER][MAX_LPC_ORDER], double *errors)
+{
+    double autocorrelation[MAX_LPC_ORDER + 1];
+    double a[MAX_LPC_ORDER] = {0};
+    double half = (n - 1) / 2.0;
+
+    /* Apply a Welch window to reduce the leakage at the block edges */
+    for (size_t i = 0; i < n; i++) {
+        double w = (i - half) / (half + 1);
+        window[i] = x[i] * (1 - w * w);
+    }
+
+    for (int lag = 0; lag <= max_order; lag++) {
+        double sum = 0;
+
+        for (size_t i = lag; i < n; i++) {
+            sum += window[i] * window[i - lag];
+        }
+
+        autocorrelation[lag] = sum;
+    }
+
+    if (autocorrelation[0] == 0) {
+        return 0;
+    }
+
+    /* Solve the normal equations with the Levinson-Durbin recursion */
+    double error = autocorrelation[0];
+
+    for (int i = 0; i < max_order; i++) {
+        double r = -autocorrelation[i + 1];
+
+        for (int j = 0; j < i; j++) {
+            r -= a[j] * autocorrelation[i - j];
+        }
+
+        r /= error;
+        a[i] = r;
+
+        for (int j = 0; j < i / 2; j++) {
+            double tmp = a[j];
+            a[j] += r * a[i - 1 - j];
+            a[i - 1 - j] += r * tmp;
+        }
+
+        if (i % 2) {
+            a[i / 2] += a[i / 2] * r;
+        }
+
+        error *= 1 - r * r;
+        errors[i] = error;
+
+        for (int j = 0; j <= i; j++) {
+            lpc[i][j] = -a[j];
+        }
+
+        if (error <= 0) {
+            return i + 1;
+        }
+    }
+
+    return max_order;
+}
+
+/**
+ * Estimate the order of linear predictor that codes a block in the least
+ * amount of bits from the prediction errors, so that only a single predictor
+ * needs to be evaluated.
+ */
+static int lpc_order(const double *errors, int orders, size_t n, int bps)
+{
+    double best = HUGE_VAL;
+    int order = 1;
+
+    for (int k = 1; k <= orders; k++) {
+        double error = errors[k - 1] > 0 ? errors[k - 1] / n : 1e-9;
+        double bits = 0.5 * log2(error > 1 ? error : 1) * (n - k) + k * (PRECISION + bps);
+
+        if (bits < best) {
+            best = bits;
+            order = k;
+        }
+    }
+
+    return order;
+}
+
+/**
+ * Quantize the coefficients of a linear predictor, which fails if the
+ * coefficients cannot be represented.
+ */
+static int lpc_quantize(const double *lpc, int order, int32_t *coefficients, int *shift)
+{
+    const int32_t max = (1 << (PRECISION - 1)) - 1;
+    const int32_t min = -(1 << (PRECISION - 1));
+    double cmax = 0;
+    int log2cmax;
+
+    for (int i = 0; i < order; i++) {
+        cmax = fabs(lpc[i]) > cmax ? fabs(lpc[i]) : cmax;
+    }
+
+    if (cmax <= 0 || !isfinite(cmax)) {
+        return -1;
+    }
+
+    frexp(cmax, &log2cmax);
+    *shift = PRECISION - 1 - log2cmax;
+
+    if (*shift < 0) {
+        return -1;
+    } else if (*shift > MAX_SHIFT) {
+        *shift = MAX_SHIFT;
+    }
+
+    /* Carry the rounding error over to the next coefficient */
+    double error = 0;
+
+    for (int i = 0; i < order; i++) {
+        error += lpc[i] * (1 << *shift);
+
+        long q = lround(error);
+        q = q > max ? max : (q < min ? min : q);
+
+        coefficients[i] = (int32_t) q;
+        error -= q;
+    }
+
+    return 0;
+}
+
+/**
+ * The scratch space of the encoder.
+ */
+struct workspace {
+    int32_t *channels[4];
+    int32_t *residual;
+    int32_t *best;
+    double *window;
+};
+
+static void subframe_write(struct writer *w, const int32_t *x, size_t n, int bps,
+                           struct workspace *ws)
+{
+    size_t i;
+
+    for (i = 1; i < n && x[i] == x[0]; i++);
+
+    if (i == n) {
+        put(w, TYPE_CONSTANT, 2);
+        put(w, (uint32_t) x[0], bps);
+        return;
+    }
+
+    uint64_t best = 2 + (uint64_t) n * bps;
+    int type = TYPE_VERBATIM;
+    int order = 0;
+    int shift = 0;
+    int32_t coefficients[MAX_LPC_ORDER];
+    struct rice rice;
+    struct rice candidate;
+
+    for (int k = 0; k <= MAX_FIXED_ORDER && (size_t) k < n; k++) {
+        if (residual_of(x, n, fixed_coefficients[k], k, 0, ws->residual) < 0) {
+            continue;
+        }
+
+        uint64_t bits = 2 + 3 + (uint64_t) k * bps + rice_plan(ws->residual, n, k, &candidate);
+
+        if (bits < best) {
+            int32_t *tmp = ws->best;
+
+            best = bits;
+            type = TYPE_FIXED;
+            order = k;
+            rice = candidate;
+            ws->best = ws->residual;
+            ws->residual = tmp;
+        }
+    }
+
+    if (n >= MIN_LPC_FRAMES) {
+        double lpc[MAX_LPC_ORDER][MAX_LPC_ORDER];
+        double errors[MAX_LPC_ORDER];
+        int orders = lpc_compute(x, n, MAX_LPC_ORDER, ws->window, lpc, errors);
+
+        int k = orders > 0 ? lpc_order(errors, orders, n, bps) : 0;
+        int32_t quantized[MAX_LPC_ORDER];
+        int s;
+
+        if (k > 0 && lpc_quantize(lpc[k - 1], k, quantized, &s) == 0 &&
+            residual_of(x, n, quantized, k, s, ws->residual) == 0) {
+            uint64_t bits = 2 + 4 + 4 + 5 + (uint64_t) k * (PRECISION + bps) +
+                            rice_plan(ws->residual, n, k, &candidate);
+
+            if (bits < best) {
+                int32_t *tmp = ws->best;
+
+                best = bits;
+                type = TYPE_LPC;
+                order = k;
+                shift = s;
+                rice = candidate;
+                memcpy(coefficients, quantized, sizeof(quantized));
+                ws->best = ws->residual;
+                ws->residual = tmp;
+            }
+        }
+    }
+
+    /* Fall back to the verbatim samples when the estimate was off */
+    struct writer start = *w;
+
+    if (type != TYPE_VERBATIM) {
+        put(w, type, 2);
+
+        if (type == TYPE_FIXED) {
+            put(w, order, 3);
+        } else {
+            put(w, order - 1, 4);
+            put(w, PRECISION - 1, 4);
+            put(w, shift, 5);
+
+            for (int k = 0; k < order; k++) {
+                put(w, (uint32_t) coefficients[k], PRECISION);
+            }
+        }
+
+        for (int k = 0; k < order; k++) {
+            put(w, (uint32_t) x[k], bps);
+        }
+
+        rice_write(w, ws->best, n, order, &rice);
+
+        uint64_t written = (w->offset - start.offset) * 8 + w->count - start.count;
+
+        if (written <= 2 + (uint64_t) n * bps) {
+            return;
+        }
+
+        *w = start;
+    }
+
+    put(w, TYPE_VERBATIM, 2);
+
+    for (i = 0; i < n; i++) {
+        put(w, (uint32_t) x[i], bps);
+    }
+}
+
+static int subframe_read(struct reader *r, int32_t *x, size_t n, int bps)
+{
+    int type = get(r, 2);
+    int order = 0;
+    int shift = 0;
+    int32_t coefficients[MAX_LPC_ORDER];
+
+    switch (type) {
+        case TYPE_CONSTANT: {
+            int32_t value = get_signed(r, bps);
+
+            for (size_t i = 0; i < n; i++) {
+                x[i] = value;
+            }
+            return r->error ? -1 : 0;
+        }
+        case TYPE_VERBATIM:
+            for (size_t i = 0; i < n; i++) {
+                x[i] = get_signed(r, bps);
+            }
+            return r->error ? -1 : 0;
+        case TYPE_FIXED:
+            order = get(r, 3);
+
+            if (order > MAX_FIXED_ORDER) {
+                return -1;
+            }
+
+            memcpy(coefficients, fixed_coefficients[order], sizeof(fixed_coefficients[order]));
+            break;
+        default: {
+            order = get(r, 4) + 1;
+            int precision = get(r, 4) + 1;
+            shift = get(r, 5);
+
+            if (order > MAX_LPC_ORDER || shift > MAX_SHIFT) {
+                return -1;
+            }
+
+            for (int k = 0; k < order; k++) {
+                coefficients[k] = get_signed(r, precision);
+            }
+            break;
+        }
+    }
+
+    if ((size_t) order > n) {
+        return -1;
+    }
+
+    for (int k = 0; k < order; k++) {
+        x[k] = get_signed(r, bps);
+    }
+
+    if (rice_read(r, &x[order], n, order) < 0) {
+        return -1;
+    }
+
+    for (size_t i = order; i < n; i++) {
+        int64_t sum = 0;
+
+        for (int j = 0; j < order; j++) {
+            sum += (int64_t) coefficients[j] * x[i - 1 - j];
+        }
+
+        x[i] = (int32_t) (x[i] + (sum >> shift));
+    }
+
+    return 0;
+}
+
+/**
+ * Estimate the cost of a channel by the magnitude of its second order
+ * residual.
+ */
+static uint64_t stereo_cost(const int32_t *x, size_t n)
+{
+    uint64_t sum = 0;
+
+    for (size_t i = 2; i < n; i++) {
+        int32_t error = x[i] - 2 * x[i - 1] + x[i - 2];
+        sum += error < 0 ? -(int64_t) error : error;
+    }
+
+    return sum;
+}
+
+static size_t block_write(uint8_t *out, const int16_t *pcm, size_t n, int channels,
+                          struct workspace *ws)
+{
+    struct writer w = { &out[4], 0, 0, 0 };
+    int32_t *x[2];
+    int bps[2] = {16, 16};
+    int assignment = STEREO_INDEPENDENT;
+
+    for (int c = 0; c < channels; c++) {
+        for (size_t i = 0; i < n; i++) {
+            ws->channels[c][i] = pcm[i * channels + c];
+        }
+        x[c] = ws->channels[c];
+    }
+
+    if (channels == 2) {
+        int32_t *left = ws->channels[0], *right = ws->channels[1];
+        int32_t *mid = ws->channels[2], *side = ws->channels[3];
+
+        for (size_t i = 0; i < n; i++) {
+            mid[i] = (left[i] + right[i]) >> 1;
+            side[i] = left[i] - right[i];
+        }
+
+        uint64_t l = stereo_cost(left, n), r = stereo_cost(right, n);
+        uint64_t m = stereo_cost(mid, n), s = stereo_cost(side, n);
+        uint64_t best = l + r;
+
+        if (l + s < best) {
+            best = l + s;
+            assignment = STEREO_LEFT_SIDE;
+        }
+        if (s + r < best) {
+            best = s + r;
+            assignment = STEREO_SIDE_RIGHT;
+        }
+        if (m + s < best) {
+            assignment = STEREO_MID_SIDE;
+        }
+
+        switch (assignment) {
+            case STEREO_LEFT_SIDE:
+                x[1] = side;
+                bps[1] = 17;
+                break;
+            case STEREO_SIDE_RIGHT:
+                x[0] = side;
+                bps[0] = 17;
+                break;
+            case STEREO_MID_SIDE:
+                x[0] = mid;
+                x[1] = side;
+                bps[1] = 17;
+                break;
+        }
+    }
+
+    put(&w, assignment, 2);
+
+    for (int c = 0; c < channels; c++) {
+        subframe_write(&w, x[c], n, bps[c], ws);
+    }
+
+    align(&w);
+
+    out[0] = (uint8_t) w.offset;
+    out[1] = (uint8_t) (w.offset >> 8);
+    out[2] = (uint8_t) n;
+    out[3] = (uint8_t) (n >> 8);
+
+    return 4 + w.offset;
+}
+
+static int block_read(const uint8_t *in, size_t size, size_t n, int channels,
+                      int32_t *x0, int32_t *x1, int16_t *pcm)
+{
+    struct reader r = { in, size, 0, 0, 0, 0 };
+    int32_t *x[2] = { x0, x1 };
+    int assignment = get(&r, 2);
+
+    if (channels == 1 && assignment != STEREO_INDEPENDENT) {
+        return -1;
+    }
+
+    for (int c = 0; c < channels; c++) {
+        int side = (assignment == STEREO_SIDE_RIGHT && c == 0) ||
+                   ((assignment == STEREO_LEFT_SIDE || assignment == STEREO_MID_SIDE) && c == 1);
+
+        if (subframe_read(&r, x[c], n, side ? 17 : 16) < 0) {
+            return -1;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        int64_t left = x[0][i];
+        int64_t right = channels == 2 ? x[1][i] : 0;
+
+        switch (assignment) {
+            case STEREO_LEFT_SIDE:
+                right = left - right;
+                break;
+            case STEREO_SIDE_RIGHT:
+                left = left + right;
+                break;
+            case STEREO_MID_SIDE: {
+                int64_t mid = left * 2 | (right & 1);
+                left = (mid + right) >> 1;
+                right = (mid - right) >> 1;
+                break;
+            }
+        }
+
+        pcm[i * channels] = (int16_t) left;
+
+        if (channels == 2) {
+            pcm[i * channels + 1] = (int16_t) right;
+        }
+    }
+
+    return 0;
+}
+
+size_t sas_codec_lossless_bound(size_t frames, int channels)
+{
+    size_t blocks = (frames + BLOCK - 1) / BLOCK;
+    return blocks * 5 + (channels * (2 + 17 * frames) + 7) / 8 + blocks * channels;
+}
+
+size_t sas_codec_lossless_encode(const int16_t *pcm, size_t frames, int channels,
+                                 uint8_t *out)
+{
+    size_t n = frames < BLOCK ? frames : BLOCK;
+    size_t size = 0;
+    struct workspace ws;
+
+    if (frames == 0 || channels < 1 || channels > 2) {
+        return 0;
+    }
+
+    int32_t *scratch = malloc(sizeof(int32_t) * n * 6);
+    ws.window = malloc(sizeof(double) * n);
+
+    if (!scratch || !ws.window) {
+        free(scratch);
+        free(ws.window);
+        return 0;
+    }
+
+    for (int c = 0; c < 4; c++) {
+        ws.channels[c] = &scratch[c * n];
+    }
+    ws.residual = &scratch[4 * n];
+    ws.best = &scratch[5 * n];
+
+    for (size_t offset = 0; offset < frames; offset += BLOCK) {
+        size_t count = frames - offset < BLOCK ? frames - offset : BLOCK;
+        size += block_write(&out[size], &pcm[offset * channels], count, channels, &ws);
+    }
+
+    free(scratch);
+    free(ws.window);
+    return size;
+}
+
+long sas_codec_lossless_frames(const uint8_t *in, size_t size, int channels)
+{
+    long frames = 0;
+    size_t offset = 0;
+
+    if (channels < 1 || channels > 2) {
+        return -1;
+    }
+
+    while (offset < size) {
+        if (size - offset < 4) {
+            return -1;
+        }
+
+        size_t length = in[offset] | in[offset + 1] << 8;
+        size_t n = in[offset + 2] | in[offset + 3] << 8;
+
+        if (n == 0 || n > BLOCK || size - offset - 4 < length) {
+            return -1;
+        }
+
+        frames += n;
+        offset += 4 + length;
+    }
+
+    return frames;
+}
+
+long sas_codec_lossless_decode(const uint8_t *in, size_t size, int channels,
+                               int16_t *pcm)
+{
+    long frames = sas_codec_lossless_frames(in, size, channels);
+
+    if (frames <= 0) {
+        return frames;
+    }
+
+    int32_t *scratch = malloc(sizeof(int32_t) * BLOCK * 2);
+
+    if (!scratch) {
+        return -1;
+    }
+
+    size_t offset = 0;
+    long decoded = 0;
+
+    while (offset < size) {
+        size_t length = in[offset] | in[offset + 1] << 8;
+        size_t n = in[offset + 2] | in[offset + 3] << 8;
+
+        if (block_read(&in[offset + 4], length, n, channels, scratch, &scratch[BLOCK],
+                       &pcm[decoded * channels]) < 0) {
+            free(scratch);
+            return -1;
+        }
+
+        decoded += n;
+        offset += 4 + length;
+    }
+
+    free(scratch);
+    return decoded;
+}
+
+static int supports(int32_t sample_rate, int8_t sample_size, int8_t channels)
+{
+    return sample_size == 16 && channels >= 1 && channels <= 2;
+}
+
+static void * encode(void *element)
+{
+    struct sas_chunk *chunk = element;
+    const struct sas_format *format = chunk->format;
+
+    /* Chunks from the cache are encoded already */
+    if (format->codec == SAS_CODEC_LOSSLESS) {
+        return chunk;
+    }
+
+    /* The client decodes every chunk with the negotiated codec, so chunks
+     * that cannot be encoded are dropped rather than sent raw */
+    if (format->codec != SAS_CODEC_NONE ||
+        !supports(format->sample_rate, format->sample_size, format->channels)) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    struct sas_chunk *interleaved = sas_chunk_layout(chunk, SAS_LAYOUT_INTERLEAVED);
+
+    if (!interleaved) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    chunk = interleaved;
+
+    size_t frames = chunk->size / (sizeof(int16_t) * chunk->format->channels);
+    struct sas_chunk *encoded = (format = sas_format_with_codec(chunk->format, SAS_CODEC_LOSSLESS)) ?
+            sas_chunk_alloc_size(format, sas_codec_lossless_bound(frames, format->channels)) : NULL;
+
+    if (!encoded) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    encoded->size = sas_codec_lossless_encode((const int16_t *) chunk->buffer, frames,
+                                              format->channels, encoded->buffer);
+    sas_chunk_dealloc(chunk);
+
+    if (encoded->size == 0 && frames > 0) {
+        sas_chunk_dealloc(encoded);
+        return NULL;
+    }
+
+    return encoded;
+}
+
+static void * decode(void *element)
+{
+    struct sas_chunk *chunk = element;
+    const struct sas_format *format = sas_format_with_codec(chunk->format, SAS_CODEC_NONE);
+    long frames = sas_codec_lossless_frames(chunk->buffer, chunk->size, chunk->format->channels);
+
+    /* Chunks of which the blocks are malformed are decoded into silence,
+     * other malformed chunks into an empty chunk */
+    size_t size = frames > 0 ? frames * sizeof(int16_t) * chunk->format->channels : 0;
+    struct sas_chunk *decoded = format ? sas_chunk_alloc_size(format, size) : NULL;
+
+    /* Drop the chunk rather than passing it on still encoded */
+    if (!decoded) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    if (frames > 0 && sas_codec_lossless_decode(chunk->buffer, chunk->size, format->channels,
+                                                (int16_t *) decoded->buffer) < 0) {
+        memset(decoded->buffer, 0, size);
+    }
+
+    sas_chunk_dealloc(chunk);
+    return decoded;
+}
+
+static struct rxc_flow * encoder(void)
+{
+    return rxc_flow_map(encode);
+}
+
+static struct rxc_flow * decoder(void)
+{
+    return rxc_flow_map(decode);
+}
+
+const struct sas_codec sas_codec_lossless = {
+    .id = SAS_CODEC_LOSSLESS,
+    .name = "lossless",
+    .supports = supports,
+    .independent = 1,
+    .encoder = encoder,
+    .decoder = decoder,
+};
@@ -0,0 +1,328 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <opus.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+
+#include <sas/chunk.h>
+#include <sas/codecs/opus.h>
+
+/**
+ * The maximum size of a single Opus frame in bytes.
+ */
+#define MAX_FRAME_BYTES 1275
+
+/**
+ * The state of an encoder or decoder of a single stream, which is created
+ * lazily once the format of the stream is known.
+ */
+struct opus_state {
+    OpusEncoder *encoder;
+    OpusDecoder *decoder;
+
+    int32_t sample_rate;
+    int8_t channels;
+
+    /* The amount of frames in an Opus frame */
+    int frame;
+
+    /* The frames that did not fill up an Opus frame yet */
+    int16_t *pending;
+    int count;
+
+    /* The format of the encoded chunks */
+    const struct sas_format *format;
+};
+
+static int supports(int32_t sample_rate, int8_t sample_size, int8_t channels)
+{
+    switch (sample_rate) {
+        case 8000:
+        case 12000:
+        case 16000:
+        case 24000:
+        case 48000:
+            return sample_size == 16 && channels >= 1 && channels <= 2;
+        default:
+            return 0;
+    }
+}
+
+static void * state_create(void *ctx)
+{
+    return calloc(1, sizeof(struct opus_state));
+}
+
+static void state_reset(struct opus_state *state)
+{
+    if (state->encoder) {
+        opus_encoder_destroy(state->encoder);
+    }
+
+    if (state->decoder) {
+        opus_decoder_destroy(state->decoder);
+    }
+
+    free(state->pending);
+    memset(state, 0, sizeof(struct opus_state));
+}
+
+static void state_dealloc(void *state)
+{
+    state_reset(state);
+    free(state);
+}
+
+/**
+ * Prepare the state for the format of the specified chunk, which returns
+ * <code>0</code> if the state can be used.
+ */
+static int state_prepare(struct opus_state *state, const struct sas_chunk *chunk, int encoder)
+{
+    int err;
+
+    if ((encoder ? (void *) state->encoder : (void *) state->decoder) &&
+        state->sample_rate == chunk->format->sample_rate &&
+        state->channels == chunk->format->channels) {
+        return 0;
+    }
+
+    state_reset(state);
+    state->sample_rate = chunk->format->sample_rate;
+    state->channels = chunk->format->channels;
+    state->frame = state->sample_rate / 1000 * SAS_CODEC_OPUS_FRAME_MS;
+
+    if (encoder) {
+        state->pending = malloc(sizeof(int16_t) * state->frame * state->channels);
+        state->encoder = opus_encoder_create(state->sample_rate, state->channels,
+                                             OPUS_APPLICATION_AUDIO, &err);
+
+        if (!state->pending || !state->encoder) {
+            state_reset(state);
+            return -1;
+        }
+
+        opus_encoder_ctl(state->encoder, OPUS_SET_BITRATE(SAS_CODEC_OPUS_BITRATE));
+    } else {
+        state->decoder = opus_decoder_create(state->sample_rate, state->channels, &err);
+
+        if (!state->decoder) {
+            state_reset(state);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Encode a single Opus frame and prefix it with its size, which returns the
+ * amount of bytes written.
+ */
+static size_t frame_encode(struct opus_state *state, const int16_t *pcm, uint8_t *out)
+{
+    opus_int32 size = opus_encode(state->encoder, pcm, state->frame, &out[2], MAX_FRAME_BYTES);
+
+    /* Drop frames that could not be encoded */
+    if (size <= 0) {
+        return 0;
+    }
+
+    out[0] = (uint8_t) size;
+    out[1] = (uint8_t) (size >> 8);
+    return 2 + size;
+}
+
+static void * encode(void *state_ptr, void *element)
+{
+    struct opus_state *state = state_ptr;
+    struct sas_chunk *chunk = element;
+    const struct sas_format *format = chunk->format;
+
+    /* Chunks from the cache are encoded already */
+    if (format->codec == SAS_CODEC_OPUS) {
+        return chunk;
+    }
+
+    /* The client decodes every chunk with the negotiated codec, so chunks
+     * that cannot be encoded are dropped rather than sent raw */
+    if (format->codec != SAS_CODEC_NONE ||
+        !supports(format->sample_rate, format->sample_size, format->channels)) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    struct sas_chunk *interleaved = sas_chunk_layout(chunk, SAS_LAYOUT_INTERLEAVED);
+
+    if (!interleaved) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    chunk = interleaved;
+
+    if (!(format = sas_format_with_codec(chunk->format, SAS_CODEC_OPUS)) ||
+        state_prepare(state, chunk, 1) < 0) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    state->format = format;
+
+    int channels = format->channels;
+    size_t frames = chunk->size / (sizeof(int16_t) * channels);
+    size_t count = (state->count + frames) / state->frame;
+    struct sas_chunk *encoded = NULL;
+
+    /* Chunks that do not complete a frame are only buffered */
+    if (count > 0) {
+        if (!(encoded = sas_chunk_alloc_size(format, count * (2 + MAX_FRAME_BYTES)))) {
+            sas_chunk_dealloc(chunk);
+            return NULL;
+        }
+
+        encoded->size = 0;
+    }
+
+    const int16_t *pcm = (const int16_t *) chunk->buffer;
+
+    while (frames > 0) {
+        /* Encode straight from the chunk while no frames are pending */
+        if (state->count == 0 && frames >= (size_t) state->frame) {
+            encoded->size += frame_encode(state, pcm, &encoded->buffer[encoded->size]);
+            pcm += state->frame * channels;
+            frames -= state->frame;
+            continue;
+        }
+
+        size_t n = state->frame - state->count;
+        n = n < frames ? n : frames;
+
+        memcpy(&state->pending[state->count * channels], pcm, n * channels * sizeof(int16_t));
+        state->count += n;
+        pcm += n * channels;
+        frames -= n;
+
+        if (state->count == state->frame) {
+            encoded->size += frame_encode(state, state->pending, &encoded->buffer[encoded->size]);
+            state->count = 0;
+        }
+    }
+
+    sas_chunk_dealloc(chunk);
+
+    /* Drop the chunk if none of its frames could be encoded */
+    if (encoded && encoded->size == 0) {
+        sas_chunk_dealloc(encoded);
+        return NULL;
+    }
+
+    return encoded;
+}
+
+/**
+ * Encode the frames that are still pending at the end of the stream, padded
+ * with silence up to a full Opus frame.
+ */
+static void * encode_flush(void *state_ptr)
+{
+    struct opus_state *state = state_ptr;
+    struct sas_chunk *encoded;
+
+    if (!state->encoder || state->count == 0) {
+        return NULL;
+    }
+
+    if (!(encoded = sas_chunk_alloc_size(state->format, 2 + MAX_FRAME_BYTES))) {
+        return NULL;
+    }
+
+    memset(&state->pending[state->count * state->channels], 0,
+           (state->frame - state->count) * state->channels * sizeof(int16_t));
+    encoded->size = frame_encode(state, state->pending, encoded->buffer);
+    state->count = 0;
+
+    if (encoded->size == 0) {
+        sas_chunk_dealloc(encoded);
+        return NULL;
+    }
+
+    return encoded;
+}
+
+static void * decode(void *state_ptr, void *element)
+{
+    struct opus_state *state = state_ptr;
+    struct sas_chunk *chunk = element;
+    const struct sas_format *format = sas_format_with_codec(chunk->format, SAS_CODEC_NONE);
+    int channels = chunk->format->channels;
+    size_t count = 0;
+    size_t offset = 0;
+
+    /* Count the frames in the chunk, where malformed chunks are decoded into
+     * an empty chunk and frames that fail to decode into silence */
+    while (offset + 2 <= chunk->size) {
+        size_t length = chunk->buffer[offset] | chunk->buffer[offset + 1] << 8;
+
+        if (length == 0 || length > chunk->size - offset - 2) {
+            break;
+        }
+
+        offset += 2 + length;
+        count++;
+    }
+
+    if (offset != chunk->size || !supports(chunk->format->sample_rate, 16, channels) ||
+        state_prepare(state, chunk, 0) < 0) {
+        count = 0;
+    }
+
+    size_t samples = count * state->frame * channels;
+    struct sas_chunk *decoded;
+
+    /* Drop the chunk rather than passing it on still encoded */
+    if (!format || !(decoded = sas_chunk_alloc_size(format, samples * sizeof(int16_t)))) {
+        sas_chunk_dealloc(chunk);
+        return NULL;
+    }
+
+    int16_t *pcm = (int16_t *) decoded->buffer;
+    offset = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t length = chunk->buffer[offset] | chunk->buffer[offset + 1] << 8;
+
+        if (opus_decode(state->decoder, &chunk->buffer[offset + 2], (opus_int32) length,
+                        pcm, state->frame, 0) != state->frame) {
+            memset(pcm, 0, state->frame * channels * sizeof(int16_t));
+        }
+
+        offset += 2 + length;
+        pcm += state->frame * channels;
+    }
+
+    sas_chunk_dealloc(chunk);
+    return decoded;
+}
+
+static struct rxc_flow * encoder(void)
+{
+    return rxc_flow_map_state_flush(state_create, encode, encode_flush, state_dealloc, NULL);
+}
+
+static struct rxc_flow * decoder(void)
+{
+    return rxc_flow_map_state(state_create, decode, state_dealloc, NULL);
+}
+
+const struct sas_codec sas_codec_opus = {
+    .id = SAS_CODEC_OPUS,
+    .name = "opus",
+    .supports = supports,
+    .independent = 0,
+    .encoder = encoder,
+    .decoder = decoder,
+};
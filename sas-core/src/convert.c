@@ -0,0 +1,924 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+
+#include <sas/chunk.h>
+#include <sas/codec.h>
+#include <sas/cpu.h>
+#include <sas/convert.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SAS_CONVERT_SIMD 1
+#endif
+
+/**
+ * The amount of samples that are converted at once. Samples are converted
+ * through 32-bit integers that are scaled to their full range, so that every
+ * format only needs a kernel to and from this intermediate format.
+ */
+#define BLOCK 256
+
+/* The scale of floating point samples in the intermediate format, and the
+ * largest float below it, since the scale itself does not fit */
+#define F32_SCALE 2147483648.0f
+#define F32_MAX 2147483520.0f
+
+/* The levels of instructions the kernels are implemented with */
+#define ISA_AVX512 0
+#define ISA_AVX2   1
+#define ISA_SSE2   2
+#define ISA_SCALAR 3
+#define ISA_COUNT  4
+
+/**
+ * A kernel that converts samples into the intermediate format, which returns
+ * the amount of samples it converted.
+ */
+typedef size_t (*decoder)(const void *in, int32_t *out, size_t count);
+
+/**
+ * A kernel that converts samples from the intermediate format, which returns
+ * the amount of samples it converted. The dither of sample <code>i</code> is
+ * derived from <code>seed + i</code>.
+ */
+typedef size_t (*encoder)(const int32_t *in, void *out, size_t count, uint32_t seed,
+                          int dithered);
+
+size_t sas_convert_size(int format)
+{
+    switch (format) {
+        case SAS_SAMPLE_U8:
+            return 1;
+        case SAS_SAMPLE_S16:
+            return 2;
+        case SAS_SAMPLE_S24:
+            return 3;
+        case SAS_SAMPLE_S32:
+        case SAS_SAMPLE_F32:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+int sas_convert_integer_format(int sample_size)
+{
+    switch (sample_size) {
+        case 8:
+            return SAS_SAMPLE_U8;
+        case 16:
+            return SAS_SAMPLE_S16;
+        case 24:
+            return SAS_SAMPLE_S24;
+        case 32:
+            return SAS_SAMPLE_S32;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Hash a counter into uniformly distributed bits.
+ *
+ * This function is based on the lowbias32 hash.
+ * See https://nullprogram.com/blog/2018/07/31/
+ */
+static inline uint32_t hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * Derive triangular dither of one least significant bit of a format whose
+ * samples are the intermediate samples shifted right by <code>shift</code>
+ * from the difference of two uniform 16-bit values.
+ */
+static inline int32_t tpdf(uint32_t h, int shift)
+{
+    int32_t d = (int32_t) (h & 0xffff) - (int32_t) (h >> 16);
+    return shift >= 16 ? d * (1 << (shift - 16)) : d >> (16 - shift);
+}
+
+/**
+ * Shift an intermediate sample right after adding the specified offset,
+ * without overflowing.
+ */
+static inline int32_t requantize(int32_t x, int shift, int32_t offset)
+{
+    return (x >> shift) + (((x & ((1 << shift) - 1)) + offset) >> shift);
+}
+
+static inline int32_t quantize(int32_t x, int shift, uint32_t counter, int dithered)
+{
+    int32_t offset = (1 << (shift - 1)) + (dithered ? tpdf(hash(counter), shift) : 0);
+    int32_t y = requantize(x, shift, offset);
+    int32_t max = (int32_t) (0x7fffffffu >> shift);
+
+    return y > max ? max : (y < -max - 1 ? -max - 1 : y);
+}
+
+/* Scalar kernels */
+static size_t decode_u8_scalar(const void *in, int32_t *out, size_t count)
+{
+    const uint8_t *src = in;
+
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (int32_t) ((uint32_t) (src[i] ^ 0x80) << 24);
+    }
+
+    return count;
+}
+
+static size_t decode_s16_scalar(const void *in, int32_t *out, size_t count)
+{
+    const int16_t *src = in;
+
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (int32_t) ((uint32_t) (uint16_t) src[i] << 16);
+    }
+
+    return count;
+}
+
+static size_t decode_s24_scalar(const void *in, int32_t *out, size_t count)
+{
+    const uint8_t *src = in;
+
+    for (size_t i = 0; i < count; i++, src += 3) {
+        out[i] = (int32_t) ((uint32_t) src[0] << 8 | (uint32_t) src[1] << 16 |
+                            (uint32_t) src[2] << 24);
+    }
+
+    return count;
+}
+
+static size_t decode_s32_scalar(const void *in, int32_t *out, size_t count)
+{
+    memcpy(out, in, count * sizeof(int32_t));
+    return count;
+}
+
+static size_t decode_f32_scalar(const void *in, int32_t *out, size_t count)
+{
+    const float *src = in;
+
+    for (size_t i = 0; i < count; i++) {
+        float x = src[i] * F32_SCALE;
+
+        /* Clip the sample, where NaN becomes the lowest value like the vector
+         * instructions do */
+        if (!(x > -F32_SCALE)) {
+            x = -F32_SCALE;
+        } else if (x > F32_MAX) {
+            x = F32_MAX;
+        }
+
+        out[i] = (int32_t) lrintf(x);
+    }
+
+    return count;
+}
+
+static size_t encode_u8_scalar(const int32_t *in, void *out, size_t count, uint32_t seed,
+                               int dithered)
+{
+    uint8_t *dst = out;
+
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = (uint8_t) (quantize(in[i], 24, seed + i, dithered) + 128);
+    }
+
+    return count;
+}
+
+static size_t encode_s16_scalar(const int32_t *in, void *out, size_t count, uint32_t seed,
+                                int dithered)
+{
+    int16_t *dst = out;
+
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = (int16_t) quantize(in[i], 16, seed + i, dithered);
+    }
+
+    return count;
+}
+
+static size_t encode_s24_scalar(const int32_t *in, void *out, size_t count, uint32_t seed,
+                                int dithered)
+{
+    uint8_t *dst = out;
+
+    for (size_t i = 0; i < count; i++, dst += 3) {
+        uint32_t y = (uint32_t) quantize(in[i], 8, seed + i, dithered);
+
+        dst[0] = (uint8_t) y;
+        dst[1] = (uint8_t) (y >> 8);
+        dst[2] = (uint8_t) (y >> 16);
+    }
+
+    return count;
+}
+
+static size_t encode_s32_scalar(const int32_t *in, void *out, size_t count, uint32_t seed,
+                                int dithered)
+{
+    memcpy(out, in, count * sizeof(int32_t));
+    return count;
+}
+
+static size_t encode_f32_scalar(const int32_t *in, void *out, size_t count, uint32_t seed,
+                                int dithered)
+{
+    float *dst = out;
+
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = (float) in[i] * (1.0f / F32_SCALE);
+    }
+
+    return count;
+}
+
+#ifdef SAS_CONVERT_SIMD
+/* SSE2 kernels, which process four samples per vector */
+static inline __m128i mullo_sse2(__m128i a, __m128i b)
+{
+    /* SSE2 only multiplies the even lanes */
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i offset_sse2(uint32_t counter, int shift, int dithered)
+{
+    __m128i round = _mm_set1_epi32(1 << (shift - 1));
+
+    if (!dithered) {
+        return round;
+    }
+
+    __m128i x = _mm_add_epi32(_mm_set1_epi32((int) counter), _mm_setr_epi32(0, 1, 2, 3));
+
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+    x = mullo_sse2(x, _mm_set1_epi32(0x7feb352d));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+    x = mullo_sse2(x, _mm_set1_epi32((int) 0x846ca68bu));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+
+    __m128i d = _mm_sub_epi32(_mm_and_si128(x, _mm_set1_epi32(0xffff)), _mm_srli_epi32(x, 16));
+
+    d = shift >= 16 ? _mm_sll_epi32(d, _mm_cvtsi32_si128(shift - 16))
+                    : _mm_sra_epi32(d, _mm_cvtsi32_si128(16 - shift));
+    return _mm_add_epi32(round, d);
+}
+
+static inline __m128i requantize_sse2(__m128i x, int shift, __m128i offset)
+{
+    __m128i count = _mm_cvtsi32_si128(shift);
+    __m128i low = _mm_and_si128(x, _mm_set1_epi32((1 << shift) - 1));
+
+    return _mm_add_epi32(_mm_sra_epi32(x, count), _mm_sra_epi32(_mm_add_epi32(low, offset), count));
+}
+
+static size_t decode_u8_sse2(const void *in, int32_t *out, size_t count)
+{
+    const uint8_t *src = in;
+    const __m128i sign = _mm_set1_epi8((char) 0x80);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *) &src[i]), sign);
+        __m128i lo = _mm_unpacklo_epi8(zero, x);
+        __m128i hi = _mm_unpackhi_epi8(zero, x);
+
+        _mm_storeu_si128((__m128i *) &out[i], _mm_unpacklo_epi16(zero, lo));
+        _mm_storeu_si128((__m128i *) &out[i + 4], _mm_unpackhi_epi16(zero, lo));
+        _mm_storeu_si128((__m128i *) &out[i + 8], _mm_unpacklo_epi16(zero, hi));
+        _mm_storeu_si128((__m128i *) &out[i + 12], _mm_unpackhi_epi16(zero, hi));
+    }
+
+    return i;
+}
+
+static size_t decode_s16_sse2(const void *in, int32_t *out, size_t count)
+{
+    const int16_t *src = in;
+    const __m128i zero = _mm_setzero_si128();
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *) &src[i]);
+
+        _mm_storeu_si128((__m128i *) &out[i], _mm_unpacklo_epi16(zero, x));
+        _mm_storeu_si128((__m128i *) &out[i + 4], _mm_unpackhi_epi16(zero, x));
+    }
+
+    return i;
+}
+
+static size_t decode_f32_sse2(const void *in, int32_t *out, size_t count)
+{
+    const float *src = in;
+    const __m128 scale = _mm_set1_ps(F32_SCALE);
+    const __m128 min = _mm_set1_ps(-F32_SCALE);
+    const __m128 max = _mm_set1_ps(F32_MAX);
+    size_t i;
+
+    for (i = 0; i + 4 <= count; i += 4) {
+        __m128 x = _mm_mul_ps(_mm_loadu_ps(&src[i]), scale);
+
+        /* The maximum picks the second operand if the sample is NaN */
+        x = _mm_min_ps(_mm_max_ps(x, min), max);
+        _mm_storeu_si128((__m128i *) &out[i], _mm_cvtps_epi32(x));
+    }
+
+    return i;
+}
+
+static size_t encode_u8_sse2(const int32_t *in, void *out, size_t count, uint32_t seed,
+                             int dithered)
+{
+    uint8_t *dst = out;
+    const __m128i sign = _mm_set1_epi8((char) 0x80);
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m128i y[4];
+
+        for (int k = 0; k < 4; k++) {
+            __m128i x = _mm_loadu_si128((const __m128i *) &in[i + 4 * k]);
+            y[k] = requantize_sse2(x, 24, offset_sse2(seed + i + 4 * k, 24, dithered));
+        }
+
+        /* The packs saturate the samples */
+        __m128i packed = _mm_packs_epi16(_mm_packs_epi32(y[0], y[1]), _mm_packs_epi32(y[2], y[3]));
+        _mm_storeu_si128((__m128i *) &dst[i], _mm_xor_si128(packed, sign));
+    }
+
+    return i;
+}
+
+static size_t encode_s16_sse2(const int32_t *in, void *out, size_t count, uint32_t seed,
+                              int dithered)
+{
+    int16_t *dst = out;
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *) &in[i]);
+        __m128i b = _mm_loadu_si128((const __m128i *) &in[i + 4]);
+
+        a = requantize_sse2(a, 16, offset_sse2(seed + i, 16, dithered));
+        b = requantize_sse2(b, 16, offset_sse2(seed + i + 4, 16, dithered));
+        _mm_storeu_si128((__m128i *) &dst[i], _mm_packs_epi32(a, b));
+    }
+
+    return i;
+}
+
+static size_t encode_f32_sse2(const int32_t *in, void *out, size_t count, uint32_t seed,
+                              int dithered)
+{
+    float *dst = out;
+    const __m128 scale = _mm_set1_ps(1.0f / F32_SCALE);
+    size_t i;
+
+    for (i = 0; i + 4 <= count; i += 4) {
+        __m128 x = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) &in[i]));
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(x, scale));
+    }
+
+    return i;
+}
+
+/* AVX2 kernels, which process eight samples per vector */
+__attribute__((target("avx2")))
+static inline __m256i offset_avx2(uint32_t counter, int shift, int dithered)
+{
+    __m256i round = _mm256_set1_epi32(1 << (shift - 1));
+
+    if (!dithered) {
+        return round;
+    }
+
+    __m256i x = _mm256_add_epi32(_mm256_set1_epi32((int) counter),
+                                 _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int) 0x846ca68bu));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+
+    __m256i d = _mm256_sub_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0xffff)),
+                                 _mm256_srli_epi32(x, 16));
+
+    d = shift >= 16 ? _mm256_sll_epi32(d, _mm_cvtsi32_si128(shift - 16))
+                    : _mm256_sra_epi32(d, _mm_cvtsi32_si128(16 - shift));
+    return _mm256_add_epi32(round, d);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i requantize_avx2(__m256i x, int shift, __m256i offset)
+{
+    __m128i count = _mm_cvtsi32_si128(shift);
+    __m256i low = _mm256_and_si256(x, _mm256_set1_epi32((1 << shift) - 1));
+
+    return _mm256_add_epi32(_mm256_sra_epi32(x, count),
+                            _mm256_sra_epi32(_mm256_add_epi32(low, offset), count));
+}
+
+__attribute__((target("avx2")))
+static size_t decode_u8_avx2(const void *in, int32_t *out, size_t count)
+{
+    const uint8_t *src = in;
+    const __m128i sign = _mm_set1_epi8((char) 0x80);
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        __m128i x = _mm_xor_si128(_mm_loadl_epi64((const __m128i *) &src[i]), sign);
+        __m256i y = _mm256_slli_epi32(_mm256_cvtepi8_epi32(x), 24);
+
+        _mm256_storeu_si256((__m256i *) &out[i], y);
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t decode_s16_avx2(const void *in, int32_t *out, size_t count)
+{
+    const int16_t *src = in;
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *) &src[i]);
+        _mm256_storeu_si256((__m256i *) &out[i], _mm256_slli_epi32(_mm256_cvtepi16_epi32(x), 16));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t decode_f32_avx2(const void *in, int32_t *out, size_t count)
+{
+    const float *src = in;
+    const __m256 scale = _mm256_set1_ps(F32_SCALE);
+    const __m256 min = _mm256_set1_ps(-F32_SCALE);
+    const __m256 max = _mm256_set1_ps(F32_MAX);
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_mul_ps(_mm256_loadu_ps(&src[i]), scale);
+
+        x = _mm256_min_ps(_mm256_max_ps(x, min), max);
+        _mm256_storeu_si256((__m256i *) &out[i], _mm256_cvtps_epi32(x));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t encode_u8_avx2(const int32_t *in, void *out, size_t count, uint32_t seed,
+                             int dithered)
+{
+    uint8_t *dst = out;
+    const __m256i sign = _mm256_set1_epi8((char) 0x80);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i;
+
+    for (i = 0; i + 32 <= count; i += 32) {
+        __m256i y[4];
+
+        for (int k = 0; k < 4; k++) {
+            __m256i x = _mm256_loadu_si256((const __m256i *) &in[i + 8 * k]);
+            y[k] = requantize_avx2(x, 24, offset_avx2(seed + i + 8 * k, 24, dithered));
+        }
+
+        /* The packs operate on the 128-bit halves, so restore the order */
+        __m256i packed = _mm256_packs_epi16(_mm256_packs_epi32(y[0], y[1]),
+                                            _mm256_packs_epi32(y[2], y[3]));
+        packed = _mm256_permutevar8x32_epi32(packed, order);
+        _mm256_storeu_si256((__m256i *) &dst[i], _mm256_xor_si256(packed, sign));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t encode_s16_avx2(const int32_t *in, void *out, size_t count, uint32_t seed,
+                              int dithered)
+{
+    int16_t *dst = out;
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) &in[i]);
+        __m256i b = _mm256_loadu_si256((const __m256i *) &in[i + 8]);
+
+        a = requantize_avx2(a, 16, offset_avx2(seed + i, 16, dithered));
+        b = requantize_avx2(b, 16, offset_avx2(seed + i + 8, 16, dithered));
+
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *) &dst[i], packed);
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t encode_f32_avx2(const int32_t *in, void *out, size_t count, uint32_t seed,
+                              int dithered)
+{
+    float *dst = out;
+    const __m256 scale = _mm256_set1_ps(1.0f / F32_SCALE);
+    size_t i;
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *) &in[i]));
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(x, scale));
+    }
+
+    return i;
+}
+
+/* AVX-512 kernels, which process sixteen samples per vector and narrow with
+ * saturation in a single instruction */
+__attribute__((target("avx512f")))
+static inline __m512i offset_avx512(uint32_t counter, int shift, int dithered)
+{
+    __m512i round = _mm512_set1_epi32(1 << (shift - 1));
+
+    if (!dithered) {
+        return round;
+    }
+
+    __m512i x = _mm512_add_epi32(_mm512_set1_epi32((int) counter),
+                                 _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                                   8, 9, 10, 11, 12, 13, 14, 15));
+
+    x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+    x = _mm512_mullo_epi32(x, _mm512_set1_epi32(0x7feb352d));
+    x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 15));
+    x = _mm512_mullo_epi32(x, _mm512_set1_epi32((int) 0x846ca68bu));
+    x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+
+    __m512i d = _mm512_sub_epi32(_mm512_and_si512(x, _mm512_set1_epi32(0xffff)),
+                                 _mm512_srli_epi32(x, 16));
+
+    d = shift >= 16 ? _mm512_sll_epi32(d, _mm_cvtsi32_si128(shift - 16))
+                    : _mm512_sra_epi32(d, _mm_cvtsi32_si128(16 - shift));
+    return _mm512_add_epi32(round, d);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i requantize_avx512(__m512i x, int shift, __m512i offset)
+{
+    __m128i count = _mm_cvtsi32_si128(shift);
+    __m512i low = _mm512_and_si512(x, _mm512_set1_epi32((1 << shift) - 1));
+
+    return _mm512_add_epi32(_mm512_sra_epi32(x, count),
+                            _mm512_sra_epi32(_mm512_add_epi32(low, offset), count));
+}
+
+__attribute__((target("avx512f")))
+static size_t decode_u8_avx512(const void *in, int32_t *out, size_t count)
+{
+    const uint8_t *src = in;
+    const __m128i sign = _mm_set1_epi8((char) 0x80);
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *) &src[i]), sign);
+        _mm512_storeu_si512(&out[i], _mm512_slli_epi32(_mm512_cvtepi8_epi32(x), 24));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t decode_s16_avx512(const void *in, int32_t *out, size_t count)
+{
+    const int16_t *src = in;
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) &src[i]);
+        _mm512_storeu_si512(&out[i], _mm512_slli_epi32(_mm512_cvtepi16_epi32(x), 16));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t decode_f32_avx512(const void *in, int32_t *out, size_t count)
+{
+    const float *src = in;
+    const __m512 scale = _mm512_set1_ps(F32_SCALE);
+    const __m512 min = _mm512_set1_ps(-F32_SCALE);
+    const __m512 max = _mm512_set1_ps(F32_MAX);
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m512 x = _mm512_mul_ps(_mm512_loadu_ps(&src[i]), scale);
+
+        x = _mm512_min_ps(_mm512_max_ps(x, min), max);
+        _mm512_storeu_si512(&out[i], _mm512_cvtps_epi32(x));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t encode_u8_avx512(const int32_t *in, void *out, size_t count, uint32_t seed,
+                               int dithered)
+{
+    uint8_t *dst = out;
+    const __m128i sign = _mm_set1_epi8((char) 0x80);
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m512i x = _mm512_loadu_si512(&in[i]);
+
+        x = requantize_avx512(x, 24, offset_avx512(seed + i, 24, dithered));
+        _mm_storeu_si128((__m128i *) &dst[i], _mm_xor_si128(_mm512_cvtsepi32_epi8(x), sign));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t encode_s16_avx512(const int32_t *in, void *out, size_t count, uint32_t seed,
+                                int dithered)
+{
+    int16_t *dst = out;
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m512i x = _mm512_loadu_si512(&in[i]);
+
+        x = requantize_avx512(x, 16, offset_avx512(seed + i, 16, dithered));
+        _mm256_storeu_si256((__m256i *) &dst[i], _mm512_cvtsepi32_epi16(x));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t encode_f32_avx512(const int32_t *in, void *out, size_t count, uint32_t seed,
+                                int dithered)
+{
+    float *dst = out;
+    const __m512 scale = _mm512_set1_ps(1.0f / F32_SCALE);
+    size_t i;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m512 x = _mm512_cvtepi32_ps(_mm512_loadu_si512(&in[i]));
+        _mm512_storeu_ps(&dst[i], _mm512_mul_ps(x, scale));
+    }
+
+    return i;
+}
+
+#define VECTOR(avx512, avx2, sse2) avx512, avx2, sse2
+#else
+#define VECTOR(avx512, avx2, sse2) NULL, NULL, NULL
+#endif
+
+/**
+ * The kernels of a format for each level of instructions, where missing
+ * vectorized kernels fall back to the scalar kernel.
+ */
+struct kernels {
+    decoder decode[ISA_COUNT];
+    encoder encode[ISA_COUNT];
+};
+
+static const struct kernels kernels[] = {
+    [SAS_SAMPLE_U8] = {
+        { VECTOR(decode_u8_avx512, decode_u8_avx2, decode_u8_sse2), decode_u8_scalar },
+        { VECTOR(encode_u8_avx512, encode_u8_avx2, encode_u8_sse2), encode_u8_scalar },
+    },
+    [SAS_SAMPLE_S16] = {
+        { VECTOR(decode_s16_avx512, decode_s16_avx2, decode_s16_sse2), decode_s16_scalar },
+        { VECTOR(encode_s16_avx512, encode_s16_avx2, encode_s16_sse2), encode_s16_scalar },
+    },
+    [SAS_SAMPLE_S24] = {
+        { NULL, NULL, NULL, decode_s24_scalar },
+        { NULL, NULL, NULL, encode_s24_scalar },
+    },
+    [SAS_SAMPLE_S32] = {
+        { NULL, NULL, NULL, decode_s32_scalar },
+        { NULL, NULL, NULL, encode_s32_scalar },
+    },
+    [SAS_SAMPLE_F32] = {
+        { VECTOR(decode_f32_avx512, decode_f32_avx2, decode_f32_sse2), decode_f32_scalar },
+        { VECTOR(encode_f32_avx512, encode_f32_avx2, encode_f32_sse2), encode_f32_scalar },
+    },
+};
+
+static int isa(void)
+{
+    if (sas_cpu_supports(SAS_CPU_AVX512)) {
+        return ISA_AVX512;
+    } else if (sas_cpu_supports(SAS_CPU_AVX2)) {
+        return ISA_AVX2;
+    } else if (sas_cpu_supports(SAS_CPU_SSE2)) {
+        return ISA_SSE2;
+    }
+
+    return ISA_SCALAR;
+}
+
+/**
+ * Determine the amount of significant bits of a format.
+ */
+static int precision(int format)
+{
+    return format == SAS_SAMPLE_F32 ? 32 : (int) sas_convert_size(format) * 8;
+}
+
+static void decode(int format, int level, const uint8_t *in, int32_t *out, size_t count)
+{
+    const struct kernels *k = &kernels[format];
+    size_t done = k->decode[level] ? k->decode[level](in, out, count) : 0;
+
+    k->decode[ISA_SCALAR](in + done * sas_convert_size(format), out + done, count - done);
+}
+
+static void encode(int format, int level, const int32_t *in, uint8_t *out, size_t count,
+                   uint32_t seed, int dithered)
+{
+    const struct kernels *k = &kernels[format];
+    size_t done = k->encode[level] ? k->encode[level](in, out, count, seed, dithered) : 0;
+
+    k->encode[ISA_SCALAR](in + done, out + done * sas_convert_size(format), count - done,
+                          seed + (uint32_t) done, dithered);
+}
+
+void sas_convert(const void *in, int from, void *out, int to, size_t count,
+                 uint32_t *dither)
+{
+    size_t in_size = sas_convert_size(from);
+    size_t out_size = sas_convert_size(to);
+    uint32_t seed = dither ? *dither : 0;
+    int dithered = dither && precision(from) > precision(to);
+    int level = isa();
+    int32_t block[BLOCK];
+
+    if (!in_size || !out_size) {
+        return;
+    } else if (dither) {
+        *dither = seed + (uint32_t) count;
+    }
+
+    if (from == to) {
+        memcpy(out, in, count * in_size);
+        return;
+    }
+
+    for (size_t offset = 0; offset < count; offset += BLOCK) {
+        size_t n = count - offset < BLOCK ? count - offset : BLOCK;
+        const uint8_t *src = (const uint8_t *) in + offset * in_size;
+        uint8_t *dst = (uint8_t *) out + offset * out_size;
+
+        /* 32-bit integers are in the intermediate format already */
+        if (from == SAS_SAMPLE_S32) {
+            encode(to, level, (const int32_t *) src, dst, n, seed + (uint32_t) offset, dithered);
+        } else if (to == SAS_SAMPLE_S32) {
+            decode(from, level, src, (int32_t *) dst, n);
+        } else {
+            decode(from, level, src, block, n);
+            encode(to, level, block, dst, n, seed + (uint32_t) offset, dithered);
+        }
+    }
+}
+
+/**
+ * A filter that converts chunks into another format.
+ */
+struct convert_filter {
+    struct sas_filter base;
+    int format;
+    int dither;
+};
+
+/**
+ * The state of the filter in a single stream.
+ */
+struct convert_state {
+    const struct convert_filter *filter;
+    uint32_t dither;
+};
+
+static void * state_create(void *ctx)
+{
+    struct convert_state *state = malloc(sizeof(struct convert_state));
+
+    if (!state) {
+        return NULL;
+    }
+
+    state->filter = ctx;
+    state->dither = 0;
+    return state;
+}
+
+static void * convert(void *state_ptr, void *element)
+{
+    struct convert_state *state = state_ptr;
+    const struct convert_filter *filter = state->filter;
+    struct sas_chunk *chunk = element;
+    const struct sas_format *in = chunk->format;
+    int layout = in->layout;
+
+    if (in->codec != SAS_CODEC_NONE || in->sample == filter->format ||
+        !sas_convert_size(in->sample)) {
+        return chunk;
+    }
+
+    /* The dither is applied in interleaved order, so that it does not depend
+     * on the layout or size of the chunks */
+    if (filter->dither && layout == SAS_LAYOUT_PLANAR) {
+        struct sas_chunk *interleaved = sas_chunk_layout(chunk, SAS_LAYOUT_INTERLEAVED);
+
+        if (!interleaved) {
+            return chunk;
+        }
+
+        chunk = interleaved;
+        in = chunk->format;
+    }
+
+    struct sas_format format = *in;
+    format.sample = (uint8_t) filter->format;
+    format.sample_size = (int8_t) (sas_convert_size(filter->format) * 8);
+
+    const struct sas_format *out = sas_format_intern(&format);
+    size_t frames = sas_chunk_frames(chunk);
+    struct sas_chunk *converted = out ? sas_chunk_alloc(out, frames) : NULL;
+
+    if (!converted) {
+        return chunk;
+    }
+
+    if (in->layout == SAS_LAYOUT_PLANAR) {
+        for (int c = 0; c < in->channels; c++) {
+            sas_convert(sas_chunk_plane(chunk, c), in->sample, sas_chunk_plane(converted, c),
+                        filter->format, frames, NULL);
+        }
+    } else {
+        sas_convert(chunk->buffer, in->sample, converted->buffer, filter->format,
+                    frames * in->channels, filter->dither ? &state->dither : NULL);
+    }
+
+    sas_chunk_dealloc(chunk);
+
+    /* The chunk stays interleaved if it cannot be restored to the layout of
+     * the input, which its format reflects */
+    struct sas_chunk *restored = sas_chunk_layout(converted, layout);
+    return restored ? restored : converted;
+}
+
+static void filter_init(struct sas_filter *filter)
+{
+    filter->flow = rxc_flow_map_state(state_create, convert, free, filter);
+}
+
+static void filter_dealloc(struct sas_filter *filter)
+{
+    free(filter);
+}
+
+struct sas_filter * sas_convert_filter(int format, int dither)
+{
+    struct convert_filter *filter;
+
+    if (!sas_convert_size(format) || !(filter = malloc(sizeof(struct convert_filter)))) {
+        return NULL;
+    }
+
+    filter->base.dealloc = filter_dealloc;
+    filter->base.init = filter_init;
+    filter->base.flow = NULL;
+    filter->base.create_state = NULL;
+    filter->base.process = NULL;
+    filter->base.dealloc_state = NULL;
+    filter->base.flush = NULL;
+    filter->format = format;
+    filter->dither = dither;
+
+    return &filter->base;
+}
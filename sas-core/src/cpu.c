@@ -0,0 +1,52 @@
+#include <stdatomic.h>
+
+#include <sas/cpu.h>
+
+/**
+ * The features of the processor, where a negative value indicates the
+ * features have not been detected yet.
+ */
+static atomic_int features = -1;
+
+static int detect(void)
+{
+    int detected = 0;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse2")) {
+        detected |= SAS_CPU_SSE2;
+    }
+
+    if (__builtin_cpu_supports("avx2")) {
+        detected |= SAS_CPU_AVX2;
+    }
+
+    if (__builtin_cpu_supports("avx512f")) {
+        detected |= SAS_CPU_AVX512;
+    }
+#endif
+
+    return detected;
+}
+
+int sas_cpu_supports(int mask)
+{
+    int current = atomic_load_explicit(&features, memory_order_relaxed);
+
+    if (current < 0) {
+        int expected = -1;
+        atomic_compare_exchange_strong(&features, &expected, detect());
+        current = atomic_load(&features);
+    }
+
+    return (current & mask) == mask;
+}
+
+void sas_cpu_disable(int mask)
+{
+    /* Make sure the detection does not overwrite the mask afterwards */
+    sas_cpu_supports(0);
+    atomic_fetch_and(&features, ~mask);
+}
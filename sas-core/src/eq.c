@@ -0,0 +1,372 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <sas/chain.h>
+#include <sas/cpu.h>
+#include <sas/eq.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SAS_EQ_SIMD 1
+#endif
+
+/**
+ * The amount of channels the vectorized sections filter at once. The states
+ * of the sections are padded to a multiple of it.
+ */
+#define LANES 4
+
+/**
+ * States of the sections below this magnitude are flushed to zero after
+ * every block, so that decaying tails do not turn into slow denormals.
+ */
+#define DENORMAL 1e-20f
+
+/**
+ * A filter that equalizes chunks.
+ */
+struct eq_filter {
+    struct sas_filter base;
+    size_t count;
+    struct sas_eq_band bands[SAS_EQ_MAX_BANDS];
+};
+
+/**
+ * The coefficients of a biquad section in transposed direct form II,
+ * normalized so that <code>a0</code> is one.
+ */
+struct section {
+    float b0, b1, b2, a1, a2;
+};
+
+/**
+ * The state of the filter in a single stream.
+ */
+struct eq_state {
+    size_t count;
+    struct section sections[SAS_EQ_MAX_BANDS];
+
+    /**
+     * The channels of the stream and the amount of lanes they occupy.
+     */
+    size_t channels;
+    size_t lanes;
+
+    /**
+     * The delay elements of each section, stored per section at a stride of
+     * <code>lanes</code>.
+     */
+    float *z1;
+    float *z2;
+
+    /**
+     * The plane unused lanes write their output to.
+     */
+    float *unused;
+};
+
+/**
+ * Compute the coefficients of a band following the Audio EQ Cookbook by
+ * Robert Bristow-Johnson, which returns <code>0</code> if the band is left
+ * out at the specified sample rate.
+ */
+static int section_design(const struct sas_eq_band *band, int32_t rate, struct section *section)
+{
+    if (band->frequency >= rate / 2.0) {
+        return 0;
+    }
+
+    double a = pow(10, band->gain / 40);
+    double w = 2 * M_PI * band->frequency / rate;
+    double cosw = cos(w);
+    double alpha = sin(w) / (2 * band->q);
+    double shelf = 2 * sqrt(a) * alpha;
+    double b0, b1, b2, a0, a1, a2;
+
+    switch (band->type) {
+        case SAS_EQ_PEAK:
+            b0 = 1 + alpha * a;
+            b1 = -2 * cosw;
+            b2 = 1 - alpha * a;
+            a0 = 1 + alpha / a;
+            a1 = -2 * cosw;
+            a2 = 1 - alpha / a;
+            break;
+        case SAS_EQ_LOW_SHELF:
+            b0 = a * ((a + 1) - (a - 1) * cosw + shelf);
+            b1 = 2 * a * ((a - 1) - (a + 1) * cosw);
+            b2 = a * ((a + 1) - (a - 1) * cosw - shelf);
+            a0 = (a + 1) + (a - 1) * cosw + shelf;
+            a1 = -2 * ((a - 1) + (a + 1) * cosw);
+            a2 = (a + 1) + (a - 1) * cosw - shelf;
+            break;
+        case SAS_EQ_HIGH_SHELF:
+            b0 = a * ((a + 1) + (a - 1) * cosw + shelf);
+            b1 = -2 * a * ((a - 1) + (a + 1) * cosw);
+            b2 = a * ((a + 1) + (a - 1) * cosw - shelf);
+            a0 = (a + 1) - (a - 1) * cosw + shelf;
+            a1 = 2 * ((a - 1) - (a + 1) * cosw);
+            a2 = (a + 1) - (a - 1) * cosw - shelf;
+            break;
+        case SAS_EQ_LOW_PASS:
+            b0 = (1 - cosw) / 2;
+            b1 = 1 - cosw;
+            b2 = (1 - cosw) / 2;
+            a0 = 1 + alpha;
+            a1 = -2 * cosw;
+            a2 = 1 - alpha;
+            break;
+        default:
+            b0 = (1 + cosw) / 2;
+            b1 = -(1 + cosw);
+            b2 = (1 + cosw) / 2;
+            a0 = 1 + alpha;
+            a1 = -2 * cosw;
+            a2 = 1 - alpha;
+            break;
+    }
+
+    section->b0 = (float) (b0 / a0);
+    section->b1 = (float) (b1 / a0);
+    section->b2 = (float) (b2 / a0);
+    section->a1 = (float) (a1 / a0);
+    section->a2 = (float) (a2 / a0);
+    return 1;
+}
+
+/**
+ * Filter the channels starting at <code>first</code> one at a time. The
+ * operations are ordered like in the vectorized sections, so that both produce
+ * identical samples.
+ */
+static void sections_scalar(struct eq_state *state, float *const *planes, size_t frames,
+                            size_t first)
+{
+    for (size_t c = first; c < state->channels; c++) {
+        float *plane = planes[c];
+        float z1[SAS_EQ_MAX_BANDS];
+        float z2[SAS_EQ_MAX_BANDS];
+
+        for (size_t k = 0; k < state->count; k++) {
+            z1[k] = state->z1[k * state->lanes + c];
+            z2[k] = state->z2[k * state->lanes + c];
+        }
+
+        for (size_t i = 0; i < frames; i++) {
+            float x = plane[i];
+
+            for (size_t k = 0; k < state->count; k++) {
+                const struct section *s = &state->sections[k];
+                float y = s->b0 * x + z1[k];
+
+                z1[k] = s->b1 * x - s->a1 * y + z2[k];
+                z2[k] = s->b2 * x - s->a2 * y;
+                x = y;
+            }
+
+            plane[i] = x;
+        }
+
+        for (size_t k = 0; k < state->count; k++) {
+            state->z1[k * state->lanes + c] = z1[k];
+            state->z2[k * state->lanes + c] = z2[k];
+        }
+    }
+}
+
+#ifdef SAS_EQ_SIMD
+/**
+ * Pass a frame of four channels through all sections.
+ */
+static inline __m128 frame_sse2(const struct eq_state *state, __m128 x, __m128 *z1, __m128 *z2)
+{
+    for (size_t k = 0; k < state->count; k++) {
+        const struct section *s = &state->sections[k];
+        __m128 y = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s->b0), x), z1[k]);
+
+        z1[k] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(s->b1), x),
+                                      _mm_mul_ps(_mm_set1_ps(s->a1), y)), z2[k]);
+        z2[k] = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(s->b2), x), _mm_mul_ps(_mm_set1_ps(s->a2), y));
+        x = y;
+    }
+
+    return x;
+}
+
+/**
+ * Filter the channels in groups of four, one channel in every lane, which
+ * returns the amount of channels it handled. Each run of four frames is
+ * transposed from the planes into frames and back.
+ */
+static size_t sections_sse2(struct eq_state *state, float *const *planes, size_t frames)
+{
+    static const float silence[SAS_FILTER_BLOCK] __attribute__((aligned(64)));
+
+    for (size_t g = 0; g < state->channels; g += LANES) {
+        const float *in[LANES];
+        float *out[LANES];
+        __m128 z1[SAS_EQ_MAX_BANDS];
+        __m128 z2[SAS_EQ_MAX_BANDS];
+
+        /* Unused lanes filter silence, so their states remain zero */
+        for (size_t l = 0; l < LANES; l++) {
+            in[l] = g + l < state->channels ? planes[g + l] : silence;
+            out[l] = g + l < state->channels ? planes[g + l] : state->unused;
+        }
+
+        for (size_t k = 0; k < state->count; k++) {
+            z1[k] = _mm_loadu_ps(&state->z1[k * state->lanes + g]);
+            z2[k] = _mm_loadu_ps(&state->z2[k * state->lanes + g]);
+        }
+
+        size_t i = 0;
+
+        for (; i + 4 <= frames; i += 4) {
+            __m128 f0 = _mm_loadu_ps(&in[0][i]);
+            __m128 f1 = _mm_loadu_ps(&in[1][i]);
+            __m128 f2 = _mm_loadu_ps(&in[2][i]);
+            __m128 f3 = _mm_loadu_ps(&in[3][i]);
+
+            _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+            f0 = frame_sse2(state, f0, z1, z2);
+            f1 = frame_sse2(state, f1, z1, z2);
+            f2 = frame_sse2(state, f2, z1, z2);
+            f3 = frame_sse2(state, f3, z1, z2);
+            _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+
+            _mm_storeu_ps(&out[0][i], f0);
+            _mm_storeu_ps(&out[1][i], f1);
+            _mm_storeu_ps(&out[2][i], f2);
+            _mm_storeu_ps(&out[3][i], f3);
+        }
+
+        for (; i < frames; i++) {
+            float y[LANES];
+
+            _mm_storeu_ps(y, frame_sse2(state, _mm_setr_ps(in[0][i], in[1][i], in[2][i], in[3][i]),
+                                        z1, z2));
+
+            for (size_t l = 0; l < LANES; l++) {
+                out[l][i] = y[l];
+            }
+        }
+
+        for (size_t k = 0; k < state->count; k++) {
+            _mm_storeu_ps(&state->z1[k * state->lanes + g], z1[k]);
+            _mm_storeu_ps(&state->z2[k * state->lanes + g], z2[k]);
+        }
+    }
+
+    return state->channels;
+}
+#endif
+
+static void * eq_create_state(struct sas_filter *filter, const struct sas_format *format)
+{
+    struct eq_filter *self = (struct eq_filter *) filter;
+    struct eq_state *state = malloc(sizeof(struct eq_state));
+
+    if (!state) {
+        return NULL;
+    }
+
+    state->count = 0;
+    state->channels = (size_t) format->channels;
+    state->lanes = (state->channels + LANES - 1) / LANES * LANES;
+
+    for (size_t i = 0; i < self->count; i++) {
+        state->count += section_design(&self->bands[i], format->sample_rate,
+                                       &state->sections[state->count]);
+    }
+
+    size_t size = (state->count ? state->count : 1) * state->lanes * sizeof(float);
+
+    state->z1 = calloc(1, size);
+    state->z2 = calloc(1, size);
+    state->unused = malloc(SAS_FILTER_BLOCK * sizeof(float));
+
+    if (!state->z1 || !state->z2 || !state->unused) {
+        free(state->z1);
+        free(state->z2);
+        free(state->unused);
+        free(state);
+        return NULL;
+    }
+
+    return state;
+}
+
+static void eq_process(void *state_ptr, float *const *planes, size_t frames)
+{
+    struct eq_state *state = state_ptr;
+    size_t handled = 0;
+
+#ifdef SAS_EQ_SIMD
+    if (sas_cpu_supports(SAS_CPU_SSE2)) {
+        handled = sections_sse2(state, planes, frames);
+    }
+#endif
+    sections_scalar(state, planes, frames, handled);
+
+    for (size_t i = 0; i < state->count * state->lanes; i++) {
+        if (fabsf(state->z1[i]) < DENORMAL) {
+            state->z1[i] = 0;
+        }
+        if (fabsf(state->z2[i]) < DENORMAL) {
+            state->z2[i] = 0;
+        }
+    }
+}
+
+static void eq_dealloc_state(void *state_ptr)
+{
+    struct eq_state *state = state_ptr;
+
+    free(state->z1);
+    free(state->z2);
+    free(state->unused);
+    free(state);
+}
+
+static void filter_init(struct sas_filter *filter)
+{
+    filter->flow = sas_chain_flow(filter);
+}
+
+static void filter_dealloc(struct sas_filter *filter)
+{
+    free(filter);
+}
+
+struct sas_filter * sas_eq_filter(const struct sas_eq_band *bands, size_t count)
+{
+    struct eq_filter *filter;
+
+    if (count > SAS_EQ_MAX_BANDS) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (bands[i].type < SAS_EQ_PEAK || bands[i].type > SAS_EQ_HIGH_PASS ||
+            !(bands[i].frequency > 0) || !(bands[i].q > 0)) {
+            return NULL;
+        }
+    }
+
+    if (!(filter = malloc(sizeof(struct eq_filter)))) {
+        return NULL;
+    }
+
+    filter->base.dealloc = filter_dealloc;
+    filter->base.init = filter_init;
+    filter->base.flow = NULL;
+    filter->base.create_state = eq_create_state;
+    filter->base.process = eq_process;
+    filter->base.dealloc_state = eq_dealloc_state;
+    filter->base.flush = NULL;
+    filter->count = count;
+    memcpy(filter->bands, bands, count * sizeof(struct sas_eq_band));
+
+    return &filter->base;
+}
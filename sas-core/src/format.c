@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include <sas/format.h>
+
+/**
+ * The amount of buckets of the table of interned formats, of which a process
+ * only uses a few.
+ */
+#define BUCKETS 64
+
+/**
+ * An interned format in the table.
+ */
+struct node {
+    struct sas_format format;
+    struct node *next;
+};
+
+/**
+ * The table of interned formats. Nodes are only ever prepended to a bucket
+ * and never removed, so the buckets can be read without locks.
+ */
+static _Atomic(struct node *) buckets[BUCKETS];
+
+/**
+ * Hash the specified format.
+ *
+ * This function is based on the djb2 algorithm, applied to the fields of the
+ * format rather than bytes, since the structure contains padding.
+ */
+static unsigned long format_hash(const struct sas_format *format)
+{
+    unsigned long fields[] = { (unsigned long) format->sample_rate, (unsigned long) format->sample_size,
+                               (unsigned long) format->channels, format->sample, format->layout,
+                               format->codec };
+    unsigned long hash = 5381;
+
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        hash = ((hash << 5) + hash) ^ fields[i];
+    }
+
+    return hash;
+}
+
+static int format_eq(const struct sas_format *a, const struct sas_format *b)
+{
+    return a->sample_rate == b->sample_rate && a->sample_size == b->sample_size &&
+           a->channels == b->channels && a->sample == b->sample && a->layout == b->layout &&
+           a->codec == b->codec;
+}
+
+const struct sas_format * sas_format_intern(const struct sas_format *format)
+{
+    _Atomic(struct node *) *bucket = &buckets[format_hash(format) % BUCKETS];
+    struct node *head = atomic_load(bucket);
+    struct node *node = NULL;
+
+    while (1) {
+        for (struct node *current = head; current; current = current->next) {
+            if (format_eq(&current->format, format)) {
+                /* Another thread may have interned the format concurrently */
+                free(node);
+                return &current->format;
+            }
+        }
+
+        if (!node && !(node = malloc(sizeof(struct node)))) {
+            return NULL;
+        }
+
+        node->format = *format;
+        node->next = head;
+
+        /* On failure, the head is updated and the bucket is searched again */
+        if (atomic_compare_exchange_weak(bucket, &head, node)) {
+            return &node->format;
+        }
+    }
+}
+
+const struct sas_format * sas_format_with_codec(const struct sas_format *format,
+                                                uint8_t codec)
+{
+    struct sas_format derived = *format;
+
+    if (format->codec == codec) {
+        return format;
+    }
+
+    derived.codec = codec;
+    return sas_format_intern(&derived);
+}
@@ -0,0 +1,266 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <math.h>
+
+#include <sas/chain.h>
+#include <sas/cpu.h>
+#include <sas/gain.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SAS_GAIN_SIMD 1
+#endif
+
+/**
+ * The maximum duration of a ramp in frames, below which the index of each
+ * frame in the ramp is exact as a float.
+ */
+#define MAX_RAMP (1 << 24)
+
+/**
+ * A filter that applies a gain to chunks.
+ */
+struct gain_filter {
+    struct sas_filter base;
+
+    /**
+     * The linear gain the streams ramp towards, which may be changed while
+     * the streams are processed on other threads.
+     */
+    _Atomic float gain;
+
+    /**
+     * The duration of a ramp in milliseconds.
+     */
+    double ramp;
+};
+
+/**
+ * The state of the filter in a single stream.
+ */
+struct gain_state {
+    const struct gain_filter *filter;
+    size_t channels;
+
+    /**
+     * The ramp from <code>start</code> to <code>target</code> over
+     * <code>length</code> frames, of which <code>position</code> frames have
+     * been processed.
+     */
+    float start;
+    float target;
+    float step;
+    size_t length;
+    size_t position;
+
+    /**
+     * The gain of each frame of a block.
+     */
+    float gains[SAS_FILTER_BLOCK];
+};
+
+/**
+ * Fill in the gains of the frames of a ramp starting at frame
+ * <code>offset</code>. The gain of each frame is computed from its index in
+ * the ramp rather than accumulated, so that the ramp does not depend on the
+ * size of the blocks or the kernel.
+ */
+static void ramp_scalar(float *gains, float start, float step, size_t offset, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        gains[i] = start + step * (float) (offset + i + 1);
+    }
+}
+
+static void scale_scalar(float *plane, const float *gains, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        plane[i] = plane[i] * gains[i];
+    }
+}
+
+#ifdef SAS_GAIN_SIMD
+__attribute__((target("avx2")))
+static void ramp_avx2(float *gains, float start, float step, size_t offset, size_t frames)
+{
+    __m256i index = _mm256_add_epi32(_mm256_set1_epi32((int) offset + 1),
+                                     _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    size_t i = 0;
+
+    for (; i + 8 <= frames; i += 8) {
+        __m256 g = _mm256_add_ps(_mm256_set1_ps(start),
+                                 _mm256_mul_ps(_mm256_set1_ps(step), _mm256_cvtepi32_ps(index)));
+
+        _mm256_storeu_ps(&gains[i], g);
+        index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+    }
+
+    ramp_scalar(&gains[i], start, step, offset + i, frames - i);
+}
+
+__attribute__((target("avx2")))
+static void scale_avx2(float *plane, const float *gains, size_t frames)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= frames; i += 8) {
+        _mm256_storeu_ps(&plane[i], _mm256_mul_ps(_mm256_loadu_ps(&plane[i]),
+                                                  _mm256_loadu_ps(&gains[i])));
+    }
+
+    scale_scalar(&plane[i], &gains[i], frames - i);
+}
+
+static void ramp_sse2(float *gains, float start, float step, size_t offset, size_t frames)
+{
+    __m128i index = _mm_add_epi32(_mm_set1_epi32((int) offset + 1), _mm_setr_epi32(0, 1, 2, 3));
+    size_t i = 0;
+
+    for (; i + 4 <= frames; i += 4) {
+        __m128 g = _mm_add_ps(_mm_set1_ps(start),
+                              _mm_mul_ps(_mm_set1_ps(step), _mm_cvtepi32_ps(index)));
+
+        _mm_storeu_ps(&gains[i], g);
+        index = _mm_add_epi32(index, _mm_set1_epi32(4));
+    }
+
+    ramp_scalar(&gains[i], start, step, offset + i, frames - i);
+}
+
+static void scale_sse2(float *plane, const float *gains, size_t frames)
+{
+    size_t i = 0;
+
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_ps(&plane[i], _mm_mul_ps(_mm_loadu_ps(&plane[i]), _mm_loadu_ps(&gains[i])));
+    }
+
+    scale_scalar(&plane[i], &gains[i], frames - i);
+}
+#endif
+
+static void ramp(float *gains, float start, float step, size_t offset, size_t frames)
+{
+#ifdef SAS_GAIN_SIMD
+    if (sas_cpu_supports(SAS_CPU_AVX2)) {
+        ramp_avx2(gains, start, step, offset, frames);
+        return;
+    } else if (sas_cpu_supports(SAS_CPU_SSE2)) {
+        ramp_sse2(gains, start, step, offset, frames);
+        return;
+    }
+#endif
+    ramp_scalar(gains, start, step, offset, frames);
+}
+
+static void scale(float *plane, const float *gains, size_t frames)
+{
+#ifdef SAS_GAIN_SIMD
+    if (sas_cpu_supports(SAS_CPU_AVX2)) {
+        scale_avx2(plane, gains, frames);
+        return;
+    } else if (sas_cpu_supports(SAS_CPU_SSE2)) {
+        scale_sse2(plane, gains, frames);
+        return;
+    }
+#endif
+    scale_scalar(plane, gains, frames);
+}
+
+static void * gain_create_state(struct sas_filter *filter, const struct sas_format *format)
+{
+    struct gain_filter *self = (struct gain_filter *) filter;
+    struct gain_state *state = malloc(sizeof(struct gain_state));
+    float gain = atomic_load_explicit(&self->gain, memory_order_relaxed);
+
+    if (!state) {
+        return NULL;
+    }
+
+    double length = round(self->ramp * format->sample_rate / 1000);
+
+    state->filter = self;
+    state->channels = (size_t) format->channels;
+    state->start = gain;
+    state->target = gain;
+    state->step = 0;
+    state->length = length < 1 ? 1 : length > MAX_RAMP ? MAX_RAMP : (size_t) length;
+    state->position = state->length;
+    return state;
+}
+
+static void gain_process(void *state_ptr, float *const *planes, size_t frames)
+{
+    struct gain_state *state = state_ptr;
+    float gain = atomic_load_explicit(&state->filter->gain, memory_order_relaxed);
+
+    /* Ramp from the current gain towards the new gain */
+    if (gain != state->target) {
+        float current = state->position < state->length ?
+                        state->start + state->step * (float) state->position : state->target;
+
+        state->start = current;
+        state->target = gain;
+        state->step = (state->target - current) / (float) state->length;
+        state->position = 0;
+    }
+
+    if (state->position >= state->length && state->target == 1.0f) {
+        return;
+    }
+
+    /* The last frame of the ramp is at the target exactly */
+    size_t n = state->position + 1 < state->length ? state->length - 1 - state->position : 0;
+    n = n < frames ? n : frames;
+
+    ramp(state->gains, state->start, state->step, state->position, n);
+
+    for (size_t i = n; i < frames; i++) {
+        state->gains[i] = state->target;
+    }
+
+    for (size_t c = 0; c < state->channels; c++) {
+        scale(planes[c], state->gains, frames);
+    }
+
+    size_t remaining = state->length - state->position;
+    state->position += remaining < frames ? remaining : frames;
+}
+
+static void filter_init(struct sas_filter *filter)
+{
+    filter->flow = sas_chain_flow(filter);
+}
+
+static void filter_dealloc(struct sas_filter *filter)
+{
+    free(filter);
+}
+
+struct sas_filter * sas_gain_filter(double gain, double ramp)
+{
+    struct gain_filter *filter = malloc(sizeof(struct gain_filter));
+
+    if (!filter) {
+        return NULL;
+    }
+
+    filter->base.dealloc = filter_dealloc;
+    filter->base.init = filter_init;
+    filter->base.flow = NULL;
+    filter->base.create_state = gain_create_state;
+    filter->base.process = gain_process;
+    filter->base.dealloc_state = free;
+    filter->base.flush = NULL;
+    atomic_init(&filter->gain, (float) pow(10, gain / 20));
+    filter->ramp = ramp > 0 ? ramp : 0;
+
+    return &filter->base;
+}
+
+void sas_gain_set(struct sas_filter *filter, double gain)
+{
+    atomic_store_explicit(&((struct gain_filter *) filter)->gain, (float) pow(10, gain / 20),
+                          memory_order_relaxed);
+}
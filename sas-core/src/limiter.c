@@ -0,0 +1,369 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include <sas/chain.h>
+#include <sas/cpu.h>
+#include <sas/limiter.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SAS_LIMITER_SIMD 1
+#endif
+
+/**
+ * A filter that limits the peaks of chunks.
+ */
+struct limiter_filter {
+    struct sas_filter base;
+    float ceiling;
+    double lookahead;
+    double release;
+};
+
+/**
+ * The state of the filter in a single stream.
+ *
+ * The gain each frame requires to stay below the ceiling is held at its
+ * minimum over the look-ahead window, released exponentially and then
+ * averaged over the window. Since the average of a frame only covers gains at
+ * or below the gain its delayed sample requires, the delayed samples never
+ * exceed the ceiling, while the gain ramps down over the whole window.
+ */
+struct limiter_state {
+    size_t channels;
+    float ceiling;
+    float release;
+
+    /**
+     * The length of the look-ahead in frames.
+     */
+    size_t window;
+
+    /**
+     * The delayed samples of each channel, stored at a stride of
+     * <code>window + SAS_FILTER_BLOCK</code>, followed by the samples of the
+     * current block.
+     */
+    float *delay;
+
+    /**
+     * The minimum of the gains required over the window, as a queue of
+     * increasing gains and the frames they were required at.
+     */
+    float *held;
+    uint64_t *frames;
+    size_t head;
+    size_t length;
+    uint64_t frame;
+
+    /**
+     * The amount of delayed frames that have not been flushed at the end of
+     * the stream.
+     */
+    size_t tail;
+
+    /**
+     * The released envelope and its average over the window.
+     */
+    float envelope;
+    float *history;
+    size_t position;
+    double sum;
+
+    /**
+     * The gain each frame of a block requires and receives.
+     */
+    float required[SAS_FILTER_BLOCK];
+    float gains[SAS_FILTER_BLOCK];
+};
+
+/**
+ * Determine the gain each frame requires from its peak over the channels. The
+ * kernels compare and divide like this function, so that they produce
+ * identical gains.
+ */
+static void detect_scalar(float *const *planes, size_t channels, float ceiling,
+                          float *required, size_t offset, size_t frames)
+{
+    for (size_t i = offset; i < frames; i++) {
+        float peak = 0;
+
+        for (size_t c = 0; c < channels; c++) {
+            float magnitude = fabsf(planes[c][i]);
+            peak = magnitude > peak ? magnitude : peak;
+        }
+
+        required[i] = peak > ceiling ? ceiling / peak : 1.0f;
+    }
+}
+
+static void apply_scalar(float *out, const float *in, const float *gains, size_t offset,
+                         size_t frames)
+{
+    for (size_t i = offset; i < frames; i++) {
+        out[i] = in[i] * gains[i];
+    }
+}
+
+#ifdef SAS_LIMITER_SIMD
+__attribute__((target("avx2")))
+static void detect_avx2(float *const *planes, size_t channels, float ceiling,
+                        float *required, size_t frames)
+{
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 limit = _mm256_set1_ps(ceiling);
+    size_t i = 0;
+
+    for (; i + 8 <= frames; i += 8) {
+        __m256 peak = _mm256_setzero_ps();
+
+        for (size_t c = 0; c < channels; c++) {
+            peak = _mm256_max_ps(_mm256_andnot_ps(sign, _mm256_loadu_ps(&planes[c][i])), peak);
+        }
+
+        __m256 over = _mm256_cmp_ps(peak, limit, _CMP_GT_OQ);
+        __m256 gain = _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_div_ps(limit, peak), over);
+
+        _mm256_storeu_ps(&required[i], gain);
+    }
+
+    detect_scalar(planes, channels, ceiling, required, i, frames);
+}
+
+__attribute__((target("avx2")))
+static void apply_avx2(float *out, const float *in, const float *gains, size_t frames)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= frames; i += 8) {
+        _mm256_storeu_ps(&out[i], _mm256_mul_ps(_mm256_loadu_ps(&in[i]),
+                                                _mm256_loadu_ps(&gains[i])));
+    }
+
+    apply_scalar(out, in, gains, i, frames);
+}
+
+static void detect_sse2(float *const *planes, size_t channels, float ceiling,
+                        float *required, size_t frames)
+{
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 limit = _mm_set1_ps(ceiling);
+    __m128 one = _mm_set1_ps(1.0f);
+    size_t i = 0;
+
+    for (; i + 4 <= frames; i += 4) {
+        __m128 peak = _mm_setzero_ps();
+
+        for (size_t c = 0; c < channels; c++) {
+            peak = _mm_max_ps(_mm_andnot_ps(sign, _mm_loadu_ps(&planes[c][i])), peak);
+        }
+
+        __m128 over = _mm_cmpgt_ps(peak, limit);
+        __m128 gain = _mm_or_ps(_mm_and_ps(over, _mm_div_ps(limit, peak)),
+                                _mm_andnot_ps(over, one));
+
+        _mm_storeu_ps(&required[i], gain);
+    }
+
+    detect_scalar(planes, channels, ceiling, required, i, frames);
+}
+
+static void apply_sse2(float *out, const float *in, const float *gains, size_t frames)
+{
+    size_t i = 0;
+
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_ps(&out[i], _mm_mul_ps(_mm_loadu_ps(&in[i]), _mm_loadu_ps(&gains[i])));
+    }
+
+    apply_scalar(out, in, gains, i, frames);
+}
+#endif
+
+static void detect(float *const *planes, size_t channels, float ceiling, float *required,
+                   size_t frames)
+{
+#ifdef SAS_LIMITER_SIMD
+    if (sas_cpu_supports(SAS_CPU_AVX2)) {
+        detect_avx2(planes, channels, ceiling, required, frames);
+        return;
+    } else if (sas_cpu_supports(SAS_CPU_SSE2)) {
+        detect_sse2(planes, channels, ceiling, required, frames);
+        return;
+    }
+#endif
+    detect_scalar(planes, channels, ceiling, required, 0, frames);
+}
+
+static void apply(float *out, const float *in, const float *gains, size_t frames)
+{
+#ifdef SAS_LIMITER_SIMD
+    if (sas_cpu_supports(SAS_CPU_AVX2)) {
+        apply_avx2(out, in, gains, frames);
+        return;
+    } else if (sas_cpu_supports(SAS_CPU_SSE2)) {
+        apply_sse2(out, in, gains, frames);
+        return;
+    }
+#endif
+    apply_scalar(out, in, gains, 0, frames);
+}
+
+/**
+ * Follow the envelope of the required gains for every frame of a block.
+ */
+static void envelope_follow(struct limiter_state *state, size_t frames)
+{
+    size_t window = state->window;
+    size_t capacity = window + 1;
+
+    for (size_t i = 0; i < frames; i++, state->frame++) {
+        float required = state->required[i];
+
+        /* Hold the minimum over the window and the current frame */
+        if (state->length > 0 && state->frames[state->head] + capacity <= state->frame) {
+            state->head = (state->head + 1) % capacity;
+            state->length--;
+        }
+
+        while (state->length > 0 &&
+               state->held[(state->head + state->length - 1) % capacity] >= required) {
+            state->length--;
+        }
+
+        size_t tail = (state->head + state->length) % capacity;
+
+        state->held[tail] = required;
+        state->frames[tail] = state->frame;
+        state->length++;
+
+        float held = state->held[state->head];
+
+        if (held < state->envelope) {
+            state->envelope = held;
+        } else {
+            state->envelope += (held - state->envelope) * state->release;
+        }
+
+        state->sum += (double) state->envelope - state->history[state->position];
+        state->history[state->position] = state->envelope;
+        state->position = (state->position + 1) % window;
+        state->gains[i] = (float) (state->sum / (double) window);
+    }
+}
+
+static void limiter_dealloc_state(void *state_ptr)
+{
+    struct limiter_state *state = state_ptr;
+
+    free(state->delay);
+    free(state->held);
+    free(state->frames);
+    free(state->history);
+    free(state);
+}
+
+static void * limiter_create_state(struct sas_filter *filter, const struct sas_format *format)
+{
+    struct limiter_filter *self = (struct limiter_filter *) filter;
+    struct limiter_state *state = calloc(1, sizeof(struct limiter_state));
+
+    if (!state) {
+        return NULL;
+    }
+
+    double window = round(self->lookahead * format->sample_rate / 1000);
+    double release = self->release * format->sample_rate / 1000;
+
+    state->channels = (size_t) format->channels;
+    state->ceiling = self->ceiling;
+    state->release = release > 1 ? (float) (1 - exp(-1 / release)) : 1.0f;
+    state->window = window < 1 ? 1 : (size_t) window;
+    state->delay = calloc(state->channels * (state->window + SAS_FILTER_BLOCK), sizeof(float));
+    state->held = malloc((state->window + 1) * sizeof(float));
+    state->frames = malloc((state->window + 1) * sizeof(uint64_t));
+    state->history = malloc(state->window * sizeof(float));
+
+    if (!state->delay || !state->held || !state->frames || !state->history) {
+        limiter_dealloc_state(state);
+        return NULL;
+    }
+
+    state->tail = state->window;
+    state->envelope = 1.0f;
+    state->sum = (double) state->window;
+
+    for (size_t i = 0; i < state->window; i++) {
+        state->history[i] = 1.0f;
+    }
+
+    return state;
+}
+
+static void limiter_process(void *state_ptr, float *const *planes, size_t frames)
+{
+    struct limiter_state *state = state_ptr;
+    size_t stride = state->window + SAS_FILTER_BLOCK;
+
+    detect(planes, state->channels, state->ceiling, state->required, frames);
+    envelope_follow(state, frames);
+
+    for (size_t c = 0; c < state->channels; c++) {
+        float *delay = &state->delay[c * stride];
+
+        memcpy(&delay[state->window], planes[c], frames * sizeof(float));
+        apply(planes[c], delay, state->gains, frames);
+        memmove(delay, &delay[frames], state->window * sizeof(float));
+    }
+}
+
+/**
+ * Push the delayed frames out of the filter with silence.
+ */
+static size_t limiter_flush(void *state_ptr, float *const *planes)
+{
+    struct limiter_state *state = state_ptr;
+    size_t n = state->tail < SAS_FILTER_BLOCK ? state->tail : SAS_FILTER_BLOCK;
+
+    for (size_t c = 0; c < state->channels; c++) {
+        memset(planes[c], 0, n * sizeof(float));
+    }
+
+    limiter_process(state, planes, n);
+    state->tail -= n;
+    return n;
+}
+
+static void filter_init(struct sas_filter *filter)
+{
+    filter->flow = sas_chain_flow(filter);
+}
+
+static void filter_dealloc(struct sas_filter *filter)
+{
+    free(filter);
+}
+
+struct sas_filter * sas_limiter_filter(double ceiling, double lookahead, double release)
+{
+    struct limiter_filter *filter = malloc(sizeof(struct limiter_filter));
+
+    if (!filter) {
+        return NULL;
+    }
+
+    filter->base.dealloc = filter_dealloc;
+    filter->base.init = filter_init;
+    filter->base.flow = NULL;
+    filter->base.create_state = limiter_create_state;
+    filter->base.process = limiter_process;
+    filter->base.dealloc_state = limiter_dealloc_state;
+    filter->base.flush = limiter_flush;
+    filter->ceiling = (float) pow(10, ceiling / 20);
+    filter->lookahead = lookahead > 0 ? lookahead : 0;
+    filter->release = release > 0 ? release : 0;
+
+    return &filter->base;
+}
@@ -0,0 +1,625 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+
+#include <sas/chunk.h>
+#include <sas/codec.h>
+#include <sas/convert.h>
+#include <sas/cpu.h>
+#include <sas/resample.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SAS_RESAMPLE_SIMD 1
+#endif
+
+/**
+ * The amount of taps of each phase when upsampling, which is widened when
+ * downsampling to keep the transition band as narrow relative to the lower
+ * cutoff. The amount of taps is always a multiple of eight, the width of the
+ * vectorized dot product.
+ */
+#define TAPS 64
+#define MAX_TAPS 256
+
+/**
+ * The limits on the size of the filter tables.
+ */
+#define MAX_PHASES 4096
+#define MAX_COEFFICIENTS 65536
+
+/**
+ * The cutoff of the filter relative to the lowest Nyquist frequency, which
+ * leaves room for the transition band, and the shape of the Kaiser window,
+ * which attenuates the stop band by about 80 dB.
+ */
+#define CUTOFF 0.91
+#define KAISER_BETA 8.0
+
+/**
+ * The filter table for a ratio <code>up / down</code>, which holds the
+ * coefficients of each phase <code>p</code> of the output sample between two
+ * input samples at offset <code>p * taps</code>.
+ */
+struct table {
+    struct table *next;
+    int32_t from;
+    size_t up;
+    size_t down;
+    size_t taps;
+    float coefficients[];
+};
+
+/**
+ * A filter that converts chunks to another sample rate.
+ */
+struct resample_filter {
+    struct sas_filter base;
+    int32_t rate;
+
+    /**
+     * The tables computed for the input sample rates that were seen.
+     */
+    struct table *tables;
+};
+
+/**
+ * A dot product over a multiple of eight samples. All implementations sum the
+ * products into eight lanes and reduce them in the same order.
+ */
+typedef float (*dot_product)(const float *x, const float *h, size_t taps);
+
+/**
+ * The state of the filter in a single stream.
+ */
+struct resample_state {
+    struct resample_filter *filter;
+
+    /**
+     * The table of the stream or <code>NULL</code> if the stream has not
+     * started yet.
+     */
+    const struct table *table;
+
+    /**
+     * The dot product selected for the instruction set when the stream
+     * started.
+     */
+    dot_product dot;
+
+    /**
+     * The format of the input chunks of the stream and the interleaved
+     * format of its output chunks.
+     */
+    const struct sas_format *in;
+    const struct sas_format *out;
+
+    /**
+     * The phase of the next output sample and the position of the first input
+     * sample of its window in the history.
+     */
+    size_t phase;
+    size_t position;
+
+    /**
+     * The input samples that are still needed, stored per channel at a
+     * stride of <code>capacity</code>.
+     */
+    float *history;
+    size_t length;
+    size_t capacity;
+
+    /**
+     * The state of the dither of the output samples.
+     */
+    uint32_t dither;
+};
+
+static float dot_scalar(const float *x, const float *h, size_t taps)
+{
+    float acc[8] = { 0 };
+
+    for (size_t k = 0; k < taps; k += 8) {
+        for (int j = 0; j < 8; j++) {
+            acc[j] += x[k + j] * h[k + j];
+        }
+    }
+
+    return ((acc[0] + acc[4]) + (acc[2] + acc[6])) + ((acc[1] + acc[5]) + (acc[3] + acc[7]));
+}
+
+#ifdef SAS_RESAMPLE_SIMD
+static inline float reduce_sse2(__m128 s)
+{
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+static float dot_sse2(const float *x, const float *h, size_t taps)
+{
+    __m128 lo = _mm_setzero_ps();
+    __m128 hi = _mm_setzero_ps();
+
+    for (size_t k = 0; k < taps; k += 8) {
+        lo = _mm_add_ps(lo, _mm_mul_ps(_mm_loadu_ps(&x[k]), _mm_loadu_ps(&h[k])));
+        hi = _mm_add_ps(hi, _mm_mul_ps(_mm_loadu_ps(&x[k + 4]), _mm_loadu_ps(&h[k + 4])));
+    }
+
+    return reduce_sse2(_mm_add_ps(lo, hi));
+}
+
+__attribute__((target("avx2")))
+static float dot_avx2(const float *x, const float *h, size_t taps)
+{
+    __m256 acc = _mm256_setzero_ps();
+
+    for (size_t k = 0; k < taps; k += 8) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(&x[k]), _mm256_loadu_ps(&h[k])));
+    }
+
+    return reduce_sse2(_mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1)));
+}
+#endif
+
+static dot_product dot_select(void)
+{
+#ifdef SAS_RESAMPLE_SIMD
+    if (sas_cpu_supports(SAS_CPU_AVX2)) {
+        return dot_avx2;
+    } else if (sas_cpu_supports(SAS_CPU_SSE2)) {
+        return dot_sse2;
+    }
+#endif
+    return dot_scalar;
+}
+
+static int32_t gcd(int32_t a, int32_t b)
+{
+    while (b) {
+        int32_t t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+static size_t taps_of(size_t up, size_t down)
+{
+    size_t taps = down > up ? (TAPS * down + up - 1) / up : TAPS;
+
+    taps = (taps + 7) & ~(size_t) 7;
+    return taps > MAX_TAPS ? MAX_TAPS : taps;
+}
+
+int sas_resample_supports(int32_t from, int32_t to)
+{
+    if (from <= 0 || to <= 0) {
+        return 0;
+    }
+
+    size_t up = (size_t) (to / gcd(from, to));
+    size_t down = (size_t) (from / gcd(from, to));
+
+    return up <= MAX_PHASES && up * taps_of(up, down) <= MAX_COEFFICIENTS;
+}
+
+/**
+ * Compute the modified Bessel function of the first kind of order zero.
+ */
+static double bessel_i0(double x)
+{
+    double sum = 1, term = 1;
+
+    for (int k = 1; k < 32; k++) {
+        double t = x / (2 * k);
+        term *= t * t;
+        sum += term;
+    }
+
+    return sum;
+}
+
+static struct table * table_create(int32_t from, int32_t to)
+{
+    size_t up = (size_t) (to / gcd(from, to));
+    size_t down = (size_t) (from / gcd(from, to));
+    size_t taps = taps_of(up, down);
+    struct table *table = malloc(sizeof(struct table) + up * taps * sizeof(float));
+
+    if (!table) {
+        return NULL;
+    }
+
+    table->next = NULL;
+    table->from = from;
+    table->up = up;
+    table->down = down;
+    table->taps = taps;
+
+    /* The cutoff relative to the Nyquist frequency of the input */
+    double cutoff = CUTOFF * (up < down ? (double) up / down : 1.0);
+    double half = (double) (taps / 2);
+    double norm = bessel_i0(KAISER_BETA);
+
+    for (size_t p = 0; p < up; p++) {
+        float *h = &table->coefficients[p * taps];
+        double sum = 0;
+
+        for (size_t k = 0; k < taps; k++) {
+            /* The distance of the tap to the output sample in input samples */
+            double x = (double) k - (half - 1) - (double) p / up;
+            double t = x / half;
+            double window = bessel_i0(KAISER_BETA * sqrt(t < 1 ? 1 - t * t : 0)) / norm;
+            double sinc = x == 0 ? 1 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            double v = cutoff * sinc * window;
+
+            h[k] = (float) v;
+            sum += v;
+        }
+
+        /* Normalize each phase to unity gain, so that silence stays silent
+         * and steady signals do not ripple at the rate of the phases */
+        for (size_t k = 0; k < taps; k++) {
+            h[k] = (float) (h[k] / sum);
+        }
+    }
+
+    return table;
+}
+
+/**
+ * Find the table for the specified input sample rate or compute it once.
+ */
+static const struct table * table_find(struct resample_filter *filter, int32_t from)
+{
+    struct table *table = filter->tables;
+
+    while (table && table->from != from) {
+        table = table->next;
+    }
+
+    if (!table && (table = table_create(from, filter->rate))) {
+        table->next = filter->tables;
+        filter->tables = table;
+    }
+
+    return table;
+}
+
+/**
+ * Make room for the specified amount of samples per channel in the history.
+ */
+static int history_reserve(struct resample_state *state, size_t length)
+{
+    if (length <= state->capacity) {
+        return 0;
+    }
+
+    size_t capacity = state->capacity * 2 > length ? state->capacity * 2 : length;
+    float *history = malloc(capacity * state->in->channels * sizeof(float));
+
+    if (!history) {
+        return -1;
+    }
+
+    for (int c = 0; c < state->in->channels && state->history; c++) {
+        memcpy(&history[c * capacity], &state->history[c * state->capacity],
+               state->length * sizeof(float));
+    }
+
+    free(state->history);
+    state->history = history;
+    state->capacity = capacity;
+    return 0;
+}
+
+/**
+ * Start the stream with the configuration of its first chunk.
+ */
+static int state_start(struct resample_state *state, const struct sas_chunk *chunk)
+{
+    const struct table *table = table_find(state->filter, chunk->format->sample_rate);
+    struct sas_format format = *chunk->format;
+
+    format.sample_rate = state->filter->rate;
+    format.layout = SAS_LAYOUT_INTERLEAVED;
+
+    if (!table || !(state->out = sas_format_intern(&format))) {
+        return -1;
+    }
+
+    state->table = table;
+    state->dot = dot_select();
+    state->in = chunk->format;
+
+    if (history_reserve(state, table->taps * 4) != 0) {
+        state->table = NULL;
+        return -1;
+    }
+
+    /* Prime the history with silence, so that the first output sample is
+     * centered on the first input sample */
+    state->length = table->taps / 2 - 1;
+
+    for (int c = 0; c < state->in->channels; c++) {
+        memset(&state->history[c * state->capacity], 0, state->length * sizeof(float));
+    }
+
+    return 0;
+}
+
+static void * state_create(void *ctx)
+{
+    struct resample_state *state = malloc(sizeof(struct resample_state));
+
+    if (!state) {
+        return NULL;
+    }
+
+    state->filter = ctx;
+    state->table = NULL;
+    state->dot = NULL;
+    state->in = NULL;
+    state->out = NULL;
+    state->phase = 0;
+    state->position = 0;
+    state->history = NULL;
+    state->length = 0;
+    state->capacity = 0;
+    state->dither = 0;
+    return state;
+}
+
+static void state_dealloc(void *state_ptr)
+{
+    struct resample_state *state = state_ptr;
+
+    free(state->history);
+    free(state);
+}
+
+/**
+ * Append the samples of a chunk to the history of each channel. The planes of
+ * planar chunks are converted into the history directly.
+ */
+static int history_append(struct resample_state *state, const struct sas_chunk *chunk,
+                          size_t frames)
+{
+    const struct sas_format *format = chunk->format;
+    size_t channels = (size_t) format->channels;
+
+    if (history_reserve(state, state->length + frames) != 0) {
+        return -1;
+    }
+
+    if (format->layout == SAS_LAYOUT_PLANAR) {
+        for (size_t c = 0; c < channels; c++) {
+            sas_convert(sas_chunk_plane(chunk, (int) c), format->sample,
+                        &state->history[c * state->capacity + state->length], SAS_SAMPLE_F32,
+                        frames, NULL);
+        }
+
+        state->length += frames;
+        return 0;
+    }
+
+    float *samples = malloc(frames * channels * sizeof(float));
+
+    if (!samples) {
+        return -1;
+    }
+
+    sas_convert(chunk->buffer, format->sample, samples, SAS_SAMPLE_F32, frames * channels, NULL);
+
+    for (size_t c = 0; c < channels; c++) {
+        float *plane = &state->history[c * state->capacity + state->length];
+
+        for (size_t i = 0; i < frames; i++) {
+            plane[i] = samples[i * channels + c];
+        }
+    }
+
+    free(samples);
+    state->length += frames;
+    return 0;
+}
+
+/**
+ * Determine the amount of output frames the history yields.
+ */
+static size_t output_frames(const struct resample_state *state)
+{
+    const struct table *table = state->table;
+    size_t phase = state->phase;
+    size_t position = state->position;
+    size_t n = 0;
+
+    while (position + table->taps <= state->length) {
+        n++;
+        phase += table->down;
+        position += phase / table->up;
+        phase %= table->up;
+    }
+
+    return n;
+}
+
+/**
+ * Filter the output frames the history yields into an interleaved chunk and
+ * drop the samples they no longer need from the history.
+ */
+static struct sas_chunk * history_filter(struct resample_state *state)
+{
+    const struct table *table = state->table;
+    dot_product dot = state->dot;
+    size_t channels = (size_t) state->in->channels;
+    size_t n = output_frames(state);
+    float *out = malloc((n ? n : 1) * channels * sizeof(float));
+    struct sas_chunk *resampled = sas_chunk_alloc(state->out, n);
+
+    if (!out || !resampled) {
+        free(out);
+
+        if (resampled) {
+            sas_chunk_dealloc(resampled);
+        }
+
+        return NULL;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        const float *h = &table->coefficients[state->phase * table->taps];
+
+        for (size_t c = 0; c < channels; c++) {
+            out[i * channels + c] = dot(&state->history[c * state->capacity + state->position],
+                                        h, table->taps);
+        }
+
+        state->phase += table->down;
+        state->position += state->phase / table->up;
+        state->phase %= table->up;
+    }
+
+    /* Keep the samples the next output frames need */
+    if (state->position > 0) {
+        size_t keep = state->position < state->length ? state->length - state->position : 0;
+
+        for (size_t c = 0; c < channels; c++) {
+            float *plane = &state->history[c * state->capacity];
+            memmove(plane, &plane[state->position], keep * sizeof(float));
+        }
+
+        state->position -= state->length - keep;
+        state->length = keep;
+    }
+
+    /* The output is dithered in interleaved order, so that it does not depend
+     * on the layout or size of the chunks */
+    sas_convert(out, SAS_SAMPLE_F32, resampled->buffer, state->in->sample, n * channels,
+                &state->dither);
+
+    free(out);
+    return resampled;
+}
+
+/**
+ * Return an output chunk in the layout of the input. The chunk stays
+ * interleaved if it cannot be restored to the layout of the input, which its
+ * format reflects.
+ */
+static struct sas_chunk * output_layout(struct resample_state *state,
+                                        struct sas_chunk *resampled)
+{
+    struct sas_chunk *restored = sas_chunk_layout(resampled, state->in->layout);
+    return restored ? restored : resampled;
+}
+
+static void * resample(void *state_ptr, void *element)
+{
+    struct resample_state *state = state_ptr;
+    struct sas_chunk *chunk = element;
+    const struct sas_format *format = chunk->format;
+    struct sas_chunk *resampled;
+
+    if (format->codec != SAS_CODEC_NONE || format->sample_rate == state->filter->rate ||
+        !sas_convert_size(format->sample) || format->channels <= 0 ||
+        !sas_resample_supports(format->sample_rate, state->filter->rate)) {
+        return chunk;
+    } else if (!state->table && state_start(state, chunk) != 0) {
+        return chunk;
+    } else if (format != state->in) {
+        /* The configuration of a stream does not change */
+        return chunk;
+    }
+
+    if (history_append(state, chunk, sas_chunk_frames(chunk)) != 0 ||
+        !(resampled = history_filter(state))) {
+        return chunk;
+    }
+
+    sas_chunk_dealloc(chunk);
+    return output_layout(state, resampled);
+}
+
+/**
+ * Pad the history with silence at the end of the stream, which yields the
+ * output frames up to the last input frame.
+ */
+static void * resample_flush(void *state_ptr)
+{
+    struct resample_state *state = state_ptr;
+    struct sas_chunk *resampled;
+
+    if (!state->table) {
+        return NULL;
+    }
+
+    size_t padding = state->table->taps / 2;
+
+    if (history_reserve(state, state->length + padding) != 0) {
+        return NULL;
+    }
+
+    for (int c = 0; c < state->in->channels; c++) {
+        memset(&state->history[c * state->capacity + state->length], 0,
+               padding * sizeof(float));
+    }
+
+    state->length += padding;
+
+    if (!(resampled = history_filter(state))) {
+        return NULL;
+    } else if (resampled->size == 0) {
+        sas_chunk_dealloc(resampled);
+        return NULL;
+    }
+
+    return output_layout(state, resampled);
+}
+
+static void filter_init(struct sas_filter *filter)
+{
+    filter->flow = rxc_flow_map_state_flush(state_create, resample, resample_flush, state_dealloc,
+                                            filter);
+}
+
+static void filter_dealloc(struct sas_filter *filter)
+{
+    struct resample_filter *self = (struct resample_filter *) filter;
+    struct table *table = self->tables;
+
+    while (table) {
+        struct table *next = table->next;
+        free(table);
+        table = next;
+    }
+
+    free(self);
+}
+
+struct sas_filter * sas_resample_filter(int32_t rate)
+{
+    struct resample_filter *filter;
+
+    if (rate <= 0 || !(filter = malloc(sizeof(struct resample_filter)))) {
+        return NULL;
+    }
+
+    filter->base.dealloc = filter_dealloc;
+    filter->base.init = filter_init;
+    filter->base.flow = NULL;
+    filter->base.create_state = NULL;
+    filter->base.process = NULL;
+    filter->base.dealloc_state = NULL;
+    filter->base.flush = NULL;
+    filter->rate = rate;
+    filter->tables = NULL;
+
+    return &filter->base;
+}
@@ -20,12 +20,12 @@ void sas_transport_packet_header_decode(struct sas_transport_packet_header *head
 
 void sas_transport_packet_cfg_encode(struct sas_transport_packet_cfg *packet)
 {
-    /* Future-proofing; no fields actually need encoding */
+    packet->sample_rate = htonl(packet->sample_rate);
 }
 
 void sas_transport_packet_cfg_decode(struct sas_transport_packet_cfg *packet)
 {
-    /* Future-proofing; no fields actually need decoding */
+    packet->sample_rate = ntohl(packet->sample_rate);
 }
 
 void sas_transport_packet_cfg_ack_encode(struct sas_transport_packet_cfg_ack *packet)
@@ -0,0 +1,145 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <sas/chain.h>
+#include <sas/codec.h>
+#include <sas/cpu.h>
+#include <sas/eq.h>
+#include <sas/format.h>
+#include <sas/gain.h>
+#include <sas/limiter.h>
+
+#include "stream.h"
+
+#define FRAMES 44100
+#define EFFECTS 4
+
+static struct sas_filter * effect_create(int effect)
+{
+    static const struct sas_eq_band bands[] = {
+        {SAS_EQ_HIGH_PASS, 40, 0, 0.707},
+        {SAS_EQ_LOW_SHELF, 120, 3, 0.707},
+        {SAS_EQ_PEAK, 1000, -2, 1.4},
+        {SAS_EQ_HIGH_SHELF, 8000, -3, 0.707},
+    };
+    struct sas_filter *filter = NULL;
+
+    switch (effect) {
+    case 0:
+        filter = sas_eq_filter(bands, sizeof(bands) / sizeof(bands[0]));
+        break;
+    case 1:
+        /* Drive the signal into the limiter */
+        filter = sas_gain_filter(9, 10);
+        break;
+    case 2:
+        filter = sas_limiter_filter(-3, 5, 50);
+        break;
+    case 3:
+        filter = sas_gain_filter(-1, 10);
+        break;
+    }
+
+    TEST_ASSERT(filter != NULL);
+    return filter;
+}
+
+/**
+ * Stream the signal through the specified effects connected one after another.
+ */
+static uint8_t * stream_sequential(const struct sas_format *format, const int16_t *pcm,
+                                   size_t chunk_frames, size_t *size)
+{
+    struct sas_filter *filters[EFFECTS];
+    struct rxc_flow *flows[EFFECTS];
+    uint8_t *bytes;
+
+    for (int i = 0; i < EFFECTS; i++) {
+        filters[i] = effect_create(i);
+        filters[i]->init(filters[i]);
+        flows[i] = filters[i]->flow;
+    }
+
+    bytes = test_stream(format, pcm, FRAMES, chunk_frames, flows, EFFECTS, size);
+
+    for (int i = 0; i < EFFECTS; i++) {
+        filters[i]->dealloc(filters[i]);
+    }
+
+    return bytes;
+}
+
+/**
+ * Stream the signal through the effects fused into a chain, of which the
+ * specified amount of effects at the end are fused into a nested chain.
+ */
+static uint8_t * stream_fused(const struct sas_format *format, const int16_t *pcm,
+                              size_t chunk_frames, int nested, size_t *size)
+{
+    struct sas_filter *filters[EFFECTS];
+    struct sas_filter *chain;
+    uint8_t *bytes;
+
+    for (int i = 0; i < EFFECTS; i++) {
+        filters[i] = effect_create(i);
+    }
+
+    if (nested > 0) {
+        filters[EFFECTS - nested] = sas_chain_filter(&filters[EFFECTS - nested], nested);
+        TEST_ASSERT(filters[EFFECTS - nested] != NULL);
+    }
+
+    chain = sas_chain_filter(filters, EFFECTS - (nested > 0 ? nested - 1 : 0));
+    TEST_ASSERT(chain != NULL);
+
+    chain->init(chain);
+    bytes = test_stream(format, pcm, FRAMES, chunk_frames, &chain->flow, 1, size);
+    chain->dealloc(chain);
+    return bytes;
+}
+
+/**
+ * A chain produces exactly the same samples as its filters connected one
+ * after another, for chunks that are not a multiple of the block size and
+ * for planar streams, also when chains are nested. The stream grows by the
+ * look-ahead of the limiter in both cases.
+ */
+static void test_fused(void)
+{
+    static const size_t chunk_frames[] = { 100, SAS_FILTER_BLOCK, 1000 };
+
+    for (int layout = SAS_LAYOUT_INTERLEAVED; layout <= SAS_LAYOUT_PLANAR; layout++) {
+        struct sas_format format = { 44100, 16, 2, SAS_SAMPLE_S16, layout, SAS_CODEC_NONE };
+        const struct sas_format *interned = sas_format_intern(&format);
+        int16_t *pcm = test_signal(FRAMES, format.channels);
+
+        for (size_t i = 0; i < sizeof(chunk_frames) / sizeof(chunk_frames[0]); i++) {
+            size_t expected, size;
+            uint8_t *sequential = stream_sequential(interned, pcm, chunk_frames[i], &expected);
+
+            TEST_ASSERT(expected > FRAMES * format.channels * sizeof(int16_t));
+
+            for (int nested = 0; nested <= 2; nested++) {
+                uint8_t *fused = stream_fused(interned, pcm, chunk_frames[i], nested, &size);
+
+                TEST_ASSERT(size == expected);
+                TEST_ASSERT(!memcmp(fused, sequential, size));
+                free(fused);
+            }
+
+            free(sequential);
+        }
+
+        free(pcm);
+    }
+}
+
+int main(void)
+{
+    test_fused();
+
+    /* The scalar kernels of the filters are chained the same way */
+    sas_cpu_disable(SAS_CPU_AVX512 | SAS_CPU_AVX2 | SAS_CPU_SSE2);
+    test_fused();
+    return EXIT_SUCCESS;
+}
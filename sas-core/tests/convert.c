@@ -0,0 +1,201 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <sas/convert.h>
+#include <sas/cpu.h>
+#include <sas/format.h>
+
+#include "test.h"
+
+/* An odd amount of samples leaves a tail after every vector width */
+#define COUNT 4099
+
+#define FORMATS 5
+
+/**
+ * The instruction levels in the order they are disabled, which starts with
+ * every instruction the processor supports.
+ */
+static const int levels[] = { 0, SAS_CPU_AVX512, SAS_CPU_AVX2, SAS_CPU_SSE2 };
+
+#define LEVELS (sizeof(levels) / sizeof(levels[0]))
+
+/**
+ * Create samples of the specified format that cover its whole range, which
+ * for floating point samples includes values that need clipping.
+ */
+static uint8_t * samples_create(int format)
+{
+    static const float specials[] = {
+        0.0f, -0.0f, 1.0f, -1.0f, 1.5f, -1.5f, 1e-9f, -1e-9f, INFINITY, -INFINITY, NAN,
+        0.99999994f, -0.99999994f
+    };
+    size_t size = sas_convert_size(format);
+    uint8_t *samples = malloc(COUNT * size);
+    uint32_t seed = format;
+
+    TEST_ASSERT(samples != NULL);
+
+    for (size_t i = 0; i < COUNT * size; i++) {
+        seed = seed * 1103515245 + 12345;
+        samples[i] = seed >> 24;
+    }
+
+    if (format == SAS_SAMPLE_F32) {
+        float *floats = (float *) samples;
+
+        for (size_t i = 0; i < COUNT; i++) {
+            seed = seed * 1103515245 + 12345;
+            floats[i] = i < sizeof(specials) / sizeof(specials[0]) ?
+                        specials[i] : ((float) (seed >> 8) / (1 << 23) - 1) * 1.1f;
+        }
+    }
+
+    return samples;
+}
+
+/**
+ * Convert between every pair of formats, with and without dither, at the
+ * instructions that are currently enabled.
+ */
+static void convert_all(uint8_t *const *samples, uint8_t **out, uint32_t *dither)
+{
+    for (int from = 1; from <= FORMATS; from++) {
+        for (int to = 1; to <= FORMATS; to++) {
+            for (int dithered = 0; dithered < 2; dithered++) {
+                size_t index = ((from - 1) * FORMATS + to - 1) * 2 + dithered;
+                uint32_t *state = dithered ? &dither[index] : NULL;
+
+                out[index] = malloc(COUNT * sas_convert_size(to));
+                TEST_ASSERT(out[index] != NULL);
+
+                dither[index] = 0x12345678;
+
+                /* Convert in two parts at an unaligned offset, which continues
+                 * the dither where the first part left off */
+                sas_convert(samples[from - 1], from, out[index], to, 37, state);
+                sas_convert(&samples[from - 1][37 * sas_convert_size(from)], from,
+                            &out[index][37 * sas_convert_size(to)], to, COUNT - 37, state);
+            }
+        }
+    }
+}
+
+/**
+ * Every conversion produces the same samples at every level of instructions,
+ * and a conversion that is split produces the same samples as one that is not.
+ * The instructions are disabled for the rest of the process, so this test
+ * runs last.
+ */
+static void test_levels(uint8_t *const *samples)
+{
+    size_t conversions = FORMATS * FORMATS * 2;
+    uint8_t *reference[FORMATS * FORMATS * 2], *out[FORMATS * FORMATS * 2];
+    uint32_t reference_dither[FORMATS * FORMATS * 2], dither[FORMATS * FORMATS * 2];
+
+    convert_all(samples, reference, reference_dither);
+
+    /* The split conversion is compared to a single one at the widest level */
+    for (int from = 1; from <= FORMATS; from++) {
+        for (int to = 1; to <= FORMATS; to++) {
+            size_t index = ((from - 1) * FORMATS + to - 1) * 2 + 1;
+            uint8_t *whole = malloc(COUNT * sas_convert_size(to));
+            uint32_t state = 0x12345678;
+
+            TEST_ASSERT(whole != NULL);
+            sas_convert(samples[from - 1], from, whole, to, COUNT, &state);
+            TEST_ASSERT(!memcmp(whole, reference[index], COUNT * sas_convert_size(to)));
+            TEST_ASSERT(state == reference_dither[index]);
+            TEST_ASSERT(state == 0x12345678 + COUNT);
+            free(whole);
+        }
+    }
+
+    for (size_t level = 1; level < LEVELS; level++) {
+        sas_cpu_disable(levels[level]);
+        convert_all(samples, out, dither);
+
+        for (size_t i = 0; i < conversions; i++) {
+            int to = (int) (i / 2 % FORMATS) + 1;
+
+            TEST_ASSERT(!memcmp(out[i], reference[i], COUNT * sas_convert_size(to)));
+            TEST_ASSERT(dither[i] == reference_dither[i]);
+            free(out[i]);
+        }
+    }
+
+    for (size_t i = 0; i < conversions; i++) {
+        free(reference[i]);
+    }
+}
+
+/**
+ * Converting to a format with more bits and back without dither yields the
+ * original samples.
+ */
+static void test_identity(uint8_t *const *samples)
+{
+    static const int pairs[][2] = {
+        { SAS_SAMPLE_U8, SAS_SAMPLE_S16 }, { SAS_SAMPLE_U8, SAS_SAMPLE_F32 },
+        { SAS_SAMPLE_S16, SAS_SAMPLE_S24 }, { SAS_SAMPLE_S16, SAS_SAMPLE_S32 },
+        { SAS_SAMPLE_S16, SAS_SAMPLE_F32 }, { SAS_SAMPLE_S24, SAS_SAMPLE_S32 },
+    };
+
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++) {
+        int from = pairs[i][0], to = pairs[i][1];
+        uint8_t *wide = malloc(COUNT * sas_convert_size(to));
+        uint8_t *back = malloc(COUNT * sas_convert_size(from));
+
+        TEST_ASSERT(wide != NULL && back != NULL);
+
+        sas_convert(samples[from - 1], from, wide, to, COUNT, NULL);
+        sas_convert(wide, to, back, from, COUNT, NULL);
+        TEST_ASSERT(!memcmp(samples[from - 1], back, COUNT * sas_convert_size(from)));
+
+        free(wide);
+        free(back);
+    }
+}
+
+/**
+ * Floating point samples are clipped to the range of the integer formats.
+ */
+static void test_clip(uint8_t *const *samples)
+{
+    const float *floats = (const float *) samples[SAS_SAMPLE_F32 - 1];
+    int16_t *out = malloc(COUNT * sizeof(int16_t));
+
+    TEST_ASSERT(out != NULL);
+
+    sas_convert(floats, SAS_SAMPLE_F32, out, SAS_SAMPLE_S16, COUNT, NULL);
+
+    for (size_t i = 0; i < COUNT; i++) {
+        if (floats[i] >= 1) {
+            TEST_ASSERT(out[i] == INT16_MAX);
+        } else if (floats[i] <= -1) {
+            TEST_ASSERT(out[i] == INT16_MIN);
+        }
+    }
+
+    free(out);
+}
+
+int main(void)
+{
+    uint8_t *samples[FORMATS];
+
+    for (int format = 1; format <= FORMATS; format++) {
+        samples[format - 1] = samples_create(format);
+    }
+
+    test_identity(samples);
+    test_clip(samples);
+    test_levels(samples);
+
+    for (int format = 1; format <= FORMATS; format++) {
+        free(samples[format - 1]);
+    }
+
+    return EXIT_SUCCESS;
+}
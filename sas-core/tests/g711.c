@@ -0,0 +1,267 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <sas/codec.h>
+#include <sas/cpu.h>
+#include <sas/format.h>
+#include <sas/codecs/g711.h>
+
+#include "stream.h"
+
+#define FRAMES 44100
+#define CHUNK_FRAMES 256
+
+/*
+ * The reference implementation of G.711 as published by Sun Microsystems,
+ * which searches the segment of a sample instead of looking it up.
+ */
+static int segment(int value, const int *ends)
+{
+    int segment = 0;
+
+    while (segment < 8 && value > ends[segment]) {
+        segment++;
+    }
+
+    return segment;
+}
+
+static uint8_t reference_ulaw_encode(int16_t x)
+{
+    static const int ends[8] = { 0x3f, 0x7f, 0xff, 0x1ff, 0x3ff, 0x7ff, 0xfff, 0x1fff };
+    int sample = x >> 2;
+    int mask = 0xff;
+
+    if (sample < 0) {
+        sample = -sample;
+        mask = 0x7f;
+    }
+    if (sample > 8159) {
+        sample = 8159;
+    }
+
+    sample += 0x84 >> 2;
+
+    int seg = segment(sample, ends);
+
+    if (seg >= 8) {
+        return 0x7f ^ mask;
+    }
+
+    return ((seg << 4) | ((sample >> (seg + 1)) & 0x0f)) ^ mask;
+}
+
+static int16_t reference_ulaw_decode(uint8_t code)
+{
+    int value = ~code;
+    int t = (((value & 0x0f) << 3) + 0x84) << ((value & 0x70) >> 4);
+
+    return (value & 0x80) ? 0x84 - t : t - 0x84;
+}
+
+static uint8_t reference_alaw_encode(int16_t x)
+{
+    static const int ends[8] = { 0x1f, 0x3f, 0x7f, 0xff, 0x1ff, 0x3ff, 0x7ff, 0xfff };
+    int sample = x >> 3;
+    int mask = 0xd5;
+
+    if (sample < 0) {
+        sample = -sample - 1;
+        mask = 0x55;
+    }
+
+    int seg = segment(sample, ends);
+
+    if (seg >= 8) {
+        return 0x7f ^ mask;
+    }
+
+    return ((seg << 4) | ((sample >> (seg < 2 ? 1 : seg)) & 0x0f)) ^ mask;
+}
+
+static int16_t reference_alaw_decode(uint8_t code)
+{
+    int value = code ^ 0x55;
+    int seg = (value & 0x70) >> 4;
+    int t = (value & 0x0f) << 4;
+
+    if (seg == 0) {
+        t += 8;
+    } else {
+        t = (t + 0x108) << (seg - 1);
+    }
+
+    return (value & 0x80) ? t : -t;
+}
+
+struct law {
+    const struct sas_codec *codec;
+    void (*encode)(const int16_t *pcm, size_t count, uint8_t *out);
+    void (*decode)(const uint8_t *in, size_t count, int16_t *pcm);
+    uint8_t (*reference_encode)(int16_t x);
+    int16_t (*reference_decode)(uint8_t code);
+};
+
+static const struct law laws[] = {
+    { &sas_codec_g711_ulaw, sas_codec_g711_ulaw_encode, sas_codec_g711_ulaw_decode,
+      reference_ulaw_encode, reference_ulaw_decode },
+    { &sas_codec_g711_alaw, sas_codec_g711_alaw_encode, sas_codec_g711_alaw_decode,
+      reference_alaw_encode, reference_alaw_decode },
+};
+
+#define LAWS (sizeof(laws) / sizeof(laws[0]))
+
+/**
+ * Every sample is encoded and every code is decoded like the reference
+ * implementation does.
+ */
+static void test_reference(const struct law *law)
+{
+    int16_t *pcm = malloc(65536 * sizeof(int16_t));
+    uint8_t *codes = malloc(65536);
+
+    TEST_ASSERT(pcm != NULL && codes != NULL);
+
+    for (long i = 0; i < 65536; i++) {
+        pcm[i] = (int16_t) (i + INT16_MIN);
+    }
+
+    law->encode(pcm, 65536, codes);
+
+    for (long i = 0; i < 65536; i++) {
+        TEST_ASSERT(codes[i] == law->reference_encode(pcm[i]));
+    }
+
+    for (long i = 0; i < 65536; i++) {
+        codes[i] = (uint8_t) i;
+    }
+
+    law->decode(codes, 65536, pcm);
+
+    for (long i = 0; i < 65536; i++) {
+        TEST_ASSERT(pcm[i] == law->reference_decode(codes[i]));
+    }
+
+    free(pcm);
+    free(codes);
+}
+
+/**
+ * Decoding is undone by encoding, apart from the negative zero of μ-law, and
+ * a signal survives a round trip with the quality of a voice-grade channel.
+ */
+static void test_round_trip(const struct law *law)
+{
+    int16_t *pcm = test_signal(FRAMES, 1);
+    int16_t *decoded = malloc(FRAMES * sizeof(int16_t));
+    uint8_t *codes = malloc(FRAMES);
+
+    TEST_ASSERT(decoded != NULL && codes != NULL);
+
+    for (int i = 0; i < 256; i++) {
+        uint8_t code = (uint8_t) i;
+        int16_t sample;
+        uint8_t encoded;
+
+        law->decode(&code, 1, &sample);
+        law->encode(&sample, 1, &encoded);
+        TEST_ASSERT(encoded == code || (law->codec->id == SAS_CODEC_G711_ULAW && code == 0x7f));
+    }
+
+    law->encode(pcm, FRAMES, codes);
+    law->decode(codes, FRAMES, decoded);
+    TEST_ASSERT(test_snr(pcm, decoded, FRAMES) > 30);
+
+    free(pcm);
+    free(decoded);
+    free(codes);
+}
+
+/**
+ * Streaming through the flows of the codec produces the same frames as coding
+ * the signal at once.
+ */
+static void test_flow(const struct law *law)
+{
+    struct sas_format format = { 8000, 16, 2, SAS_SAMPLE_S16, SAS_LAYOUT_PLANAR,
+                                 SAS_CODEC_NONE };
+    size_t count = FRAMES * format.channels;
+    int16_t *pcm = test_signal(FRAMES, format.channels);
+    int16_t *decoded = malloc(count * sizeof(int16_t));
+    uint8_t *codes = malloc(count);
+    struct rxc_flow *flows[2];
+    uint8_t *bytes;
+    size_t size;
+
+    TEST_ASSERT(decoded != NULL && codes != NULL);
+    TEST_ASSERT(law->codec->independent);
+    TEST_ASSERT(sas_codec_find(law->codec->id) == law->codec);
+
+    flows[0] = law->codec->encoder();
+    flows[1] = law->codec->decoder();
+    bytes = test_stream(sas_format_intern(&format), pcm, FRAMES, CHUNK_FRAMES, flows, 2, &size);
+
+    law->encode(pcm, count, codes);
+    law->decode(codes, count, decoded);
+    TEST_ASSERT(size == count * sizeof(int16_t));
+    TEST_ASSERT(!memcmp(bytes, decoded, size));
+
+    free(bytes);
+    free(pcm);
+    free(decoded);
+    free(codes);
+}
+
+/**
+ * The vectorized decoders produce exactly the same samples as the scalar
+ * decoders, also for the samples that do not fill a vector. The decoders are
+ * disabled for the rest of the process, so this test runs last.
+ */
+static void test_kernels(void)
+{
+    size_t count = 4096 + 13;
+    uint8_t *codes = malloc(count);
+    int16_t *decoded[LAWS][2];
+    uint32_t seed = 7;
+
+    TEST_ASSERT(codes != NULL);
+
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        codes[i] = seed >> 24;
+    }
+
+    for (int level = 0; level < 2; level++) {
+        if (level == 1) {
+            sas_cpu_disable(SAS_CPU_AVX2);
+        }
+
+        for (size_t i = 0; i < LAWS; i++) {
+            decoded[i][level] = malloc(count * sizeof(int16_t));
+            TEST_ASSERT(decoded[i][level] != NULL);
+
+            /* Start at an odd offset to also cover unaligned loads */
+            laws[i].decode(&codes[1], count - 1, decoded[i][level]);
+        }
+    }
+
+    for (size_t i = 0; i < LAWS; i++) {
+        TEST_ASSERT(!memcmp(decoded[i][0], decoded[i][1], (count - 1) * sizeof(int16_t)));
+        free(decoded[i][0]);
+        free(decoded[i][1]);
+    }
+
+    free(codes);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < LAWS; i++) {
+        test_reference(&laws[i]);
+        test_round_trip(&laws[i]);
+        test_flow(&laws[i]);
+    }
+
+    test_kernels();
+    return EXIT_SUCCESS;
+}
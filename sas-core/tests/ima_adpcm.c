@@ -0,0 +1,140 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <sas/codec.h>
+#include <sas/cpu.h>
+#include <sas/format.h>
+#include <sas/codecs/ima_adpcm.h>
+
+#include "stream.h"
+
+#define FRAMES 44100
+#define CHUNK_FRAMES 256
+
+/**
+ * Encode and decode the specified frames as a single chunk.
+ */
+static int16_t * round_trip(const int16_t *pcm, size_t frames, int channels)
+{
+    uint8_t *encoded = malloc(sas_codec_ima_adpcm_size(frames, channels));
+    int16_t *decoded = malloc((frames ? frames : 1) * channels * sizeof(int16_t));
+    size_t size;
+
+    TEST_ASSERT(encoded != NULL && decoded != NULL);
+
+    size = sas_codec_ima_adpcm_encode(pcm, frames, channels, encoded);
+    TEST_ASSERT(size == sas_codec_ima_adpcm_size(frames, channels));
+    TEST_ASSERT(sas_codec_ima_adpcm_frames(encoded, size, channels) == (long) frames);
+    TEST_ASSERT(sas_codec_ima_adpcm_decode(encoded, size, channels, decoded) == (long) frames);
+
+    /* A truncated chunk is rejected rather than read past its end */
+    if (frames > 0) {
+        TEST_ASSERT(sas_codec_ima_adpcm_decode(encoded, size - 1, channels, decoded) == -1);
+    }
+
+    free(encoded);
+    return decoded;
+}
+
+/**
+ * A chunk decodes into as many frames as were encoded, including the lanes
+ * that run past the end of the chunk, and approximates the signal closely.
+ */
+static void test_round_trip(void)
+{
+    static const size_t lengths[] = { 0, 1, 7, 255, 256, 4099, FRAMES };
+
+    for (int channels = 1; channels <= SAS_CODEC_IMA_ADPCM_LANES; channels *= 2) {
+        for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+            int16_t *pcm = test_signal(lengths[i], channels);
+            int16_t *decoded = round_trip(pcm, lengths[i], channels);
+
+            if (lengths[i] >= CHUNK_FRAMES) {
+                TEST_ASSERT(test_snr(pcm, decoded, lengths[i] * channels) > 20);
+            }
+
+            free(pcm);
+            free(decoded);
+        }
+    }
+}
+
+/**
+ * The flows of the codec code every chunk independently, so that streaming
+ * produces the same frames as coding the chunks one by one.
+ */
+static void test_flow(void)
+{
+    const struct sas_codec *codec = sas_codec_find(SAS_CODEC_IMA_ADPCM);
+    struct sas_format format = { 44100, 16, 2, SAS_SAMPLE_S16, SAS_LAYOUT_PLANAR,
+                                 SAS_CODEC_NONE };
+    int16_t *pcm = test_signal(FRAMES, format.channels);
+    struct rxc_flow *flows[2];
+    uint8_t *bytes;
+    size_t size;
+
+    TEST_ASSERT(codec != NULL && codec->independent);
+    TEST_ASSERT(codec->supports(format.sample_rate, format.sample_size, format.channels));
+    TEST_ASSERT(!codec->supports(format.sample_rate, format.sample_size, 3));
+
+    flows[0] = codec->encoder();
+    flows[1] = codec->decoder();
+    bytes = test_stream(sas_format_intern(&format), pcm, FRAMES, CHUNK_FRAMES, flows, 2, &size);
+    TEST_ASSERT(size == FRAMES * format.channels * sizeof(int16_t));
+
+    for (size_t offset = 0; offset < FRAMES; offset += CHUNK_FRAMES) {
+        size_t frames = FRAMES - offset < CHUNK_FRAMES ? FRAMES - offset : CHUNK_FRAMES;
+        size_t index = offset * format.channels;
+        int16_t *decoded = round_trip(&pcm[index], frames, format.channels);
+
+        TEST_ASSERT(!memcmp(&bytes[index * sizeof(int16_t)], decoded,
+                            frames * format.channels * sizeof(int16_t)));
+        free(decoded);
+    }
+
+    free(bytes);
+    free(pcm);
+}
+
+/**
+ * The vectorized kernels produce exactly the same chunks and frames as the
+ * scalar kernels. The kernels are disabled for the rest of the process, so
+ * this test runs last.
+ */
+static void test_kernels(void)
+{
+    int16_t *pcm = test_signal(FRAMES, 2);
+    size_t size = sas_codec_ima_adpcm_size(FRAMES, 2);
+    uint8_t *encoded[2] = { malloc(size), malloc(size) };
+    int16_t *decoded[2] = { malloc(FRAMES * 2 * sizeof(int16_t)),
+                            malloc(FRAMES * 2 * sizeof(int16_t)) };
+
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT(encoded[i] != NULL && decoded[i] != NULL);
+
+        if (i == 1) {
+            sas_cpu_disable(SAS_CPU_AVX2);
+        }
+
+        sas_codec_ima_adpcm_encode(pcm, FRAMES, 2, encoded[i]);
+        sas_codec_ima_adpcm_decode(encoded[0], size, 2, decoded[i]);
+    }
+
+    TEST_ASSERT(!memcmp(encoded[0], encoded[1], size));
+    TEST_ASSERT(!memcmp(decoded[0], decoded[1], FRAMES * 2 * sizeof(int16_t)));
+
+    for (int i = 0; i < 2; i++) {
+        free(encoded[i]);
+        free(decoded[i]);
+    }
+
+    free(pcm);
+}
+
+int main(void)
+{
+    test_round_trip();
+    test_flow();
+    test_kernels();
+    return EXIT_SUCCESS;
+}
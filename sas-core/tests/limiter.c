@@ -0,0 +1,108 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <sas/codec.h>
+#include <sas/format.h>
+#include <sas/gain.h>
+#include <sas/limiter.h>
+
+#include "stream.h"
+
+#define SAMPLE_RATE 44100
+#define CHANNELS 2
+#define FRAMES 44100
+#define LOOKAHEAD 5
+
+/**
+ * The look-ahead of the limiter in frames.
+ */
+#define WINDOW ((size_t) lround(LOOKAHEAD * SAMPLE_RATE / 1000.0))
+
+static const struct sas_format * format_create(void)
+{
+    struct sas_format format = { SAMPLE_RATE, 16, CHANNELS, SAS_SAMPLE_S16,
+                                 SAS_LAYOUT_INTERLEAVED, SAS_CODEC_NONE };
+
+    return sas_format_intern(&format);
+}
+
+/**
+ * A signal below the ceiling is only delayed by the look-ahead, and the
+ * frames still delayed at the end of the stream are flushed, however the
+ * stream is cut into chunks.
+ */
+static void test_delay(void)
+{
+    static const size_t chunk_frames[] = { 1, 100, WINDOW, 1000, FRAMES };
+    int16_t *pcm = test_signal(FRAMES, CHANNELS);
+
+    for (size_t i = 0; i < sizeof(chunk_frames) / sizeof(chunk_frames[0]); i++) {
+        struct sas_filter *limiter = sas_limiter_filter(0, LOOKAHEAD, 50);
+        int16_t *out;
+        size_t size;
+
+        TEST_ASSERT(limiter != NULL);
+        limiter->init(limiter);
+
+        out = (int16_t *) test_stream(format_create(), pcm, FRAMES, chunk_frames[i],
+                                      &limiter->flow, 1, &size);
+
+        TEST_ASSERT(size == (FRAMES + WINDOW) * CHANNELS * sizeof(int16_t));
+
+        for (size_t j = 0; j < WINDOW * CHANNELS; j++) {
+            TEST_ASSERT(out[j] == 0);
+        }
+
+        TEST_ASSERT(!memcmp(&out[WINDOW * CHANNELS], pcm, FRAMES * CHANNELS * sizeof(int16_t)));
+
+        free(out);
+        limiter->dealloc(limiter);
+    }
+
+    free(pcm);
+}
+
+/**
+ * The peaks of a signal that is driven over the ceiling are limited to it.
+ */
+static void test_ceiling(void)
+{
+    struct sas_filter *gain = sas_gain_filter(12, 10);
+    struct sas_filter *limiter = sas_limiter_filter(-3, LOOKAHEAD, 50);
+    int16_t *pcm = test_signal(FRAMES, CHANNELS);
+    double ceiling = pow(10, -3 / 20.0) * 32768;
+    struct rxc_flow *flows[2];
+    int16_t *out;
+    size_t size;
+    int peak = 0;
+
+    TEST_ASSERT(gain != NULL && limiter != NULL);
+    gain->init(gain);
+    limiter->init(limiter);
+    flows[0] = gain->flow;
+    flows[1] = limiter->flow;
+
+    out = (int16_t *) test_stream(format_create(), pcm, FRAMES, 256, flows, 2, &size);
+    TEST_ASSERT(size == (FRAMES + WINDOW) * CHANNELS * sizeof(int16_t));
+
+    for (size_t i = 0; i < size / sizeof(int16_t); i++) {
+        peak = abs(out[i]) > peak ? abs(out[i]) : peak;
+    }
+
+    /* The limiter had work to do, and the rounding to 16 bits is allowed */
+    TEST_ASSERT(peak > ceiling * 0.9);
+    TEST_ASSERT(peak <= ceiling + 1);
+
+    free(out);
+    free(pcm);
+    gain->dealloc(gain);
+    limiter->dealloc(limiter);
+}
+
+int main(void)
+{
+    test_delay();
+    test_ceiling();
+    return EXIT_SUCCESS;
+}
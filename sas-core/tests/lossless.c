@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <sas/codec.h>
+#include <sas/format.h>
+#include <sas/codecs/lossless.h>
+
+#include "stream.h"
+
+#define FRAMES 44100
+#define CHUNK_FRAMES 1024
+
+/**
+ * The signals that exercise the different ways a subframe is coded.
+ */
+enum shape {
+    SHAPE_TONES,
+    SHAPE_SILENCE,
+    SHAPE_NOISE,
+    SHAPE_EXTREMES,
+    SHAPE_MONO,
+};
+
+#define SHAPES 5
+
+static int16_t * signal_create(enum shape shape, size_t frames, int channels)
+{
+    int16_t *pcm = test_signal(frames, channels);
+    uint32_t seed = 13;
+
+    for (size_t i = 0; i < frames * channels; i++) {
+        seed = seed * 1103515245 + 12345;
+
+        switch (shape) {
+        case SHAPE_TONES:
+            break;
+        case SHAPE_SILENCE:
+            pcm[i] = -3;
+            break;
+        case SHAPE_NOISE:
+            pcm[i] = (int16_t) (seed >> 16);
+            break;
+        case SHAPE_EXTREMES:
+            /* The side channel of opposite full-scale samples needs 17 bits */
+            pcm[i] = (i / channels + i % channels) % 2 ? INT16_MAX : INT16_MIN;
+            break;
+        case SHAPE_MONO:
+            /* Identical channels are best coded as mid and side */
+            pcm[i] = pcm[i - i % channels];
+            break;
+        }
+    }
+
+    return pcm;
+}
+
+/**
+ * Encode and decode the specified frames as a single chunk, which must
+ * reproduce them exactly.
+ */
+static size_t round_trip(const int16_t *pcm, size_t frames, int channels)
+{
+    size_t bound = sas_codec_lossless_bound(frames, channels);
+    uint8_t *encoded = malloc(bound ? bound : 1);
+    int16_t *decoded = malloc((frames ? frames : 1) * channels * sizeof(int16_t));
+    size_t size;
+
+    TEST_ASSERT(encoded != NULL && decoded != NULL);
+
+    size = sas_codec_lossless_encode(pcm, frames, channels, encoded);
+    TEST_ASSERT(size <= bound);
+    TEST_ASSERT(frames == 0 || size > 0);
+    TEST_ASSERT(sas_codec_lossless_frames(encoded, size, channels) == (long) frames);
+    TEST_ASSERT(sas_codec_lossless_decode(encoded, size, channels, decoded) == (long) frames);
+    TEST_ASSERT(!memcmp(pcm, decoded, frames * channels * sizeof(int16_t)));
+
+    free(encoded);
+    free(decoded);
+    return size;
+}
+
+/**
+ * Every signal survives a round trip exactly, for chunks that are shorter
+ * than the order of the predictors as well as chunks that span several
+ * blocks.
+ */
+static void test_round_trip(void)
+{
+    static const size_t lengths[] = {
+        0, 1, 2, 3, 4, 5, 33, SAS_CODEC_LOSSLESS_BLOCK - 1, SAS_CODEC_LOSSLESS_BLOCK,
+        SAS_CODEC_LOSSLESS_BLOCK + 1, FRAMES
+    };
+
+    for (int channels = 1; channels <= 2; channels++) {
+        for (int shape = 0; shape < SHAPES; shape++) {
+            for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+                int16_t *pcm = signal_create(shape, lengths[i], channels);
+                size_t size = round_trip(pcm, lengths[i], channels);
+
+                /* Predictable signals are actually compressed */
+                if (lengths[i] == FRAMES && shape != SHAPE_NOISE && shape != SHAPE_EXTREMES) {
+                    TEST_ASSERT(size < lengths[i] * channels * sizeof(int16_t) * 3 / 4);
+                }
+
+                free(pcm);
+            }
+        }
+    }
+}
+
+/**
+ * Truncated and corrupted chunks are rejected or decoded into garbage, but
+ * never read or written out of bounds, and unsupported streams are refused.
+ */
+static void test_malformed(void)
+{
+    int16_t *pcm = signal_create(SHAPE_TONES, SAS_CODEC_LOSSLESS_BLOCK + 100, 2);
+    uint8_t *encoded = malloc(sas_codec_lossless_bound(SAS_CODEC_LOSSLESS_BLOCK + 100, 2));
+    int16_t *decoded = malloc((SAS_CODEC_LOSSLESS_BLOCK + 100) * 2 * sizeof(int16_t));
+    size_t size;
+    uint32_t seed = 99;
+
+    TEST_ASSERT(encoded != NULL && decoded != NULL);
+
+    size = sas_codec_lossless_encode(pcm, SAS_CODEC_LOSSLESS_BLOCK + 100, 2, encoded);
+
+    /* Only whole blocks are accepted */
+    for (size_t length = 0; length < size; length += 97) {
+        long frames = sas_codec_lossless_decode(encoded, length, 2, decoded);
+
+        TEST_ASSERT(frames == -1 || frames == 0 || frames == SAS_CODEC_LOSSLESS_BLOCK);
+    }
+
+    for (int i = 0; i < 1000; i++) {
+        seed = seed * 1103515245 + 12345;
+        encoded[4 + (seed >> 8) % (size - 4)] ^= 1 << (seed >> 29);
+
+        /* A corrupted header may claim more frames than were encoded */
+        long frames = sas_codec_lossless_frames(encoded, size, 2);
+
+        if (frames > 0) {
+            int16_t *garbage = malloc(frames * 2 * sizeof(int16_t));
+
+            TEST_ASSERT(garbage != NULL);
+            sas_codec_lossless_decode(encoded, size, 2, garbage);
+            free(garbage);
+        }
+    }
+
+    TEST_ASSERT(sas_codec_lossless_encode(pcm, 100, 3, encoded) == 0);
+    TEST_ASSERT(sas_codec_lossless_frames(encoded, size, 3) == -1);
+    TEST_ASSERT(!sas_codec_lossless.supports(44100, 16, 3));
+    TEST_ASSERT(!sas_codec_lossless.supports(44100, 24, 2));
+
+    free(pcm);
+    free(encoded);
+    free(decoded);
+}
+
+/**
+ * Streaming through the flows of the codec reproduces the stream exactly.
+ */
+static void test_flow(void)
+{
+    const struct sas_codec *codec = sas_codec_find(SAS_CODEC_LOSSLESS);
+    struct sas_format format = { 44100, 16, 2, SAS_SAMPLE_S16, SAS_LAYOUT_PLANAR,
+                                 SAS_CODEC_NONE };
+    int16_t *pcm = test_signal(FRAMES, format.channels);
+    struct rxc_flow *flows[2];
+    uint8_t *bytes;
+    size_t size;
+
+    TEST_ASSERT(codec != NULL && codec->independent);
+
+    flows[0] = codec->encoder();
+    flows[1] = codec->decoder();
+    bytes = test_stream(sas_format_intern(&format), pcm, FRAMES, CHUNK_FRAMES, flows, 2, &size);
+
+    TEST_ASSERT(size == FRAMES * format.channels * sizeof(int16_t));
+    TEST_ASSERT(!memcmp(bytes, pcm, size));
+
+    free(bytes);
+    free(pcm);
+}
+
+int main(void)
+{
+    test_round_trip();
+    test_malformed();
+    test_flow();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <sas/codec.h>
+#include <sas/format.h>
+#include <sas/codecs/opus.h>
+
+#include "stream.h"
+
+#define SAMPLE_RATE 48000
+#define CHANNELS 2
+#define CHUNK_FRAMES 256
+
+/**
+ * The amount of frames in an Opus frame.
+ */
+#define FRAME (SAMPLE_RATE / 1000 * SAS_CODEC_OPUS_FRAME_MS)
+
+static const struct sas_format * format_create(int32_t sample_rate)
+{
+    struct sas_format format = { sample_rate, 16, CHANNELS, SAS_SAMPLE_S16,
+                                 SAS_LAYOUT_INTERLEAVED, SAS_CODEC_NONE };
+    const struct sas_format *interned = sas_format_intern(&format);
+
+    TEST_ASSERT(interned != NULL);
+    return interned;
+}
+
+/**
+ * Count the Opus frames in a sequence of encoded chunks, which are each a
+ * sequence of frames preceded by their size.
+ */
+static long frames_count(const uint8_t *bytes, size_t size)
+{
+    size_t offset = 0;
+    long count = 0;
+
+    while (offset < size) {
+        TEST_ASSERT(size - offset >= 2);
+
+        size_t length = bytes[offset] | bytes[offset + 1] << 8;
+
+        TEST_ASSERT(length > 0 && length <= size - offset - 2);
+        offset += 2 + length;
+        count++;
+    }
+
+    return count;
+}
+
+static double energy(const int16_t *pcm, size_t count)
+{
+    double sum = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        sum += (double) pcm[i] * pcm[i];
+    }
+
+    return sum / (count ? count : 1);
+}
+
+/**
+ * The encoder emits a frame for every Opus frame the chunks complete,
+ * regardless of how the chunks align with the frames, and pads the frames
+ * still pending at the end of the stream into a final frame.
+ */
+static void test_frames(void)
+{
+    static const size_t lengths[] = { 0, 1, FRAME - 1, FRAME, FRAME + 1, SAMPLE_RATE + 123 };
+    const struct sas_codec *codec = sas_codec_find(SAS_CODEC_OPUS);
+
+    TEST_ASSERT(codec != NULL && !codec->independent);
+
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        int16_t *pcm = test_signal(lengths[i], CHANNELS);
+        struct rxc_flow *flows[1] = { codec->encoder() };
+        uint8_t *bytes;
+        size_t size;
+
+        bytes = test_stream(format_create(SAMPLE_RATE), pcm, lengths[i], CHUNK_FRAMES,
+                            flows, 1, &size);
+        TEST_ASSERT(frames_count(bytes, size) == (long) ((lengths[i] + FRAME - 1) / FRAME));
+
+        free(bytes);
+        free(pcm);
+    }
+}
+
+/**
+ * A stream survives a round trip with its frames padded to whole Opus frames
+ * and its loudness intact.
+ */
+static void test_round_trip(void)
+{
+    const struct sas_codec *codec = sas_codec_find(SAS_CODEC_OPUS);
+    size_t frames = SAMPLE_RATE + 123;
+    size_t padded = (frames + FRAME - 1) / FRAME * FRAME;
+    int16_t *pcm = test_signal(frames, CHANNELS);
+    struct rxc_flow *flows[2] = { codec->encoder(), codec->decoder() };
+    int16_t *decoded;
+    size_t size;
+
+    decoded = (int16_t *) test_stream(format_create(SAMPLE_RATE), pcm, frames, CHUNK_FRAMES,
+                                      flows, 2, &size);
+    TEST_ASSERT(size == padded * CHANNELS * sizeof(int16_t));
+
+    /* The decoder lags behind by its look-ahead, so only the loudness of the
+     * frames after the first one is compared */
+    double ratio = energy(&decoded[FRAME * CHANNELS], (frames - FRAME) * CHANNELS) /
+                   energy(&pcm[FRAME * CHANNELS], (frames - FRAME) * CHANNELS);
+
+    TEST_ASSERT(ratio > 0.5 && ratio < 2);
+
+    free(decoded);
+    free(pcm);
+}
+
+/**
+ * Chunks of a sample rate that Opus does not support are dropped rather than
+ * passed on raw.
+ */
+static void test_unsupported(void)
+{
+    const struct sas_codec *codec = sas_codec_find(SAS_CODEC_OPUS);
+    int16_t *pcm = test_signal(44100, CHANNELS);
+    struct rxc_flow *flows[1] = { codec->encoder() };
+    uint8_t *bytes;
+    size_t size;
+
+    TEST_ASSERT(!codec->supports(44100, 16, CHANNELS));
+    TEST_ASSERT(!codec->supports(SAMPLE_RATE, 16, 3));
+
+    bytes = test_stream(format_create(44100), pcm, 44100, CHUNK_FRAMES, flows, 1, &size);
+    TEST_ASSERT(size == 0);
+
+    free(bytes);
+    free(pcm);
+}
+
+int main(void)
+{
+    test_frames();
+    test_round_trip();
+    test_unsupported();
+    return EXIT_SUCCESS;
+}
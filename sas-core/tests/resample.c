@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <sas/codec.h>
+#include <sas/cpu.h>
+#include <sas/format.h>
+#include <sas/resample.h>
+
+#include "stream.h"
+
+#define FROM 44100
+#define TO 48000
+#define CHANNELS 2
+
+/* The reduced ratio of the rates */
+#define UP 160
+#define DOWN 147
+
+static const struct sas_format * format_create(int32_t sample_rate)
+{
+    struct sas_format format = { sample_rate, 16, CHANNELS, SAS_SAMPLE_S16,
+                                 SAS_LAYOUT_INTERLEAVED, SAS_CODEC_NONE };
+
+    return sas_format_intern(&format);
+}
+
+/**
+ * Resample the specified frames from 44.1 kHz to 48 kHz.
+ */
+static int16_t * resample(const int16_t *pcm, size_t frames, size_t chunk_frames,
+                          int32_t rate, size_t *out_frames)
+{
+    struct sas_filter *filter = sas_resample_filter(TO);
+    uint8_t *bytes;
+    size_t size;
+
+    TEST_ASSERT(filter != NULL);
+    filter->init(filter);
+
+    bytes = test_stream(format_create(rate), pcm, frames, chunk_frames, &filter->flow, 1, &size);
+    *out_frames = size / (CHANNELS * sizeof(int16_t));
+
+    filter->dealloc(filter);
+    return (int16_t *) bytes;
+}
+
+/**
+ * Every input frame produces its share of output frames, including the frames
+ * held in the history of the filter when the stream finishes.
+ */
+static void test_length(void)
+{
+    static const size_t lengths[] = { 1, 2, DOWN, 1000, FROM, FROM + 123 };
+
+    TEST_ASSERT(sas_resample_supports(FROM, TO));
+
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        int16_t *pcm = test_signal(lengths[i], CHANNELS);
+        size_t frames;
+        int16_t *out = resample(pcm, lengths[i], 256, FROM, &frames);
+
+        TEST_ASSERT(frames == (lengths[i] * UP + DOWN - 1) / DOWN);
+
+        free(out);
+        free(pcm);
+    }
+}
+
+/**
+ * The history is carried across chunks, so that the output does not depend on
+ * how the stream is cut into chunks.
+ */
+static void test_chunks(void)
+{
+    static const size_t chunk_frames[] = { 1, 100, 4096 };
+    size_t frames = 10000;
+    int16_t *pcm = test_signal(frames, CHANNELS);
+    size_t reference_frames;
+    int16_t *reference = resample(pcm, frames, frames, FROM, &reference_frames);
+
+    for (size_t i = 0; i < sizeof(chunk_frames) / sizeof(chunk_frames[0]); i++) {
+        size_t out_frames;
+        int16_t *out = resample(pcm, frames, chunk_frames[i], FROM, &out_frames);
+
+        TEST_ASSERT(out_frames == reference_frames);
+        TEST_ASSERT(!memcmp(out, reference, out_frames * CHANNELS * sizeof(int16_t)));
+        free(out);
+    }
+
+    free(reference);
+    free(pcm);
+}
+
+/**
+ * A tone keeps its frequency, phase and level, and streams that are at the
+ * sample rate already pass through.
+ */
+static void test_tone(void)
+{
+    size_t frames = FROM;
+    int16_t *pcm = malloc(frames * CHANNELS * sizeof(int16_t));
+    int16_t *expected, *out;
+    size_t out_frames;
+
+    TEST_ASSERT(pcm != NULL);
+
+    for (size_t i = 0; i < frames; i++) {
+        for (int c = 0; c < CHANNELS; c++) {
+            pcm[i * CHANNELS + c] = (int16_t) lrint(16000 * sin(2 * M_PI * 1000 * (c + 1) * i / FROM));
+        }
+    }
+
+    out = resample(pcm, frames, 256, FROM, &out_frames);
+    expected = malloc(out_frames * CHANNELS * sizeof(int16_t));
+    TEST_ASSERT(expected != NULL);
+
+    for (size_t i = 0; i < out_frames; i++) {
+        for (int c = 0; c < CHANNELS; c++) {
+            expected[i * CHANNELS + c] = (int16_t) lrint(16000 * sin(2 * M_PI * 1000 * (c + 1) * i / TO));
+        }
+    }
+
+    /* The edges of the stream are left out, where the filter rings */
+    TEST_ASSERT(test_snr(&expected[TO / 100 * CHANNELS], &out[TO / 100 * CHANNELS],
+                         (out_frames - TO / 50) * CHANNELS) > 40);
+
+    free(out);
+    free(expected);
+
+    out = resample(pcm, frames, 256, TO, &out_frames);
+    TEST_ASSERT(out_frames == frames);
+    TEST_ASSERT(!memcmp(out, pcm, frames * CHANNELS * sizeof(int16_t)));
+
+    free(out);
+    free(pcm);
+}
+
+/**
+ * The vector kernels produce the same samples as the scalar kernel. The
+ * instructions are disabled for the rest of the process, so this test runs
+ * last.
+ */
+static void test_kernels(void)
+{
+    size_t frames = 10000, reference_frames, out_frames;
+    int16_t *pcm = test_signal(frames, CHANNELS);
+    int16_t *reference = resample(pcm, frames, 256, FROM, &reference_frames);
+
+    sas_cpu_disable(SAS_CPU_AVX512 | SAS_CPU_AVX2 | SAS_CPU_SSE2);
+
+    int16_t *out = resample(pcm, frames, 256, FROM, &out_frames);
+
+    TEST_ASSERT(out_frames == reference_frames);
+    TEST_ASSERT(!memcmp(out, reference, out_frames * CHANNELS * sizeof(int16_t)));
+
+    free(out);
+    free(reference);
+    free(pcm);
+}
+
+int main(void)
+{
+    test_length();
+    test_chunks();
+    test_tone();
+    test_kernels();
+    return EXIT_SUCCESS;
+}
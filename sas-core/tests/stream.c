@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include <rxc/generator.h>
+#include <rxc/pipeline.h>
+
+#include <sas/chunk.h>
+
+#include "stream.h"
+
+int16_t * test_signal(size_t frames, int channels)
+{
+    int16_t *pcm = malloc((frames ? frames : 1) * channels * sizeof(int16_t));
+    uint32_t seed = 42;
+
+    TEST_ASSERT(pcm != NULL);
+
+    for (size_t i = 0; i < frames; i++) {
+        for (int c = 0; c < channels; c++) {
+            double t = (double) i / 44100;
+            double x = 8000 * sin(2 * M_PI * 440 * (c + 1) * t) + 4000 * sin(2 * M_PI * 97 * t);
+
+            /* A linear congruential generator keeps the noise reproducible */
+            seed = seed * 1103515245 + 12345;
+            pcm[i * channels + c] = (int16_t) (x + (int) (seed >> 16) % 200 - 100);
+        }
+    }
+
+    return pcm;
+}
+
+/* A source of raw chunks */
+struct chunks {
+    struct rxc_generator base;
+    const struct sas_format *format;
+    const int16_t *pcm;
+    size_t frames;
+    size_t chunk_frames;
+    size_t offset;
+};
+
+struct chunks_ctx {
+    const struct sas_format *format;
+    const int16_t *pcm;
+    size_t frames;
+    size_t chunk_frames;
+};
+
+static void chunks_init(struct rxc_generator *gen, void *ctx)
+{
+    struct chunks *self = (struct chunks *) gen;
+    struct chunks_ctx *chunks = ctx;
+
+    self->format = chunks->format;
+    self->pcm = chunks->pcm;
+    self->frames = chunks->frames;
+    self->chunk_frames = chunks->chunk_frames;
+    self->offset = 0;
+}
+
+static int chunks_step(struct rxc_generator *gen)
+{
+    struct chunks *self = (struct chunks *) gen;
+
+    RXC_GENERATOR_BEGIN(gen);
+    for (; self->offset < self->frames; self->offset += self->chunk_frames) {
+        size_t frames = self->frames - self->offset < self->chunk_frames ?
+                        self->frames - self->offset : self->chunk_frames;
+        struct sas_chunk *chunk = sas_chunk_alloc(self->format, frames);
+        const int16_t *pcm = &self->pcm[self->offset * self->format->channels];
+        int channels = self->format->channels;
+
+        TEST_ASSERT(chunk != NULL);
+
+        if (self->format->layout == SAS_LAYOUT_PLANAR) {
+            for (int c = 0; c < channels; c++) {
+                int16_t *plane = (int16_t *) sas_chunk_plane(chunk, c);
+
+                for (size_t i = 0; i < frames; i++) {
+                    plane[i] = pcm[i * channels + c];
+                }
+            }
+        } else {
+            memcpy(chunk->buffer, pcm, chunk->size);
+        }
+
+        RXC_GENERATOR_YIELD(gen, rxc_value_pointer(chunk));
+    }
+    RXC_GENERATOR_END(gen);
+}
+
+static void chunk_release(void *element)
+{
+    sas_chunk_dealloc(element);
+}
+
+uint8_t * test_stream(const struct sas_format *format, const int16_t *pcm, size_t frames,
+                      size_t chunk_frames, struct rxc_flow **flows, size_t count, size_t *size)
+{
+    struct chunks_ctx ctx = { format, pcm, frames, chunk_frames };
+    struct rxc_source *source = rxc_source_generator(chunks_step, sizeof(struct chunks),
+                                                     chunks_init, NULL, &ctx);
+    struct test_probe probe;
+    uint8_t *bytes;
+
+    TEST_ASSERT(format->sample == SAS_SAMPLE_S16 && chunk_frames > 0);
+
+    for (size_t i = 0; i < count; i++) {
+        source = rxc_source_via(source, flows[i]);
+        TEST_ASSERT(source != NULL);
+    }
+
+    test_probe_init(&probe);
+    source->connect(source, &probe.sink);
+    test_probe_pull(&probe, LONG_MAX);
+    TEST_ASSERT(probe.finished);
+
+    *size = 0;
+
+    for (long i = 0; i < probe.count; i++) {
+        struct sas_chunk *chunk = sas_chunk_layout(probe.elements[i], SAS_LAYOUT_INTERLEAVED);
+
+        TEST_ASSERT(chunk != NULL);
+        probe.elements[i] = chunk;
+        *size += chunk->size;
+    }
+
+    bytes = malloc(*size ? *size : 1);
+    TEST_ASSERT(bytes != NULL);
+
+    for (long i = 0, offset = 0; i < probe.count; i++) {
+        struct sas_chunk *chunk = probe.elements[i];
+
+        memcpy(&bytes[offset], chunk->buffer, chunk->size);
+        offset += chunk->size;
+    }
+
+    test_probe_destroy(&probe, chunk_release);
+    rxc_source_dealloc(source);
+    return bytes;
+}
+
+double test_snr(const int16_t *reference, const int16_t *signal, size_t count)
+{
+    double power = 0, noise = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        double error = (double) signal[i] - reference[i];
+
+        power += (double) reference[i] * reference[i];
+        noise += error * error;
+    }
+
+    return noise > 0 ? 10 * log10(power / noise) : INFINITY;
+}
@@ -0,0 +1,54 @@
+#ifndef SAS_TEST_STREAM_H
+#define SAS_TEST_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rxc/rxc.h>
+
+#include <sas/format.h>
+
+#include "test.h"
+
+/**
+ * Generate a test signal of two tones with a little noise, which is the same
+ * for every call with the same arguments.
+ *
+ * @param[in] frames The amount of frames to generate.
+ * @param[in] channels The amount of channels of the signal.
+ * @return The interleaved 16-bit samples of the signal, which the caller
+ * releases with <code>free</code>.
+ */
+int16_t * test_signal(size_t frames, int channels);
+
+/**
+ * Stream the specified frames in chunks through the given flows and collect
+ * the chunks the last flow emits. The frames are cut into chunks of
+ * <code>chunk_frames</code> frames, where the last chunk may be shorter.
+ *
+ * @param[in] format The raw 16-bit format of the chunks to stream, which may
+ * be planar.
+ * @param[in] pcm The interleaved frames to stream.
+ * @param[in] frames The amount of frames to stream.
+ * @param[in] chunk_frames The amount of frames in a chunk.
+ * @param[in] flows The flows to stream the chunks through, in order.
+ * @param[in] count The amount of flows.
+ * @param[out] size The size of the collected chunks in bytes.
+ * @return The bytes of the collected chunks, of which raw chunks are converted
+ * into the interleaved layout, and which the caller releases with
+ * <code>free</code>.
+ */
+uint8_t * test_stream(const struct sas_format *format, const int16_t *pcm, size_t frames,
+                      size_t chunk_frames, struct rxc_flow **flows, size_t count, size_t *size);
+
+/**
+ * Determine the signal-to-noise ratio of a signal that approximates another.
+ *
+ * @param[in] reference The original samples.
+ * @param[in] signal The approximated samples.
+ * @param[in] count The amount of samples to compare.
+ * @return The ratio in decibels.
+ */
+double test_snr(const int16_t *reference, const int16_t *signal, size_t count);
+
+#endif /* SAS_TEST_STREAM_H */
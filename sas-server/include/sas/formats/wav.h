@@ -10,6 +10,9 @@
 
 #include <rxc/rxc.h>
 
+#include <sas/chunk.h>
+#include <sas/format.h>
+
 /**
  * The source structure for a Wav audio stream.
  */
@@ -17,15 +20,24 @@ struct sas_formats_wav_source {
     struct rxc_source base;
 
     int fd, finished;
-    int32_t sample_rate;
-    int8_t sample_size, channels;
+
+    /**
+     * The interned format of the samples in the file.
+     */
+    const struct sas_format *format;
+
+    /**
+     * The pool from which the chunks of the stream are taken.
+     */
+    struct sas_chunk_pool *pool;
 };
 
 /**
  * Create a Wave audio stream.
  *
  * Note that not all WAV filetypes are
- * supported. Only the simplest uncompressed PCM streams can be read.
+ * supported. Only the simplest uncompressed streams can be read, which are
+ * 8, 16, 24 or 32 bit integer PCM or 32 bit floating point samples.
  *
  * the function writes metadata about the opened file in the integers pointed
  * to by the parameters.
@@ -1,6 +1,8 @@
 #ifndef SAS_SERVER_H
 #define SAS_SERVER_H
 
+#include <stddef.h>
+
 #include <sys/socket.h>
 #include <netinet/in.h>
 
@@ -40,6 +42,19 @@ int sas_server_init(struct sas_server *server);
  */
 int sas_server_bind(struct sas_server *server, struct sockaddr_in6 *addr);
 
+/**
+ * Set the memory budget of the cache of encoded chunks, which is shared by the
+ * sessions of the server so that sessions streaming the same file with the
+ * same codec encode each chunk once. The cache cannot be disabled while
+ * sessions are running.
+ *
+ * @param[in] server The server to use.
+ * @param[in] budget The maximum amount of bytes the cache may occupy, where
+ * <code>0</code> disables the cache.
+ * @return <code>0</code> on success, otherwise an error code.
+ */
+int sas_server_set_cache_budget(struct sas_server *server, size_t budget);
+
 /**
  * Run the specified server and handle the incoming requests.
  *
@@ -0,0 +1,381 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <rxc/rxc.h>
+#include <rxc/ops/core.h>
+
+#include <sas/codec.h>
+
+#include "cache.h"
+
+#define SAS_SERVER_CACHE_INITIAL_CAPACITY 256
+
+/**
+ * An encoded chunk in the cache.
+ */
+struct sas_server_cache_entry {
+    /**
+     * The next entry at the same index of the hash table.
+     */
+    struct sas_server_cache_entry *next;
+
+    /**
+     * The neighbours of the entry in order of use.
+     */
+    struct sas_server_cache_entry *newer;
+    struct sas_server_cache_entry *older;
+
+    /**
+     * The key of the entry.
+     */
+    uint64_t hash;
+    struct sas_server_cache_stream stream;
+    uint64_t index;
+
+    /**
+     * The interned format of the chunk.
+     */
+    const struct sas_format *format;
+
+    /**
+     * The encoded bytes of the chunk.
+     */
+    size_t size;
+    uint8_t buffer[];
+};
+
+struct sas_server_cache {
+    /**
+     * The maximum and current amount of bytes occupied by the entries.
+     */
+    size_t budget;
+    size_t used;
+
+    /**
+     * A hash table of the entries.
+     */
+    size_t count;
+    size_t capacity;
+    struct sas_server_cache_entry **table;
+
+    /**
+     * The most and least recently used entries.
+     */
+    struct sas_server_cache_entry *newest;
+    struct sas_server_cache_entry *oldest;
+};
+
+/**
+ * Hash the key of a chunk into a 64 bit integer.
+ *
+ * This function is based on the djb2 algorithm, applied to the fields of the
+ * key rather than bytes.
+ */
+static uint64_t key_hash(const struct sas_server_cache_stream *stream, uint64_t index)
+{
+    uint64_t fields[] = { stream->dev, stream->ino, stream->size, (uint64_t) stream->mtime,
+                          (uint64_t) stream->sample_rate, stream->codec, index };
+    uint64_t hash = 5381;
+
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        hash = ((hash << 5) + hash) ^ fields[i];
+    }
+
+    /* Mix the high bits into the low bits that select the bucket */
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static int key_eq(const struct sas_server_cache_entry *entry, uint64_t hash,
+                  const struct sas_server_cache_stream *stream, uint64_t index)
+{
+    return entry->hash == hash && entry->index == index &&
+           entry->stream.dev == stream->dev && entry->stream.ino == stream->ino &&
+           entry->stream.size == stream->size && entry->stream.mtime == stream->mtime &&
+           entry->stream.sample_rate == stream->sample_rate && entry->stream.codec == stream->codec;
+}
+
+static void list_unlink(struct sas_server_cache *cache, struct sas_server_cache_entry *entry)
+{
+    if (entry->newer) {
+        entry->newer->older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+
+    if (entry->older) {
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+}
+
+static void list_push(struct sas_server_cache *cache, struct sas_server_cache_entry *entry)
+{
+    entry->newer = NULL;
+    entry->older = cache->newest;
+
+    if (cache->newest) {
+        cache->newest->newer = entry;
+    } else {
+        cache->oldest = entry;
+    }
+
+    cache->newest = entry;
+}
+
+static void entry_remove(struct sas_server_cache *cache, struct sas_server_cache_entry *entry)
+{
+    struct sas_server_cache_entry **link = &cache->table[entry->hash & (cache->capacity - 1)];
+
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+
+    *link = entry->next;
+    list_unlink(cache, entry);
+
+    cache->count--;
+    cache->used -= sizeof(struct sas_server_cache_entry) + entry->size;
+    free(entry);
+}
+
+static struct sas_server_cache_entry * entry_find(struct sas_server_cache *cache,
+                                                  const struct sas_server_cache_stream *stream,
+                                                  uint64_t index)
+{
+    uint64_t hash = key_hash(stream, index);
+    struct sas_server_cache_entry *entry = cache->table[hash & (cache->capacity - 1)];
+
+    while (entry && !key_eq(entry, hash, stream, index)) {
+        entry = entry->next;
+    }
+
+    return entry;
+}
+
+/**
+ * Double the capacity of the hash table, which keeps the current table on
+ * allocation failure.
+ */
+static void table_grow(struct sas_server_cache *cache)
+{
+    size_t capacity = cache->capacity * 2;
+    struct sas_server_cache_entry **table = calloc(capacity, sizeof(struct sas_server_cache_entry *));
+
+    if (!table) {
+        return;
+    }
+
+    for (size_t i = 0; i < cache->capacity; i++) {
+        struct sas_server_cache_entry *entry = cache->table[i];
+
+        while (entry) {
+            struct sas_server_cache_entry *next = entry->next;
+            size_t bucket = entry->hash & (capacity - 1);
+
+            entry->next = table[bucket];
+            table[bucket] = entry;
+            entry = next;
+        }
+    }
+
+    free(cache->table);
+    cache->table = table;
+    cache->capacity = capacity;
+}
+
+static void entry_insert(struct sas_server_cache *cache,
+                         const struct sas_server_cache_stream *stream,
+                         uint64_t index, const struct sas_chunk *chunk)
+{
+    size_t size = sizeof(struct sas_server_cache_entry) + chunk->size;
+
+    if (size > cache->budget) {
+        return;
+    }
+
+    /* Evict the least recently used chunks until the chunk fits */
+    while (cache->used + size > cache->budget) {
+        entry_remove(cache, cache->oldest);
+    }
+
+    struct sas_server_cache_entry *entry = malloc(size);
+
+    if (!entry) {
+        return;
+    }
+
+    entry->hash = key_hash(stream, index);
+    entry->stream = *stream;
+    entry->index = index;
+    entry->format = chunk->format;
+    entry->size = chunk->size;
+    memcpy(entry->buffer, chunk->buffer, chunk->size);
+
+    if (cache->count >= cache->capacity) {
+        table_grow(cache);
+    }
+
+    size_t bucket = entry->hash & (cache->capacity - 1);
+
+    entry->next = cache->table[bucket];
+    cache->table[bucket] = entry;
+    list_push(cache, entry);
+
+    cache->count++;
+    cache->used += size;
+}
+
+struct sas_server_cache * sas_server_cache_alloc(size_t budget)
+{
+    struct sas_server_cache *cache = malloc(sizeof(struct sas_server_cache));
+
+    if (!cache) {
+        return NULL;
+    }
+
+    cache->budget = budget;
+    cache->used = 0;
+    cache->count = 0;
+    cache->capacity = SAS_SERVER_CACHE_INITIAL_CAPACITY;
+    cache->table = calloc(cache->capacity, sizeof(struct sas_server_cache_entry *));
+    cache->newest = NULL;
+    cache->oldest = NULL;
+
+    if (!cache->table) {
+        free(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+void sas_server_cache_dealloc(struct sas_server_cache *cache)
+{
+    struct sas_server_cache_entry *entry = cache->newest;
+
+    while (entry) {
+        struct sas_server_cache_entry *older = entry->older;
+        free(entry);
+        entry = older;
+    }
+
+    free(cache->table);
+    free(cache);
+}
+
+void sas_server_cache_budget(struct sas_server_cache *cache, size_t budget)
+{
+    cache->budget = budget;
+
+    while (cache->used > cache->budget) {
+        entry_remove(cache, cache->oldest);
+    }
+}
+
+int sas_server_cache_stream_init(struct sas_server_cache_stream *stream,
+                                 struct sas_server_cache *cache, int fd,
+                                 int32_t sample_rate, uint8_t codec)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) < 0) {
+        return errno;
+    }
+
+    stream->cache = cache;
+    stream->dev = st.st_dev;
+    stream->ino = st.st_ino;
+    stream->size = st.st_size;
+    stream->mtime = st.st_mtime;
+    stream->sample_rate = sample_rate;
+    stream->codec = codec;
+    return 0;
+}
+
+/**
+ * The position of a stage in the stream it caches.
+ */
+struct cursor {
+    const struct sas_server_cache_stream *stream;
+    uint64_t index;
+};
+
+static void * cursor_create(void *ctx)
+{
+    struct cursor *cursor = malloc(sizeof(struct cursor));
+
+    if (!cursor) {
+        return NULL;
+    }
+
+    cursor->stream = ctx;
+    cursor->index = 0;
+    return cursor;
+}
+
+static void * lookup(void *state, void *element)
+{
+    struct cursor *cursor = state;
+    struct sas_chunk *chunk = element;
+    struct sas_server_cache *cache = cursor->stream->cache;
+    uint64_t index = cursor->index++;
+
+    if (chunk->format->codec != SAS_CODEC_NONE) {
+        return chunk;
+    }
+
+    struct sas_server_cache_entry *entry = entry_find(cache, cursor->stream, index);
+
+    if (!entry) {
+        return chunk;
+    }
+
+    struct sas_chunk *encoded = sas_chunk_alloc_size(entry->format, entry->size);
+
+    if (!encoded) {
+        return chunk;
+    }
+
+    memcpy(encoded->buffer, entry->buffer, entry->size);
+
+    list_unlink(cache, entry);
+    list_push(cache, entry);
+
+    sas_chunk_dealloc(chunk);
+    return encoded;
+}
+
+static void * store(void *state, void *element)
+{
+    struct cursor *cursor = state;
+    struct sas_chunk *chunk = element;
+    struct sas_server_cache *cache = cursor->stream->cache;
+    uint64_t index = cursor->index++;
+
+    /* Only encoded chunks are cached, and chunks from the cache are already
+     * there */
+    if (chunk->format->codec == cursor->stream->codec && !entry_find(cache, cursor->stream, index)) {
+        entry_insert(cache, cursor->stream, index, chunk);
+    }
+
+    return chunk;
+}
+
+struct rxc_flow * sas_server_cache_lookup(const struct sas_server_cache_stream *stream)
+{
+    return rxc_flow_map_state(cursor_create, lookup, free, (void *) stream);
+}
+
+struct rxc_flow * sas_server_cache_store(const struct sas_server_cache_stream *stream)
+{
+    return rxc_flow_map_state(cursor_create, store, free, (void *) stream);
+}
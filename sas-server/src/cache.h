@@ -0,0 +1,124 @@
+#ifndef SAS_INTERNAL_CACHE_H
+#define SAS_INTERNAL_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rxc/rxc.h>
+
+#include <sas/chunk.h>
+
+/**
+ * The default memory budget of the cache in bytes.
+ */
+#define SAS_SERVER_CACHE_BUDGET (64 * 1024 * 1024)
+
+/**
+ * A cache of encoded chunks that is shared by the sessions of a server, so
+ * that sessions which stream the same file with the same codec encode each
+ * chunk only once. The chunks are keyed by the identity of the file, the sample
+ * rate, the codec and the index of the chunk in the stream, and the least
+ * recently used chunks are evicted once the cache exceeds its memory budget.
+ *
+ * The cache is not thread-safe, since the server runs the pipelines of all
+ * sessions on its own thread.
+ */
+struct sas_server_cache;
+
+/**
+ * The stream of a session in the cache, which identifies the file and codec
+ * of the session.
+ */
+struct sas_server_cache_stream {
+    /**
+     * The cache the stream belongs to.
+     */
+    struct sas_server_cache *cache;
+
+    /**
+     * The device and inode of the file.
+     */
+    uint64_t dev;
+    uint64_t ino;
+
+    /**
+     * The size and modification time of the file, so that modified files do
+     * not hit stale chunks.
+     */
+    uint64_t size;
+    int64_t mtime;
+
+    /**
+     * The sample rate of the stream, which differs from the file if the
+     * stream is resampled.
+     */
+    int32_t sample_rate;
+
+    /**
+     * The codec the stream is encoded with.
+     */
+    uint8_t codec;
+};
+
+/**
+ * Allocate a cache.
+ *
+ * @param[in] budget The maximum amount of bytes the cache may occupy.
+ * @return The cache or <code>NULL</code> on allocation failure.
+ */
+struct sas_server_cache * sas_server_cache_alloc(size_t budget);
+
+/**
+ * Deallocate the specified cache and the chunks in it.
+ *
+ * @param[in] cache The cache to deallocate.
+ */
+void sas_server_cache_dealloc(struct sas_server_cache *cache);
+
+/**
+ * Change the memory budget of the cache, which evicts chunks until the cache
+ * fits.
+ *
+ * @param[in] cache The cache to change the budget of.
+ * @param[in] budget The maximum amount of bytes the cache may occupy, where
+ * <code>0</code> disables the cache.
+ */
+void sas_server_cache_budget(struct sas_server_cache *cache, size_t budget);
+
+/**
+ * Initialize the stream of a session for the file referred to by the
+ * specified file descriptor.
+ *
+ * @param[out] stream The stream to initialize.
+ * @param[in] cache The cache to use.
+ * @param[in] fd The file descriptor of the file that is streamed.
+ * @param[in] sample_rate The sample rate of the stream.
+ * @param[in] codec The codec the stream is encoded with.
+ * @return <code>0</code> on success, otherwise an error code.
+ */
+int sas_server_cache_stream_init(struct sas_server_cache_stream *stream,
+                                 struct sas_server_cache *cache, int fd,
+                                 int32_t sample_rate, uint8_t codec);
+
+/**
+ * Create a flow that replaces the raw chunks of the specified stream with
+ * their encoded counterparts from the cache. The flow is placed right after
+ * the source of the file, so that the index of a chunk is the same as after
+ * the encoder. The conversion, resampling and encoding stages pass these
+ * chunks through, since they are encoded already.
+ *
+ * @param[in] stream The stream to look up, which must outlive the flow.
+ * @return The flow or <code>NULL</code> on allocation failure.
+ */
+struct rxc_flow * sas_server_cache_lookup(const struct sas_server_cache_stream *stream);
+
+/**
+ * Create a flow that stores the encoded chunks of the specified stream in the
+ * cache.
+ *
+ * @param[in] stream The stream to store, which must outlive the flow.
+ * @return The flow or <code>NULL</code> on allocation failure.
+ */
+struct rxc_flow * sas_server_cache_store(const struct sas_server_cache_stream *stream);
+
+#endif /* SAS_INTERNAL_CACHE_H */
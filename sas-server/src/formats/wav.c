@@ -11,8 +11,10 @@
 
 #include <rxc/rxc.h>
 #include <rxc/logic.h>
+#include <rxc/alloc.h>
 
 #include <sas/chunk.h>
+#include <sas/convert.h>
 #include <sas/formats/wav.h>
 
 #define swap_short(x)		(x)
@@ -24,6 +26,7 @@
 #define WAVEFMT		"WAVEfmt"
 #define DATA		0x61746164
 #define PCM_CODE	1
+#define FLOAT_CODE	3
 
 typedef struct _waveheader {
     char		main_chunk[4];	/* 'RIFF' */
@@ -41,12 +44,6 @@ typedef struct _waveheader {
     uint32_t	data_length;	/* samplecount */
 } WaveHeader;
 
-static void chunk_dealloc(struct sas_chunk *chunk)
-{
-    free(chunk->buffer);
-    free(chunk);
-}
-
 static void on_pull(struct rxc_source_logic *self, long n)
 {
     struct sas_formats_wav_source *source = (void *) self->source;
@@ -57,24 +54,13 @@ static void on_pull(struct rxc_source_logic *self, long n)
     }
 
     for (; n > 0; n--) {
-        size_t buffer_size = 1024;
-        struct sas_chunk *chunk = malloc(sizeof(struct sas_chunk));
-        uint8_t *buffer = malloc(buffer_size);
-
-        ssize_t nread = read(source->fd, buffer, buffer_size);
-
-        chunk->dealloc = chunk_dealloc;
-        chunk->buffer = buffer;
-        chunk->size = nread;
-        chunk->sample_rate = source->sample_rate;
-        chunk->sample_size = source->sample_size;
-        chunk->channels = source->channels;
-        chunk->codec = 0;
+        struct sas_chunk *chunk = sas_chunk_pool_get(source->pool);
+        ssize_t nread = chunk ? read(source->fd, chunk->buffer, chunk->size) : -1;
 
         if (nread == 0) {
             source->finished = 1;
             close(source->fd);
-            chunk_dealloc(chunk);
+            sas_chunk_dealloc(chunk);
             rxc_outlet_complete(self->out);
             return;
         } else if (nread < 0) {
@@ -83,10 +69,14 @@ static void on_pull(struct rxc_source_logic *self, long n)
             source->finished = 1;
             close(source->fd);
 
-            chunk_dealloc(chunk);
+            if (chunk) {
+                sas_chunk_dealloc(chunk);
+            }
             return;
         }
 
+        chunk->size = nread;
+
         rxc_outlet_emit(self->out, chunk);
     }
 }
@@ -96,14 +86,14 @@ static void on_downstream_finish(struct rxc_source_logic *logic)
 
 static struct rxc_source_logic * create_logic(struct rxc_source *source)
 {
-    struct rxc_source_logic *logic = malloc(sizeof(struct rxc_source_logic));
+    struct rxc_source_logic *logic = rxc_alloc(sizeof(struct rxc_source_logic));
 
     if (!logic) {
         return NULL;
     }
 
     logic->source = source;
-    logic->dealloc = (void (*)(struct rxc_source_logic *)) free;
+    logic->dealloc = (void (*)(struct rxc_source_logic *)) rxc_free;
     logic->on_pull = on_pull;
     logic->on_downstream_finish = on_downstream_finish;
 
@@ -118,7 +108,8 @@ static void dealloc(struct rxc_source *source, int shallow)
         close(self->fd);
     }
 
-    free(self);
+    sas_chunk_pool_dealloc(self->pool);
+    rxc_free(self);
 }
 
 static void connect(struct rxc_source *self, struct rxc_sink *sink)
@@ -143,31 +134,58 @@ struct rxc_source * sas_formats_wav(int fd)
         fprintf(stderr, "not a WAVE-file\n");
         return NULL;
     }
-    if (swap_short(wh.format) != PCM_CODE) {
-        fprintf(stderr, "can't play non PCM WAVE-files\n");
+    int sample;
+
+    if (swap_short(wh.format) == PCM_CODE) {
+        sample = sas_convert_integer_format(swap_short(wh.bit_p_spl));
+    } else if (swap_short(wh.format) == FLOAT_CODE && swap_short(wh.bit_p_spl) == 32) {
+        sample = SAS_SAMPLE_F32;
+    } else {
+        sample = 0;
+    }
+
+    if (!sample) {
+        fprintf(stderr, "can't play WAVE-files with format %hu and %hu bits\n", wh.format, wh.bit_p_spl);
         return NULL;
     }
-    if (swap_short(wh.chans) > 2) {
+    if (swap_short(wh.chans) < 1 || swap_short(wh.chans) > 2) {
         fprintf(stderr, "can't play WAVE-files with %d tracks\n", wh.chans);
         return NULL;
     }
 
-    struct sas_formats_wav_source *source = malloc(sizeof(struct sas_formats_wav_source));
+    struct sas_format format = {
+        .sample_rate = (int32_t) swap_long(wh.sample_fq),
+        .sample_size = (int8_t) swap_short(wh.bit_p_spl),
+        .channels = (int8_t) swap_short(wh.chans),
+        .sample = (uint8_t) sample,
+        .layout = SAS_LAYOUT_INTERLEAVED,
+        .codec = 0,
+    };
+    struct sas_formats_wav_source *source = rxc_alloc(sizeof(struct sas_formats_wav_source));
 
     if (!source) {
         return NULL;
+    } else if (!(source->format = sas_format_intern(&format))) {
+        rxc_free(source);
+        return NULL;
+    }
+
+    /* Read a whole number of frames, so that every chunk can be processed on
+     * its own. The chunks are recycled once downstream is done with them. */
+    size_t frame_size = format.channels * sas_convert_size(format.sample);
+
+    if (!(source->pool = sas_chunk_pool_alloc(source->format, 1024 / frame_size))) {
+        rxc_free(source);
+        return NULL;
     }
 
     source->finished = 0;
     source->fd = fd;
-    source->sample_rate = (unsigned int) swap_long(wh.sample_fq);
-    source->sample_size = (unsigned int) swap_short(wh.bit_p_spl);
-    source->channels =  (unsigned int) swap_short(wh.chans);
     source->base.dealloc = dealloc;
     source->base.connect = connect;
 
     fprintf (stderr, "chan=%u, freq=%u bitrate=%u format=%hu\n",
-             source->channels, source->sample_rate, source->sample_size, wh.format);
+             format.channels, format.sample_rate, format.sample_size, wh.format);
 
     return &source->base;
 }
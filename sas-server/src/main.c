@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <signal.h>
 
 #include <netdb.h>
 #include <sys/types.h>
@@ -12,6 +13,84 @@
 #include <sas/log.h>
 #include <sas/server.h>
 
+#include <rxc/trace.h>
+
+/**
+ * Dump the trace when the program exits.
+ */
+static void trace_dump_at_exit(void)
+{
+    int err;
+
+    if ((err = rxc_trace_dump()) != 0) {
+        sas_log(LOG_ERR "Failed to dump trace: %s\n", strerror(err));
+    }
+}
+
+/**
+ * Request a dump of the trace on SIGUSR1. The dump is written by the server
+ * loop, since it is not safe to do so in the signal handler.
+ */
+static void trace_signal_handler(int signum)
+{
+    rxc_trace_request_dump();
+}
+
+/**
+ * Enable tracing if the SAS_TRACE environment variable names a file to dump
+ * the trace to.
+ */
+static void trace_setup(void)
+{
+    const char *path = getenv("SAS_TRACE");
+
+    if (!path || !*path) {
+        return;
+    }
+
+    rxc_trace_enable(path);
+    atexit(trace_dump_at_exit);
+
+    /* Do not restart select, so that the server loop can pick up the dump */
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = trace_signal_handler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, NULL);
+
+    sas_log(LOG_INFO "Tracing to %s (send SIGUSR1 to dump)\n", path);
+}
+
+/**
+ * Set the memory budget of the cache of encoded chunks if the SAS_CACHE_SIZE
+ * environment variable specifies one in bytes.
+ */
+static void cache_setup(struct sas_server *server)
+{
+    const char *size = getenv("SAS_CACHE_SIZE");
+    char *end;
+
+    if (!size || !*size) {
+        return;
+    }
+
+    unsigned long long budget = strtoull(size, &end, 10);
+
+    if (*end) {
+        sas_log(LOG_WARN "Ignoring invalid cache size: %s\n", size);
+        return;
+    }
+
+    int err = sas_server_set_cache_budget(server, budget);
+
+    if (err) {
+        sas_log(LOG_WARN "Failed to set cache size: %s\n", strerror(err));
+        return;
+    }
+
+    sas_log(LOG_INFO "Cache size set to %llu bytes\n", budget);
+}
+
 /**
  * Main entry point of the server program.
  *
@@ -27,6 +106,8 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
+    trace_setup();
+
     int err;
     struct sas_server *server = sas_server_alloc();
 
@@ -35,6 +116,8 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
+    cache_setup(server);
+
     if ((err = sas_server_init(server)) != 0) {
         sas_log(LOG_ERR "Failed to initialize server: %s\n", strerror(err));
         sas_server_dealloc(server);
@@ -17,10 +17,13 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
+#include <sas/convert.h>
 #include <sas/log.h>
 #include <sas/transport.h>
 #include <sas/server.h>
 
+#include <rxc/trace.h>
+
 #include <sas/formats/wav.h>
 
 #include "server.h"
@@ -42,6 +45,11 @@ struct sas_server * sas_server_alloc(void)
     server->timeouts.capacity = SAS_SERVER_TIMEOUT_HEAP_INITIAL_CAPACITY;
     server->timeouts.heap = calloc(server->timeouts.capacity, sizeof(struct sas_server_session *));
 
+    server->blueprint = rxc_blueprint_create(sas_server_session_build);
+    server->cache = sas_server_cache_alloc(SAS_SERVER_CACHE_BUDGET);
+    server->convert = sas_convert_filter(SAS_SAMPLE_S32, 0);
+    server->resamplers = NULL;
+
     return server;
 }
 
@@ -53,9 +61,46 @@ void sas_server_dealloc(struct sas_server *server)
 
     free(server->sessions.table);
     free(server->timeouts.heap);
+    rxc_blueprint_dealloc(server->blueprint);
+
+    if (server->cache) {
+        sas_server_cache_dealloc(server->cache);
+    }
+
+    if (server->convert) {
+        server->convert->dealloc(server->convert);
+    }
+
+    while (server->resamplers) {
+        struct sas_server_resampler *next = server->resamplers->next;
+
+        server->resamplers->filter->dealloc(server->resamplers->filter);
+        free(server->resamplers);
+        server->resamplers = next;
+    }
+
     free(server);
 }
 
+int sas_server_set_cache_budget(struct sas_server *server, size_t budget)
+{
+    if (budget == 0) {
+        /* The streams of running sessions refer to the cache */
+        if (server->cache && server->sessions.count > 0) {
+            return EBUSY;
+        } else if (server->cache) {
+            sas_server_cache_dealloc(server->cache);
+            server->cache = NULL;
+        }
+    } else if (server->cache) {
+        sas_server_cache_budget(server->cache, budget);
+    } else if (!(server->cache = sas_server_cache_alloc(budget))) {
+        return ENOMEM;
+    }
+
+    return 0;
+}
+
 int sas_server_init(struct sas_server *server)
 {
     server->fd = -1;
@@ -87,7 +132,7 @@ int sas_server_bind(struct sas_server *server, struct sockaddr_in6 *addr)
 
 int sas_server_run(struct sas_server *server)
 {
-    int fd = server->fd, nb;
+    int fd = server->fd, nb, err;
     fd_set fds;
 
     struct timeval timeval;
@@ -122,10 +167,25 @@ int sas_server_run(struct sas_server *server)
         FD_SET(fd, &fds);
 
         nb = select(fd + 1, &fds, NULL, NULL, timeout);
+        err = errno;
+
+        /* Dump the trace if a signal has asked for it, which may overwrite
+         * errno */
+        int trace_err = rxc_trace_poll();
+
+        if (trace_err != 0) {
+            sas_log(LOG_ERR "Failed to dump trace: %s\n", strerror(trace_err));
+        }
 
-        if (nb < 0) {
+        if (nb < 0 && err == EINTR) {
+            /* Re-add session that was waiting for timeout */
+            if (timeout_session) {
+                sas_server_timeout_add(server, timeout_session);
+            }
+            continue;
+        } else if (nb < 0) {
             free(buffer);
-            return errno;
+            return err;
         } else if (nb == 0) {
             /* Possibly time out session */
             sas_server_timeout(server, timeout_session);
@@ -147,6 +207,8 @@ int sas_server_run(struct sas_server *server)
                 continue;
             }
 
+            RXC_TRACE_INSTANT("packet received", (long) count);
+
             /* Get active session or create a new one */
             struct sas_server_session *session = sas_server_session_get(server, &clientaddr);
 
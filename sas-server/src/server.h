@@ -1,11 +1,36 @@
 #ifndef SAS_INTERNAL_SERVER_H
 #define SAS_INTERNAL_SERVER_H
 
+#include <rxc/blueprint.h>
+
+#include <sas/filter.h>
 #include <sas/server.h>
 
+#include "cache.h"
 #include "session.h"
 #include "timeout.h"
 
+/**
+ * A resampler that is shared by the sessions which request the same sample
+ * rate, so that its filter tables are computed once.
+ */
+struct sas_server_resampler {
+    /**
+     * The sample rate the resampler converts to.
+     */
+    int32_t rate;
+
+    /**
+     * The filter of the resampler.
+     */
+    struct sas_filter *filter;
+
+    /**
+     * The next resampler in the list.
+     */
+    struct sas_server_resampler *next;
+};
+
 struct sas_server {
     /**
      * The file descriptor of the socket created for the server.
@@ -21,6 +46,28 @@ struct sas_server {
      * The timeout heap for the active sessions.
      */
     struct sas_server_timeout_heap timeouts;
+
+    /**
+     * The blueprint from which the pipelines of the sessions are materialized.
+     */
+    struct rxc_blueprint *blueprint;
+
+    /**
+     * The cache of encoded chunks shared by the sessions or <code>NULL</code>
+     * if chunks are not cached.
+     */
+    struct sas_server_cache *cache;
+
+    /**
+     * The filter that converts floating point files into 32 bit integer
+     * samples, which is the format the protocol streams.
+     */
+    struct sas_filter *convert;
+
+    /**
+     * The resamplers for the sample rates the sessions have requested.
+     */
+    struct sas_server_resampler *resamplers;
 };
 
 #endif /* SAS_INTERNAL_SERVER_H */
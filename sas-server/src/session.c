@@ -17,12 +17,18 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
+#include <sas/codec.h>
+#include <sas/codecs/opus.h>
+#include <sas/convert.h>
 #include <sas/log.h>
+#include <sas/resample.h>
 #include <sas/transport.h>
 #include <sas/server.h>
 
 #include <sas/formats/wav.h>
 
+#include <rxc/trace.h>
+
 #include "server.h"
 #include "session.h"
 #include "sink.h"
@@ -77,6 +83,230 @@ static int addr_eq(const struct sockaddr_in6 *a, const struct sockaddr_in6 *b)
     return ntohs(a->sin6_port) == ntohs(b->sin6_port);
 }
 
+/**
+ * Look up the chunks of the specified source in the cache of the server, so
+ * that chunks which have been encoded before skip the conversion, resampling
+ * and encoding of the stream. Only codecs that code chunks independently are
+ * cached, since they are able to resume at any chunk.
+ *
+ * @param[in] server The server the session belongs to.
+ * @param[in] session The session to look up the stream of, of which the sample
+ * rate and codec have been decided.
+ * @param[in] codec The codec to encode the stream with.
+ * @param[in] source The source of raw chunks from the file.
+ * @param[out] cached A flag to indicate the stream is cached.
+ * @return The source of raw and encoded chunks or <code>NULL</code> on
+ * allocation failure.
+ */
+static struct rxc_source * session_lookup(struct sas_server *server,
+                                          struct sas_server_session *session,
+                                          const struct sas_codec *codec,
+                                          struct rxc_source *source, int *cached)
+{
+    *cached = server->cache && codec->independent &&
+              sas_server_cache_stream_init(&session->cache_stream, server->cache,
+                                           session->fd, session->sample_rate, codec->id) == 0;
+
+    if (!*cached) {
+        return source;
+    }
+
+    struct rxc_flow *lookup = sas_server_cache_lookup(&session->cache_stream);
+    return lookup ? rxc_source_via(source, lookup) : NULL;
+}
+
+/**
+ * Encode the specified source with a codec and store the encoded chunks in the
+ * cache if the stream is cached. Chunks from the cache pass the encoder.
+ *
+ * @param[in] session The session to encode the stream of.
+ * @param[in] codec The codec to encode the stream with.
+ * @param[in] source The source of raw chunks.
+ * @param[in] cached A flag to indicate the stream is cached.
+ * @return The source of encoded chunks or <code>NULL</code> on allocation
+ * failure.
+ */
+static struct rxc_source * session_encode(struct sas_server_session *session,
+                                          const struct sas_codec *codec,
+                                          struct rxc_source *source, int cached)
+{
+    struct rxc_flow *encoder = codec->encoder();
+    source = encoder ? rxc_source_via(source, encoder) : NULL;
+
+    if (cached && source) {
+        struct rxc_flow *store = sas_server_cache_store(&session->cache_stream);
+        source = store ? rxc_source_via(source, store) : NULL;
+    }
+
+    return source;
+}
+
+/**
+ * Resample the specified source to another sample rate with the resampler the
+ * server shares between the sessions requesting the rate.
+ *
+ * @param[in] server The server the session belongs to.
+ * @param[in] source The source of raw chunks.
+ * @param[in] rate The sample rate to resample the source to.
+ * @return The source of resampled chunks or <code>NULL</code> on allocation
+ * failure.
+ */
+static struct rxc_source * session_resample(struct sas_server *server,
+                                            struct rxc_source *source,
+                                            int32_t rate)
+{
+    struct sas_server_resampler *resampler = server->resamplers;
+
+    while (resampler && resampler->rate != rate) {
+        resampler = resampler->next;
+    }
+
+    if (!resampler) {
+        if (!(resampler = malloc(sizeof(struct sas_server_resampler)))) {
+            return NULL;
+        } else if (!(resampler->filter = sas_resample_filter(rate))) {
+            free(resampler);
+            return NULL;
+        }
+
+        resampler->rate = rate;
+        resampler->next = server->resamplers;
+        server->resamplers = resampler;
+    }
+
+    resampler->filter->init(resampler->filter);
+    return resampler->filter->flow ? rxc_source_via(source, resampler->filter->flow) : NULL;
+}
+
+struct rxc_pipeline * sas_server_session_build(void *ctx)
+{
+    struct sas_server_session_build_ctx *build = ctx;
+    struct sas_server_session *session = build->session;
+    struct rxc_source *source = sas_formats_wav(session->fd);
+
+    if (!source) {
+        return NULL;
+    }
+
+    struct sas_formats_wav_source *wav = (struct sas_formats_wav_source *) source;
+
+    /* Until the pipeline is built, the sample rate is the one the client
+     * prefers, if any */
+    int32_t rate = session->sample_rate;
+
+    session->sample_rate = wav->format->sample_rate;
+    session->sample_size = wav->format->sample_size;
+    session->channels = wav->format->channels;
+
+    /* The protocol only streams integer samples */
+    int convert = wav->format->sample == SAS_SAMPLE_F32;
+
+    if (convert) {
+        session->sample_size = 32;
+    }
+
+    const struct sas_codec *codec = sas_codec_find(session->codec);
+
+    /* Codecs that only support a few sample rates (e.g. Opus) are able to
+     * encode the file at 48 kHz if the client has no preference */
+    if (!rate && codec && codec->encoder &&
+        !codec->supports(session->sample_rate, session->sample_size, session->channels) &&
+        codec->supports(48000, session->sample_size, session->channels)) {
+        rate = 48000;
+    }
+
+    /* Resample the stream if it is able to, otherwise fall back to the sample
+     * rate of the file, which is reported in the SYN-ACK */
+    int resample = rate > 0 && rate != session->sample_rate &&
+                   sas_resample_supports(session->sample_rate, rate);
+
+    if (resample) {
+        session->sample_rate = rate;
+    }
+
+    /* Encode the stream with the requested codec if it is able to, otherwise
+     * fall back to the raw stream, which is reported in the SYN-ACK */
+    if (!codec || !codec->encoder ||
+        !codec->supports(session->sample_rate, session->sample_size, session->channels)) {
+        session->codec = SAS_CODEC_NONE;
+        codec = NULL;
+    }
+
+    /* The cache is consulted before the stream is converted and resampled,
+     * since its key already holds the sample rate and codec of the stream */
+    int cached = 0;
+
+    if (codec) {
+        struct rxc_source *looked_up = session_lookup(build->server, session, codec, source, &cached);
+
+        if (!looked_up) {
+            session->fd = -1;
+            rxc_source_dealloc(source);
+            return NULL;
+        }
+
+        source = looked_up;
+    }
+
+    if (convert) {
+        struct sas_filter *filter = build->server->convert;
+        struct rxc_source *converted = NULL;
+
+        if (filter) {
+            filter->init(filter);
+            converted = filter->flow ? rxc_source_via(source, filter->flow) : NULL;
+        }
+
+        if (!converted) {
+            session->fd = -1;
+            rxc_source_dealloc(source);
+            return NULL;
+        }
+
+        source = converted;
+    }
+
+    if (resample) {
+        struct rxc_source *resampled = session_resample(build->server, source, rate);
+
+        if (!resampled) {
+            session->fd = -1;
+            rxc_source_dealloc(source);
+            return NULL;
+        }
+
+        source = resampled;
+    }
+
+    if (codec) {
+        struct rxc_source *encoded = session_encode(session, codec, source, cached);
+
+        if (!encoded) {
+            session->fd = -1;
+            rxc_source_dealloc(source);
+            return NULL;
+        }
+
+        source = encoded;
+    }
+
+    struct rxc_sink *sink = sas_server_session_sink(build->server, session);
+    struct rxc_pipeline *pipeline = sink ? rxc_source_to(source, sink) : NULL;
+
+    if (!pipeline) {
+        /* The source has taken ownership of the file descriptor */
+        session->fd = -1;
+        rxc_source_dealloc(source);
+
+        if (sink) {
+            rxc_sink_dealloc(sink);
+        }
+        return NULL;
+    }
+
+    return pipeline;
+}
+
 struct sas_server_session * sas_server_session_find(const struct sas_server *server,
                                                     const struct sockaddr_in6 *addr)
 {
@@ -125,6 +355,7 @@ struct sas_server_session * sas_server_session_get(struct sas_server *server,
     session->receive_window = SAS_SERVER_SESSION_WINDOW_SIZE;
     session->pipeline = NULL;
     session->sink_logic = NULL;
+    session->codec = SAS_CODEC_NONE;
     session->fd = -1;
     session->next = NULL;
 
@@ -135,6 +366,7 @@ struct sas_server_session * sas_server_session_get(struct sas_server *server,
     }
 
     server->sessions.count++;
+    RXC_TRACE_INSTANT("session created", server->sessions.count);
     sas_log(LOG_DEBUG "Active sessions: %d\n", server->sessions.count);
     return session;
 }
@@ -163,6 +395,7 @@ void sas_server_session_delete(struct sas_server *server,
             }
             free(session);
             server->sessions.count--;
+            RXC_TRACE_INSTANT("session deleted", server->sessions.count);
             sas_log(LOG_DEBUG "Active sessions: %d\n", server->sessions.count);
             return;
         }
@@ -209,7 +442,9 @@ int sas_server_session_send_chunk(struct sas_server *server,
     char *dst = (void *) &packet[1];
     memcpy(dst, chunk->buffer, size);
 
+    RXC_TRACE_BEGIN("chunk sent", (long) size);
     int err = sas_server_session_send(server, session, packet);
+    RXC_TRACE_END("chunk sent", (long) size);
     free(packet);
     return err;
 }
@@ -308,16 +543,41 @@ void sas_server_session_state_machine(struct sas_server *server,
                 return;
             }
 
-            struct sas_transport_packet_cfg *cfg = (void *) &header[1];
-            sas_transport_packet_cfg_decode(cfg);
-            char *name = strndup((char *) &cfg[1], header->length - sizeof(struct sas_transport_packet_cfg));
+            struct sas_transport_packet_cfg cfg = { 0, SAS_CODEC_NONE };
+            int rate = sas_transport_packet_flag_isset(header->flags, SAS_TRANSPORT_PACKET_FLAG_RAT);
+
+            /* Clients of the first version of the protocol leave the RAT flag
+             * bit unset and only send the codec */
+            size_t offset = rate ? sizeof(struct sas_transport_packet_cfg) : sizeof(cfg.codec);
 
-            if (cfg->codec != 0) {
+            if (header->length < offset) {
                 sas_server_session_error(server, session, EINVAL);
                 sas_server_session_delete(server, session);
                 return;
+            } else if (rate) {
+                memcpy(&cfg, &header[1], sizeof(struct sas_transport_packet_cfg));
+                sas_transport_packet_cfg_decode(&cfg);
+            } else {
+                cfg.codec = *(uint8_t *) &header[1];
             }
 
+            char *name = strndup((char *) &header[1] + offset, header->length - offset);
+
+            const struct sas_codec *codec = sas_codec_find(cfg.codec);
+
+            /* Servers built without libopus stream raw PCM instead */
+            if (!codec && cfg.codec == SAS_CODEC_OPUS) {
+                codec = &sas_codec_none;
+            } else if (!codec) {
+                free(name);
+                sas_server_session_error(server, session, EINVAL);
+                sas_server_session_delete(server, session);
+                return;
+            }
+
+            session->codec = codec->id;
+            session->sample_rate = cfg.sample_rate;
+
             session->fd = open(name, O_RDONLY);
 
             free(name);
@@ -328,20 +588,14 @@ void sas_server_session_state_machine(struct sas_server *server,
                 return;
             }
 
-            /* Setup the streaming pipeline */
-            struct rxc_source *source = sas_formats_wav(session->fd);
-            if (!source) {
+            /* Materialize the streaming pipeline */
+            struct sas_server_session_build_ctx build = { server, session };
+            session->pipeline = rxc_blueprint_materialize(server->blueprint, &build);
+            if (!session->pipeline) {
                 sas_server_session_error(server, session, errno);
                 sas_server_session_delete(server, session);
                 return;
             }
-            struct rxc_sink *sink = sas_server_session_sink(server, session);
-            session->pipeline = rxc_source_to(source, sink);
-
-            session->sample_rate = ((struct sas_formats_wav_source *) source)->sample_rate;
-            session->sample_size = ((struct sas_formats_wav_source *) source)->sample_size;
-            session->channels = ((struct sas_formats_wav_source *) source)->channels;
-
             sas_server_session_syn_ack(server, session);
             session->state = SAS_TRANSPORT_STATE_SACK_SENT;
 
@@ -13,6 +13,8 @@
 #include <sas/transport.h>
 #include <sas/server.h>
 
+#include "cache.h"
+
 /**
  * A client that is connected to the server and has established a session.
  */
@@ -63,7 +65,8 @@ struct sas_server_session {
     time_t timeout;
 
     /**
-     * The sample rate that is used.
+     * The sample rate that is used, which is the sample rate the client
+     * prefers until the pipeline of the session is built.
      */
     int32_t sample_rate;
 
@@ -87,6 +90,11 @@ struct sas_server_session {
      */
     int fd;
 
+    /**
+     * The stream of the session in the cache of encoded chunks.
+     */
+    struct sas_server_cache_stream cache_stream;
+
     /**
      * The next session at this hash table index.
      */
@@ -113,6 +121,32 @@ struct sas_server_session_table {
     struct sas_server_session **table;
 };
 
+/**
+ * The context with which the streaming pipeline of a session is built.
+ */
+struct sas_server_session_build_ctx {
+    /**
+     * The server the session belongs to.
+     */
+    struct sas_server *server;
+
+    /**
+     * The session to build the pipeline for.
+     */
+    struct sas_server_session *session;
+};
+
+/**
+ * Build the streaming pipeline of a session, which streams the file of the
+ * session to the client. This is the build function of the blueprint the
+ * server materializes the pipeline of each session from.
+ *
+ * @param[in] ctx The <code>struct sas_server_session_build_ctx</code> to
+ * build the pipeline for.
+ * @return The pipeline or <code>NULL</code> on failure.
+ */
+struct rxc_pipeline * sas_server_session_build(void *ctx);
+
 /**
  * Find an active connection in the server.
  *
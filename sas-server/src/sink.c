@@ -1,6 +1,8 @@
 #include <stdlib.h>
 #include <errno.h>
 
+#include <rxc/alloc.h>
+
 #include <sas/chunk.h>
 
 #include "sink.h"
@@ -8,7 +10,7 @@
 
 static void dealloc(struct rxc_sink *self, int shallow)
 {
-    free(self);
+    rxc_free(self);
 }
 
 static void on_connect(struct rxc_sink_logic *self)
@@ -20,7 +22,16 @@ static void on_connect(struct rxc_sink_logic *self)
 static void on_push(struct rxc_sink_logic *self, void *element)
 {
     struct sas_server_session_sink *sink = (void *) self->sink;
-    struct sas_chunk *chunk = element;
+    /* The protocol streams interleaved samples */
+    struct sas_chunk *chunk = sas_chunk_layout(element, SAS_LAYOUT_INTERLEAVED);
+
+    if (!chunk) {
+        sas_chunk_dealloc(element);
+        sas_server_session_error(sink->server, sink->session, ENOMEM);
+        rxc_inlet_cancel(self->in);
+        return;
+    }
+
     sas_server_session_send_chunk(sink->server, sink->session, chunk);
     sas_chunk_dealloc(chunk);
 
@@ -42,16 +53,17 @@ static void on_upstream_failure(struct rxc_sink_logic *self, void *failure)
 
 static struct rxc_sink_logic * create_logic(struct rxc_sink *self)
 {
-    struct rxc_sink_logic *logic = malloc(sizeof(struct rxc_sink_logic));
+    struct rxc_sink_logic *logic = rxc_alloc(sizeof(struct rxc_sink_logic));
 
     if (!logic) {
         return NULL;
     }
 
     logic->sink = self;
-    logic->dealloc = (void (*)(struct rxc_sink_logic *)) free;
+    logic->dealloc = (void (*)(struct rxc_sink_logic *)) rxc_free;
     logic->on_connect = on_connect;
     logic->on_push = on_push;
+    logic->on_push_value = NULL;
     logic->on_upstream_finish = on_upstream_finish;
     logic->on_upstream_failure = on_upstream_failure;
 
@@ -61,7 +73,7 @@ static struct rxc_sink_logic * create_logic(struct rxc_sink *self)
 struct rxc_sink * sas_server_session_sink(struct sas_server *server,
                                           struct sas_server_session *session)
 {
-    struct sas_server_session_sink *sink = malloc(sizeof(struct sas_server_session_sink));
+    struct sas_server_session_sink *sink = rxc_alloc(sizeof(struct sas_server_session_sink));
 
     if (!sink) {
         return NULL;